@@ -0,0 +1,78 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <SpRenderer/MemoryAllocator.h>
+
+#include <random>
+
+using SpRenderer::BuddyAllocator;
+
+namespace {
+	const VkDeviceSize BenchmarkBlockSize = SpRenderer::PreferredBlockSize;
+	const uint32 LiveAllocationCount = 1024;
+
+	// Buffer sized requests between 256 bytes and 256 KiB, weighted towards the small end like uniform and vertex buffers
+	std::vector<VkDeviceSize> randomSizes(uint32 count) {
+		std::mt19937 random(3);
+		std::uniform_int_distribution<uint32> exponent(8, 18);
+
+		std::vector<VkDeviceSize> sizes(count);
+		for (VkDeviceSize& size : sizes) {
+			uint32 bits = std::min(exponent(random), exponent(random));
+			size = (1ull << bits) + random() % (1ull << bits);
+		}
+		return sizes;
+	}
+}
+
+SP_BENCHMARK("BuddyAllocator/allocate and free 4KiB") {
+	BuddyAllocator buddy(BenchmarkBlockSize, SpRenderer::MinBuddySize);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		VkDeviceSize offset = 0;
+		bool allocated = buddy.allocate(4096, 256, offset);
+		SpBenchmark::doNotOptimize(allocated);
+		buddy.free(offset);
+	}
+}
+
+SP_BENCHMARK("BuddyAllocator/churn 1024 live") {
+	// Steady state of a busy pool: every iteration frees the oldest allocation and makes a new one
+	BuddyAllocator buddy(BenchmarkBlockSize, SpRenderer::MinBuddySize);
+	std::vector<VkDeviceSize> sizes = randomSizes(4096);
+	std::vector<VkDeviceSize> offsets(LiveAllocationCount);
+	for (uint32 i = 0; i < LiveAllocationCount; i++) {
+		buddy.allocate(sizes[i], 256, offsets[i]);
+	}
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		uint32 slot = static_cast<uint32>(i % LiveAllocationCount);
+		buddy.free(offsets[slot]);
+		bool allocated = buddy.allocate(sizes[i % sizes.size()], 256, offsets[slot]);
+		SpBenchmark::doNotOptimize(allocated);
+	}
+}
+
+SP_BENCHMARK("BuddyAllocator/largestFreeBlock") {
+	BuddyAllocator buddy(BenchmarkBlockSize, SpRenderer::MinBuddySize);
+	std::vector<VkDeviceSize> sizes = randomSizes(LiveAllocationCount);
+	std::vector<VkDeviceSize> offsets(LiveAllocationCount);
+	for (uint32 i = 0; i < LiveAllocationCount; i++) {
+		buddy.allocate(sizes[i], 256, offsets[i]);
+	}
+	// Every other allocation freed leaves the pool splintered
+	for (uint32 i = 0; i < LiveAllocationCount; i += 2) {
+		buddy.free(offsets[i]);
+	}
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		VkDeviceSize largest = buddy.largestFreeBlock();
+		SpBenchmark::doNotOptimize(largest);
+	}
+}
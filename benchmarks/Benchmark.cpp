@@ -0,0 +1,279 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+	// Per thread so the logger and job system threads never show up in a benchmark's numbers
+	thread_local uint64 tAllocationCount = 0;
+	thread_local uint64 tAllocationBytes = 0;
+
+	void* countedAlloc(size_t size, size_t alignment) {
+		tAllocationCount++;
+		tAllocationBytes += size;
+
+		if (size == 0) {
+			size = 1;
+		}
+		void* memory = nullptr;
+		if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			memory = std::malloc(size);
+		}else {
+#ifdef _WIN32
+			memory = _aligned_malloc(size, alignment);
+#else
+			memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+		}
+		if (memory == nullptr) {
+			throw std::bad_alloc();
+		}
+		return memory;
+	}
+
+	// Registered from static initializers in other translation units, so it has to be constructed on first use
+	std::map<std::string, SpBenchmark::BenchmarkFunction>& benchmarkRegistry() {
+		static std::map<std::string, SpBenchmark::BenchmarkFunction> registry;
+		return registry;
+	}
+
+	void appendJsonString(std::string& json, std::string_view text) {
+		json += '"';
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				json += '\\';
+			}
+			json += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+		}
+		json += '"';
+	}
+
+	std::string padRight(std::string text, size_t width) {
+		if (text.size() < width) {
+			text.append(width - text.size(), ' ');
+		}
+		return text;
+	}
+
+	std::string padLeft(std::string text, size_t width) {
+		if (text.size() < width) {
+			text.insert(0, width - text.size(), ' ');
+		}
+		return text;
+	}
+
+	std::string formatNumber(double value, int decimals) {
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+		return buffer;
+	}
+}
+
+// Every other form of new and delete ends up in these, the sized deletes are forwarded explicitly
+void* operator new(size_t size) {
+	return countedAlloc(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	return countedAlloc(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	operator delete(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept {
+	operator delete(memory, alignment);
+}
+
+namespace SpBenchmark {
+#pragma region BenchmarkState
+	BenchmarkState::BenchmarkState(uint64 iterations) : mIterations(iterations) {
+		resetTimer();
+	}
+
+	void BenchmarkState::resetTimer() {
+		mElapsedNs = 0;
+		mAllocs = 0;
+		mBytes = 0;
+		mStartAllocs = tAllocationCount;
+		mStartBytes = tAllocationBytes;
+		mStart = std::chrono::steady_clock::now();
+	}
+
+	void BenchmarkState::stopTimer() {
+		if (!mRunning) {
+			return;
+		}
+
+		mElapsedNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count();
+		mAllocs += tAllocationCount - mStartAllocs;
+		mBytes += tAllocationBytes - mStartBytes;
+		mRunning = false;
+	}
+
+	void BenchmarkState::startTimer() {
+		if (mRunning) {
+			return;
+		}
+
+		mStartAllocs = tAllocationCount;
+		mStartBytes = tAllocationBytes;
+		mRunning = true;
+		mStart = std::chrono::steady_clock::now();
+	}
+
+	void BenchmarkState::finish() {
+		stopTimer();
+	}
+#pragma endregion
+
+	bool registerBenchmark(const char* name, BenchmarkFunction function) {
+		bool inserted = benchmarkRegistry().emplace(name, std::move(function)).second;
+		if (!inserted) {
+			SpConsole::FatalExit(std::string("Benchmark registered twice: ") + name, SP_FAILURE);
+		}
+		return inserted;
+	}
+
+	fs::path scratchPath(std::string_view fileName) {
+		fs::path directory = RENDERER_DATA_DIR "/benchmarks/scratch";
+		std::error_code error;
+		fs::create_directories(directory, error);
+		if (error) {
+			SpConsole::FatalExit("Failed to create " + directory.string() + ": " + error.message(), SP_FAILURE);
+		}
+		return directory / fileName;
+	}
+
+	uint64 threadAllocationCount() {
+		return tAllocationCount;
+	}
+
+	uint64 threadAllocationBytes() {
+		return tAllocationBytes;
+	}
+
+#pragma region BenchmarkRunner
+	BenchmarkRunner::BenchmarkRunner(BenchmarkSettings settings) : mSettings(std::move(settings)) {}
+
+	std::vector<BenchmarkResult> BenchmarkRunner::run() {
+		std::vector<BenchmarkResult> results;
+
+		SpConsole::PlainWrite(padRight("Benchmark", 44) + padLeft("iterations", 12) + padLeft("ns/op", 14) +
+		                      padLeft("allocs/op", 12) + padLeft("bytes/op", 12));
+		for (const auto& [name, function] : benchmarkRegistry()) {
+			if (!mSettings.filter.empty() && name.find(mSettings.filter) == std::string::npos) {
+				continue;
+			}
+
+			BenchmarkResult result = runBenchmark(name, function);
+			SpConsole::PlainWrite(padRight(result.name, 44) + padLeft(std::to_string(result.iterations), 12) +
+			                      padLeft(formatNumber(result.nsPerOp, 1), 14) + padLeft(formatNumber(result.allocsPerOp, 2), 12) +
+			                      padLeft(formatNumber(result.bytesPerOp, 1), 12));
+			results.push_back(std::move(result));
+		}
+		SpConsole::Flush();
+
+		return results;
+	}
+
+	bool BenchmarkRunner::writeJson(const std::vector<BenchmarkResult>& results) const {
+		std::string json = "{\n\"settings\":{\"minTimeMs\":" + formatNumber(mSettings.minTimeMs, 1) +
+		                   ",\"repetitions\":" + std::to_string(mSettings.repetitions) +
+		                   ",\"hardwareThreads\":" + std::to_string(std::thread::hardware_concurrency()) + "},\n\"benchmarks\":[\n";
+		for (size_t i = 0; i < results.size(); i++) {
+			const BenchmarkResult& result = results[i];
+			json += "{\"name\":";
+			appendJsonString(json, result.name);
+			json += ",\"iterations\":" + std::to_string(result.iterations) +
+			        ",\"nsPerOp\":" + formatNumber(result.nsPerOp, 3) +
+			        ",\"minNsPerOp\":" + formatNumber(result.minNsPerOp, 3) +
+			        ",\"maxNsPerOp\":" + formatNumber(result.maxNsPerOp, 3) +
+			        ",\"allocsPerOp\":" + formatNumber(result.allocsPerOp, 3) +
+			        ",\"bytesPerOp\":" + formatNumber(result.bytesPerOp, 3) + "}";
+			json += i + 1 < results.size() ? ",\n" : "\n";
+		}
+		json += "]\n}\n";
+
+		std::error_code error;
+		fs::create_directories(mSettings.jsonPath.parent_path(), error);
+		if (error) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to create " + mSettings.jsonPath.parent_path().string() + ": " + error.message());
+			return false;
+		}
+
+		Utils::FileUtils::writeTextFile(mSettings.jsonPath, json);
+		SpConsole::Write(SP_MESSAGE_INFO, "Wrote " + std::to_string(results.size()) + " benchmark results to " + mSettings.jsonPath.string());
+		return true;
+	}
+
+	BenchmarkResult BenchmarkRunner::runBenchmark(const std::string& name, const BenchmarkFunction& function) const {
+		const double minTimeNs = mSettings.minTimeMs * 1.0e6;
+
+		// Grow the iteration count until a run is long enough, aiming a little past the target like Go's testing package
+		uint64 iterations = 1;
+		while (true) {
+			BenchmarkState state = measure(function, iterations);
+			if (static_cast<double>(state.mElapsedNs) >= minTimeNs || iterations >= 1'000'000'000ull) {
+				break;
+			}
+
+			double nsPerOp = std::max(static_cast<double>(state.mElapsedNs) / static_cast<double>(iterations), 1.0);
+			uint64 predicted = static_cast<uint64>(minTimeNs * 1.2 / nsPerOp);
+			iterations = std::clamp(predicted, iterations + 1, iterations * 100);
+		}
+
+		std::vector<double> nsPerOp;
+		uint64 allocs = 0;
+		uint64 bytes = 0;
+		uint32 repetitions = std::max(mSettings.repetitions, 1u);
+		for (uint32 i = 0; i < repetitions; i++) {
+			BenchmarkState state = measure(function, iterations);
+			nsPerOp.push_back(static_cast<double>(state.mElapsedNs) / static_cast<double>(iterations));
+			allocs += state.mAllocs;
+			bytes += state.mBytes;
+		}
+		std::sort(nsPerOp.begin(), nsPerOp.end());
+
+		double operations = static_cast<double>(iterations) * repetitions;
+
+		BenchmarkResult result;
+		result.name = name;
+		result.iterations = iterations;
+		result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+		result.minNsPerOp = nsPerOp.front();
+		result.maxNsPerOp = nsPerOp.back();
+		result.allocsPerOp = static_cast<double>(allocs) / operations;
+		result.bytesPerOp = static_cast<double>(bytes) / operations;
+		return result;
+	}
+
+	BenchmarkState BenchmarkRunner::measure(const BenchmarkFunction& function, uint64 iterations) {
+		BenchmarkState state(iterations);
+		function(state);
+		state.finish();
+		return state;
+	}
+#pragma endregion
+} // SpBenchmark
@@ -0,0 +1,127 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_BENCHMARK_H
+#define SPARKER_ENGINE_BENCHMARK_H
+
+#include <SpRenderer/Utils.h>
+
+#include <atomic>
+#include <functional>
+
+namespace SpBenchmark {
+	struct BenchmarkSettings {
+		double minTimeMs = 250.0;   // Each measured run lasts at least this long
+		uint32 repetitions = 5;     // Measured runs, the median is reported
+		std::string filter;         // Only benchmarks whose name contains this
+		std::filesystem::path jsonPath = RENDERER_DATA_DIR "/benchmarks/benchmarks.json";
+	};
+
+	struct BenchmarkResult {
+		std::string name;
+		uint64 iterations = 0;   // Per measured run
+		double nsPerOp = 0.0;    // Median over the runs
+		double minNsPerOp = 0.0;
+		double maxNsPerOp = 0.0;
+		double allocsPerOp = 0.0; // Heap allocations made by the benchmark's thread
+		double bytesPerOp = 0.0;  // Bytes those allocations asked for
+	};
+
+	/**
+	 * Handed to a benchmark function, which runs its operation iterations() times. Everything before the loop that
+	 * should not count goes before resetTimer(), per iteration setup goes between stopTimer() and startTimer().
+	 * Time and allocations are counted the same way, so a paused timer also hides the setup's allocations.
+	 */
+	class BenchmarkState {
+	public:
+		explicit BenchmarkState(uint64 iterations);
+
+		uint64 iterations() const { return mIterations; }
+
+		void resetTimer();
+		void stopTimer();
+		void startTimer();
+
+	private:
+		friend class BenchmarkRunner;
+
+		uint64 mIterations;
+		bool mRunning = true;
+
+		std::chrono::steady_clock::time_point mStart;
+		uint64 mElapsedNs = 0;
+
+		uint64 mStartAllocs = 0;
+		uint64 mStartBytes = 0;
+		uint64 mAllocs = 0;
+		uint64 mBytes = 0;
+
+		void finish();
+	};
+
+	typedef std::function<void(BenchmarkState& state)> BenchmarkFunction;
+
+	/*!
+	 * Used by SP_BENCHMARK, benchmarks run in name order
+	 */
+	bool registerBenchmark(const char* name, BenchmarkFunction function);
+
+	/*!
+	 * Keeps the compiler from optimising away a result the benchmark never uses
+	 */
+	template<typename T>
+	inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		static const void* volatile sink;
+		sink = &value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	/**
+	 * Runs every registered benchmark matching the filter. The iteration count is grown until a run takes minTimeMs,
+	 * then that many iterations are measured repetitions times.
+	 */
+	class BenchmarkRunner {
+	public:
+		explicit BenchmarkRunner(BenchmarkSettings settings);
+
+		std::vector<BenchmarkResult> run();
+		/*!
+		 * One object per benchmark and one benchmark per line, so results diff cleanly between commits
+		 */
+		bool writeJson(const std::vector<BenchmarkResult>& results) const;
+
+	private:
+		BenchmarkSettings mSettings;
+
+		BenchmarkResult runBenchmark(const std::string& name, const BenchmarkFunction& function) const;
+		static BenchmarkState measure(const BenchmarkFunction& function, uint64 iterations);
+	};
+
+	/*!
+	 * File in RENDERER_DATA_DIR/benchmarks/scratch for benchmarks that need something on disk, the directory is created
+	 */
+	std::filesystem::path scratchPath(std::string_view fileName);
+
+	/*!
+	 * Heap allocations made by the calling thread so far, counted by the replaced global operator new
+	 */
+	uint64 threadAllocationCount();
+	uint64 threadAllocationBytes();
+} // SpBenchmark
+
+#define SP_BENCHMARK_CONCAT_INNER(a, b) a##b
+#define SP_BENCHMARK_CONCAT(a, b) SP_BENCHMARK_CONCAT_INNER(a, b)
+
+// Registers a benchmark before main runs, the body gets a BenchmarkState& named state
+#define SP_BENCHMARK(name) \
+	static void SP_BENCHMARK_CONCAT(spBenchmark, __LINE__)(SpBenchmark::BenchmarkState& state); \
+	static const bool SP_BENCHMARK_CONCAT(spBenchmarkRegistered, __LINE__) = \
+		SpBenchmark::registerBenchmark(name, SP_BENCHMARK_CONCAT(spBenchmark, __LINE__)); \
+	static void SP_BENCHMARK_CONCAT(spBenchmark, __LINE__)(SpBenchmark::BenchmarkState& state)
+
+#endif //SPARKER_ENGINE_BENCHMARK_H
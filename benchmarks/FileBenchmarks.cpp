@@ -0,0 +1,86 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <random>
+
+namespace {
+	std::vector<char> randomBytes(size_t size) {
+		std::mt19937 random(7);
+		std::vector<char> bytes(size);
+		for (char& byte : bytes) {
+			byte = static_cast<char>(random());
+		}
+		return bytes;
+	}
+
+	// Written once per measured run, so reads hit the page cache like asset loads after the first
+	std::filesystem::path writeScratchFile(std::string_view fileName, size_t size) {
+		std::filesystem::path filePath = SpBenchmark::scratchPath(fileName);
+		Utils::FileUtils::writeBinaryFile(filePath, randomBytes(size));
+		return filePath;
+	}
+}
+
+SP_BENCHMARK("FileUtils/readBinaryFile 64KiB") {
+	std::filesystem::path filePath = writeScratchFile("read_64k.bin", 64 * 1024);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		std::vector<char> data = Utils::FileUtils::readBinaryFile(filePath);
+		SpBenchmark::doNotOptimize(data.data());
+	}
+}
+
+SP_BENCHMARK("FileUtils/readTextFile 64KiB") {
+	std::filesystem::path filePath = writeScratchFile("read_text_64k.txt", 64 * 1024);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		std::vector<char> data = Utils::FileUtils::readTextFile(filePath);
+		SpBenchmark::doNotOptimize(data.data());
+	}
+}
+
+SP_BENCHMARK("FileUtils/writeBinaryFile 64KiB") {
+	std::filesystem::path filePath = SpBenchmark::scratchPath("write_64k.bin");
+	std::vector<char> data = randomBytes(64 * 1024);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		Utils::FileUtils::writeBinaryFile(filePath, data);
+	}
+}
+
+SP_BENCHMARK("FileUtils/mapFile 1MiB") {
+	std::filesystem::path filePath = writeScratchFile("map_1m.bin", 1024 * 1024);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		Utils::MappedFile file = Utils::FileUtils::mapFile(filePath);
+		SpBenchmark::doNotOptimize(file.data().data());
+	}
+}
+
+SP_BENCHMARK("FileUtils/mapFile and hash 1MiB") {
+	std::filesystem::path filePath = writeScratchFile("map_hash_1m.bin", 1024 * 1024);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		Utils::MappedFile file = Utils::FileUtils::mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+		uint64 hash = Utils::hash64(file.data().data(), file.size());
+		SpBenchmark::doNotOptimize(hash);
+	}
+}
+
+SP_BENCHMARK("Utils/hash64 1KiB") {
+	std::vector<char> data = randomBytes(1024);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		uint64 hash = Utils::hash64(data.data(), data.size());
+		SpBenchmark::doNotOptimize(hash);
+	}
+}
@@ -0,0 +1,75 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <SpRenderer/JobSystem.h>
+#include <SpRenderer/Profiler.h>
+
+using SpRenderer::JobCounter;
+using SpRenderer::JobSystem;
+
+SP_BENCHMARK("JobSystem/run and wait") {
+	JobSystem jobSystem;
+	jobSystem.init();
+	uint64 ran = 0;
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		JobCounter counter;
+		jobSystem.run([&ran] { ran++; }, &counter);
+		jobSystem.wait(counter);
+	}
+	state.stopTimer();
+
+	SpBenchmark::doNotOptimize(ran);
+	jobSystem.destroy();
+}
+
+SP_BENCHMARK("JobSystem/parallelFor 64K items") {
+	// Scheduling overhead of splitting a frame's worth of small items, the work itself is trivial
+	const uint32 itemCount = 64 * 1024;
+	JobSystem jobSystem;
+	jobSystem.init();
+	std::vector<uint32> items(itemCount, 1);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		JobCounter counter;
+		jobSystem.parallelFor(itemCount, 1024, [&items](uint32 begin, uint32 end) {
+			for (uint32 item = begin; item < end; item++) {
+				items[item] = items[item] * 3 + 1;
+			}
+		}, counter);
+		jobSystem.wait(counter);
+	}
+	state.stopTimer();
+
+	SpBenchmark::doNotOptimize(items.data());
+	jobSystem.destroy();
+}
+
+SP_BENCHMARK("Profiler/zone disabled") {
+	SpRenderer::Profiler::get().setEnabled(false);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		SP_PROFILE_ZONE("Benchmark zone");
+		SpBenchmark::doNotOptimize(i);
+	}
+}
+
+SP_BENCHMARK("Profiler/zone enabled") {
+	// Events are kept until exit, once this thread's buffer is full zones are counted as dropped but cost the same
+	SpRenderer::Profiler::get().setEnabled(true);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		SP_PROFILE_ZONE("Benchmark zone");
+		SpBenchmark::doNotOptimize(i);
+	}
+	state.stopTimer();
+
+	SpRenderer::Profiler::get().setEnabled(false);
+}
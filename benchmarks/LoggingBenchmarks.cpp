@@ -0,0 +1,63 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <SpRenderer/Logger.h>
+
+namespace {
+	// What SpConsole::Write costs the calling thread, without the drain thread printing millions of lines
+	void benchmarkRingPush(SpBenchmark::BenchmarkState& state, size_t messageLength) {
+		SpConsole::LogRing ring(0);
+		std::string message(messageLength, 'x');
+
+		state.resetTimer();
+		for (uint64 i = 0; i < state.iterations(); i++) {
+			while (!ring.push(i, SP_MESSAGE_INFO, 0, {}, message)) {
+				// A full ring is the drain thread's work, not the writer's
+				state.stopTimer();
+				ring.drain([](const SpConsole::LogRecordHeader&, std::string_view) {});
+				state.startTimer();
+			}
+		}
+	}
+}
+
+SP_BENCHMARK("LogRing/push 64B") {
+	benchmarkRingPush(state, 64);
+}
+
+SP_BENCHMARK("LogRing/push 1KiB") {
+	benchmarkRingPush(state, 1024);
+}
+
+SP_BENCHMARK("LogRing/push and drain 64B") {
+	SpConsole::LogRing ring(0);
+	std::string message(64, 'x');
+	uint64 drainedBytes = 0;
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		ring.push(i, SP_MESSAGE_INFO, 0, {}, message);
+		ring.drain([&drainedBytes](const SpConsole::LogRecordHeader& header, std::string_view) {
+			drainedBytes += header.length;
+		});
+	}
+	SpBenchmark::doNotOptimize(drainedBytes);
+}
+
+SP_BENCHMARK("LogRing/push formatted message") {
+	// The usual call site builds its message with std::to_string and concatenation first
+	SpConsole::LogRing ring(0);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		std::string message = "Created " + std::to_string(i) + " thread command pools";
+		while (!ring.push(i, SP_MESSAGE_INFO, 0, {}, message)) {
+			state.stopTimer();
+			ring.drain([](const SpConsole::LogRecordHeader&, std::string_view) {});
+			state.startTimer();
+		}
+	}
+}
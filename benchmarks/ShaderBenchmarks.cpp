@@ -0,0 +1,87 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <SpRenderer/ShaderCache.h>
+
+namespace {
+	const char* BenchmarkShaderSource =
+		"#version 450\n"
+		"layout(location = 0) in vec2 inPosition;\n"
+		"void main() {\n"
+		"    gl_Position = vec4(inPosition, 0.0, 1.0);\n"
+		"}\n";
+
+	// A cache directory holding one shader, written once per process
+	std::filesystem::path prepareShaderCache(const std::filesystem::path& sourcePath) {
+		std::filesystem::path cacheDirectory = SpBenchmark::scratchPath("shader_cache");
+		static bool prepared = false;
+		if (prepared) {
+			return cacheDirectory;
+		}
+		prepared = true;
+
+		std::string_view source(BenchmarkShaderSource);
+		Utils::FileUtils::writeTextFile(sourcePath, source);
+
+		ShaderCache cache;
+		cache.load(cacheDirectory);
+
+		std::span<const uint32> spirv;
+		if (!cache.find(sourcePath, SP_SHADER_STAGE_VERTEX, {}, spirv)) {
+			std::vector<uint32> fakeSpirv(256, 0x07230203);
+			cache.store(sourcePath, SP_SHADER_STAGE_VERTEX, {}, {}, fakeSpirv);
+			cache.save();
+		}
+		return cacheDirectory;
+	}
+}
+
+SP_BENCHMARK("ShaderCache/find hit") {
+	std::filesystem::path sourcePath = SpBenchmark::scratchPath("benchmark.vert");
+	std::filesystem::path cacheDirectory = prepareShaderCache(sourcePath);
+
+	ShaderCache cache;
+	cache.load(cacheDirectory);
+	ShaderCompileSettings settings{};
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		std::span<const uint32> spirv;
+		bool found = cache.find(sourcePath, SP_SHADER_STAGE_VERTEX, settings, spirv);
+		SpBenchmark::doNotOptimize(found);
+	}
+}
+
+SP_BENCHMARK("ShaderCache/find miss") {
+	std::filesystem::path sourcePath = SpBenchmark::scratchPath("benchmark.vert");
+	std::filesystem::path cacheDirectory = prepareShaderCache(sourcePath);
+
+	ShaderCache cache;
+	cache.load(cacheDirectory);
+
+	// Not in the cache, a changed macro changes the fingerprint
+	ShaderCompileSettings settings{};
+	settings.macros.emplace_back("BENCHMARK_MISS", "1");
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		std::span<const uint32> spirv;
+		bool found = cache.find(sourcePath, SP_SHADER_STAGE_VERTEX, settings, spirv);
+		SpBenchmark::doNotOptimize(found);
+	}
+}
+
+SP_BENCHMARK("ShaderCompileSettings/fingerprint") {
+	ShaderCompileSettings settings{};
+	settings.macros.emplace_back("MAX_LIGHTS", "16");
+	settings.macros.emplace_back("USE_SHADOWS", "1");
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		uint64 fingerprint = settings.fingerprint();
+		SpBenchmark::doNotOptimize(fingerprint);
+	}
+}
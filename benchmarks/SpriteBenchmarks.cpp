@@ -0,0 +1,110 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <SpRenderer/SpriteBatcher.h>
+
+#include <random>
+
+using SpRenderer::Sprite;
+using SpRenderer::SpriteBatcher;
+using SpRenderer::SpriteInstance;
+
+namespace {
+	const uint32 BenchmarkSpriteCount = 16 * 1024;
+
+	// Spread over 16 textures and 4 pipelines like a busy 2D scene, same seed every run
+	std::vector<Sprite> randomSprites(uint32 count) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(0.0f, 1920.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		std::vector<Sprite> sprites(count);
+		for (Sprite& sprite : sprites) {
+			sprite.position = vec2(position(random), position(random));
+			sprite.size = vec2(16.0f + 48.0f * unit(random));
+			sprite.color = static_cast<uint32>(random());
+			sprite.rotation = unit(random) * 6.2831853f;
+			sprite.depth = unit(random);
+			sprite.texture = random() % 16;
+			sprite.pipeline = random() % 4;
+		}
+		return sprites;
+	}
+
+	struct SortedSprites {
+		std::vector<Sprite> sprites;
+		std::vector<uint64> keys;
+		std::vector<uint32> order;
+	};
+
+	SortedSprites sortedSprites(uint32 count) {
+		SortedSprites sorted;
+		sorted.sprites = randomSprites(count);
+		sorted.keys.resize(count);
+		sorted.order.resize(count);
+		for (uint32 i = 0; i < count; i++) {
+			sorted.keys[i] = SpriteBatcher::sortKey(sorted.sprites[i]);
+			sorted.order[i] = i;
+		}
+
+		std::vector<uint64> keysScratch(count);
+		std::vector<uint32> orderScratch(count);
+		SpriteBatcher::radixSort(sorted.keys, sorted.order, keysScratch, orderScratch);
+		return sorted;
+	}
+}
+
+SP_BENCHMARK("SpriteBatcher/sortKey 16K") {
+	std::vector<Sprite> sprites = randomSprites(BenchmarkSpriteCount);
+	std::vector<uint64> keys(BenchmarkSpriteCount);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		for (uint32 sprite = 0; sprite < BenchmarkSpriteCount; sprite++) {
+			keys[sprite] = SpriteBatcher::sortKey(sprites[sprite]);
+		}
+		SpBenchmark::doNotOptimize(keys.data());
+	}
+}
+
+SP_BENCHMARK("SpriteBatcher/radixSort 16K") {
+	std::vector<Sprite> sprites = randomSprites(BenchmarkSpriteCount);
+	std::vector<uint64> unsortedKeys(BenchmarkSpriteCount);
+	for (uint32 i = 0; i < BenchmarkSpriteCount; i++) {
+		unsortedKeys[i] = SpriteBatcher::sortKey(sprites[i]);
+	}
+
+	std::vector<uint64> keys(BenchmarkSpriteCount);
+	std::vector<uint32> order(BenchmarkSpriteCount);
+	std::vector<uint64> keysScratch(BenchmarkSpriteCount);
+	std::vector<uint32> orderScratch(BenchmarkSpriteCount);
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		state.stopTimer();
+		keys = unsortedKeys;
+		for (uint32 sprite = 0; sprite < BenchmarkSpriteCount; sprite++) {
+			order[sprite] = sprite;
+		}
+		state.startTimer();
+
+		SpriteBatcher::radixSort(keys, order, keysScratch, orderScratch);
+		SpBenchmark::doNotOptimize(order.data());
+	}
+}
+
+SP_BENCHMARK("SpriteBatcher/packInstances 16K") {
+	SortedSprites sorted = sortedSprites(BenchmarkSpriteCount);
+	std::vector<SpriteInstance> instances(BenchmarkSpriteCount);
+	std::vector<SpriteBatcher::SpriteBatch> batches;
+
+	state.resetTimer();
+	for (uint64 i = 0; i < state.iterations(); i++) {
+		batches.clear();
+		SpriteBatcher::packInstances(sorted.sprites, sorted.keys, sorted.order, instances.data(), batches);
+		SpBenchmark::doNotOptimize(instances.data());
+	}
+}
@@ -0,0 +1,41 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <SpRenderer/BlockCompression.h>
+
+#include <random>
+
+namespace {
+	const uint32 BenchmarkTextureSize = 256;
+
+	// Random blocks decode like any other, every code path of the decoder gets hit
+	void benchmarkDecode(SpBenchmark::BenchmarkState& state, VkFormat format) {
+		std::mt19937 random(5);
+		std::vector<uint8> blocks(SpRenderer::imageSize(format, BenchmarkTextureSize, BenchmarkTextureSize));
+		for (uint8& byte : blocks) {
+			byte = static_cast<uint8>(random());
+		}
+		std::vector<uint8> pixels;
+
+		state.resetTimer();
+		for (uint64 i = 0; i < state.iterations(); i++) {
+			SpRenderer::decodeBlocks(format, blocks, BenchmarkTextureSize, BenchmarkTextureSize, pixels);
+			SpBenchmark::doNotOptimize(pixels.data());
+		}
+	}
+}
+
+SP_BENCHMARK("BlockCompression/decode BC1 256x256") {
+	benchmarkDecode(state, VK_FORMAT_BC1_RGBA_UNORM_BLOCK);
+}
+
+SP_BENCHMARK("BlockCompression/decode BC3 256x256") {
+	benchmarkDecode(state, VK_FORMAT_BC3_UNORM_BLOCK);
+}
+
+SP_BENCHMARK("BlockCompression/decode BC5 256x256") {
+	benchmarkDecode(state, VK_FORMAT_BC5_UNORM_BLOCK);
+}
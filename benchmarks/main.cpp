@@ -0,0 +1,37 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <cstring>
+
+int main(int argc, char* args[]) {
+    SpBenchmark::BenchmarkSettings settings{};
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(args[i], "--filter") == 0 && hasValue) {
+            settings.filter = args[++i];
+        }else if (std::strcmp(args[i], "--json") == 0 && hasValue) {
+            settings.jsonPath = args[++i];
+        }else if (std::strcmp(args[i], "--min-time") == 0 && hasValue) {
+            settings.minTimeMs = std::strtod(args[++i], nullptr);
+        }else if (std::strcmp(args[i], "--repetitions") == 0 && hasValue) {
+            settings.repetitions = static_cast<uint32>(std::strtoul(args[++i], nullptr, 10));
+        }else {
+            SpConsole::PlainWrite("Usage: SparkerBenchmarks [--filter text] [--json path] [--min-time ms] [--repetitions count]");
+            SpConsole::Flush();
+            return SP_FAILURE;
+        }
+    }
+
+    SpBenchmark::BenchmarkRunner runner(settings);
+    std::vector<SpBenchmark::BenchmarkResult> results = runner.run();
+    if (results.empty()) {
+        SpConsole::Write(SP_MESSAGE_WARNING, "No benchmark matches \"" + settings.filter + "\"");
+    }
+
+    bool written = runner.writeJson(results);
+    SpConsole::Flush();
+    return written ? SP_SUCCESS : SP_FAILURE;
+}
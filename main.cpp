@@ -1,16 +1,107 @@
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
 
+#include <SpRenderer/Profiler.h>
 #include <SpRenderer/RendererCore.h>
+#include <SpRenderer/SpriteBenchmark.h>
 
 int main(int argc, char* args[]) {
+    uint32 benchmarkSprites = 0;
+    bool profile = false;
+    uint64 headlessFrames = 0;
+    bool readback = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(args[i], "--sprite-benchmark") == 0) {
+            benchmarkSprites = 100000;
+            if (i + 1 < argc && args[i + 1][0] != '-') {
+                benchmarkSprites = static_cast<uint32>(std::strtoul(args[++i], nullptr, 10));
+            }
+        }else if (std::strcmp(args[i], "--profile") == 0) {
+            profile = true;
+        }else if (std::strcmp(args[i], "--headless") == 0) {
+            headlessFrames = 1000;
+            if (i + 1 < argc && args[i + 1][0] != '-') {
+                headlessFrames = std::strtoull(args[++i], nullptr, 10);
+            }
+        }else if (std::strcmp(args[i], "--readback") == 0) {
+            readback = true;
+        }
+    }
+
+    // Before start() so startup shows up in the trace too
+    if (profile) {
+        SpRenderer::Profiler::get().setEnabled(true);
+    }
+
     SpRenderer::RendererCore renderer;
 
-    renderer.start("Sparker Engine");
+    // The last frame read back is written out as a PPM once the renderer stops
+    std::vector<uint8> lastFrame;
+    VkExtent2D lastFrameExtent = {0, 0};
 
+    if (headlessFrames != 0) {
+        SpRenderer::RendererCore::HeadlessSettings settings{};
+        settings.frameLimit = headlessFrames;
+        settings.readback = readback;
+        renderer.setReadbackCallback([&](std::span<const uint8> pixels, VkExtent2D extent, uint64) {
+            lastFrame.assign(pixels.begin(), pixels.end());
+            lastFrameExtent = extent;
+        });
+        renderer.startHeadless("Sparker Engine", settings);
+    }else {
+        renderer.start("Sparker Engine");
+    }
+
+    SpRenderer::SpriteBenchmark spriteBenchmark;
+    if (benchmarkSprites != 0) {
+        spriteBenchmark.init(benchmarkSprites);
+    }
+
+    std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastFrameTime = runStart;
     while ( !renderer.shouldClose() ) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double deltaSeconds = std::chrono::duration<double>(now - lastFrameTime).count();
+        lastFrameTime = now;
+
+        if (benchmarkSprites != 0) {
+            spriteBenchmark.update(renderer, deltaSeconds);
+        }
         renderer.endFrame();
     }
 
+    if (benchmarkSprites != 0) {
+        spriteBenchmark.logResults();
+    }
+
+    if (headlessFrames != 0) {
+        double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+        uint64 frameCount = renderer.getFrameStats().frameCount;
+        SpConsole::Write(SP_MESSAGE_INFO, "Headless: " + std::to_string(frameCount) + " frames in " + std::to_string(runSeconds) +
+                                          " s, " + std::to_string(static_cast<double>(frameCount) / runSeconds) + " fps");
+    }
+
     renderer.stop();
+
+    if (!lastFrame.empty()) {
+        // Binary PPM, RGB without the alpha channel
+        std::string header = "P6\n" + std::to_string(lastFrameExtent.width) + " " + std::to_string(lastFrameExtent.height) + "\n255\n";
+        std::vector<char> ppm(header.begin(), header.end());
+        ppm.reserve(ppm.size() + lastFrame.size() / 4 * 3);
+        for (size_t i = 0; i < lastFrame.size(); i += 4) {
+            ppm.push_back(static_cast<char>(lastFrame[i]));
+            ppm.push_back(static_cast<char>(lastFrame[i + 1]));
+            ppm.push_back(static_cast<char>(lastFrame[i + 2]));
+        }
+        Utils::FileUtils::writeBinaryFile(RENDERER_DATA_DIR "/headless_frame.ppm", ppm);
+        SpConsole::Write(SP_MESSAGE_INFO, "Wrote last frame to " RENDERER_DATA_DIR "/headless_frame.ppm");
+    }
+
+    if (profile) {
+        SpRenderer::Profiler::get().exportChromeTrace();
+    }
     return 0;
 }
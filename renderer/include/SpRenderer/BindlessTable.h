@@ -0,0 +1,146 @@
+//
+// Created by robsc on 11/30/25.
+//
+
+#ifndef SPARKER_ENGINE_BINDLESSTABLE_H
+#define SPARKER_ENGINE_BINDLESSTABLE_H
+
+#include "Utils.h"
+#include "MemoryAllocator.h"
+
+#include <mutex>
+
+namespace SpRenderer {
+	// Upper bounds, clamped to the device's update after bind limits
+	const uint32 BindlessImageCapacity = 16 * 1024;
+	const uint32 BindlessSamplerCapacity = 256;
+	const uint32 BindlessBufferCapacity = 4 * 1024;
+
+	const VkDeviceSize DefaultBindlessBufferSize = 256;
+
+	// Set 0 of every pipeline layout holds the per frame uniforms, the bindless table is always set 1
+	const uint32 BindlessDescriptorSet = 1;
+
+	// Binding of each array in the bindless set, shaders declare them as unsized arrays
+	enum BindlessBinding {
+		SP_BINDLESS_BINDING_SAMPLED_IMAGES = 0,
+		SP_BINDLESS_BINDING_SAMPLERS = 1,
+		SP_BINDLESS_BINDING_STORAGE_BUFFERS = 2,
+		SP_BINDLESS_BINDING_COUNT
+	};
+
+	// Index into one of the bindless arrays, handed to shaders through instance data or push constants
+	typedef uint32 BindlessIndex;
+	// Slot 0 of every array is the default resource, unused slots point at it too so any index is safe to sample
+	const BindlessIndex DefaultBindlessIndex = 0;
+
+	struct BindlessStats {
+		uint32 imageCount = 0;   // Live registrations, defaults not included
+		uint32 samplerCount = 0;
+		uint32 bufferCount = 0;
+
+		uint32 imageCapacity = 0;
+		uint32 samplerCapacity = 0;
+		uint32 bufferCapacity = 0;
+
+		uint32 lastCommitWrites = 0; // Descriptors written by the last commit()
+		uint64 commitCount = 0;      // Commits that called vkUpdateDescriptorSets
+	};
+
+	/**
+	 * One update after bind descriptor set holding large partially bound arrays of sampled images, samplers and
+	 * storage buffers. The set is bound once per frame and resources are addressed by index, so switching textures
+	 * or buffers costs no descriptor binds.
+	 *
+	 * Registering and releasing can happen from any thread and only queue descriptor writes, commit() applies them.
+	 * A registered index reads the default resource until the commit after it was registered. A released index
+	 * keeps pointing at its resource until no frame in flight can use it, then it is reset to the default and
+	 * handed out again, the resource has to stay alive until then.
+	 */
+	class BindlessTable {
+	public:
+		/**
+		 *
+		 * @param defaultImageView Shader read only view every unused sampled image slot points at
+		 */
+		void init(VkPhysicalDevice physicalDevice,
+		          VkDevice device,
+		          MemoryAllocator& allocator,
+		          uint32 framesInFlight,
+		          VkImageView defaultImageView);
+		void destroy();
+
+		BindlessIndex registerImage(VkImageView imageView, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		BindlessIndex registerSampler(VkSampler sampler);
+		BindlessIndex registerBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+		void releaseImage(BindlessIndex index);
+		void releaseSampler(BindlessIndex index);
+		void releaseBuffer(BindlessIndex index);
+
+		/*!
+		 * Writes every registration since the last commit and recycles released slots the GPU is done with.
+		 * Render thread only, once per frame after the frame's fence was waited on and before it is submitted
+		 */
+		void commit(uint64 frameNumber);
+
+		VkDescriptorSetLayout getLayout() const { return mLayout; }
+		VkDescriptorSet getSet() const { return mSet; }
+
+		BindlessStats getStats();
+
+	private:
+		struct RetiredSlot {
+			BindlessIndex index;
+			uint64 retireFrame;
+		};
+
+		struct SlotArray {
+			VkDescriptorType type;
+			uint32 capacity = 0;
+			BindlessIndex nextIndex = DefaultBindlessIndex + 1; // Slots from here on were never handed out
+			uint32 liveCount = 0;
+			std::vector<BindlessIndex> freeIndices;
+			std::vector<RetiredSlot> retired;
+		};
+
+		struct PendingWrite {
+			BindlessBinding binding;
+			BindlessIndex index;
+			VkDescriptorImageInfo imageInfo;
+			VkDescriptorBufferInfo bufferInfo;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		MemoryAllocator* mAllocator = nullptr;
+		uint32 mFramesInFlight = 0;
+
+		VkDescriptorSetLayout mLayout = VK_NULL_HANDLE;
+		VkDescriptorPool mPool = VK_NULL_HANDLE;
+		VkDescriptorSet mSet = VK_NULL_HANDLE;
+
+		VkImageView mDefaultImageView = VK_NULL_HANDLE;
+		VkSampler mDefaultSampler = VK_NULL_HANDLE;
+		VkBuffer mDefaultBuffer = VK_NULL_HANDLE;
+		Allocation mDefaultBufferAllocation;
+
+		std::mutex mMutex;
+		std::array<SlotArray, SP_BINDLESS_BINDING_COUNT> mArrays;
+		std::vector<PendingWrite> mPendingWrites;
+		uint64 mFrameNumber = 0; // Frame being recorded, releases retire with it
+
+		BindlessStats mStats;
+
+		void queryCapacities(VkPhysicalDevice physicalDevice);
+		void createLayout();
+		void createPool();
+		void createDefaults();
+		void writeDefaults();
+
+		BindlessIndex acquireSlot(BindlessBinding binding);
+		void releaseSlot(BindlessBinding binding, BindlessIndex index);
+		PendingWrite defaultWrite(BindlessBinding binding, BindlessIndex index) const;
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_BINDLESSTABLE_H
@@ -0,0 +1,54 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_BLOCKCOMPRESSION_H
+#define SPARKER_ENGINE_BLOCKCOMPRESSION_H
+
+#include "Utils.h"
+
+namespace SpRenderer {
+	// Every block compressed format textures can be loaded in, RendererCore picks an upload format for each
+	const std::array<VkFormat, 10> BlockCompressedFormats = {
+		VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+		VK_FORMAT_BC1_RGBA_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_SRGB_BLOCK,
+		VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK,
+		VK_FORMAT_BC4_UNORM_BLOCK,
+		VK_FORMAT_BC5_UNORM_BLOCK,
+		VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK
+	};
+
+	/*!
+	 * Bytes per 4x4 block, 0 when the format is not block compressed
+	 */
+	uint32 blockSize(VkFormat format);
+	/*!
+	 * Bytes per texel of the 8 bit per channel formats textures are stored or decoded in, 0 for anything else
+	 */
+	uint32 texelSize(VkFormat format);
+
+	/*!
+	 * Bytes of a width x height image, 0 when the format is neither block compressed nor 8 bit per channel
+	 */
+	VkDeviceSize imageSize(VkFormat format, uint32 width, uint32 height);
+
+	/*!
+	 * 8 bit per channel format with the same channels and color space, VK_FORMAT_UNDEFINED when there is none
+	 */
+	VkFormat uncompressedFormat(VkFormat format);
+	/*!
+	 * True when decodeBlocks() can turn the format into its uncompressed format. BC7 has no decoder
+	 */
+	bool canDecodeBlocks(VkFormat format);
+
+	/**
+	 * Decodes a whole mip level on the CPU, for devices that cannot sample the compressed format. Texels of
+	 * partial blocks past the right and bottom edges are dropped.
+	 *
+	 * @param blocks At least imageSize(format, width, height) bytes
+	 * @param pixels Resized to imageSize(uncompressedFormat(format), width, height)
+	 */
+	void decodeBlocks(VkFormat format, std::span<const uint8> blocks, uint32 width, uint32 height, std::vector<uint8>& pixels);
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_BLOCKCOMPRESSION_H
@@ -0,0 +1,90 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_DEVICEPROFILE_H
+#define SPARKER_ENGINE_DEVICEPROFILE_H
+
+#include "Utils.h"
+
+#define DEVICE_PROFILE_FILE_NAME "device_profile.bin"
+// Index into vkEnumeratePhysicalDevices or part of the device name, overrides SP_PREFERRED_DEVICE
+#define DEVICE_OVERRIDE_ENV "SP_DEVICE"
+
+namespace SpRenderer {
+	/**
+	 * Everything device selection and feature gating need from a physical device, apart from what depends on the
+	 * surface. Plain data so the chosen device's profile can be cached between runs.
+	 */
+	struct DeviceCapabilities {
+		// Identity, a cached profile is only used for a device and driver matching all of it
+		uint32 vendorID;
+		uint32 deviceID;
+		uint32 driverVersion;
+		uint8 pipelineCacheUUID[VK_UUID_SIZE];
+		char deviceName[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+		VkPhysicalDeviceType deviceType;
+
+		uint32 apiVersion;            // Lower of the instance's and the device's
+		uint64 deviceLocalBytes;      // Largest device local heap
+		uint32 timestampValidBits;    // Of the first graphics family, 0 without timestamps
+		uint32 optionalExtensionMask; // Bit i is OptionalDeviceExtensions[i]
+
+		VkBool32 requiredExtensions;  // Every extension passed as required
+		VkBool32 asyncCompute;        // A compute family without graphics
+		VkBool32 dedicatedTransfer;   // A transfer family without graphics or compute, the DMA engine
+		VkBool32 timelineSemaphores;
+		VkBool32 dynamicRendering;    // Vulkan 1.3 with dynamicRendering and synchronization2
+		VkBool32 descriptorIndexing;  // Everything the bindless table needs, from Vulkan 1.2 or VK_EXT_descriptor_indexing
+		VkBool32 drawIndirectCount;   // From Vulkan 1.2 or VK_KHR_draw_indirect_count
+		VkBool32 multiDrawIndirect;
+		VkBool32 drawIndirectFirstInstance;
+	};
+
+	/**
+	 *
+	 * @param optionalExtensions At most 32, their support ends up in optionalExtensionMask
+	 */
+	DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice physicalDevice,
+	                                           uint32 instanceApiVersion,
+	                                           std::span<const char* const> requiredExtensions,
+	                                           std::span<const char* const> optionalExtensions);
+
+	/**
+	 * Ranks by what the renderer can make use of: device type first, then local memory, async compute and transfer
+	 * queues, timestamps, the 1.2 and 1.3 paths and indirect draw counts.
+	 *
+	 * @return Negative when the renderer can't run on it at all
+	 */
+	int64 scoreDevice(const DeviceCapabilities& capabilities);
+
+	bool sameDevice(const DeviceCapabilities& capabilities, const VkPhysicalDeviceProperties& properties);
+
+	/*!
+	 * Key for loadDeviceProfile, covers everything queryDeviceCapabilities depends on besides the device
+	 */
+	uint64 deviceProfileConfiguration(uint32 instanceApiVersion,
+	                                  std::span<const char* const> requiredExtensions,
+	                                  std::span<const char* const> optionalExtensions);
+
+	/*!
+	 * DEVICE_OVERRIDE_ENV, else the SP_PREFERRED_DEVICE CMake option, else empty
+	 */
+	std::string preferredDevice();
+	/**
+	 *
+	 * @param preference A number matches the enumeration index, anything else part of the name, ignoring case
+	 */
+	bool matchesDevicePreference(const std::string& preference, uint32 index, const char* deviceName);
+
+	/**
+	 * Cached profile of the device picked last time. The file is keyed by configuration, which covers whatever
+	 * changes the outcome besides the device, so a new extension list or instance version starts over.
+	 *
+	 * @return False when there is none or it belongs to another configuration
+	 */
+	bool loadDeviceProfile(const std::filesystem::path& filePath, uint64 configuration, DeviceCapabilities& capabilities);
+	void saveDeviceProfile(const std::filesystem::path& filePath, uint64 configuration, const DeviceCapabilities& capabilities);
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_DEVICEPROFILE_H
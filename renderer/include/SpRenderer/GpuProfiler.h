@@ -0,0 +1,88 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_GPUPROFILER_H
+#define SPARKER_ENGINE_GPUPROFILER_H
+
+#include "Utils.h"
+#include "Profiler.h"
+
+namespace SpRenderer {
+	const uint32 MaxGpuZonesPerFrame = 128;
+
+	typedef uint32 GpuZone;
+	const GpuZone InvalidGpuZone = std::numeric_limits<GpuZone>::max();
+
+	/**
+	 * GPU zones from vkCmdWriteTimestamp pairs, one query pool per frame in flight. A frame's timestamps are read
+	 * back the next time its slot comes around, once its fence has been waited on, and handed to the Profiler.
+	 *
+	 * Ticks become nanoseconds with limits.timestampPeriod. The GPU clock is not the CPU's, so a frame's first
+	 * timestamp is placed at the CPU time the frame was submitted; zones are exact relative to each other but the
+	 * frame as a whole can sit slightly early on the CPU timeline.
+	 *
+	 * Records nothing while the Profiler is disabled. Render thread only.
+	 */
+	class GpuProfiler {
+	public:
+		/**
+		 *
+		 * @param queueFamilyIndex Family the zones are recorded on
+		 * @param timestampValidBits Of that family, 0 turns GPU zones off
+		 */
+		void init(VkDevice device,
+		          uint32 queueFamilyIndex,
+		          uint32 timestampValidBits,
+		          const VkPhysicalDeviceLimits& limits,
+		          uint32 framesInFlight);
+		/*!
+		 * The device must be idle
+		 */
+		void destroy();
+
+		/*!
+		 * False when the queue family has no timestamps, every call then does nothing
+		 */
+		bool supported() const { return mSupported; }
+
+		/*!
+		 * Reads back the zones the frame slot recorded last time and resets its queries. Call first thing in the
+		 * frame's command buffer, outside any render pass, once the frame's fence has been waited on
+		 */
+		void beginFrame(VkCommandBuffer commandBuffer, uint32 frameIndex);
+		/*!
+		 * Call right before submitting the frame's command buffer
+		 */
+		void markSubmit(uint32 frameIndex);
+
+		/**
+		 *
+		 * @param name String literal, only the pointer is kept
+		 * @return InvalidGpuZone when disabled or the frame has used up MaxGpuZonesPerFrame
+		 */
+		GpuZone beginZone(VkCommandBuffer commandBuffer, const char* name);
+		void endZone(VkCommandBuffer commandBuffer, GpuZone zone);
+
+	private:
+		struct FrameQueries {
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::vector<const char*> zoneNames; // Zone i is queries 2i and 2i + 1
+			uint64 submitNs = 0;
+			bool active = false; // Queries were reset and written this time round
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		bool mSupported = false;
+		double mTimestampPeriod = 1.0; // Nanoseconds per tick
+		uint64 mTimestampMask = 0;
+		uint32 mCurrentFrame = 0;
+
+		std::vector<FrameQueries> mFrames;
+		std::vector<uint64> mTimestamps; // Readback scratch
+
+		void collect(FrameQueries& frame);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_GPUPROFILER_H
@@ -0,0 +1,290 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_GPUSCENE_H
+#define SPARKER_ENGINE_GPUSCENE_H
+
+#include "Utils.h"
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "BindlessTable.h"
+#include "MeshFile.h"
+#include "PipelineRegistry.h"
+#include "RenderGraph.h"
+#include "Vertex.h"
+
+#include <span>
+
+namespace SpRenderer {
+	const uint32 InitialSceneObjectCapacity = 16 * 1024;
+	const uint32 InitialSceneMeshCapacity = 256;
+	// Geometry of every mesh shares one vertex and one index buffer, so all objects draw from the same bindings
+	const uint32 SceneVertexCapacity = 1024 * 1024;
+	const uint32 SceneIndexCapacity = 4 * 1024 * 1024;
+	// local_size_x of Cull.comp
+	const uint32 CullWorkgroupSize = 64;
+
+	typedef uint32 MeshHandle;
+	typedef uint32 ObjectHandle;
+	const uint32 InvalidSceneHandle = std::numeric_limits<uint32>::max();
+
+	enum IndirectDrawMode {
+		SP_INDIRECT_DRAW_COUNT,      // vkCmdDrawIndexedIndirectCount, culling compacts the visible draws and counts them
+		SP_INDIRECT_DRAW_MULTI,      // One vkCmdDrawIndexedIndirect over every object, culled ones get no instances
+		SP_INDIRECT_DRAW_SINGLE,     // A vkCmdDrawIndexedIndirect per object, devices without multiDrawIndirect
+		SP_INDIRECT_DRAW_UNSUPPORTED // No drawIndirectFirstInstance, objects are kept but never drawn
+	};
+
+	struct SceneObject {
+		MeshHandle mesh = InvalidSceneHandle;
+		mat4 transform = mat4(1.0f);
+		uint32 color = 0xFFFFFFFF; // RGBA8 tint, R in the lowest byte
+		uint32 texture = 0;        // Index into the bindless texture table, 0 is plain white
+	};
+
+	// std430, Cull.comp and Mesh.vert declare the same
+	struct GpuObject {
+		mat4 transform; // Includes the mesh's position scale
+		uint32 mesh;
+		uint32 texture;
+		uint32 color;
+		uint32 padding;
+	};
+	static_assert(sizeof(GpuObject) == 80);
+
+	// std430, Cull.comp declares the same
+	struct GpuMesh {
+		vec4 boundingSphere; // Center and radius in packed position units
+		uint32 indexCount;   // 0 until the geometry is uploaded, culling skips the mesh's objects until then
+		uint32 firstIndex;
+		int32 vertexOffset;
+		uint32 padding;
+	};
+	static_assert(sizeof(GpuMesh) == 32);
+
+	struct GpuSceneStats {
+		uint32 meshCount = 0;
+		uint32 objectCount = 0;
+		uint32 objectWrites = 0; // Objects the last prepare() wrote, only the ones changed since the slot was last used
+		double prepareMs = 0.0;
+	};
+
+	/**
+	 * Meshes and objects drawn without the CPU touching each object every frame. Transforms and mesh bounds live in
+	 * storage buffers, a compute pass tests every object's bounding sphere against the camera frustum and writes
+	 * one VkDrawIndexedIndirectCommand per visible object, and the main pass draws them all with a single
+	 * vkCmdDrawIndexedIndirectCount. The draw's first instance is the object index, which is how Mesh.vert finds
+	 * the object's transform.
+	 *
+	 * Each frame in flight has its own object buffer, and prepare() only rewrites the objects changed since that
+	 * buffer was last used, so a static scene costs the CPU the same at any size.
+	 *
+	 * Render thread only.
+	 */
+	class GpuScene {
+	public:
+		// Handed to the main pass, which has to read them as SP_GRAPH_ACCESS_INDIRECT
+		struct CullOutputs {
+			GraphResource drawCommands = InvalidGraphResource;
+			GraphResource drawCount = InvalidGraphResource; // Only with SP_INDIRECT_DRAW_COUNT
+		};
+
+		/**
+		 *
+		 * @param drawIndexedIndirectCount Core or KHR entry point, only used with SP_INDIRECT_DRAW_COUNT
+		 * @param maxDrawIndirectCount VkPhysicalDeviceLimits::maxDrawIndirectCount. SP_INDIRECT_DRAW_MULTI splits its
+		 * draws to stay under it, with SP_INDIRECT_DRAW_COUNT it caps the object count
+		 */
+		void init(VkDevice device,
+		          MemoryAllocator& allocator,
+		          UploadManager& uploadManager,
+		          BindlessTable& bindlessTable,
+		          uint32 framesInFlight,
+		          IndirectDrawMode drawMode,
+		          PFN_vkCmdDrawIndexedIndirectCount drawIndexedIndirectCount,
+		          uint32 maxDrawIndirectCount);
+		/*!
+		 * The device must be idle
+		 */
+		void destroy();
+
+		/**
+		 *
+		 * @param cullLayout Needs a 120 byte compute stage push constant range and the bindless table as set 1
+		 * @param meshLayout Needs a 68 byte vertex stage push constant range and the bindless table as set 1
+		 * @param registry Has to outlive the scene, nothing is drawn until the mesh pipeline has compiled
+		 */
+		void setPipelines(VkPipeline cullPipeline,
+		                  VkPipelineLayout cullLayout,
+		                  const PipelineRegistry& registry,
+		                  PipelineKey meshPipeline,
+		                  VkPipelineLayout meshLayout);
+
+		/*!
+		 * Packs the vertices and uploads them, objects using the mesh show up once the upload is done
+		 */
+		MeshHandle addMesh(std::span<const Vertex> vertices, std::span<const uint32> indices);
+		/**
+		 *
+		 * @param positionScale What the positions were divided by when packing
+		 * @param boundingSphere Center and radius in mesh space, before packing
+		 */
+		MeshHandle addMesh(std::span<const VertexPacked> vertices,
+		                   std::span<const uint32> indices,
+		                   float positionScale,
+		                   vec4 boundingSphere);
+		/**
+		 * Every mesh of a cooked file, see MeshFile.h. The vertices and indices are copied from the file straight into
+		 * staging with one upload each, so the file only has to stay mapped for the call
+		 *
+		 * @return Handles in the file's mesh order
+		 */
+		std::vector<MeshHandle> addMeshes(const MeshFileView& file);
+
+		/*!
+		 * Fatal past getMaxObjects()
+		 */
+		ObjectHandle addObject(const SceneObject& object);
+		void updateObject(ObjectHandle handle, const SceneObject& object);
+		void setTransform(ObjectHandle handle, const mat4& transform);
+		void removeObject(ObjectHandle handle);
+
+		/*!
+		 * World space to clip space, culling extracts the frustum from it
+		 */
+		void setCamera(const mat4& viewProjection) { mViewProjection = viewProjection; }
+
+		/*!
+		 * Writes the frame's object and mesh buffers. The frame's fence must have been waited on, and the bindless
+		 * table committed after it
+		 */
+		void prepare(uint32 frameIndex, uint64 frameNumber);
+		/*!
+		 * Adds the culling pass for the frame, nothing when the scene is empty
+		 */
+		CullOutputs addCullPass(RenderGraph& graph, uint32 frameIndex) const;
+		/*!
+		 * Records the frame's draws. Call inside the pass reading the cull outputs, with viewport and scissor set
+		 */
+		void record(VkCommandBuffer commandBuffer, uint32 frameIndex) const;
+
+		/*!
+		 * Whether record() has anything to draw for the frame
+		 */
+		bool hasDraws(uint32 frameIndex) const;
+
+		IndirectDrawMode getDrawMode() const { return mDrawMode; }
+		uint32 getMaxObjects() const { return mMaxObjects; }
+		const GpuSceneStats& getStats() const { return mStats; }
+
+		/*!
+		 * Left, right, bottom, top, near and far, normalized and facing inwards. Depth in [0, 1]
+		 */
+		static std::array<vec4, 6> frustumPlanes(const mat4& viewProjection);
+		/*!
+		 * Center of the bounds and the farthest vertex from it, not the tightest sphere but close for most meshes
+		 */
+		static vec4 boundingSphere(std::span<const Vertex> vertices);
+
+	private:
+		struct SceneBuffer {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation;
+			BindlessIndex index = DefaultBindlessIndex;
+		};
+
+		struct FrameBuffers {
+			SceneBuffer objects;  // Host visible
+			SceneBuffer meshes;   // Host visible
+			SceneBuffer commands; // Device local, written by culling
+			SceneBuffer count;    // Device local, written by culling
+			uint32 objectCapacity = 0;
+			uint32 meshCapacity = 0;
+
+			uint32 objectCount = 0; // Objects prepared for the frame
+			uint64 meshVersion = 0;
+			std::vector<uint32> dirtyObjects; // Slots changed since the buffer was last written
+		};
+
+		struct RetiredBuffer {
+			SceneBuffer buffer;
+			uint64 retireFrame;
+		};
+
+		struct PendingMesh {
+			MeshHandle mesh;
+			GpuMesh resident;
+			UploadTicket ticket;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		MemoryAllocator* mAllocator = nullptr;
+		UploadManager* mUploadManager = nullptr;
+		BindlessTable* mBindlessTable = nullptr;
+		uint32 mFramesInFlight = 0;
+		uint64 mFrameNumber = 0;
+
+		IndirectDrawMode mDrawMode = SP_INDIRECT_DRAW_UNSUPPORTED;
+		PFN_vkCmdDrawIndexedIndirectCount mDrawIndexedIndirectCount = nullptr;
+		uint32 mMaxDrawIndirectCount = 0;
+		uint32 mMaxObjects = std::numeric_limits<uint32>::max();
+
+		VkPipeline mCullPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout mCullLayout = VK_NULL_HANDLE;
+		const PipelineRegistry* mRegistry = nullptr;
+		PipelineKey mMeshPipeline = 0;
+		VkPipelineLayout mMeshLayout = VK_NULL_HANDLE;
+
+		// Geometry, bump allocated
+		VkBuffer mVertexBuffer = VK_NULL_HANDLE;
+		Allocation mVertexAllocation;
+		VkBuffer mIndexBuffer = VK_NULL_HANDLE;
+		Allocation mIndexAllocation;
+		uint32 mVertexCount = 0;
+		uint32 mIndexCount = 0;
+
+		std::vector<GpuMesh> mMeshes;
+		std::vector<PendingMesh> mPendingMeshes;
+		std::vector<float> mMeshScales;
+		uint64 mMeshVersion = 1; // Bumped whenever mMeshes changes
+
+		// Dense, removing swaps the last object into the gap
+		std::vector<GpuObject> mObjects;
+		std::vector<ObjectHandle> mObjectHandles; // Slot to handle
+		std::vector<uint8> mObjectDirtyFrames;    // Slot to a bit per frame that still has it in its dirty list
+		std::vector<uint32> mHandleSlots;         // Handle to slot, InvalidSceneHandle when free
+		std::vector<ObjectHandle> mFreeHandles;
+
+		std::vector<FrameBuffers> mFrames;
+		std::vector<RetiredBuffer> mRetired;
+
+		mat4 mViewProjection = mat4(1.0f);
+
+		GpuSceneStats mStats;
+
+		void createGeometryBuffers();
+		void createBuffer(SceneBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+		/*!
+		 * Keeps it alive and registered until no frame in flight can use it
+		 */
+		void retireBuffer(SceneBuffer& buffer);
+		void releaseRetired(bool force);
+
+		/*!
+		 * Uploads to the end of the geometry buffers, fatal when they are full
+		 */
+		UploadTicket uploadGeometry(std::span<const VertexPacked> vertices, std::span<const uint32> indices,
+		                            uint32& firstVertex, uint32& firstIndex);
+		MeshHandle addPendingMesh(const GpuMesh& resident, float positionScale, UploadTicket ticket);
+		void updateResidentMeshes();
+		void reserveObjects(FrameBuffers& frame, uint32 objectCount);
+		void reserveMeshes(FrameBuffers& frame, uint32 meshCount);
+
+		GpuObject packObject(const SceneObject& object) const;
+		uint32 slotOf(ObjectHandle handle) const;
+		void markDirty(uint32 slot);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_GPUSCENE_H
@@ -0,0 +1,144 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_JOBSYSTEM_H
+#define SPARKER_ENGINE_JOBSYSTEM_H
+
+#include "Utils.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace SpRenderer {
+	// Index of the thread that called JobSystem::init, the only one main thread jobs run on
+	const uint32 MainJobThread = 0;
+	// threadIndex() of threads the job system does not know about
+	const uint32 InvalidJobThread = std::numeric_limits<uint32>::max();
+
+	typedef std::function<void()> Job;
+	typedef std::function<void(uint32 begin, uint32 end)> RangeJob;
+
+	/**
+	 * Counts jobs that have not finished yet. Jobs can depend on a counter and wait() blocks on one. A counter has
+	 * to outlive every job counting on or depending on it, and can be reused once done.
+	 */
+	class JobCounter {
+	public:
+		bool done() const { return mCount.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32> mCount = 0;
+	};
+
+	struct JobStats {
+		uint32 threadCount = 0;
+		uint64 jobCount = 0;      // Finished since init
+		uint64 stealCount = 0;    // Taken from another thread's queue
+		uint64 deferredCount = 0; // Held back until their dependency was done
+	};
+
+	/**
+	 * Work stealing job scheduler. Each thread owns a queue it pushes to and pops from the back of, idle threads
+	 * steal from the front of the others' so the oldest, usually largest, work moves. Workers sleep when every queue
+	 * is empty. Jobs depending on a counter wait outside the queues until it is done.
+	 *
+	 * The thread calling init() is the main thread. Jobs that have to run on it, e.g. anything touching SDL, go
+	 * through runOnMainThread() and run in pumpMainThread() or while it waits.
+	 */
+	class JobSystem {
+	public:
+		/**
+		 *
+		 * @param threadCount Threads including the main thread, 0 uses one per hardware thread
+		 */
+		void init(uint32 threadCount = 0);
+		/*!
+		 * Joins the workers. Every job must have been waited on
+		 */
+		void destroy();
+
+		/**
+		 *
+		 * @param counter Incremented now and decremented once the job has run
+		 * @param dependency Job only starts once it is done
+		 */
+		void run(Job job, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr);
+		void runOnMainThread(Job job, JobCounter* counter = nullptr);
+
+		/**
+		 * Splits [0, count) into batchSize ranges and runs a job for each
+		 */
+		void parallelFor(uint32 count, uint32 batchSize, RangeJob job, JobCounter& counter);
+
+		/*!
+		 * Runs other jobs until the counter is done. Threads the job system does not know about only sleep
+		 */
+		void wait(const JobCounter& counter);
+		/*!
+		 * Runs every queued main thread job. Main thread only
+		 */
+		void pumpMainThread();
+
+		uint32 getThreadCount() const { return static_cast<uint32>(mQueues.size()); }
+		/*!
+		 * [0, getThreadCount()) on job system threads, stable for the thread's lifetime. For picking per thread resources
+		 */
+		static uint32 threadIndex();
+
+		JobStats getStats() const;
+
+	private:
+		struct QueuedJob {
+			Job job;
+			JobCounter* counter = nullptr;
+		};
+
+		struct DeferredJob {
+			QueuedJob job;
+			const JobCounter* dependency;
+		};
+
+		struct WorkQueue {
+			std::mutex mutex;
+			std::deque<QueuedJob> jobs;
+		};
+
+		std::vector<std::unique_ptr<WorkQueue>> mQueues;
+		std::vector<std::thread> mWorkers;
+		std::atomic<uint32> mNextQueue = 0; // For threads outside the job system
+
+		std::mutex mSleepMutex;
+		std::condition_variable mWakeCondition;
+		std::atomic<int32> mQueuedCount = 0;
+		bool mStopping = false;
+
+		std::mutex mDeferredMutex;
+		std::vector<DeferredJob> mDeferred;
+		std::atomic<uint32> mDeferredCount = 0;
+
+		std::mutex mMainMutex;
+		std::deque<QueuedJob> mMainJobs;
+
+		std::atomic<uint64> mJobCount = 0;
+		std::atomic<uint64> mStealCount = 0;
+		std::atomic<uint64> mTotalDeferredCount = 0;
+
+		void workerLoop(uint32 index);
+
+		void push(QueuedJob job);
+		bool pop(uint32 index, QueuedJob& job);
+		bool popMainThread(QueuedJob& job);
+		void execute(QueuedJob& job);
+		void releaseDeferred();
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_JOBSYSTEM_H
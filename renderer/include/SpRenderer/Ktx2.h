@@ -0,0 +1,34 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_KTX2_H
+#define SPARKER_ENGINE_KTX2_H
+
+#include "Utils.h"
+
+namespace SpRenderer {
+	struct Ktx2Level {
+		uint32 width;
+		uint32 height;
+		std::span<const uint8> data; // Points into the file
+	};
+
+	struct Ktx2Texture {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32 width = 0;
+		uint32 height = 0;
+		std::vector<Ktx2Level> levels; // Level 0 is the full size image, every level after it halves
+	};
+
+	/**
+	 * Reads the header and level index of a KTX2 container without copying any image data. Only 2D textures with
+	 * a single layer and face, no supercompression and a block compressed or 8 bit per channel format are accepted.
+	 *
+	 * @param error Why the file was rejected
+	 * @return False when the file is malformed or uses something unsupported
+	 */
+	bool parseKtx2(std::span<const uint8> file, Ktx2Texture& texture, std::string& error);
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_KTX2_H
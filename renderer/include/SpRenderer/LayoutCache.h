@@ -0,0 +1,100 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_LAYOUTCACHE_H
+#define SPARKER_ENGINE_LAYOUTCACHE_H
+
+#include "Utils.h"
+#include "ShaderReflection.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace SpRenderer {
+	// A set layout made elsewhere that replaces the reflected one, for sets like the bindless table that need flags
+	// reflection can't know about
+	struct FixedSetLayout {
+		uint32 set;
+		VkDescriptorSetLayout layout;
+	};
+
+	struct LayoutCacheStats {
+		uint32 setLayoutCount = 0;
+		uint32 pipelineLayoutCount = 0;
+		uint32 hits = 0;   // Requests answered with an existing layout
+		uint32 misses = 0;
+	};
+
+	/**
+	 * Creates descriptor set layouts and pipeline layouts, handing out the same handle for identical create infos.
+	 * Pipelines sharing a pipeline layout stay compatible for every set, so descriptor sets bound before a pipeline
+	 * switch stay bound. Layouts live until destroy(), callers never destroy them.
+	 *
+	 * Thread safe. Immutable samplers are not supported.
+	 */
+	class LayoutCache {
+	public:
+		void init(VkDevice device);
+		void destroy();
+
+		/**
+		 *
+		 * @param bindings Order does not matter, they are sorted by binding before hashing
+		 * @param bindingFlags Empty or one per binding, in the same order as bindings
+		 */
+		VkDescriptorSetLayout getSetLayout(std::span<const VkDescriptorSetLayoutBinding> bindings,
+		                                   VkDescriptorSetLayoutCreateFlags flags = 0,
+		                                   std::span<const VkDescriptorBindingFlags> bindingFlags = {});
+
+		VkPipelineLayout getPipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts,
+		                                   std::span<const VkPushConstantRange> pushConstantRanges);
+
+		/**
+		 * Set layouts for every set up to the highest one the shaders use, sets they skip get an empty layout.
+		 *
+		 * @param reflection Usually every stage of a pipeline merged, or of several pipelines that should share a layout
+		 * @param fixedSetLayouts Used instead of the reflected bindings of their set. Fatal when a reflected set has an
+		 *                        unsized array and no fixed layout, since its size is not known
+		 */
+		VkPipelineLayout getPipelineLayout(const ShaderReflection& reflection, std::span<const FixedSetLayout> fixedSetLayouts = {});
+
+		/*!
+		 * The set layout getPipelineLayout(reflection, fixedSetLayouts) used for set
+		 */
+		VkDescriptorSetLayout getSetLayout(const ShaderReflection& reflection, uint32 set, std::span<const FixedSetLayout> fixedSetLayouts = {});
+
+		LayoutCacheStats getStats();
+		void logStats();
+
+	private:
+		struct SetLayoutKey {
+			VkDescriptorSetLayoutCreateFlags flags = 0;
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			std::vector<VkDescriptorBindingFlags> bindingFlags;
+
+			bool operator==(const SetLayoutKey& other) const;
+		};
+
+		struct PipelineLayoutKey {
+			std::vector<VkDescriptorSetLayout> setLayouts;
+			std::vector<VkPushConstantRange> pushConstantRanges;
+
+			bool operator==(const PipelineLayoutKey& other) const;
+		};
+
+		struct KeyHash {
+			size_t operator()(const SetLayoutKey& key) const;
+			size_t operator()(const PipelineLayoutKey& key) const;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+
+		std::mutex mMutex;
+		std::unordered_map<SetLayoutKey, VkDescriptorSetLayout, KeyHash> mSetLayouts;
+		std::unordered_map<PipelineLayoutKey, VkPipelineLayout, KeyHash> mPipelineLayouts;
+		LayoutCacheStats mStats;
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_LAYOUTCACHE_H
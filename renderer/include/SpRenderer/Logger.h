@@ -0,0 +1,187 @@
+//
+// Created by robsc on 11/29/25.
+//
+
+#ifndef SPARKER_ENGINE_LOGGER_H
+#define SPARKER_ENGINE_LOGGER_H
+
+#include "Utils.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace SpConsole {
+	const uint64 LogRingSize = 256 * 1024;   // Bytes per thread, power of two
+	const uint32 LogMaxMessageLength = 4096; // Longer messages are cut off
+	const std::chrono::milliseconds LogDrainInterval(2);
+
+	const uint64 LogRecordAlignment = 16;
+
+	const uint32 LogFileMagic = 0x474C5053; // 'SPLG'
+	const uint32 LogFileVersion = 1;
+
+	enum LogRecordFlags : uint8 {
+		SP_LOG_RECORD_PLAIN = 1 << 0,     // Printed without a severity prefix
+		SP_LOG_RECORD_TRUNCATED = 1 << 1,
+		SP_LOG_RECORD_PADDING = 1 << 2,   // Fills the end of a ring so no record wraps, never written to the file
+	};
+
+	/**
+	 * Layout of a record both in the thread rings and in the binary log. Followed by length bytes of UTF-8 text
+	 * with no terminator, then padded so the next record starts on a 16 byte boundary.
+	 */
+	struct LogRecordHeader {
+		uint64 timestampNs; // Since LogFileHeader::startTimeNs
+		uint32 threadId;    // Sequential, in the order threads first logged
+		uint16 length;
+		uint8 severity;     // MessageSeverity
+		uint8 flags;        // LogRecordFlags
+	};
+
+	/*!
+	 * Bytes a record of length text bytes takes up in a ring, header and padding included
+	 */
+	inline uint64 logRecordSize(size_t length) {
+		return (sizeof(LogRecordHeader) + length + LogRecordAlignment - 1) & ~(LogRecordAlignment - 1);
+	}
+
+	struct LogFileHeader {
+		uint32 magic;
+		uint32 version;
+		int64 startTimeNs; // System clock, since the epoch
+	};
+
+	struct LogStats {
+		uint64 writtenCount = 0;
+		uint64 stallCount = 0; // Writes that found their thread's ring full and had to drain it themselves
+		uint32 threadCount = 0;
+	};
+
+	/**
+	 * Single producer, single consumer byte ring. The owning thread pushes, whoever holds the logger's drain lock
+	 * pops. Positions only ever grow, the ring index is the position masked by the size.
+	 */
+	class LogRing {
+	public:
+		explicit LogRing(uint32 threadId);
+
+		/*!
+		 * Producer only. Returns false without blocking when there is no room, the message is truncated to LogMaxMessageLength
+		 */
+		bool push(uint64 timestampNs, uint8 severity, uint8 flags, std::string_view prefix, std::string_view message);
+
+		/**
+		 * Consumer only. Calls consume(const LogRecordHeader&, std::string_view text) for every record pushed so far.
+		 *
+		 * @return Number of records consumed
+		 */
+		template<typename Consumer>
+		uint32 drain(Consumer&& consume);
+
+		uint32 threadId() const { return mThreadId; }
+		bool empty() const;
+
+		std::atomic<bool> retired{false}; // Set when the owning thread exits
+
+	private:
+		alignas(64) std::atomic<uint64> mHead{0};
+		alignas(64) std::atomic<uint64> mTail{0};
+
+		uint32 mThreadId;
+		std::unique_ptr<char[]> mData;
+	};
+
+	template<typename Consumer>
+	uint32 LogRing::drain(Consumer&& consume) {
+		uint64 head = mHead.load(std::memory_order_acquire);
+		uint64 tail = mTail.load(std::memory_order_relaxed);
+		uint32 count = 0;
+
+		while (tail != head) {
+			uint64 offset = tail & (LogRingSize - 1);
+
+			LogRecordHeader header{};
+			std::memcpy(&header, mData.get() + offset, sizeof(header));
+
+			if (header.flags & SP_LOG_RECORD_PADDING) {
+				tail += LogRingSize - offset;
+				continue;
+			}
+
+			consume(header, std::string_view(mData.get() + offset + sizeof(header), header.length));
+			tail += logRecordSize(header.length);
+			count++;
+		}
+
+		mTail.store(tail, std::memory_order_release);
+		return count;
+	}
+
+	/**
+	 * Backend behind SpConsole::Write. Callers copy their message into a ring owned by their thread, which costs a
+	 * memcpy and two atomics. A background thread drains every ring every LogDrainInterval, orders the records by
+	 * time, prints them with a single write and appends them to the binary log in RENDERER_DATA_DIR/logs.
+	 *
+	 * Messages are never dropped, a writer that finds its ring full drains all rings itself before retrying.
+	 */
+	class Logger {
+	public:
+		static Logger& get();
+
+		Logger(const Logger&) = delete;
+		Logger& operator=(const Logger&) = delete;
+
+		void write(MessageSeverity severity, uint8 flags, std::string_view prefix, std::string_view message);
+
+		/*!
+		 * Drains every ring on the calling thread, so whatever was written before the call is printed when it returns
+		 */
+		void flush();
+
+		LogStats getStats();
+
+	private:
+		struct DrainedRecord {
+			LogRecordHeader header;
+			size_t textOffset;
+		};
+
+		std::chrono::steady_clock::time_point mStartTime;
+
+		std::mutex mRingMutex;
+		std::vector<std::shared_ptr<LogRing>> mRings;
+		uint32 mNextThreadId = 0;
+
+		std::mutex mDrainMutex;
+		std::vector<DrainedRecord> mDrained; // Reused between drains
+		std::vector<char> mDrainedText;
+		std::string mConsoleText;
+		std::vector<char> mFileData;
+		std::FILE* mLogFile = nullptr;
+		uint64 mWrittenCount = 0;
+
+		std::atomic<uint64> mStallCount{0};
+
+		std::mutex mWakeMutex;
+		std::condition_variable mWake;
+		bool mStopping = false;
+		std::thread mDrainThread;
+
+		Logger();
+		~Logger();
+
+		LogRing& threadRing();
+		void openLogFile();
+		void drainLoop();
+		/*!
+		 * Caller holds mDrainMutex
+		 */
+		void drainAll();
+	};
+}
+
+#endif //SPARKER_ENGINE_LOGGER_H
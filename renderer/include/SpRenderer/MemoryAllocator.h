@@ -0,0 +1,234 @@
+//
+// Created by robsc on 11/22/25.
+//
+
+#ifndef SPARKER_ENGINE_MEMORYALLOCATOR_H
+#define SPARKER_ENGINE_MEMORYALLOCATOR_H
+
+#include "Utils.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace SpRenderer {
+	const VkDeviceSize PreferredBlockSize = 64ull * 1024 * 1024;
+	const VkDeviceSize SmallHeapBlockSize = 16ull * 1024 * 1024;
+	const VkDeviceSize SmallHeapLimit = 1024ull * 1024 * 1024;
+	const VkDeviceSize MinBuddySize = 256;
+
+	// Render targets at least this big get their own VkDeviceMemory so resizing them never fragments the pools
+	const VkDeviceSize DedicatedRenderTargetSize = 8ull * 1024 * 1024;
+
+	enum AllocationStrategy {
+		SP_ALLOCATION_DEFAULT,   // Sub-allocated from a pooled block, dedicated when too large for a block
+		SP_ALLOCATION_DEDICATED, // Always its own vkAllocateMemory
+	};
+
+	enum AllocationKind : uint8 {
+		SP_ALLOCATION_KIND_NONE,
+		SP_ALLOCATION_KIND_POOLED,
+		SP_ALLOCATION_KIND_DEDICATED,
+		SP_ALLOCATION_KIND_LINEAR
+	};
+
+	struct AllocationCreateInfo {
+		VkMemoryPropertyFlags requiredFlags = 0;
+		VkMemoryPropertyFlags preferredFlags = 0;
+		AllocationStrategy strategy = SP_ALLOCATION_DEFAULT;
+	};
+
+	struct Allocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mappedData = nullptr;
+
+		uint32 memoryTypeIndex = 0;
+		uint32 blockIndex = 0;
+		uint8 poolIndex = 0;
+		AllocationKind kind = SP_ALLOCATION_KIND_NONE;
+	};
+
+	struct AllocatorStats {
+		uint32 blockCount = 0;
+		uint32 dedicatedCount = 0;
+		uint32 linearPoolCount = 0;
+		uint32 allocationCount = 0;
+		uint32 deviceMemoryCount = 0; // Counts against maxMemoryAllocationCount
+
+		VkDeviceSize reservedBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize freeBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+
+		// 0 when all free memory in the pools is one contiguous range, approaches 1 as it splinters
+		float fragmentation = 0.0f;
+	};
+
+	/**
+	 * Power of two buddy sub-allocator over a range of offsets. Holds no Vulkan objects, so it can be used and
+	 * measured on its own.
+	 */
+	class BuddyAllocator {
+	public:
+		/**
+		 *
+		 * @param size Rounded up to a power of two
+		 * @param minBlockSize Smallest block handed out, rounded up to a power of two
+		 */
+		BuddyAllocator(VkDeviceSize size, VkDeviceSize minBlockSize);
+
+		bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+		void free(VkDeviceSize offset);
+
+		VkDeviceSize size() const { return mSize; }
+		VkDeviceSize usedBytes() const { return mRequestedBytes; }
+		VkDeviceSize reservedBytes() const { return mAllocatedBytes; }
+		VkDeviceSize freeBytes() const { return mSize - mAllocatedBytes; }
+		VkDeviceSize largestFreeBlock() const;
+		uint32 allocationCount() const { return static_cast<uint32>(mAllocations.size()); }
+		bool empty() const { return mAllocations.empty(); }
+
+		static VkDeviceSize nextPowerOfTwo(VkDeviceSize value);
+
+	private:
+		struct BuddyAllocation {
+			uint32 level;
+			VkDeviceSize requestedSize;
+		};
+
+		VkDeviceSize mSize;
+		VkDeviceSize mMinBlockSize;
+		uint32 mLevelCount;
+
+		// Level 0 is the whole range, every level down halves the block size
+		std::vector<std::set<VkDeviceSize>> mFreeLists;
+		std::unordered_map<VkDeviceSize, BuddyAllocation> mAllocations;
+
+		VkDeviceSize mAllocatedBytes = 0;
+		VkDeviceSize mRequestedBytes = 0;
+
+		uint32 levelForSize(VkDeviceSize size) const;
+	};
+
+	/**
+	 * Bump allocator over a single block for data that lives at most a frame. Individual frees are no-ops,
+	 * the whole pool is recycled with reset().
+	 */
+	class LinearPool {
+	public:
+		bool allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation);
+		void reset();
+
+		VkDeviceSize capacity() const { return mSize; }
+		VkDeviceSize usedBytes() const { return mHead; }
+
+	private:
+		friend class MemoryAllocator;
+
+		VkDeviceMemory mMemory = VK_NULL_HANDLE;
+		void* mMappedData = nullptr;
+		uint32 mMemoryTypeIndex = 0;
+		uint32 mPoolIndex = 0;
+
+		VkDeviceSize mSize = 0;
+		VkDeviceSize mHead = 0;
+	};
+
+	class MemoryAllocator {
+	public:
+		void init(VkPhysicalDevice physicalDevice, VkDevice device);
+		void destroy();
+
+		void createImage(const VkImageCreateInfo& imageCreateInfo,
+		                 const AllocationCreateInfo& allocationInfo,
+		                 VkImage& image,
+		                 Allocation& allocation);
+		void destroyImage(VkImage image, Allocation& allocation);
+		/**
+		 * Memory for optimal tiling images that are bound by hand, for example several images aliasing one range.
+		 * Released with free().
+		 */
+		Allocation allocateImageMemory(const VkMemoryRequirements& requirements, const AllocationCreateInfo& allocationInfo);
+
+		void createBuffer(const VkBufferCreateInfo& bufferCreateInfo,
+		                  const AllocationCreateInfo& allocationInfo,
+		                  VkBuffer& buffer,
+		                  Allocation& allocation);
+		void destroyBuffer(VkBuffer buffer, Allocation& allocation);
+
+		/**
+		 * Linear pools are persistently mapped when host visible. They are owned by the allocator and destroyed with it.
+		 */
+		LinearPool* createLinearPool(VkDeviceSize size, const AllocationCreateInfo& allocationInfo);
+		void destroyLinearPool(LinearPool* pool);
+
+		void free(Allocation& allocation);
+
+		/*!
+		 * No-op for host coherent memory
+		 */
+		void flush(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+		/*!
+		 * Makes device writes visible to mapped reads. No-op for host coherent memory
+		 */
+		void invalidate(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		AllocatorStats getStats();
+		void logStats();
+
+		uint32 findMemoryTypeIndex(uint32 typeFilter, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags) const;
+
+	private:
+		/*!
+		 * Range covering the allocation's bytes, widened to nonCoherentAtomSize. False for host coherent memory
+		 */
+		bool mappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange& range) const;
+
+		enum ResourceType {
+			SP_RESOURCE_LINEAR,  // Buffers and linear images
+			SP_RESOURCE_OPTIMAL, // Optimal tiling images
+			SP_RESOURCE_TYPE_COUNT
+		};
+
+		struct MemoryBlock {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			void* mappedData = nullptr;
+			std::unique_ptr<BuddyAllocator> buddy;
+		};
+
+		// Linear and optimal resources never share a block, so bufferImageGranularity never has to be padded for
+		struct MemoryPool {
+			uint32 memoryTypeIndex = 0;
+			VkDeviceSize blockSize = 0;
+			std::vector<MemoryBlock> blocks;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties mMemoryProperties{};
+		VkDeviceSize mNonCoherentAtomSize = 1;
+		uint32 mMaxAllocationCount = 0;
+
+		std::mutex mMutex;
+		std::vector<MemoryPool> mPools; // memoryTypeIndex * SP_RESOURCE_TYPE_COUNT + ResourceType
+		std::vector<std::unique_ptr<LinearPool>> mLinearPools;
+
+		uint32 mDeviceMemoryCount = 0;
+		uint32 mDedicatedCount = 0;
+		VkDeviceSize mDedicatedBytes = 0;
+
+		Allocation allocate(const VkMemoryRequirements& requirements,
+		                    const AllocationCreateInfo& allocationInfo,
+		                    ResourceType resourceType);
+		bool allocateDedicated(VkDeviceSize size, uint32 memoryTypeIndex, Allocation& allocation);
+		bool allocateBlock(MemoryPool& pool, MemoryBlock& block);
+		VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32 memoryTypeIndex);
+		void* mapIfHostVisible(VkDeviceMemory memory, uint32 memoryTypeIndex);
+		void freeDeviceMemory(VkDeviceMemory memory);
+
+		VkDeviceSize blockSizeForType(uint32 memoryTypeIndex) const;
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_MEMORYALLOCATOR_H
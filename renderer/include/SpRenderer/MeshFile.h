@@ -0,0 +1,104 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_MESHFILE_H
+#define SPARKER_ENGINE_MESHFILE_H
+
+#include "Utils.h"
+#include "Vertex.h"
+
+#define MESH_FILE_EXTENSION ".spmesh"
+
+/*
+ * Cooked meshes, written by SparkerMeshCook. Everything in the file is in the layout the GPU reads, so loading one
+ * is mapping it, checking the header and handing the mapped sections to the upload manager.
+ *
+ *   MeshFileHeader
+ *   MeshFileMesh[meshCount]
+ *   MeshFileMeshlet[meshletCount]
+ *   VertexPacked[vertexCount]
+ *   uint32[indexCount]
+ *
+ * Sections start at MeshFileAlignment, little endian throughout.
+ */
+
+namespace SpRenderer {
+	// 'SPMH'
+	const uint32 MeshFileMagic = 0x484D5053;
+	const uint32 MeshFileVersion = 1;
+	const uint32 MeshFileAlignment = 16;
+
+	// Meshlet limits the cooker builds to, the usual mesh shader sizes
+	const uint32 MaxMeshletVertices = 64;
+	const uint32 MaxMeshletTriangles = 124;
+
+	const uint32 MeshNameSize = 48;
+
+	struct MeshFileHeader {
+		uint32 magic;
+		uint32 version;
+		uint32 meshCount;
+		uint32 meshletCount;
+		uint32 vertexCount;
+		uint32 indexCount;
+		uint64 meshOffset;    // Byte offsets from the start of the file
+		uint64 meshletOffset;
+		uint64 vertexOffset;
+		uint64 indexOffset;
+		uint64 fileSize;
+	};
+	static_assert(sizeof(MeshFileHeader) == 64);
+
+	struct MeshFileMesh {
+		vec4 boundingSphere; // Mesh space, before packing
+		float positionScale; // What the positions were divided by when packing
+		uint32 firstVertex;
+		uint32 vertexCount;
+		uint32 firstIndex;   // Indices are relative to firstVertex
+		uint32 indexCount;
+		uint32 firstMeshlet;
+		uint32 meshletCount;
+		uint32 padding;
+		char name[MeshNameSize]; // Null terminated
+	};
+	static_assert(sizeof(MeshFileMesh) == 96);
+
+	/*!
+	 * A contiguous run of the mesh's indices touching at most MaxMeshletVertices vertices, so it can be culled and
+	 * drawn as one indexed draw as well as by a mesh shader
+	 */
+	struct MeshFileMeshlet {
+		vec4 boundingSphere; // Mesh space
+		// Average facing in xyz and a cosine cutoff in w. Every triangle faces away from a camera at p when
+		// dot(center - p, axis) >= w * length(center - p) + radius
+		vec4 cone;
+		uint32 firstIndex;   // Relative to the mesh's firstIndex
+		uint32 triangleCount;
+		uint32 vertexCount;
+		uint32 padding;
+	};
+	static_assert(sizeof(MeshFileMeshlet) == 48);
+
+	/*!
+	 * Points into the file, which has to stay mapped while it is used
+	 */
+	struct MeshFileView {
+		std::span<const MeshFileMesh> meshes;
+		std::span<const MeshFileMeshlet> meshlets;
+		std::span<const VertexPacked> vertices;
+		std::span<const uint32> indices;
+	};
+
+	/**
+	 * Checks the header and every mesh's ranges against the file, without looking at the vertices or indices
+	 * themselves. Costs the same for any file size.
+	 *
+	 * @param file Aligned to at least MeshFileAlignment, which a mapped file always is
+	 * @param error Why the file was rejected
+	 * @return False when the file is malformed, truncated or from another version
+	 */
+	bool parseMeshFile(std::span<const uint8> file, MeshFileView& view, std::string& error);
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_MESHFILE_H
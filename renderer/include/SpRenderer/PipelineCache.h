@@ -0,0 +1,94 @@
+//
+// Created by robsc on 11/26/25.
+//
+
+#ifndef SPARKER_ENGINE_PIPELINECACHE_H
+#define SPARKER_ENGINE_PIPELINECACHE_H
+
+#include "Utils.h"
+
+#include <mutex>
+
+#define PIPELINE_CACHE_FILE_NAME "pipeline_cache.bin"
+
+namespace SpRenderer {
+	struct PipelineCacheStats {
+		uint32 pipelineCount = 0;
+		uint32 cacheHits = 0;
+		uint32 cacheMisses = 0;
+		uint32 unknown = 0; // Created without creation feedback, so the driver did not say whether it hit
+		double totalCreateMs = 0.0;
+	};
+
+	/**
+	 * VkPipelineCache persisted to RENDERER_DATA_DIR. The driver's data is prefixed with the identity of the device
+	 * and driver that produced it, and is only handed back to the driver when all of it matches, since the
+	 * driver version is not part of the header Vulkan itself puts in front of the data.
+	 */
+	class PipelineCache {
+	public:
+		/*!
+		 * Maps the cache file and checks its hash ahead of init(), so the read can overlap device creation. Optional
+		 */
+		void preload();
+		/**
+		 *
+		 * @param creationFeedback VK_EXT_pipeline_creation_feedback is enabled, used to count cache hits
+		 */
+		void init(VkDevice device, const VkPhysicalDeviceProperties& properties, bool creationFeedback);
+		/*!
+		 * Saves the cache and destroys it. Call once every pipeline made from it is done being created
+		 */
+		void destroy();
+
+		void save();
+
+		VkPipelineCache get() const { return mPipelineCache; }
+
+		VkResult createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline& pipeline);
+		VkResult createComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline& pipeline);
+
+		PipelineCacheStats getStats();
+		void logStats();
+
+	private:
+		struct CacheFileHeader {
+			uint32 magic;
+			uint32 version;
+			uint32 vendorID;
+			uint32 deviceID;
+			uint32 driverVersion;
+			uint32 reserved;
+			uint8 pipelineCacheUUID[VK_UUID_SIZE];
+			uint64 dataSize;
+			uint64 dataHash;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties mProperties{};
+		bool mCreationFeedback = false;
+
+		std::filesystem::path mCachePath;
+
+		std::mutex mMutex;
+		PipelineCacheStats mStats;
+
+		Utils::MappedFile mPreloadedFile;
+		bool mPreloaded = false;
+
+		/*!
+		 * Empty when missing, truncated or corrupt
+		 */
+		Utils::MappedFile readCacheFile() const;
+		bool validateCacheFile(std::span<const char> fileData) const;
+		/*!
+		 * fileData has passed validateCacheFile()
+		 */
+		bool matchesDevice(std::span<const char> fileData) const;
+
+		void recordCreation(const VkPipelineCreationFeedback& feedback, double createMs);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_PIPELINECACHE_H
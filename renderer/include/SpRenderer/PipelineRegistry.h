@@ -0,0 +1,210 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_PIPELINEREGISTRY_H
+#define SPARKER_ENGINE_PIPELINEREGISTRY_H
+
+#include "Utils.h"
+#include "JobSystem.h"
+#include "PipelineCache.h"
+#include "RenderGraph.h"
+#include "ShaderLibrary.h"
+#include "Vertex.h"
+
+#include <shared_mutex>
+#include <unordered_map>
+
+#define PIPELINE_USAGE_FILE_NAME "pipeline_usage.bin"
+
+namespace SpRenderer {
+	typedef uint64 PipelineKey;
+
+	enum PipelineBlendMode : uint32 {
+		SP_BLEND_MODE_OPAQUE,
+		SP_BLEND_MODE_ALPHA,
+		SP_BLEND_MODE_PREMULTIPLIED_ALPHA,
+		SP_BLEND_MODE_ADDITIVE
+	};
+
+	enum PipelineState : uint32 {
+		SP_PIPELINE_STATE_PENDING,
+		SP_PIPELINE_STATE_READY,
+		SP_PIPELINE_STATE_FAILED
+	};
+
+	// 32 bit constant, bools are VkBool32. Applied to every stage, stages without the id ignore it
+	struct SpecializationConstant {
+		uint32 id;
+		uint32 value;
+	};
+
+	/**
+	 * Everything that goes into a graphics pipeline. Shaders and the layout are referred to by name rather than by
+	 * handle, so the same description hashes the same in every run and can be recorded for prewarming.
+	 */
+	struct GraphicsPipelineDesc {
+		std::string vertexShader;   // ShaderLibrary names, e.g. "Sprite.vert"
+		std::string fragmentShader;
+		std::string layout;         // Name given to PipelineRegistry::registerLayout
+
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+		VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		PipelineBlendMode blendMode = SP_BLEND_MODE_OPAQUE;
+
+		bool depthTest = true;
+		bool depthWrite = true;
+		VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+		std::vector<SpecializationConstant> specializationConstants;
+
+		/*!
+		 * Vertex input of VertexInputLayout<Vertices...>
+		 */
+		template<typename... Vertices>
+		void setVertexInput();
+
+		/*!
+		 * Hash of the serialized description, stable across runs and platforms
+		 */
+		PipelineKey key() const;
+
+		void serialize(std::vector<char>& data) const;
+		/**
+		 *
+		 * @param offset Start of the description, moved past it
+		 * @return False when the data ends early or is malformed
+		 */
+		bool deserialize(std::span<const char> data, size_t& offset);
+	};
+
+	struct PipelineRegistryStats {
+		uint32 pipelineCount = 0;
+		uint32 readyCount = 0;
+		uint32 pendingCount = 0;
+		uint32 failedCount = 0;
+		uint32 prewarmedCount = 0; // Requested from the usage list of the last run
+		double totalCompileMs = 0.0; // Summed over worker threads
+	};
+
+	/**
+	 * Graphics pipelines keyed by a hash of their full description. request() never blocks: a pipeline that does not
+	 * exist yet is compiled on a job system worker and draws use a fallback or skip until get() returns it.
+	 *
+	 * Every description requested during a run is written to RENDERER_DATA_DIR on destroy(), and prewarm() queues
+	 * that list on the next start so pipelines are compiled before anything asks for them. Together with the
+	 * driver's PipelineCache this keeps compilation off the frame.
+	 *
+	 * Thread safe, pipelines are owned by the registry.
+	 */
+	class PipelineRegistry {
+	public:
+		/**
+		 *
+		 * @param renderGraph Provides a render pass compatible with each description's attachment formats, unless it
+		 * uses dynamic rendering
+		 */
+		void init(VkDevice device,
+		          PipelineCache& pipelineCache,
+		          const ShaderLibrary& shaderLibrary,
+		          JobSystem& jobSystem,
+		          RenderGraph& renderGraph);
+		/*!
+		 * Waits for compiles still running, saves the usage list and destroys every pipeline
+		 */
+		void destroy();
+
+		/*!
+		 * Register layouts before requesting or prewarming pipelines that name them
+		 */
+		void registerLayout(const std::string& name, VkPipelineLayout layout);
+
+		/*!
+		 * Starts compiling the pipeline unless it already exists. Fatal when the shaders or layout are unknown
+		 */
+		PipelineKey request(const GraphicsPipelineDesc& desc);
+
+		/*!
+		 * The pipeline, or fallback while it is compiling or when it failed to compile
+		 */
+		VkPipeline get(PipelineKey key, VkPipeline fallback = VK_NULL_HANDLE) const;
+		PipelineState getState(PipelineKey key) const;
+
+		/*!
+		 * Blocks until the pipeline is compiled, running other jobs meanwhile. Fatal when it failed
+		 */
+		VkPipeline wait(PipelineKey key);
+
+		/**
+		 * Queues every pipeline of the last run's usage list. Descriptions naming shaders or layouts that no longer
+		 * exist are dropped.
+		 *
+		 * @return Pipelines queued
+		 */
+		uint32 prewarm();
+
+		PipelineRegistryStats getStats() const;
+		void logStats() const;
+
+	private:
+		struct PipelineUsageHeader {
+			uint32 magic;
+			uint32 version;
+			uint32 count;
+			uint32 reserved;
+		};
+
+		struct Entry {
+			GraphicsPipelineDesc desc;
+			VkPipelineLayout layout = VK_NULL_HANDLE;
+			VkRenderPass renderPass = VK_NULL_HANDLE; // Matches the description's formats, VK_NULL_HANDLE with dynamic rendering
+
+			std::atomic<VkPipeline> pipeline = VK_NULL_HANDLE;
+			std::atomic<PipelineState> state = SP_PIPELINE_STATE_PENDING;
+			JobCounter counter;
+
+			double compileMs = 0.0;
+			std::atomic<bool> prewarmed = false; // Only requested by prewarm() so far, not written to the next usage list
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		PipelineCache* mPipelineCache = nullptr;
+		const ShaderLibrary* mShaderLibrary = nullptr;
+		JobSystem* mJobSystem = nullptr;
+		RenderGraph* mRenderGraph = nullptr;
+
+		mutable std::shared_mutex mMutex;
+		std::unordered_map<PipelineKey, std::unique_ptr<Entry>> mEntries;
+		std::unordered_map<std::string, VkPipelineLayout> mLayouts;
+
+		std::filesystem::path mUsagePath;
+
+		/**
+		 *
+		 * @param error Why the description can't be compiled, empty when it can
+		 */
+		VkPipelineLayout resolveLayout(const GraphicsPipelineDesc& desc, std::string& error) const;
+		PipelineKey request(const GraphicsPipelineDesc& desc, bool prewarm);
+
+		void compile(Entry& entry);
+
+		std::vector<GraphicsPipelineDesc> loadUsage() const;
+		void saveUsage() const;
+	};
+
+	template<typename... Vertices>
+	void GraphicsPipelineDesc::setVertexInput() {
+		using Layout = VertexInputLayout<Vertices...>;
+		vertexBindings.assign(Layout::Bindings.begin(), Layout::Bindings.end());
+		vertexAttributes.assign(Layout::Attributes.begin(), Layout::Attributes.end());
+	}
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_PIPELINEREGISTRY_H
@@ -0,0 +1,175 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_PROFILER_H
+#define SPARKER_ENGINE_PROFILER_H
+
+#include "Utils.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace SpRenderer {
+	const uint32 ProfileBlockSize = 4096;        // Events per block
+	const uint32 MaxProfileBlocksPerThread = 256; // Past this a thread's events are dropped, about a million zones
+	const uint32 GpuProfileThreadId = 1000;      // Track the GPU zones show up on in the trace
+
+	struct ProfileEvent {
+		const char* name; // Only the pointer is kept, use string literals
+		uint64 startNs;   // Since the profiler was created
+		uint64 endNs;
+	};
+
+	struct ProfilerStats {
+		uint64 eventCount = 0;
+		uint64 droppedCount = 0; // Recorded by a thread that had used up MaxProfileBlocksPerThread
+		uint32 threadCount = 0;
+	};
+
+	/**
+	 * Events of one thread, or of the GPU. Single producer, any number of readers: the producer fills a block and
+	 * then publishes its count, readers only look at what was published. Blocks are never moved or freed while the
+	 * profiler lives, so readers need no lock.
+	 */
+	class ProfileBuffer {
+	public:
+		ProfileBuffer(uint32 threadId, std::string name);
+		~ProfileBuffer();
+
+		ProfileBuffer(const ProfileBuffer&) = delete;
+		ProfileBuffer& operator=(const ProfileBuffer&) = delete;
+
+		/*!
+		 * Producer only. False when the buffer is full
+		 */
+		bool push(const ProfileEvent& event);
+
+		/*!
+		 * Calls visit(const ProfileEvent&) for every event published so far
+		 */
+		template<typename Visitor>
+		void forEach(Visitor&& visit) const;
+
+		uint32 threadId() const { return mThreadId; }
+		const std::string& name() const { return mName; }
+		void setName(std::string name);
+
+	private:
+		struct Block {
+			std::array<ProfileEvent, ProfileBlockSize> events;
+			std::atomic<uint32> count{0};
+		};
+
+		uint32 mThreadId;
+		std::string mName; // Written before the buffer is registered or under the profiler's buffer lock
+
+		std::array<std::atomic<Block*>, MaxProfileBlocksPerThread> mBlocks{};
+		std::atomic<uint32> mBlockCount{0};
+	};
+
+	template<typename Visitor>
+	void ProfileBuffer::forEach(Visitor&& visit) const {
+		uint32 blockCount = mBlockCount.load(std::memory_order_acquire);
+		for (uint32 i = 0; i < blockCount; i++) {
+			const Block* block = mBlocks[i].load(std::memory_order_acquire);
+			uint32 count = block->count.load(std::memory_order_acquire);
+			for (uint32 event = 0; event < count; event++) {
+				visit(block->events[event]);
+			}
+		}
+	}
+
+	/**
+	 * Collects CPU zones from SP_PROFILE_ZONE on every thread and GPU zones from GpuProfiler, and writes them out as
+	 * a Chrome trace (chrome://tracing, Perfetto). Recording is off until setEnabled(true), while off a zone costs a
+	 * relaxed atomic load and a branch, so zones stay in release builds.
+	 *
+	 * Meant for captures of a bounded length: events are kept until the profiler is destroyed.
+	 */
+	class Profiler {
+	public:
+		static Profiler& get();
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		static bool enabled() { return sEnabled.load(std::memory_order_relaxed); }
+		void setEnabled(bool enabled);
+
+		uint64 nowNs() const;
+
+		void recordZone(const char* name, uint64 startNs, uint64 endNs);
+		/*!
+		 * Render thread only, see GpuProfiler
+		 */
+		void recordGpuZone(const char* name, uint64 startNs, uint64 endNs);
+
+		/*!
+		 * Names the calling thread's track in the trace
+		 */
+		void setThreadName(const std::string& name);
+
+		/**
+		 * Writes every event recorded so far. Safe while other threads are recording, their newest events may be missing
+		 *
+		 * @return False when the file could not be written
+		 */
+		bool exportChromeTrace(const std::filesystem::path& filePath = RENDERER_DATA_DIR "/profiles/sparker_trace.json");
+
+		ProfilerStats getStats();
+
+	private:
+		inline static std::atomic<bool> sEnabled{false};
+
+		std::chrono::steady_clock::time_point mStartTime;
+
+		std::mutex mBufferMutex;
+		std::vector<std::shared_ptr<ProfileBuffer>> mBuffers;
+		uint32 mNextThreadId = 0;
+		ProfileBuffer mGpuBuffer;
+
+		std::atomic<uint64> mDroppedCount{0};
+
+		Profiler();
+
+		ProfileBuffer& threadBuffer();
+	};
+
+	/**
+	 * Records the enclosing scope as a zone on the calling thread, use through SP_PROFILE_ZONE
+	 */
+	class ProfileZone {
+	public:
+		explicit ProfileZone(const char* name) : mName(name), mStartNs(Profiler::enabled() ? Profiler::get().nowNs() : NotStarted) {}
+
+		~ProfileZone() {
+			if (mStartNs != NotStarted) {
+				Profiler& profiler = Profiler::get();
+				profiler.recordZone(mName, mStartNs, profiler.nowNs());
+			}
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		static constexpr uint64 NotStarted = std::numeric_limits<uint64>::max();
+
+		const char* mName;
+		uint64 mStartNs;
+	};
+} // SpRenderer
+
+#define SP_PROFILE_CONCAT_INNER(a, b) a##b
+#define SP_PROFILE_CONCAT(a, b) SP_PROFILE_CONCAT_INNER(a, b)
+
+// Zones are compiled in unless the SP_PROFILER_DISABLED cache variable is set, and record nothing until the profiler is enabled
+#ifdef SP_PROFILER_DISABLED
+#define SP_PROFILE_ZONE(name) do {} while (0)
+#else
+#define SP_PROFILE_ZONE(name) SpRenderer::ProfileZone SP_PROFILE_CONCAT(spProfileZone, __LINE__)(name)
+#endif
+
+#endif //SPARKER_ENGINE_PROFILER_H
@@ -12,12 +12,17 @@
 struct QueueFamilyIndices {
 	std::optional<uint32> graphicsFamily;
 	std::optional<uint32> presentFamily;
-	std::optional<uint32> transferFamily;
+	std::optional<uint32> transferFamily; // Falls back to the graphics family when there is no separate transfer family
 
+	/**
+	 *
+	 * @param surface VK_NULL_HANDLE when rendering headless, presentFamily is then the graphics family
+	 */
 	void findQueueIndices(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
 
 	bool isComplete();
 	bool transferComplete();
+	bool dedicatedTransfer();
 };
 
 struct SwapchainSupportDetails {
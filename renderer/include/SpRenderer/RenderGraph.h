@@ -0,0 +1,378 @@
+//
+// Created by robsc on 11/30/25.
+//
+
+#ifndef SPARKER_ENGINE_RENDERGRAPH_H
+#define SPARKER_ENGINE_RENDERGRAPH_H
+
+#include "Utils.h"
+#include "MemoryAllocator.h"
+#include "GpuProfiler.h"
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace SpRenderer {
+	typedef uint32 GraphResource;
+	const GraphResource InvalidGraphResource = std::numeric_limits<uint32>::max();
+
+	const uint32 MaxGraphColorAttachments = 8;
+
+	enum RenderingBackend {
+		SP_RENDERING_BACKEND_RENDER_PASS, // Vulkan 1.0 render pass and framebuffer objects, vkCmdPipelineBarrier
+		SP_RENDERING_BACKEND_DYNAMIC      // Vulkan 1.3 vkCmdBeginRendering and vkCmdPipelineBarrier2
+	};
+
+	enum GraphPassType {
+		SP_GRAPH_PASS_GRAPHICS, // Runs inside a render pass built from its attachments
+		SP_GRAPH_PASS_COMPUTE,
+		SP_GRAPH_PASS_TRANSFER
+	};
+
+	enum GraphAccess : uint8 {
+		SP_GRAPH_ACCESS_COLOR_ATTACHMENT,
+		SP_GRAPH_ACCESS_DEPTH_ATTACHMENT,
+		SP_GRAPH_ACCESS_DEPTH_READ,     // Depth testing without writes, read-only layout
+		SP_GRAPH_ACCESS_SAMPLED,
+		SP_GRAPH_ACCESS_STORAGE_READ,
+		SP_GRAPH_ACCESS_STORAGE_WRITE,
+		SP_GRAPH_ACCESS_TRANSFER_SRC,
+		SP_GRAPH_ACCESS_TRANSFER_DST,
+		SP_GRAPH_ACCESS_INDIRECT,       // Buffers only, draw and dispatch arguments
+		SP_GRAPH_ACCESS_VERTEX_INPUT    // Buffers only, vertex and index data
+	};
+
+	struct GraphImageDesc {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkExtent2D extent = {0, 0};
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	};
+
+	struct RenderGraphStats {
+		uint32 passCount = 0;
+		uint32 culledPassCount = 0;
+		uint32 barrierBatchCount = 0; // vkCmdPipelineBarrier calls
+		uint32 imageBarrierCount = 0;
+		uint32 bufferBarrierCount = 0;
+
+		uint32 transientImageCount = 0;
+		uint32 memorySlotCount = 0;
+		VkDeviceSize transientBytes = 0; // What the transient images would need without aliasing
+		VkDeviceSize aliasedBytes = 0;   // What they actually use
+	};
+
+	/**
+	 * Describes a frame as passes that declare which images and buffers they read and write. compile() drops
+	 * passes nothing depends on, works out the barriers and layout transitions between the rest, and places
+	 * transient images with disjoint lifetimes in the same memory. The graph is rebuilt every frame, while
+	 * physical images, render passes and framebuffers are cached across frames.
+	 *
+	 * Render thread only.
+	 */
+	class RenderGraph {
+	public:
+		struct PassContext {
+			const RenderGraph* graph;
+			VkRenderPass renderPass; // VK_NULL_HANDLE outside graphics passes and with dynamic rendering
+			VkExtent2D extent;       // Size of the attachments in graphics passes
+
+			// Only in passes recorded with secondary command buffers, begin every secondary command buffer with it and
+			// VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT. Nothing but vkCmdExecuteCommands goes in the primary
+			const VkCommandBufferInheritanceInfo* inheritance;
+
+			VkImage getImage(GraphResource resource) const;
+			VkImageView getImageView(GraphResource resource) const;
+			VkBuffer getBuffer(GraphResource resource) const;
+		};
+
+		typedef std::function<void(VkCommandBuffer commandBuffer, const PassContext& context)> PassCallback;
+
+		class PassBuilder {
+		public:
+			/**
+			 *
+			 * @param loadOp LOAD keeps what earlier passes wrote, which makes them a dependency
+			 */
+			PassBuilder& writeColor(GraphResource resource,
+			                        VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			                        VkClearColorValue clearValue = {});
+			PassBuilder& writeDepth(GraphResource resource,
+			                        VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			                        float clearDepth = 1.0f);
+			PassBuilder& readDepth(GraphResource resource);
+
+			PassBuilder& read(GraphResource resource, GraphAccess access, VkPipelineStageFlags stages = 0);
+			PassBuilder& write(GraphResource resource, GraphAccess access, VkPipelineStageFlags stages = 0);
+			/*!
+			 * Reads and writes in the same pass, e.g. atomics on a storage buffer. Depends on earlier writes like read()
+			 */
+			PassBuilder& readWrite(GraphResource resource, GraphAccess access, VkPipelineStageFlags stages = 0);
+
+			/*!
+			 * Keeps the pass even when nothing reads what it writes, e.g. readbacks and queries
+			 */
+			PassBuilder& sideEffects();
+			/*!
+			 * Graphics passes only. The callback records its draws into secondary command buffers, e.g. from several
+			 * threads, and executes them with vkCmdExecuteCommands
+			 */
+			PassBuilder& secondaryCommandBuffers();
+			PassBuilder& execute(PassCallback callback);
+
+		private:
+			friend class RenderGraph;
+
+			RenderGraph* mGraph;
+			uint32 mPass;
+
+			PassBuilder(RenderGraph* graph, uint32 pass) : mGraph(graph), mPass(pass) {}
+		};
+
+		/**
+		 *
+		 * @param backend SP_RENDERING_BACKEND_DYNAMIC needs the dynamicRendering and synchronization2 features enabled
+		 */
+		void init(VkDevice device, MemoryAllocator& allocator, uint32 framesInFlight, RenderingBackend backend);
+		/*!
+		 * The device must be idle
+		 */
+		void destroy();
+
+		/*!
+		 * Forgets the previous frame's passes and resources. Cached objects unused for framesInFlight frames are destroyed
+		 */
+		void beginFrame(uint64 frameNumber);
+
+		/**
+		 *
+		 * @param initialStage Stages that last touched the image before the graph, e.g. the acquire semaphore's wait stage
+		 * @param finalLayout Layout the image is left in after the last pass
+		 */
+		GraphResource importImage(const char* name,
+		                          VkImage image,
+		                          VkImageView imageView,
+		                          const GraphImageDesc& desc,
+		                          VkImageLayout initialLayout,
+		                          VkPipelineStageFlags initialStage,
+		                          VkImageLayout finalLayout);
+		GraphResource importBuffer(const char* name, VkBuffer buffer, VkDeviceSize size);
+		/*!
+		 * Created by the graph and only valid inside the frame, contents never carry over between frames
+		 */
+		GraphResource createImage(const char* name, const GraphImageDesc& desc);
+
+		PassBuilder addPass(const char* name, GraphPassType type);
+
+		/*!
+		 * Keeps the passes writing a transient resource, imported resources are always outputs
+		 */
+		void markOutput(GraphResource resource);
+
+		void compile();
+		void execute(VkCommandBuffer commandBuffer);
+
+		/*!
+		 * Render pass for building pipelines against, compatible with every graphics pass using the same formats.
+		 * VK_NULL_HANDLE with dynamic rendering, pipelines take the formats through VkPipelineRenderingCreateInfo instead.
+		 * Thread safe, pipelines are requested from any thread
+		 */
+		VkRenderPass compatibleRenderPass(std::span<const VkFormat> colorFormats, VkFormat depthFormat);
+
+		/*!
+		 * Call when imported image views are destroyed, so no cached framebuffer outlives them
+		 */
+		void retireFramebuffers();
+
+		/*!
+		 * Wraps every pass executed from now on in a GPU zone named after the pass. nullptr turns it off
+		 */
+		void setGpuProfiler(GpuProfiler* profiler) { mGpuProfiler = profiler; }
+
+		RenderingBackend getBackend() const { return mBackend; }
+		const RenderGraphStats& getStats() const { return mStats; }
+
+	private:
+		enum ResourceKind : uint8 {
+			SP_GRAPH_RESOURCE_IMPORTED_IMAGE,
+			SP_GRAPH_RESOURCE_TRANSIENT_IMAGE,
+			SP_GRAPH_RESOURCE_IMPORTED_BUFFER
+		};
+
+		struct ResourceState {
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags writeStages = 0;  // Stages of the last write or layout transition
+			VkAccessFlags writeAccess = 0;         // Not yet made available
+			VkPipelineStageFlags readStages = 0;   // Reads since the last write, later writes wait for them
+			VkPipelineStageFlags visibleStages = 0;
+			VkAccessFlags visibleAccess = 0;       // Accesses the last write was already made visible to
+		};
+
+		struct Resource {
+			const char* name;
+			ResourceKind kind;
+			GraphImageDesc desc;
+			VkImageUsageFlags usage = 0;
+			VkDeviceSize bufferSize = 0;
+
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView imageView = VK_NULL_HANDLE;
+			VkBuffer buffer = VK_NULL_HANDLE;
+
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			ResourceState state;
+			bool output = false;
+
+			// Kept passes first and last touching it
+			uint32 firstPass = std::numeric_limits<uint32>::max();
+			uint32 lastPass = 0;
+			uint32 physicalImage = std::numeric_limits<uint32>::max();
+		};
+
+		struct ResourceAccess {
+			GraphResource resource;
+			GraphAccess access;
+			VkPipelineStageFlags stages;
+			bool write;
+			bool read;
+		};
+
+		struct Attachment {
+			GraphResource resource = InvalidGraphResource;
+			VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			VkClearValue clearValue = {};
+			bool readOnly = false;
+		};
+
+		struct Barrier {
+			GraphResource resource;
+			VkImageLayout oldLayout;
+			VkImageLayout newLayout;
+			VkPipelineStageFlags srcStages; // Only synchronization2 keeps stages per barrier, otherwise the batch's are used
+			VkPipelineStageFlags dstStages;
+			VkAccessFlags srcAccess;
+			VkAccessFlags dstAccess;
+		};
+
+		struct BarrierBatch {
+			VkPipelineStageFlags srcStages = 0;
+			VkPipelineStageFlags dstStages = 0;
+			std::vector<Barrier> barriers;
+		};
+
+		struct Pass {
+			const char* name;
+			GraphPassType type;
+			std::vector<ResourceAccess> accesses;
+			std::vector<Attachment> colorAttachments;
+			Attachment depthAttachment;
+			PassCallback callback;
+			bool sideEffects = false;
+			bool secondaryCommandBuffers = false;
+			bool culled = false;
+
+			BarrierBatch barriers;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			VkExtent2D extent = {0, 0};
+		};
+
+		// Transient images sharing one allocation, only ever one of them alive at a time
+		struct MemorySlot {
+			Allocation allocation;
+			VkMemoryRequirements requirements{};
+
+			// Whatever last used the memory, possibly in an earlier frame, has to finish before the next image takes it
+			VkPipelineStageFlags lastStages = 0;
+			VkAccessFlags lastWriteAccess = 0;
+		};
+
+		struct PhysicalImage {
+			GraphImageDesc desc;
+			VkImageUsageFlags usage;
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView imageView = VK_NULL_HANDLE;
+			VkMemoryRequirements requirements{};
+			uint32 memorySlot = 0;
+		};
+
+		struct AttachmentKey {
+			VkFormat format;
+			VkSampleCountFlagBits samples;
+			VkAttachmentLoadOp loadOp;
+			VkAttachmentStoreOp storeOp;
+			VkImageLayout layout;
+		};
+
+		struct CachedFramebuffer {
+			VkFramebuffer framebuffer;
+			uint64 lastUsedFrame;
+		};
+
+		// Destroyed once no frame in flight can still use them
+		struct RetiredObjects {
+			uint64 retireFrame;
+			std::vector<PhysicalImage> images;
+			std::vector<MemorySlot> memorySlots;
+			std::vector<VkFramebuffer> framebuffers;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		MemoryAllocator* mAllocator = nullptr;
+		uint32 mFramesInFlight = 1;
+		RenderingBackend mBackend = SP_RENDERING_BACKEND_RENDER_PASS;
+		uint64 mFrameNumber = 0;
+		GpuProfiler* mGpuProfiler = nullptr;
+
+		std::vector<Resource> mResources;
+		std::vector<Pass> mPasses;
+		BarrierBatch mFinalBarriers; // Imported images into their final layouts
+
+		uint64 mTransientLayoutHash = 0;
+		std::vector<PhysicalImage> mPhysicalImages;
+		std::vector<MemorySlot> mMemorySlots;
+
+		std::mutex mRenderPassMutex; // compatibleRenderPass runs on other threads than compile
+		std::unordered_map<uint64, VkRenderPass> mRenderPasses;
+		std::unordered_map<uint64, CachedFramebuffer> mFramebuffers;
+		std::vector<RetiredObjects> mRetired;
+
+		RenderGraphStats mStats;
+
+		void cullPasses();
+		void computeLifetimes();
+		void allocateTransients();
+		void buildRenderPasses();
+		void computeBarriers();
+
+		/*!
+		 * Updates the resource's state for the access, adding whatever barrier it needs to the batch
+		 */
+		void transition(GraphResource resource, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access,
+		                bool write, bool discard, BarrierBatch& batch);
+		void recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch);
+		void recordBarriers2(VkCommandBuffer commandBuffer, const BarrierBatch& batch);
+		void beginRendering(VkCommandBuffer commandBuffer, const Pass& pass);
+		void inheritanceInfo(const Pass& pass,
+		                     std::array<VkFormat, MaxGraphColorAttachments>& colorFormats,
+		                     VkCommandBufferInheritanceRenderingInfo& renderingInfo,
+		                     VkCommandBufferInheritanceInfo& inheritance) const;
+
+		VkRenderPass findRenderPass(std::span<const AttachmentKey> colorAttachments, const AttachmentKey* depthAttachment);
+		VkFramebuffer findFramebuffer(const Pass& pass);
+
+		void retirePhysicalImages();
+		void releaseRetired(bool force);
+
+		Resource& getResource(GraphResource resource);
+		Pass& addAccess(uint32 pass, GraphResource resource, GraphAccess access, VkPipelineStageFlags stages, bool read, bool write);
+
+		static void accessInfo(const ResourceAccess& access, GraphPassType type,
+		                       VkImageLayout& layout, VkPipelineStageFlags& stages, VkAccessFlags& accessMask);
+		static VkImageUsageFlags accessUsage(GraphAccess access);
+		static VkImageAspectFlags aspectMask(VkFormat format);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_RENDERGRAPH_H
@@ -6,42 +6,156 @@
 #define SPARKER_ENGINE_RENDERERCORE_H
 
 
+#include "BindlessTable.h"
+#include "BlockCompression.h"
+#include "DeviceProfile.h"
+#include "GpuProfiler.h"
+#include "GpuScene.h"
+#include "JobSystem.h"
+#include "LayoutCache.h"
 #include "QueueFamily.h"
 #include "Utils.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
+#include "MemoryAllocator.h"
+#include "PipelineCache.h"
+#include "PipelineRegistry.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "UploadManager.h"
+#include "SpriteBatcher.h"
+#include "StartupGraph.h"
+#include "TextureManager.h"
+#include "ThreadCommandPools.h"
+#include "Vertex.h"
 
 
 const uvec3 ClearColor = uvec3(25, 40, 60);
 
+const uint32 MinFramesInFlight = 2;
+const uint32 MaxFramesInFlight = 3;
+
+// Fewer sprites than this per secondary command buffer and the per buffer setup outweighs recording in parallel
+const uint32 MinSpritesPerRecordJob = 4096;
+
 namespace SpRenderer {
 	// ReSharper disable once CppClassNeedsConstructorBecauseOfUninitializedMember
 	class RendererCore {
 	public:
-		bool shouldClose() const;
+		struct FrameStats {
+			uint64 frameCount = 0;
+
+			double lastFenceWaitMs = 0.0;
+			double lastAcquireWaitMs = 0.0;
+			double lastCpuFrameMs = 0.0;
+
+			// Averages over the last report window
+			double avgFenceWaitMs = 0.0;
+			double avgAcquireWaitMs = 0.0;
+			double avgCpuFrameMs = 0.0;
+		};
+
+		struct StartupStats {
+			StartupReport startup;
+			double timeToFirstFrameMs = 0.0; // From start() until the first frame was submitted, 0 before that
+		};
+
+		struct HeadlessSettings {
+			VkExtent2D extent = {1280, 720};
+			uint64 frameLimit = 0; // shouldClose() turns true once this many frames were submitted, 0 never
+			bool readback = false; // Copy every frame to host memory and hand it to the readback callback
+		};
 
-		void start(const char* ApplicationName);
+		/*!
+		 * pixels are tightly packed R8G8B8A8 rows and only valid during the call
+		 */
+		typedef std::function<void(std::span<const uint8> pixels, VkExtent2D extent, uint64 frameNumber)> ReadbackCallback;
+
+		bool shouldClose() const;
+		VkExtent2D getWindowExtent() const;
+
+		/**
+		 *
+		 * @param framesInFlight Number of frames the CPU may record ahead of the GPU, clamped to [MinFramesInFlight, MaxFramesInFlight]
+		 */
+		void start(const char* ApplicationName, uint32 framesInFlight = MinFramesInFlight);
+		/**
+		 * Renders into offscreen images instead of a window: no SDL, no surface and no swapchain, so any device
+		 * that can draw qualifies, software rasterizers like lavapipe included. Frames are paced by the frame
+		 * fences only, which makes it the mode to measure throughput in
+		 *
+		 * @param framesInFlight Number of frames the CPU may record ahead of the GPU, clamped to [MinFramesInFlight, MaxFramesInFlight]
+		 */
+		void startHeadless(const char* ApplicationName, const HeadlessSettings& settings, uint32 framesInFlight = MinFramesInFlight);
 		void stop();
 
+		bool isHeadless() const;
+		/*!
+		 * Headless with readback only. Called on the render thread once a frame's copy has landed, which is
+		 * framesInFlight frames after it was drawn, and for the frames still in flight during stop()
+		 */
+		void setReadbackCallback(ReadbackCallback callback);
+
 		void endFrame();
 
+		const FrameStats& getFrameStats() const;
+		/*!
+		 * How long each startup stage took, see StartupGraph
+		 */
+		const StartupStats& getStartupStats() const;
+
+		/*!
+		 * Sprites are drawn with the next endFrame(), resubmit them every frame
+		 */
+		void drawSprite(const Sprite& sprite);
+		void drawSprites(std::span<const Sprite> sprites);
+		const SpriteBatchStats& getSpriteStats() const;
+
+		/*!
+		 * Meshes and objects culled and drawn on the GPU, see GpuScene. Render thread only
+		 */
+		GpuScene& getScene();
+		/*!
+		 * Maps a cooked MESH_FILE_EXTENSION file and adds its meshes to the scene, empty when it can't be loaded.
+		 * Render thread only
+		 */
+		std::vector<MeshHandle> loadMeshes(const std::filesystem::path& filePath);
+
+		/*!
+		 * Streams a KTX2 texture in the background, see TextureManager. Any thread
+		 */
+		TextureHandle loadTexture(const std::filesystem::path& filePath);
+		/*!
+		 * Index to put in Sprite::texture, look it up every frame since it changes while the texture streams in
+		 */
+		BindlessIndex getTextureIndex(TextureHandle texture);
+
+		/*!
+		 * Shared with the renderer. Jobs queued with runOnMainThread() run in endFrame(), the place for SDL calls
+		 */
+		JobSystem& getJobSystem();
+
 	private:
 #pragma region PrivateStructs
 		struct SdlContext {
 			SDL_Window* window;
 			bool quitWindow = false;
+			bool minimized = false;
 			std::string windowName;
 			VkExtent2D extent;
 			VkSurfaceKHR surface;
+			std::vector<const char*> instanceExtensions; // Needed by SDL for the surface, owned by SDL
 		};
 
 		struct PhysicalDeviceInfo {
 			VkPhysicalDevice device;
 			SwapchainSupportDetails swapchainDetails;
 			QueueFamilyIndices indices;
-			int32 score;
 			VkPhysicalDeviceProperties properties;
-			VkPhysicalDeviceFeatures features;
 			VkPhysicalDeviceMemoryProperties memoryProperties;
+			DeviceCapabilities capabilities; // Feature gates, cached between runs
+			std::vector<const char*> optionalExtensions; // Entries of OptionalDeviceExtensions the device supports
+			RenderingBackend renderingBackend;
 		};
 
 		struct LogicalDevice {
@@ -53,13 +167,19 @@ namespace SpRenderer {
 		};
 
 		struct Swapchain {
-			VkSwapchainKHR swapchain;
+			VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+			bool outOfDate = false; // Recreated before the next frame acquires
 			SwapchainSupportDetails* swapchainDetails;
 			VkSurfaceFormatKHR surfaceFormat;
 			VkPresentModeKHR presentMode;
 
 			std::vector<VkImage> images = std::vector<VkImage>(0);
 			std::vector<VkImageView> imageViews = std::vector<VkImageView>(0);
+
+			// Indexed by swapchain image, the presentation engine may hold on to these past the frame fence
+			std::vector<VkSemaphore> renderFinishedSemaphores = std::vector<VkSemaphore>(0);
+			// Fence of the frame that last rendered to each swapchain image
+			std::vector<VkFence> imagesInFlight = std::vector<VkFence>(0);
 		};
 
 		struct Renderpass {
@@ -68,16 +188,80 @@ namespace SpRenderer {
 
 		};
 
+		struct GraphicsPipeline {
+			VkDescriptorSetLayout descriptorSetLayout;
+			VkPipelineLayout layout;
+			VkPipeline pipeline;
+			PipelineKey key;
+		};
+
+		struct ComputePipeline {
+			VkPipelineLayout layout;
+			VkPipeline pipeline;
+		};
+
 		struct VulkanContext {
 			VkInstance instance;
+			uint32 apiVersion;
 			VkDebugUtilsMessengerEXT debugMessenger;
 		};
 
-		struct DepthResources {
-			VkFormat format;
-			VkImage image;
-			VkDeviceMemory imageMemory;
-			VkImageView imageView;
+		// Everything sized to a swapchain that was replaced, destroyed once no frame in flight can still use it
+		struct RetiredSwapchain {
+			VkSwapchainKHR swapchain;
+			std::vector<VkImageView> imageViews;
+			std::vector<VkSemaphore> renderFinishedSemaphores;
+			uint64 retireFrame; // FrameContext::frameNumber when it was replaced
+		};
+
+		// Set 0 binding 0 of every pipeline, std140
+		struct FrameUniforms {
+			mat4 model;
+			mat4 view;
+		};
+
+		struct FrameData {
+			VkCommandBuffer commandBuffer;
+			VkSemaphore imageAvailableSemaphore;
+			VkFence inFlightFence;
+
+			// Persistently mapped, rewritten once the fence says the GPU is done with it
+			VkBuffer uniformBuffer;
+			Allocation uniformAllocation;
+			VkDescriptorSet descriptorSet;
+		};
+
+		struct Texture {
+			VkImage image = VK_NULL_HANDLE;
+			Allocation allocation;
+			VkImageView view = VK_NULL_HANDLE;
+		};
+
+		struct FrameContext {
+			VkCommandPool commandPool;
+			ThreadCommandPools threadCommandPools; // Secondary command buffers recorded in jobs
+
+			uint32 framesInFlight = MinFramesInFlight;
+			uint32 currentFrame = 0;
+			uint64 frameNumber = 0; // Frames submitted so far
+			std::vector<FrameData> frames = std::vector<FrameData>(0);
+
+			std::chrono::steady_clock::time_point lastFrameTime;
+			std::chrono::steady_clock::time_point lastReportTime;
+			uint64 reportFrameCount = 0;
+			double reportFenceWaitMs = 0.0;
+			double reportAcquireWaitMs = 0.0;
+			double reportCpuFrameMs = 0.0;
+		};
+
+		// Stand in for the swapchain when headless, one image per frame in flight
+		struct OffscreenTargets {
+			std::vector<Allocation> imageAllocations = std::vector<Allocation>(0);
+
+			// Host visible copy of each frame's image, only with readback
+			std::vector<VkBuffer> readbackBuffers = std::vector<VkBuffer>(0);
+			std::vector<Allocation> readbackAllocations = std::vector<Allocation>(0);
+			std::vector<uint64> readbackFrames = std::vector<uint64>(0); // Frame copied into each buffer, NoPendingReadback once delivered
 		};
 
 #pragma endregion PrivateStructs
@@ -86,16 +270,53 @@ namespace SpRenderer {
 		SdlContext mainWindow;
 		VulkanContext vulkanContext;
 
+		bool mHeadless = false;
+		HeadlessSettings mHeadlessSettings;
+		OffscreenTargets mOffscreenTargets;
+		ReadbackCallback mReadbackCallback;
+
 		PhysicalDeviceInfo mPhysicalDeviceInfo;
 		LogicalDevice mLogicalDevice;
 		Swapchain mSwapchain;
-		Renderpass mRenderpass;
+		Renderpass mRenderpass; // Owned by mRenderGraph
+		VkFormat mDepthFormat;
+		std::vector<RetiredSwapchain> mRetiredSwapchains;
+
+		JobSystem mJobSystem;
+		MemoryAllocator mAllocator;
+		GpuProfiler mGpuProfiler;
+		RenderGraph mRenderGraph;
+		UploadManager mUploadManager;
+
+		BindlessTable mBindlessTable;
+		Texture mDefaultTexture; // 1x1 white, index 0 of the bindless image array
+		TextureManager mTextureManager;
+		VkDescriptorPool mDescriptorPool;
+
+		FrameContext mFrameContext;
+		FrameStats mFrameStats;
+		StartupStats mStartupStats;
+		std::chrono::steady_clock::time_point mStartTime;
+
+		PipelineCache mPipelineCache;
+		LayoutCache mLayoutCache;
+		PipelineRegistry mPipelineRegistry;
+		GraphicsPipeline m2DPipeline;
+		GraphicsPipeline mSpritePipeline;
+		SpriteBatcher mSpriteBatcher;
+		GraphicsPipeline mMeshPipeline;
+		ComputePipeline mCullPipeline;
+		GpuScene mScene;
+
+		ShaderCache mShaderCache;
+		ShaderLibrary mShaderLibrary;
 
-		DepthResources mDepthResources;
+	private:
+		static constexpr uint64 NoPendingReadback = std::numeric_limits<uint64>::max();
 
-		Shader m2DMainShader;
+		void startRenderer(const char* ApplicationName, uint32 framesInFlight);
 
-	private:
+		void startSdl();
 		void startWindow();
 		void endWindowFrame();
 		void terminateWindow();
@@ -107,45 +328,106 @@ namespace SpRenderer {
 		void createSurface();
 
 		void getPhysicalDevice();
-		int isSuitableDevice(PhysicalDeviceInfo& deviceInfo);
+		/**
+		 * Queries and scores every device, the preferred one wins when it is usable
+		 *
+		 * @return False when none is usable
+		 */
+		bool selectPhysicalDevice(const std::vector<VkPhysicalDevice>& devices, const std::string& preference, PhysicalDeviceInfo& chosen);
+		/*!
+		 * Queue families and swapchain support, the parts that depend on the surface and are never cached
+		 */
+		bool querySurfaceSupport(PhysicalDeviceInfo& deviceInfo);
 		void querySwapchainSupport(PhysicalDeviceInfo& deviceInfo);
+		bool optionalExtensionEnabled(const char* extensionName) const;
+		/*!
+		 * The swapchain extension, nothing when headless
+		 */
+		std::vector<const char*> requiredDeviceExtensions() const;
 
 		void createLogicalDevice();
+		void createAllocator();
+		void createGpuProfiler();
+		void createRenderGraph();
+		void createPipelineCache();
+		void createUploadManager();
 		void createSwapchain();
+		VkExtent2D chooseSwapchainExtent() const;
+		/*!
+		 * Replaces the swapchain and everything sized to it without waiting for the GPU
+		 *
+		 * @return False when the window has no area, the swapchain stays out of date
+		 */
+		bool recreateSwapchain();
+		void retireSwapchain();
+		/**
+		 *
+		 * @param force Destroy everything regardless of frames in flight, only once the device is idle
+		 */
+		void releaseRetiredSwapchains(bool force);
+		void createOffscreenTargets();
 		void createImageViews();
 		void createRenderpass();
-		void createDescriptorSetLayout();
 		void createGraphicsPipeline();
-		void createDepthResources();
-		void createFramebuffers();
 		void createCommandPool();
 		void createTextureImage();
+		void createBindlessTable();
+		void createTextureManager();
 
 		void createUniformBuffers();
 		void createDescriptorPool();
 		void createDescriptorSets();
+		void updateUniformBuffer(uint32 frameIndex);
 
 		void createCommandBuffers();
 		void createSyncObjects();
-
-
+		void createSwapchainSyncObjects();
+		void createSpriteBatcher();
+		void createGpuScene();
+
+		void drawFrame();
+		void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32 imageIndex);
+		/*!
+		 * Splits the sprites over jobs that each record a secondary command buffer, then executes them in order
+		 */
+		void recordSprites(VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context);
+		void recordScene(VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context);
+		void bindDrawState(VkCommandBuffer commandBuffer, VkExtent2D extent);
+		/*!
+		 * Hands the frame slot's readback to the callback, once its fence has been waited on
+		 */
+		void deliverReadback(uint32 frameIndex);
+		void updateFrameStats(double fenceWaitMs, double acquireWaitMs);
 
 
 		void inline destroySurface();
 		void inline destroyInstance();
 		void inline destroyLogicalDevice();
+		void inline destroyRenderGraph();
+		void inline destroyGpuProfiler();
+		void inline destroyAllocator();
+		void inline destroyPipelineCache();
+		void inline destroyUploadManager();
 		void inline destroySwapchain();
+		void inline destroyOffscreenTargets();
 		void inline destroyImageviews();
-		void inline destroyRenderpass();
+		void inline destroyTextureImage();
+		void inline destroyBindlessTable();
+		void inline destroyTextureManager();
+		void inline destroyUniformBuffers();
+		void inline destroyDescriptorPool();
+		void inline destroyGraphicsPipeline();
+		void inline destroyCommandPool();
+		void inline destroySyncObjects();
+		void inline destroySpriteBatcher();
+		void inline destroyGpuScene();
 
 	private:
 		VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 		VkFormat findDepthFormat();
 
-		uint32 findMemoryType(uint32 typeFilter, VkMemoryPropertyFlags properties);
-
 		void createImage(VkImage& image,
-		                 VkDeviceMemory& imageMemory,
+		                 Allocation& allocation,
 		                 uint32 width,
 		                 uint32 height,
 		                 VkFormat format,
@@ -154,6 +436,12 @@ namespace SpRenderer {
 		                 VkMemoryPropertyFlags
 		                 properties);
 
+		void createBuffer(VkBuffer& buffer,
+		                  Allocation& allocation,
+		                  VkDeviceSize size,
+		                  VkBufferUsageFlags usage,
+		                  VkMemoryPropertyFlags properties);
+
 		void createImageView(VkImageView& imageView, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
 	};
 } // SpRenderer
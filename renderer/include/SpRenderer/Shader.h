@@ -6,58 +6,26 @@
 #define SPARKER_ENGINE_SHADER_H
 
 #include "Utils.h"
+#include "ShaderCache.h"
 #include "shaderc/shaderc.hpp"
 
-#define SHADER_EXTENSION_COMPILED ".comp"
-#define SHADER_EXTENSION_COMPILED_VERTEX ".vert.comp"
-#define SHADER_EXTENSION_COMPILED_FRAGMENT ".frag.comp"
-
 class Shader {
-private:
-	enum ShaderCompileFlags {
-		CompileVertex = 0x00000001,
-		CompileFragment = 0x00000010
-	};
-
-	enum ShaderType {
-		SHADER_VERTEX,
-		SHADER_FRAGMENT
-	};
-
-	std::string shaderExtension(ShaderType type);
 public:
-	struct ShaderContext {
-		VkShaderModule vertexShaderModule;
-		VkShaderModule fragmentShaderModule;
-	};
-
 	/**
 	 *
-	 * @param vertexShaderFilePath Required .vert file extension
-	 * @param fragmentShaderFilePath Required .frag file extension
+	 * @param includedFiles Receives every file pulled in through #include, for the cache key
+	 * @return Empty when compilation failed, the errors are written to the console
 	 */
-	void createShader(const std::string vertexShaderFilePath, const std::string fragmentShaderFilePath, VkDevice device);
-
-	ShaderContext getShaderContext();
-
-
-private:
-	ShaderContext mShaderContext;
-
-	VkDevice mDevice;
-
-	uint8 mCompileFlags = 0x00000000;
-
-	std::vector<uint32> mVertSPIRV = {};
-	std::vector<uint32> mFragSPIRV = {};
+	static std::vector<uint32> compileShader(const shaderc::Compiler& compiler,
+	                                         const std::filesystem::path& filePath,
+	                                         ShaderStage stage,
+	                                         const ShaderCompileSettings& settings,
+	                                         std::vector<std::string>& includedFiles);
 
-	std::vector<uint32> compileShader(std::filesystem::path filePath);
+	static VkShaderModule createShaderModule(VkDevice device, std::span<const uint32> spirv);
 
-	void compiledCheck(std::string fileName, ShaderType type);
-	void recompileDateCheck(std::string fileName, ShaderType type);
-	void writeToFile(std::string fileName, ShaderType type);
-	std::vector<uint32> readFromFile(std::string fileName, ShaderType type);
+	static shaderc_shader_kind shaderKind(ShaderStage stage);
 };
 
 
-#endif //SPARKER_ENGINE_SHADER_H
\ No newline at end of file
+#endif //SPARKER_ENGINE_SHADER_H
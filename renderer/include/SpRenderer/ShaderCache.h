@@ -0,0 +1,132 @@
+//
+// Created by robsc on 11/24/25.
+//
+
+#ifndef SPARKER_ENGINE_SHADERCACHE_H
+#define SPARKER_ENGINE_SHADERCACHE_H
+
+#include "Utils.h"
+#include "shaderc/shaderc.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+#define SHADER_CACHE_FILE_NAME "shader_cache.bin"
+
+enum ShaderStage : uint32 {
+	SP_SHADER_STAGE_VERTEX,
+	SP_SHADER_STAGE_FRAGMENT,
+	SP_SHADER_STAGE_COMPUTE
+};
+
+struct ShaderCompileSettings {
+	shaderc_optimization_level optimizationLevel = shaderc_optimization_level_performance;
+	bool generateDebugInfo = false;
+	uint32 targetEnvironmentVersion = shaderc_env_version_vulkan_1_0;
+	std::vector<std::pair<std::string, std::string>> macros = {};
+
+	void apply(shaderc::CompileOptions& options) const;
+	uint64 fingerprint() const;
+};
+
+/**
+ * Persistent SPIR-V cache stored as a single indexed file in RENDERER_DATA_DIR/shaders.
+ *
+ * Entries are keyed by a hash of the shader source, the source of every file it includes, the compile settings
+ * and the compiler build (SHADER_COMPILER_VERSION), so editing an include, changing an option or upgrading shaderc
+ * misses the cache while touching a file without changing it does not. The file is memory mapped on load and cached SPIR-V is handed out
+ * straight from the mapping.
+ */
+class ShaderCache {
+public:
+	ShaderCache() = default;
+	ShaderCache(const ShaderCache&) = delete;
+	ShaderCache& operator=(const ShaderCache&) = delete;
+	~ShaderCache();
+
+	void load(const std::filesystem::path& cacheDirectory);
+	/*!
+	 * Writes the cache atomically when anything was added since the last load or save
+	 */
+	void save();
+
+	/**
+	 * The returned span stays valid until the next save()
+	 *
+	 * @return false when the shader, or one of its includes, changed since it was cached
+	 */
+	bool find(const std::filesystem::path& sourcePath,
+	          ShaderStage stage,
+	          const ShaderCompileSettings& settings,
+	          std::span<const uint32>& spirv);
+
+	void store(const std::filesystem::path& sourcePath,
+	           ShaderStage stage,
+	           const ShaderCompileSettings& settings,
+	           const std::vector<std::string>& includedFiles,
+	           const std::vector<uint32>& spirv);
+
+	uint32 hitCount() const { return mHits; }
+	uint32 missCount() const { return mMisses; }
+
+	static uint64 compilerVersion();
+
+private:
+	enum EntryKind : uint32 {
+		SP_SHADER_CACHE_SPIRV,
+		SP_SHADER_CACHE_DEPENDENCIES
+	};
+
+	struct CacheHeader {
+		uint32 magic;
+		uint32 version;
+		uint64 compilerVersion;
+		uint32 entryCount;
+		uint32 reserved;
+	};
+
+	// Sorted by key so lookups are a binary search over the mapped file
+	struct CacheEntry {
+		uint64 key;
+		uint64 offset;
+		uint64 size;
+		uint32 kind;
+		uint32 reserved;
+	};
+
+	struct PendingEntry {
+		EntryKind kind;
+		std::vector<uint8> data;
+	};
+
+	std::filesystem::path mCachePath;
+
+	Utils::MappedFile mCacheFile;
+	const uint8* mMappedData = nullptr;
+	size_t mMappedSize = 0;
+
+	const CacheEntry* mEntries = nullptr;
+	uint32 mEntryCount = 0;
+
+	std::mutex mMutex;
+	std::unordered_map<uint64, PendingEntry> mPending;
+
+	std::atomic<uint32> mHits = 0;
+	std::atomic<uint32> mMisses = 0;
+
+	bool mapCacheFile();
+	void unmapCacheFile();
+
+	bool lookup(uint64 key, EntryKind kind, std::span<const uint8>& data);
+
+	static uint64 dependencyKey(const std::filesystem::path& sourcePath, ShaderStage stage, const ShaderCompileSettings& settings);
+	static bool contentKey(const std::filesystem::path& sourcePath,
+	                       ShaderStage stage,
+	                       const ShaderCompileSettings& settings,
+	                       const std::vector<std::string>& includedFiles,
+	                       uint64& key);
+};
+
+#endif //SPARKER_ENGINE_SHADERCACHE_H
@@ -0,0 +1,73 @@
+//
+// Created by robsc on 11/25/25.
+//
+
+#ifndef SPARKER_ENGINE_SHADERLIBRARY_H
+#define SPARKER_ENGINE_SHADERLIBRARY_H
+
+#include "Utils.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+#include "ShaderReflection.h"
+
+#include <unordered_map>
+
+struct ShaderModuleInfo {
+	std::string name; // Path relative to the shader directory, e.g. "Vertex2D Base.vert"
+	std::filesystem::path path;
+	ShaderStage stage;
+	VkShaderModule module = VK_NULL_HANDLE;
+	SpRenderer::ShaderReflection reflection;
+	std::vector<uint32> spirv; // Only until createModules()
+
+	double compileMs = 0.0; // Includes the cache lookup, so cached shaders report how long the lookup took
+	bool cached = false;
+};
+
+/**
+ * Owns the shader modules for every shader under RENDERER_RESOURCE_DIR/shaders. compileAll() compiles them on a
+ * pool of worker threads, each keeping a single shaderc::Compiler for all of the shaders it picks up. It does not
+ * need a device, so it can run while the device is still being created, createModules() finishes the job.
+ */
+class ShaderLibrary {
+public:
+	/**
+	 *
+	 * @param threadCount 0 uses one thread per hardware thread, never more than there are shaders
+	 */
+	void compileAll(ShaderCache& shaderCache, const ShaderCompileSettings& settings = {}, uint32 threadCount = 0);
+	/*!
+	 * Creates the modules of everything compileAll() found and drops their SPIR-V
+	 */
+	void createModules(VkDevice device);
+	void destroy();
+
+	/*!
+	 * Fatal when no shader with that name was compiled
+	 */
+	VkShaderModule getModule(const std::string& name) const;
+	/*!
+	 * Fatal when no shader with that name was compiled
+	 */
+	const SpRenderer::ShaderReflection& getReflection(const std::string& name) const;
+	/*!
+	 * nullptr when no shader with that name was compiled
+	 */
+	const ShaderModuleInfo* findShader(const std::string& name) const;
+	const std::vector<ShaderModuleInfo>& getShaders() const;
+
+	void logCompileTimes() const;
+
+	static std::vector<std::filesystem::path> findShaderSources(const std::filesystem::path& directory);
+
+private:
+	VkDevice mDevice = VK_NULL_HANDLE;
+
+	std::vector<ShaderModuleInfo> mShaders;
+	std::unordered_map<std::string, size_t> mShaderIndices;
+
+	double mTotalMs = 0.0;
+	uint32 mThreadCount = 0;
+};
+
+#endif //SPARKER_ENGINE_SHADERLIBRARY_H
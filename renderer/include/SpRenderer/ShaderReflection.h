@@ -0,0 +1,88 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_SHADERREFLECTION_H
+#define SPARKER_ENGINE_SHADERREFLECTION_H
+
+#include "Utils.h"
+
+namespace SpRenderer {
+	struct ReflectedBinding {
+		uint32 set = 0;
+		uint32 binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		uint32 count = 1;               // 0 for unsized arrays
+		VkShaderStageFlags stages = 0;
+		std::string name;
+	};
+
+	// Numeric type a vertex input is read as, an attribute feeding it has to convert to the same one
+	enum VertexInputType {
+		SP_VERTEX_INPUT_FLOAT, // Float formats, unorm and snorm included
+		SP_VERTEX_INPUT_SINT,
+		SP_VERTEX_INPUT_UINT
+	};
+
+	struct ReflectedVertexInput {
+		uint32 location = 0;
+		VertexInputType type = SP_VERTEX_INPUT_FLOAT;
+		uint32 componentCount = 1;
+		std::string name;
+	};
+
+	struct ReflectedSpecConstant {
+		uint32 id = 0;            // constant_id in GLSL
+		uint32 size = 4;          // Bytes in VkSpecializationMapEntry, bools are VkBool32
+		uint32 defaultValue = 0;  // Low word for 64 bit constants
+		std::string name;
+	};
+
+	/**
+	 * Interface of one shader stage, or of several stages merged with merge(). Reflection reads the SPIR-V
+	 * declarations only, so a resource that is declared but never used still shows up.
+	 */
+	struct ShaderReflection {
+		VkShaderStageFlags stages = 0;
+
+		std::vector<ReflectedBinding> bindings;      // Sorted by set, then binding
+		std::vector<VkPushConstantRange> pushConstants; // At most one range per stage
+		std::vector<ReflectedVertexInput> inputs;    // Vertex stage only, sorted by location
+		std::vector<ReflectedSpecConstant> specConstants;
+
+		/**
+		 *
+		 * @return False when the code is not SPIR-V or uses something reflection does not understand, the reason is
+		 *         written to the console
+		 */
+		bool reflect(std::span<const uint32> spirv);
+
+		/*!
+		 * Adds another stage's interface. A binding both stages declare is merged into one visible to both, a binding
+		 * declared with different types is fatal
+		 */
+		void merge(const ShaderReflection& other);
+
+		uint32 setCount() const;
+
+		/*!
+		 * Bindings of one set in the form vkCreateDescriptorSetLayout takes them
+		 */
+		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(uint32 set) const;
+
+		/**
+		 * Checks every vertex input the shader reads is fed by an attribute converting to the same numeric type. Extra
+		 * attributes are allowed.
+		 *
+		 * @param error Receives the first mismatch
+		 */
+		bool validateVertexInput(const VkPipelineVertexInputStateCreateInfo& vertexInputInfo, std::string& error) const;
+	};
+
+	/*!
+	 * SP_VERTEX_INPUT_FLOAT for formats this can't classify
+	 */
+	VertexInputType vertexInputType(VkFormat format);
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_SHADERREFLECTION_H
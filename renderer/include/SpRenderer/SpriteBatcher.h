@@ -0,0 +1,211 @@
+//
+// Created by robsc on 11/28/25.
+//
+
+#ifndef SPARKER_ENGINE_SPRITEBATCHER_H
+#define SPARKER_ENGINE_SPRITEBATCHER_H
+
+#include "Utils.h"
+#include "MemoryAllocator.h"
+#include "PipelineRegistry.h"
+#include "Vertex.h"
+
+#include <span>
+
+namespace SpRenderer {
+	const uint32 InitialSpriteCapacity = 16 * 1024;
+	const uint32 MaxSpritePipelines = 256;       // Pipeline ids take the top 8 bits of the sort key
+	const uint32 MaxSpriteTextures = 1u << 24;   // Texture ids take the next 24 bits
+
+	struct Sprite {
+		vec2 position;                    // Center, in pixels from the top left of the window
+		vec2 size;                        // In pixels
+		vec4 uvRect = vec4(0.0f, 0.0f, 1.0f, 1.0f); // Offset in xy, scale in zw
+		uint32 color = 0xFFFFFFFF;        // RGBA8, R in the lowest byte
+		float rotation = 0.0f;            // Radians
+		float depth = 0.5f;               // [0, 1], smaller is closer
+		uint32 texture = 0;               // Index into the bindless texture table, 0 is plain white
+		uint32 pipeline = 0;              // Id returned by SpriteBatcher::registerPipeline
+	};
+
+	// Per instance vertex data, binding 1 of the sprite pipeline
+	struct SpriteInstance {
+		vec2 position;
+		vec2 size;
+		vec4 uvRect;
+		Unorm8x4 color;
+		float rotation;
+		float depth;
+		uint32 texture;
+	};
+
+	template<>
+	struct VertexLayout<SpriteInstance> {
+		static constexpr VkVertexInputRate InputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		// Locations 0 to 2 are the per vertex quad corner
+		static constexpr std::array Attributes = {
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, position, 3),
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, size, 4),
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, uvRect, 5),
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, color, 6),
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, rotation, 7),
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, depth, 8),
+			SP_VERTEX_ATTRIBUTE(SpriteInstance, texture, 9)
+		};
+	};
+
+	// Quad corners per vertex, one sprite per instance
+	using SpriteVertexInput = VertexInputLayout<Vertex2DPacked, SpriteInstance>;
+
+	struct SpriteBatchStats {
+		uint32 spriteCount = 0;
+		uint32 batchCount = 0;
+		uint32 pipelineBinds = 0;
+
+		double sortMs = 0.0;   // Building keys and sorting
+		double writeMs = 0.0;  // Writing instances to the mapped buffer
+		double recordMs = 0.0; // Recording the draws
+	};
+
+	/**
+	 * Collects sprites over a frame and draws them as instanced quads. Sprites are sorted by pipeline, then texture,
+	 * then depth, written in that order to a mapped instance buffer owned by the frame in flight, and drawn with
+	 * one vkCmdDrawIndexed per run of sprites sharing a pipeline. The shaders pick each sprite's texture out of the
+	 * bindless table, sorting by texture only keeps neighbouring instances on the same texture.
+	 *
+	 * Render thread only, except for recordRange().
+	 */
+	class SpriteBatcher {
+	public:
+		struct SpriteBatch {
+			uint32 pipeline;
+			uint32 firstInstance;
+			uint32 instanceCount;
+		};
+
+		void init(VkDevice device, MemoryAllocator& allocator, uint32 framesInFlight);
+		void destroy();
+
+		/**
+		 *
+		 * @param layout Needs a 16 byte vertex stage push constant range for the viewport transform. The descriptor sets
+		 *               are bound by the caller before record()
+		 * @return Id to put in Sprite::pipeline
+		 */
+		uint32 registerPipeline(VkPipeline pipeline, VkPipelineLayout layout);
+		/**
+		 * Pipeline looked up in the registry every time it is bound, batches using it are skipped until it has
+		 * compiled.
+		 *
+		 * @param registry Has to outlive the batcher
+		 */
+		uint32 registerPipeline(const PipelineRegistry& registry, PipelineKey key, VkPipelineLayout layout);
+
+		void draw(const Sprite& sprite);
+		void draw(std::span<const Sprite> sprites);
+
+		/*!
+		 * Sorts everything drawn since the last call into the frame's instance buffer. The frame's fence must have been waited on
+		 */
+		void prepare(uint32 frameIndex);
+		/*!
+		 * Records the draws prepared for the frame. Call inside a render pass with viewport, scissor and the frame's
+		 * descriptor sets bound
+		 */
+		void record(VkCommandBuffer commandBuffer, uint32 frameIndex, VkExtent2D extent);
+		/**
+		 * Records the draws of the prepared instances [firstInstance, firstInstance + instanceCount), same requirements
+		 * as record(). Does not touch the stats, so ranges can be recorded into different command buffers from several
+		 * threads at once. Executing the ranges in order draws exactly what record() does
+		 *
+		 * @return Pipeline binds recorded
+		 */
+		uint32 recordRange(VkCommandBuffer commandBuffer,
+		                   uint32 frameIndex,
+		                   VkExtent2D extent,
+		                   uint32 firstInstance,
+		                   uint32 instanceCount) const;
+
+		/*!
+		 * Instances prepared for the frame
+		 */
+		uint32 getInstanceCount(uint32 frameIndex) const;
+		/*!
+		 * For callers recording with recordRange(), record() sets these itself
+		 */
+		void setRecordStats(uint32 pipelineBinds, double recordMs);
+
+		const SpriteBatchStats& getStats() const { return mStats; }
+
+		/**
+		 * LSD radix sort of keys, carrying values along. Passes over bytes every key shares are skipped.
+		 *
+		 * @param keysScratch Same size as keys, contents are overwritten
+		 * @param valuesScratch Same size as values, contents are overwritten
+		 */
+		static void radixSort(std::vector<uint64>& keys,
+		                      std::vector<uint32>& values,
+		                      std::vector<uint64>& keysScratch,
+		                      std::vector<uint32>& valuesScratch);
+
+		/*!
+		 * Pipeline in the top 8 bits, texture in the next 24, depth in the low 32
+		 */
+		static uint64 sortKey(const Sprite& sprite);
+
+		/**
+		 * Writes the sprites as instances in sorted order and starts a batch wherever the pipeline changes. Holds no
+		 * Vulkan objects, so it can be measured on its own
+		 *
+		 * @param keys Sorted sort keys
+		 * @param order Index into sprites of each key
+		 * @param instances Room for order.size() instances, written front to back
+		 */
+		static void packInstances(std::span<const Sprite> sprites,
+		                          std::span<const uint64> keys,
+		                          std::span<const uint32> order,
+		                          SpriteInstance* instances,
+		                          std::vector<SpriteBatch>& batches);
+
+	private:
+		struct FrameInstances {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation;
+			uint32 capacity = 0;
+			std::vector<SpriteBatch> batches;
+		};
+
+		struct PipelineEntry {
+			VkPipeline pipeline;
+			VkPipelineLayout layout;
+
+			const PipelineRegistry* registry = nullptr; // Resolves pipeline when set
+			PipelineKey key = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		MemoryAllocator* mAllocator = nullptr;
+
+		VkBuffer mQuadBuffer = VK_NULL_HANDLE;
+		Allocation mQuadAllocation;
+		VkDeviceSize mQuadIndexOffset = 0;
+
+		std::vector<FrameInstances> mFrames;
+		std::vector<PipelineEntry> mPipelines;
+
+		std::vector<Sprite> mSprites;
+
+		// Reused every frame so sorting does not allocate once the sprite count settles
+		std::vector<uint64> mKeys;
+		std::vector<uint32> mOrder;
+		std::vector<uint64> mKeysScratch;
+		std::vector<uint32> mOrderScratch;
+
+		SpriteBatchStats mStats;
+
+		void createQuadBuffer();
+		void reserveInstances(FrameInstances& frame, uint32 spriteCount);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_SPRITEBATCHER_H
@@ -0,0 +1,60 @@
+//
+// Created by robsc on 11/28/25.
+//
+
+#ifndef SPARKER_ENGINE_SPRITEBENCHMARK_H
+#define SPARKER_ENGINE_SPRITEBENCHMARK_H
+
+#include "Utils.h"
+#include "SpriteBatcher.h"
+
+#include <random>
+
+namespace SpRenderer {
+	class RendererCore;
+
+	/**
+	 * Stress scene for the sprite batcher. Moves a fixed number of sprites around the window every frame and
+	 * periodically logs how many sprites the CPU side gets through per millisecond, counting the time spent
+	 * submitting, sorting, writing instances and recording draws.
+	 */
+	class SpriteBenchmark {
+	public:
+		/**
+		 *
+		 * @param textureCount Distinct texture ids to spread the sprites over, each one is its own batch
+		 * @param pipelineCount Distinct pipeline ids to spread the sprites over, all must be registered
+		 */
+		void init(uint32 spriteCount, uint32 textureCount = 16, uint32 pipelineCount = 1, uint32 seed = 1);
+
+		/*!
+		 * Submits the scene, call once per frame before RendererCore::endFrame()
+		 */
+		void update(RendererCore& renderer, double deltaSeconds);
+
+		void logResults() const;
+
+	private:
+		struct SpriteMotion {
+			vec2 velocity;
+			float spin;
+		};
+
+		std::vector<Sprite> mSprites;
+		std::vector<SpriteMotion> mMotion;
+		std::mt19937 mRandom;
+
+		uint64 mFrameCount = 0;
+		uint64 mSpritesDrawn = 0;
+		double mCpuMs = 0.0;
+		double mSecondsSinceLog = 0.0;
+
+		// Totals since the last log
+		uint64 mWindowFrames = 0;
+		uint64 mWindowSprites = 0;
+		double mWindowCpuMs = 0.0;
+		uint32 mLastBatchCount = 0;
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_SPRITEBENCHMARK_H
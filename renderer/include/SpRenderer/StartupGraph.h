@@ -0,0 +1,92 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_STARTUPGRAPH_H
+#define SPARKER_ENGINE_STARTUPGRAPH_H
+
+#include "Utils.h"
+#include "JobSystem.h"
+
+#include <deque>
+
+namespace SpRenderer {
+	typedef uint32 StartupStageId;
+
+	struct StartupStageTiming {
+		const char* name;
+		uint32 thread;      // JobSystem::threadIndex() it ran on
+		double startMs;     // Since StartupGraph::run() began
+		double durationMs;
+		bool critical;      // On the dependency chain that finished last, the one to shorten
+	};
+
+	struct StartupReport {
+		double totalMs = 0.0; // Wall time of run()
+		double stageMs = 0.0; // Every stage summed, more than totalMs by whatever overlapped
+		std::vector<StartupStageTiming> stages; // In the order they were added
+	};
+
+	/**
+	 * Stages of an initialization with the stages they depend on. run() hands them to the job system, so stages
+	 * that don't depend on each other overlap, and times every stage. A stage can only depend on stages added
+	 * before it, which keeps the graph free of cycles.
+	 *
+	 * Single use, build and run on the job system's main thread.
+	 */
+	class StartupGraph {
+	public:
+		explicit StartupGraph(JobSystem& jobSystem) : mJobSystem(jobSystem) {}
+
+		StartupGraph(const StartupGraph&) = delete;
+		StartupGraph& operator=(const StartupGraph&) = delete;
+
+		/**
+		 *
+		 * @param name Has to outlive the graph, it ends up in the profiler too
+		 * @param dependencies Stages that have to finish first
+		 */
+		StartupStageId add(const char* name, Job job, std::initializer_list<StartupStageId> dependencies = {});
+		/*!
+		 * Same as add(), for stages that have to run on the main thread like anything touching SDL
+		 */
+		StartupStageId addMainThread(const char* name, Job job, std::initializer_list<StartupStageId> dependencies = {});
+
+		/*!
+		 * Runs every stage and returns once all of them are done, running stages itself while waiting
+		 */
+		void run();
+
+		const StartupReport& getReport() const { return mReport; }
+		void logReport() const;
+
+	private:
+		struct Stage {
+			const char* name;
+			Job job;
+			std::vector<StartupStageId> dependencies;
+			bool mainThread;
+
+			JobCounter dependencyCounter; // Joins the dependencies when there is more than one
+			JobCounter counter;
+
+			uint32 thread = InvalidJobThread;
+			std::chrono::steady_clock::time_point startTime;
+			std::chrono::steady_clock::time_point endTime;
+		};
+
+		JobSystem& mJobSystem;
+		std::deque<Stage> mStages; // Never moves its elements, jobs keep pointers to them
+		bool mRan = false;
+
+		std::chrono::steady_clock::time_point mStartTime;
+		StartupReport mReport;
+
+		StartupStageId addStage(const char* name, Job job, std::initializer_list<StartupStageId> dependencies, bool mainThread);
+		void submit(Stage& stage);
+		void execute(Stage& stage);
+		void buildReport();
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_STARTUPGRAPH_H
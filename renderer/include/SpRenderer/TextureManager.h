@@ -0,0 +1,173 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_TEXTUREMANAGER_H
+#define SPARKER_ENGINE_TEXTUREMANAGER_H
+
+#include "Utils.h"
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "BindlessTable.h"
+#include "JobSystem.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace SpRenderer {
+	// Every mip this size or smaller goes up with the first upload, so a texture is usable as soon as possible
+	const uint32 MipTailSize = 64;
+	// Bytes of finer mips started per update(), a mip larger than this still goes up on its own
+	const VkDeviceSize DefaultStreamBudget = 8ull * 1024 * 1024;
+
+	typedef uint32 TextureHandle;
+	const TextureHandle InvalidTexture = std::numeric_limits<TextureHandle>::max();
+
+	// Format stored in the file to the format its image is created with, see RendererCore::createTextureManager
+	typedef std::unordered_map<VkFormat, VkFormat> TextureFormatMap;
+
+	enum TextureState {
+		SP_TEXTURE_LOADING,   // Waiting on its decode job
+		SP_TEXTURE_STREAMING, // Some mips are resident, finer ones are still being uploaded
+		SP_TEXTURE_RESIDENT,  // Every mip is resident
+		SP_TEXTURE_FAILED     // Draws with the default texture
+	};
+
+	struct TextureStats {
+		uint32 textureCount = 0;
+		uint32 streamingCount = 0;
+		uint32 residentCount = 0;
+		uint32 failedCount = 0;
+		uint32 fallbackCount = 0; // Decoded on the CPU because the device cannot sample the file's format
+
+		VkDeviceSize memoryBytes = 0;      // Device memory of every texture image
+		VkDeviceSize rgba8Bytes = 0;       // What the same images would take as RGBA8
+		VkDeviceSize uploadedBytes = 0;
+
+		double decodeMs = 0.0; // Job time spent parsing and decoding, summed over every texture
+	};
+
+	/**
+	 * Loads KTX2 textures with their full mip chain and streams them onto the GPU. Files are mapped, parsed and,
+	 * when the device cannot sample their block compressed format, decoded in jobs on the job system. update() then creates
+	 * the image, uploads the mip tail first and works its way towards the full size mip a few mips per frame.
+	 *
+	 * Each time finer mips become resident the texture gets a new view covering them and a new bindless index, the
+	 * previous ones stay valid for the frames in flight that still use them. Read getIndex() every frame.
+	 */
+	class TextureManager {
+	public:
+		/**
+		 *
+		 * @param uploadFormats Format to create images with for every block compressed format, formats missing from it
+		 *                      are uploaded as they are
+		 */
+		void init(VkDevice device,
+		          MemoryAllocator& allocator,
+		          UploadManager& uploadManager,
+		          BindlessTable& bindlessTable,
+		          JobSystem& jobSystem,
+		          uint32 framesInFlight,
+		          const TextureFormatMap& uploadFormats);
+		/*!
+		 * Waits for outstanding decode jobs. The device must be idle
+		 */
+		void destroy();
+
+		/*!
+		 * Queues a decode job for the file. Any thread
+		 */
+		TextureHandle load(const std::filesystem::path& filePath);
+
+		/*!
+		 * Index to put in Sprite::texture. The default texture until the first mips are resident, changes as finer mips stream in
+		 */
+		BindlessIndex getIndex(TextureHandle texture);
+		TextureState getState(TextureHandle texture);
+
+		/*!
+		 * Creates images for decoded textures and streams mips. Render thread only, once per frame before the bindless table commits
+		 */
+		void update(uint64 frameNumber);
+
+		void setStreamBudget(VkDeviceSize bytesPerUpdate) { mStreamBudget = bytesPerUpdate; }
+
+		TextureStats getStats();
+		void logStats();
+
+	private:
+		// CPU copy of the mips that are not uploaded yet, freed once the last one is
+		struct TextureSource {
+			Utils::MappedFile file;
+			std::vector<std::vector<uint8>> decodedLevels; // Only when decoded on the CPU
+			std::vector<std::span<const uint8>> levels;    // Into the file or decodedLevels
+
+			VkFormat format = VK_FORMAT_UNDEFINED; // Format of the data in levels
+			uint32 width = 0;
+			uint32 height = 0;
+			bool decoded = false;
+			double decodeMs = 0.0;
+		};
+
+		struct Texture {
+			std::filesystem::path path;
+			TextureState state = SP_TEXTURE_LOADING;
+			BindlessIndex index = DefaultBindlessIndex;
+
+			VkImage image = VK_NULL_HANDLE;
+			Allocation allocation;
+			VkImageView view = VK_NULL_HANDLE;
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			uint32 width = 0;
+			uint32 height = 0;
+			uint32 mipCount = 0;
+
+			uint32 residentMip = 0;  // Finest mip the view covers, mipCount while nothing is resident
+			uint32 uploadedMip = 0;  // Finest mip handed to the upload manager
+			UploadTicket ticket = 0; // Completes once uploadedMip is on the GPU
+
+			std::unique_ptr<TextureSource> source;
+		};
+
+		struct DecodeResult {
+			TextureHandle texture;
+			std::unique_ptr<TextureSource> source; // Null when loading failed
+			std::string error;
+		};
+
+		struct RetiredView {
+			VkImageView view;
+			uint64 retireFrame;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		MemoryAllocator* mAllocator = nullptr;
+		UploadManager* mUploadManager = nullptr;
+		BindlessTable* mBindlessTable = nullptr;
+		JobSystem* mJobSystem = nullptr;
+		uint32 mFramesInFlight = 0;
+		TextureFormatMap mUploadFormats;
+		VkDeviceSize mStreamBudget = DefaultStreamBudget;
+
+		std::mutex mTextureMutex;
+		std::vector<Texture> mTextures;
+		std::vector<RetiredView> mRetiredViews;
+
+		JobCounter mDecodeCounter;
+		std::mutex mResultMutex;
+		std::vector<DecodeResult> mResults;
+
+		TextureStats mStats;
+
+		void decodeJob(TextureHandle texture, const std::filesystem::path& filePath);
+		std::unique_ptr<TextureSource> decode(const std::filesystem::path& filePath, std::string& error) const;
+
+		void createTexture(Texture& texture, std::unique_ptr<TextureSource> source);
+		VkDeviceSize uploadMip(Texture& texture, uint32 mip);
+		void updateView(Texture& texture, uint64 frameNumber);
+		void releaseRetiredViews(uint64 frameNumber, bool force);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_TEXTUREMANAGER_H
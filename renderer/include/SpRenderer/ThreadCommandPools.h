@@ -0,0 +1,50 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_THREADCOMMANDPOOLS_H
+#define SPARKER_ENGINE_THREADCOMMANDPOOLS_H
+
+#include "Utils.h"
+
+namespace SpRenderer {
+	/**
+	 * One command pool per frame in flight and job thread, so threads can record secondary command buffers without
+	 * locking. Command pools are not thread safe, a thread only ever allocates from its own. Buffers are allocated
+	 * once and reused, reset() hands all of a frame's back at once with vkResetCommandPool.
+	 */
+	class ThreadCommandPools {
+	public:
+		void init(VkDevice device, uint32 queueFamilyIndex, uint32 framesInFlight, uint32 threadCount);
+		/*!
+		 * The device must be idle
+		 */
+		void destroy();
+
+		/*!
+		 * Recycles every buffer the frame allocated. Its fence must have been waited on
+		 */
+		void reset(uint32 frameIndex);
+
+		/**
+		 * Begins a secondary command buffer that continues a render pass
+		 *
+		 * @param threadIndex JobSystem::threadIndex() of the calling thread
+		 * @param inheritance RenderGraph::PassContext::inheritance of the pass it is executed in
+		 */
+		VkCommandBuffer beginSecondary(uint32 frameIndex, uint32 threadIndex, const VkCommandBufferInheritanceInfo& inheritance);
+
+	private:
+		struct ThreadPool {
+			VkCommandPool pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> buffers;
+			uint32 usedCount = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		uint32 mThreadCount = 0;
+		std::vector<ThreadPool> mPools; // frameIndex * mThreadCount + threadIndex
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_THREADCOMMANDPOOLS_H
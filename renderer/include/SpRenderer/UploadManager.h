@@ -0,0 +1,165 @@
+//
+// Created by robsc on 11/27/25.
+//
+
+#ifndef SPARKER_ENGINE_UPLOADMANAGER_H
+#define SPARKER_ENGINE_UPLOADMANAGER_H
+
+#include "Utils.h"
+#include "MemoryAllocator.h"
+#include "QueueFamily.h"
+
+#include <mutex>
+
+namespace SpRenderer {
+	const VkDeviceSize DefaultStagingSize = 32ull * 1024 * 1024;
+	const VkDeviceSize StagingAlignment = 16;
+	const uint32 UploadBatchCount = 8;
+
+	// Completes in order, an upload is done once the transfer timeline reaches its ticket
+	typedef uint64 UploadTicket;
+
+	struct UploadStats {
+		uint64 submitCount = 0;
+		uint64 copyCount = 0;
+		uint64 uploadedBytes = 0;
+		uint64 stallCount = 0; // Times an upload had to wait for the GPU to free staging space or a batch
+		uint32 oversizeCount = 0; // Uploads too large for the ring that got their own staging buffer
+	};
+
+	/**
+	 * Streams buffer and image data to the GPU through a persistently mapped staging ring.
+	 *
+	 * Uploads can be queued from any thread. Their data is copied into the ring straight away and the copies are
+	 * recorded into the current batch, which flush() submits to the transfer queue. Batches signal a timeline
+	 * semaphore, or a fence per batch when timeline semaphores are unavailable, so completion is polled without
+	 * blocking. When the transfer family is separate from the graphics family, ownership of every resource is
+	 * released on the transfer queue and acquired on the graphics queue by recordAcquireBarriers() once its batch
+	 * finished.
+	 */
+	class UploadManager {
+	public:
+		void init(VkDevice device,
+		          MemoryAllocator& allocator,
+		          QueueFamilyIndices indices,
+		          VkQueue transferQueue,
+		          bool timelineSemaphores,
+		          VkDeviceSize stagingSize = DefaultStagingSize);
+		/*!
+		 * Waits for every upload, call before the resources they write to are destroyed
+		 */
+		void destroy();
+
+		/**
+		 *
+		 * @param dstStageMask Graphics stages that will read the buffer
+		 * @param dstAccessMask How those stages read it
+		 */
+		UploadTicket uploadBuffer(VkBuffer buffer,
+		                          VkDeviceSize offset,
+		                          const void* data,
+		                          VkDeviceSize size,
+		                          VkPipelineStageFlags dstStageMask,
+		                          VkAccessFlags dstAccessMask);
+
+		/**
+		 * Uploads one mip level of every array layer in the range, tightly packed. The mip level is transitioned from
+		 * UNDEFINED, so whatever it held before is lost.
+		 *
+		 * @param finalLayout Layout the image is in once the ticket completed
+		 */
+		UploadTicket uploadImage(VkImage image,
+		                         const VkImageSubresourceLayers& subresource,
+		                         VkExtent3D extent,
+		                         const void* data,
+		                         VkDeviceSize size,
+		                         VkImageLayout finalLayout,
+		                         VkPipelineStageFlags dstStageMask,
+		                         VkAccessFlags dstAccessMask);
+
+		/*!
+		 * Submits everything queued since the last flush as one batch. Render thread only, once per frame
+		 */
+		void flush();
+
+		/*!
+		 * Records queue family acquire barriers for finished uploads. Render thread only, before anything reads them
+		 */
+		void recordAcquireBarriers(VkCommandBuffer commandBuffer);
+
+		/*!
+		 * Finished uploads are visible to graphics work recorded after the next recordAcquireBarriers()
+		 */
+		bool isComplete(UploadTicket ticket);
+		/*!
+		 * Submits the current batch first when the ticket is in it, so render thread only like flush()
+		 */
+		void wait(UploadTicket ticket);
+
+		UploadStats getStats();
+
+	private:
+		struct UploadBatch {
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+
+			UploadTicket ticket = 0;
+			VkDeviceSize ringEnd = 0;
+			bool recording = false;
+			bool submitted = false;
+			uint32 copyCount = 0;
+
+			VkPipelineStageFlags acquireStageMask = 0;
+			std::vector<VkBufferMemoryBarrier> bufferAcquires;
+			std::vector<VkImageMemoryBarrier> imageAcquires;
+
+			std::vector<std::pair<VkBuffer, Allocation>> oversizeStaging;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		MemoryAllocator* mAllocator = nullptr;
+		QueueFamilyIndices mIndices;
+		VkQueue mTransferQueue = VK_NULL_HANDLE;
+
+		bool mTimelineSemaphores = false;
+		bool mOwnershipTransfer = false;
+		VkSemaphore mTimelineSemaphore = VK_NULL_HANDLE;
+
+		VkCommandPool mCommandPool = VK_NULL_HANDLE;
+
+		VkBuffer mStagingBuffer = VK_NULL_HANDLE;
+		Allocation mStagingAllocation;
+		VkDeviceSize mStagingSize = 0;
+		VkDeviceSize mRingHead = 0;
+		VkDeviceSize mRingTail = 0;
+
+		std::mutex mMutex;
+		std::array<UploadBatch, UploadBatchCount> mBatches;
+		uint32 mRecordingBatch = 0; // Batch new copies go into
+		uint32 mOldestBatch = 0;    // Oldest batch that was submitted and not yet retired
+		uint32 mInFlightCount = 0;
+		UploadTicket mNextTicket = 1;
+		UploadTicket mCompletedTicket = 0;
+
+		VkPipelineStageFlags mReadyStageMask = 0;
+		std::vector<VkBufferMemoryBarrier> mReadyBufferAcquires;
+		std::vector<VkImageMemoryBarrier> mReadyImageAcquires;
+
+		UploadStats mStats;
+
+		UploadBatch& beginRecording();
+		void submitRecording();
+		void retireCompleted();
+		void waitOldest();
+		UploadTicket queryCompletedTicket();
+
+		/**
+		 *
+		 * @return Mapped pointer to write the data to, staging buffer and offset are the copy source
+		 */
+		void* allocateStaging(VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset);
+		bool allocateRing(VkDeviceSize size, VkDeviceSize& offset);
+	};
+} // SpRenderer
+
+#endif //SPARKER_ENGINE_UPLOADMANAGER_H
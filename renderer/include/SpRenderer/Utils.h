@@ -12,10 +12,15 @@
 #include <fstream>
 #include <filesystem>
 #include <vector>
+#include <array>
 #include <string>
+#include <string_view>
 #include <set>
+#include <algorithm>
 #include <limits>
 #include <chrono>
+#include <future>
+#include <span>
 
 #define SDL_EVENT
 #define SDL_MAIN_HANDLED
@@ -41,6 +46,11 @@ const bool enableValidationLayers = false;
 const std::vector<const char*> ValidationLayers = {"VK_LAYER_KHRONOS_validation"};
 
 const std::vector<const char*> DeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+// Enabled when the device has them, never required for a device to be picked
+const std::vector<const char*> OptionalDeviceExtensions = {
+	VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+	VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+};
 const std::vector<const char*> RequiredExtensions = {
 	VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_EXT_DEBUG_REPORT_EXTENSION_NAME
 };
@@ -74,16 +84,56 @@ enum MessageSeverity {
 	SP_MESSAGE_FATAL
 };
 
+// Messages below this severity are compiled out, override with the SP_LOG_MIN_SEVERITY cache variable
+#ifndef SP_LOG_MIN_SEVERITY
+#ifdef DEBUG
+#define SP_LOG_MIN_SEVERITY SP_MESSAGE_VERBOSE
+#else
+#define SP_LOG_MIN_SEVERITY SP_MESSAGE_INFO
+#endif
+#endif
+
+/*!
+ * Unlike SpConsole::Write, the message expression is not evaluated at all when the severity is compiled out
+ */
+#define SP_LOG(severity, message) \
+	do { \
+		if constexpr ((severity) >= SP_LOG_MIN_SEVERITY) { SpConsole::Write((severity), (message)); } \
+	} while (0)
+
+enum FileAccessHint {
+	SP_FILE_ACCESS_NORMAL,
+	SP_FILE_ACCESS_SEQUENTIAL, // Read front to back once, the kernel reads ahead aggressively
+	SP_FILE_ACCESS_RANDOM,     // Lookups all over the file, no read ahead
+	SP_FILE_ACCESS_WILLNEED,   // Most of the file is needed soon, start reading it in now
+};
+
 enum ExitCode {
 	SP_SUCCESS = 0,
 	SP_FAILURE = 1
 };
 
 namespace SpConsole {
-	void PlainWrite(const char* message);
-	void Write(MessageSeverity severity, std::string message);
+	/*!
+	 * Hands the message to the asynchronous logger, see Logger.h. Never blocks on I/O except for fatal messages
+	 */
+	void WriteRecord(MessageSeverity severity, uint8 flags, std::string_view prefix, std::string_view message);
+
+	/*!
+	 * Blocks until everything written so far was printed and saved
+	 */
+	void Flush();
+
+	void PlainWrite(std::string_view message);
 
-	void FatalExit(std::string message, ExitCode code);
+	inline void Write(MessageSeverity severity, std::string_view message) {
+		if (severity < SP_LOG_MIN_SEVERITY) {
+			return;
+		}
+		WriteRecord(severity, 0, {}, message);
+	}
+
+	[[noreturn]] void FatalExit(std::string_view message, ExitCode code);
 
 
 	void VulkanResult(VkResult result,
@@ -131,14 +181,81 @@ namespace RendUtils {
 }
 
 namespace Utils {
+	const uint64 HashSeed = 0xcbf29ce484222325ull;
+
+	/*!
+	 * MurmurHash64A. Stable across runs and platforms so it can be used for on-disk cache keys
+	 */
+	uint64 hash64(const void* data, size_t size, uint64 seed = HashSeed);
+	uint64 hash64(std::string_view string, uint64 seed = HashSeed);
+
+	inline uint64 hashCombine(uint64 seed, uint64 value) {
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	}
+
+	/**
+	 * Read-only view of a whole file mapped into memory, unmapped when destroyed. The data stays valid for the
+	 * lifetime of the object even if the file is replaced by renaming over it, but writing to the file in place
+	 * shows through.
+	 */
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		/**
+		 *
+		 * @return Closed file when it cannot be opened, an empty file is open with no data
+		 */
+		static MappedFile open(const std::filesystem::path& filePath, FileAccessHint hint = SP_FILE_ACCESS_NORMAL);
+
+		bool isOpen() const { return mOpen; }
+		explicit operator bool() const { return mOpen; }
+
+		std::span<const char> data() const { return {mData, mSize}; }
+		std::span<const uint8> bytes() const { return {reinterpret_cast<const uint8*>(mData), mSize}; }
+		std::string_view text() const { return {mData, mSize}; }
+		size_t size() const { return mSize; }
+
+		/*!
+		 * Applies a new access hint to part of the file, the range is widened to whole pages
+		 */
+		void advise(FileAccessHint hint, size_t offset = 0, size_t size = std::numeric_limits<size_t>::max()) const;
+
+		void close();
+
+	private:
+		const char* mData = nullptr;
+		size_t mSize = 0;
+		bool mOpen = false;
+#ifdef _WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#endif
+	};
+
 	class FileUtils {
 		public:
 
 		static std::vector<char> readBinaryFile(std::filesystem::path filePath);
-		static void writeBinaryFile(std::filesystem::path filePath, std::vector<char>& data);
+		static void writeBinaryFile(std::filesystem::path filePath, std::span<const char> data);
 
 		static std::vector<char> readTextFile(std::filesystem::path filePath);
-		static void writeTextFile(std::filesystem::path filePath, std::vector<char>& data);
+		static void writeTextFile(std::filesystem::path filePath, std::span<const char> data);
+
+		/*!
+		 * Maps the file instead of copying it, see MappedFile
+		 */
+		static MappedFile mapFile(const std::filesystem::path& filePath, FileAccessHint hint = SP_FILE_ACCESS_NORMAL);
+		/*!
+		 * Maps the file and faults every page in on a background thread, so reading the data later never waits on the disk
+		 */
+		static std::future<MappedFile> mapFileAsync(std::filesystem::path filePath);
 	private:
 
 	};
@@ -7,23 +7,339 @@
 
 #include "Utils.h"
 
+#include <bit>
+#include <cstddef>
+
+/*
+ * Every vertex type lists its fields once, in a SpRenderer::VertexLayout specialization, and the binding and attribute
+ * descriptions are built from that list at compile time. The VkFormat of an attribute comes from the field's C++
+ * type, so a field can't be described with a format of a different size.
+ *
+ * Attribute locations shared by all vertex types, and by the shaders reading them:
+ *   0 position, 1 texCoord, 2 color, per instance attributes start at 3
+ */
+
+namespace SpRenderer {
+#pragma region PackedTypes
+
+	// Read as vec2 in the shader
+	struct Half2 {
+		uint16 x;
+		uint16 y;
+	};
+
+	// Read as vec2 in [-1, 1]
+	struct Snorm16x2 {
+		int16 x;
+		int16 y;
+	};
+
+	// Read as vec4 in [-1, 1], 3D positions keep w at 1 so the padding reads as a homogeneous coordinate
+	struct Snorm16x4 {
+		int16 x;
+		int16 y;
+		int16 z;
+		int16 w;
+	};
+
+	// Read as vec4 in [0, 1]
+	struct Unorm8x4 {
+		uint8 r;
+		uint8 g;
+		uint8 b;
+		uint8 a;
+	};
+
+	/*!
+	 * Round to nearest even, out of range values become infinity
+	 */
+	constexpr uint16 packHalf(float value) {
+		uint32 bits = std::bit_cast<uint32>(value);
+		uint32 sign = (bits >> 16) & 0x8000;
+		uint32 floatExponent = (bits >> 23) & 0xFF;
+		uint32 mantissa = bits & 0x7FFFFF;
+
+		// Infinity and NaN, NaN keeps a mantissa bit
+		if (floatExponent == 0xFF) {
+			return static_cast<uint16>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+		}
+
+		int32 exponent = static_cast<int32>(floatExponent) - 127 + 15;
+		if (exponent >= 31) {
+			return static_cast<uint16>(sign | 0x7C00);
+		}
+
+		if (exponent <= 0) {
+			// Below the smallest subnormal half
+			if (exponent < -10) {
+				return static_cast<uint16>(sign);
+			}
+
+			mantissa |= 0x800000;
+			uint32 shift = static_cast<uint32>(14 - exponent);
+			uint32 half = mantissa >> shift;
+			uint32 remainder = mantissa & ((1u << shift) - 1);
+			uint32 halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+				half++;
+			}
+			return static_cast<uint16>(sign | half);
+		}
+
+		// A carry out of the mantissa moves into the exponent, which is the correctly rounded result
+		uint32 half = (static_cast<uint32>(exponent) << 10) | (mantissa >> 13);
+		uint32 remainder = mantissa & 0x1FFF;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+			half++;
+		}
+		return static_cast<uint16>(sign | half);
+	}
+
+	/*!
+	 * Clamped to [-1, 1], the same mapping the vertex input unit undoes
+	 */
+	constexpr int16 packSnorm16(float value) {
+		float scaled = std::clamp(value, -1.0f, 1.0f) * 32767.0f;
+		return static_cast<int16>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+	}
+
+	/*!
+	 * Clamped to [0, 1]
+	 */
+	constexpr uint8 packUnorm8(float value) {
+		return static_cast<uint8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	static_assert(packHalf(1.0f) == 0x3C00 && packHalf(-2.0f) == 0xC000 && packHalf(65504.0f) == 0x7BFF);
+	static_assert(packHalf(65536.0f) == 0x7C00 && packHalf(5.9604645e-8f) == 0x0001);
+	static_assert(packSnorm16(1.0f) == 32767 && packSnorm16(-1.0f) == -32767 && packSnorm16(0.5f) == 16384);
+	static_assert(packUnorm8(1.0f) == 255 && packUnorm8(0.5f) == 128);
+
+#pragma endregion PackedTypes
+
+#pragma region Layout
+
+	/*!
+	 * Vertex input format of a field type. Only the types below can be vertex fields, anything else fails to compile
+	 */
+	template<typename T>
+	struct VertexFormatOf;
+
+	template<> struct VertexFormatOf<float> { static constexpr VkFormat Format = VK_FORMAT_R32_SFLOAT; };
+	template<> struct VertexFormatOf<uint32> { static constexpr VkFormat Format = VK_FORMAT_R32_UINT; };
+	template<> struct VertexFormatOf<vec2> { static constexpr VkFormat Format = VK_FORMAT_R32G32_SFLOAT; };
+	template<> struct VertexFormatOf<vec3> { static constexpr VkFormat Format = VK_FORMAT_R32G32B32_SFLOAT; };
+	template<> struct VertexFormatOf<vec4> { static constexpr VkFormat Format = VK_FORMAT_R32G32B32A32_SFLOAT; };
+	template<> struct VertexFormatOf<Half2> { static constexpr VkFormat Format = VK_FORMAT_R16G16_SFLOAT; };
+	template<> struct VertexFormatOf<Snorm16x2> { static constexpr VkFormat Format = VK_FORMAT_R16G16_SNORM; };
+	template<> struct VertexFormatOf<Snorm16x4> { static constexpr VkFormat Format = VK_FORMAT_R16G16B16A16_SNORM; };
+	template<> struct VertexFormatOf<Unorm8x4> { static constexpr VkFormat Format = VK_FORMAT_R8G8B8A8_UNORM; };
+
+	struct VertexAttribute {
+		uint32 location;
+		VkFormat format;
+		uint32 offset;
+		uint32 size;
+	};
+
+	template<typename Field>
+	constexpr VertexAttribute vertexAttribute(uint32 location, size_t offset) {
+		return {location, VertexFormatOf<Field>::Format, static_cast<uint32>(offset), static_cast<uint32>(sizeof(Field))};
+	}
+
+	/*!
+	 * Specialized once per vertex type with:
+	 *   static constexpr VkVertexInputRate InputRate
+	 *   static constexpr std::array<VertexAttribute, N> Attributes, built with SP_VERTEX_ATTRIBUTE
+	 */
+	template<typename V>
+	struct VertexLayout;
+
+	/*!
+	 * Fields inside the vertex, not overlapping each other, and no location used twice
+	 */
+	template<typename V>
+	constexpr bool isValidVertexLayout() {
+		const auto& attributes = VertexLayout<V>::Attributes;
+		for (size_t i = 0; i < attributes.size(); i++) {
+			if (attributes[i].offset + attributes[i].size > sizeof(V)) {
+				return false;
+			}
+			for (size_t j = i + 1; j < attributes.size(); j++) {
+				if (attributes[i].location == attributes[j].location) {
+					return false;
+				}
+				if (attributes[i].offset < attributes[j].offset + attributes[j].size &&
+				    attributes[j].offset < attributes[i].offset + attributes[i].size) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	template<typename V>
+	constexpr VkVertexInputBindingDescription bindingDescription(uint32 binding) {
+		return {binding, static_cast<uint32>(sizeof(V)), VertexLayout<V>::InputRate};
+	}
+
+	template<typename V>
+	constexpr std::array<VkVertexInputAttributeDescription, VertexLayout<V>::Attributes.size()> attributeDescriptions(uint32 binding) {
+		static_assert(isValidVertexLayout<V>(), "Vertex fields overlap, run past the end of the vertex or share a location");
+
+		std::array<VkVertexInputAttributeDescription, VertexLayout<V>::Attributes.size()> descriptions{};
+		for (size_t i = 0; i < descriptions.size(); i++) {
+			const VertexAttribute& attribute = VertexLayout<V>::Attributes[i];
+			descriptions[i] = {attribute.location, binding, attribute.format, attribute.offset};
+		}
+		return descriptions;
+	}
+
+	/**
+	 * Vertex input state of a pipeline reading one vertex type per binding, binding i is the i-th type. Everything is
+	 * built at compile time and lives in static storage, so createInfo() can be handed to the pipeline as is.
+	 *
+	 * @tparam Vertices Types with a VertexLayout specialization
+	 */
+	template<typename... Vertices>
+	struct VertexInputLayout {
+		static constexpr size_t BindingCount = sizeof...(Vertices);
+		static constexpr size_t AttributeCount = (VertexLayout<Vertices>::Attributes.size() + ...);
+
+		static constexpr std::array<VkVertexInputBindingDescription, BindingCount> Bindings = [] {
+			std::array<VkVertexInputBindingDescription, BindingCount> bindings{};
+			uint32 binding = 0;
+			((bindings[binding] = bindingDescription<Vertices>(binding), binding++), ...);
+			return bindings;
+		}();
+
+		static constexpr std::array<VkVertexInputAttributeDescription, AttributeCount> Attributes = [] {
+			std::array<VkVertexInputAttributeDescription, AttributeCount> attributes{};
+			uint32 binding = 0;
+			size_t count = 0;
+			auto append = [&](const auto& descriptions) {
+				for (const VkVertexInputAttributeDescription& description : descriptions) {
+					attributes[count++] = description;
+				}
+			};
+			((append(attributeDescriptions<Vertices>(binding)), binding++), ...);
+			return attributes;
+		}();
+
+		static_assert([] {
+			for (size_t i = 0; i < AttributeCount; i++) {
+				for (size_t j = i + 1; j < AttributeCount; j++) {
+					if (Attributes[i].location == Attributes[j].location) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}(), "Two bindings use the same attribute location");
+
+		static VkPipelineVertexInputStateCreateInfo createInfo() {
+			VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+			vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32>(Bindings.size());
+			vertexInputInfo.pVertexBindingDescriptions = Bindings.data();
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32>(Attributes.size());
+			vertexInputInfo.pVertexAttributeDescriptions = Attributes.data();
+			return vertexInputInfo;
+		}
+	};
+
+#pragma endregion Layout
+}
+
+/*!
+ * One entry of a VertexLayout<type>::Attributes list, the format follows from the member's type
+ */
+#define SP_VERTEX_ATTRIBUTE(type, member, location) \
+	SpRenderer::vertexAttribute<decltype(type::member)>((location), offsetof(type, member))
+
 struct Vertex2D {
 	vec2 position;
 	vec2 texCoord;
 	vec3 color;
-
-	static VkVertexInputBindingDescription getBindingDescription();
-	static std::array<VkVertexInputAttributeDescription, 3> getBindingDescriptions();
 };
 
 struct Vertex {
 	vec3 position;
 	vec2 texCoord;
 	vec3 color;
+};
 
-	static VkVertexInputBindingDescription getBindingDescription();
-	static std::array<VkVertexInputAttributeDescription, 3> getBindingDescriptions();
+/*!
+ * Vertex2D in 12 bytes instead of 28. Positions are stored in [-1, 1], mesh space positions are divided by a scale
+ * when packing and the transform multiplies it back in
+ */
+struct Vertex2DPacked {
+	SpRenderer::Snorm16x2 position;
+	SpRenderer::Half2 texCoord;
+	SpRenderer::Unorm8x4 color;
 };
 
+/*!
+ * Vertex in 16 bytes instead of 32, positions as in Vertex2DPacked
+ */
+struct VertexPacked {
+	SpRenderer::Snorm16x4 position;
+	SpRenderer::Half2 texCoord;
+	SpRenderer::Unorm8x4 color;
+};
+
+/**
+ * @param positionScale Largest absolute position coordinate of the mesh, positions are divided by it
+ */
+Vertex2DPacked packVertex(const Vertex2D& vertex, float positionScale = 1.0f);
+/**
+ * @param positionScale Largest absolute position coordinate of the mesh, positions are divided by it
+ */
+VertexPacked packVertex(const Vertex& vertex, float positionScale = 1.0f);
+
+namespace SpRenderer {
+	template<>
+	struct VertexLayout<Vertex2D> {
+		static constexpr VkVertexInputRate InputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		static constexpr std::array Attributes = {
+			SP_VERTEX_ATTRIBUTE(Vertex2D, position, 0),
+			SP_VERTEX_ATTRIBUTE(Vertex2D, texCoord, 1),
+			SP_VERTEX_ATTRIBUTE(Vertex2D, color, 2)
+		};
+	};
+
+	template<>
+	struct VertexLayout<Vertex> {
+		static constexpr VkVertexInputRate InputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		static constexpr std::array Attributes = {
+			SP_VERTEX_ATTRIBUTE(Vertex, position, 0),
+			SP_VERTEX_ATTRIBUTE(Vertex, texCoord, 1),
+			SP_VERTEX_ATTRIBUTE(Vertex, color, 2)
+		};
+	};
+
+	template<>
+	struct VertexLayout<Vertex2DPacked> {
+		static constexpr VkVertexInputRate InputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		static constexpr std::array Attributes = {
+			SP_VERTEX_ATTRIBUTE(Vertex2DPacked, position, 0),
+			SP_VERTEX_ATTRIBUTE(Vertex2DPacked, texCoord, 1),
+			SP_VERTEX_ATTRIBUTE(Vertex2DPacked, color, 2)
+		};
+	};
+
+	template<>
+	struct VertexLayout<VertexPacked> {
+		static constexpr VkVertexInputRate InputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		static constexpr std::array Attributes = {
+			SP_VERTEX_ATTRIBUTE(VertexPacked, position, 0),
+			SP_VERTEX_ATTRIBUTE(VertexPacked, texCoord, 1),
+			SP_VERTEX_ATTRIBUTE(VertexPacked, color, 2)
+		};
+	};
+}
+
+static_assert(sizeof(Vertex2DPacked) == 12 && sizeof(VertexPacked) == 16);
+
 
-#endif //SPARKER_ENGINE_VERTEX_H
\ No newline at end of file
+#endif //SPARKER_ENGINE_VERTEX_H
@@ -0,0 +1,17 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Bindless table, see BindlessTable.h
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 1) uniform sampler samplers[];
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTexture;
+
+layout(location = 0) out vec4 outColor;
+
+void main(){
+    // One draw covers objects with different textures, so the index varies within it
+    outColor = fragColor * texture(sampler2D(textures[nonuniformEXT(fragTexture)], samplers[0]), fragTexCoord);
+}
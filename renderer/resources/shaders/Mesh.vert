@@ -0,0 +1,38 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Layout matches GpuObject in GpuScene.h
+struct GpuObject {
+    mat4 transform;
+    uint mesh;
+    uint texture;
+    uint color;
+    uint padding;
+};
+
+// Storage buffers of the bindless table, see BindlessTable.h
+layout(set = 1, binding = 2, std430) readonly buffer ObjectBuffer { GpuObject objects[]; } objectBuffers[];
+
+layout(push_constant) uniform MeshConstants {
+    mat4 viewProjection;
+    uint objectBuffer;
+} constants;
+
+// Locations match VertexLayout<VertexPacked>, w of the position is 1
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTexture;
+
+void main(){
+    // Culling put the object index in the draw's first instance
+    GpuObject object = objectBuffers[constants.objectBuffer].objects[gl_InstanceIndex];
+
+    gl_Position = constants.viewProjection * object.transform * vec4(inPosition.xyz, 1.0);
+    fragColor = inColor * unpackUnorm4x8(object.color);
+    fragTexCoord = inTexCoord;
+    fragTexture = object.texture;
+}
@@ -0,0 +1,36 @@
+#version 450
+
+layout(push_constant) uniform ViewportTransform {
+    vec2 scale;
+    vec2 offset;
+} viewport;
+
+// Locations match the VertexLayout specializations of Vertex2DPacked and SpriteInstance
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 3) in vec2 instancePosition;
+layout(location = 4) in vec2 instanceSize;
+layout(location = 5) in vec4 instanceUvRect;
+layout(location = 6) in vec4 instanceColor;
+layout(location = 7) in float instanceRotation;
+layout(location = 8) in float instanceDepth;
+layout(location = 9) in uint instanceTexture;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTexture;
+
+void main(){
+    float s = sin(instanceRotation);
+    float c = cos(instanceRotation);
+
+    vec2 local = inPosition * instanceSize;
+    vec2 pixel = instancePosition + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = vec4(pixel * viewport.scale + viewport.offset, instanceDepth, 1.0);
+    fragColor = inColor * instanceColor;
+    fragTexCoord = instanceUvRect.xy + inTexCoord * instanceUvRect.zw;
+    fragTexture = instanceTexture;
+}
@@ -1,13 +1,14 @@
 #version 450
 
-layout(binding = 0) UniformBufferObject{
+layout(set = 0, binding = 0) uniform UniformBufferObject{
     mat4 model;
     mat4 view;
 } ubo;
 
+// Locations match VertexLayout<Vertex2D>
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 texCoords;
-layout(location = 3) in vec3 color;
+layout(location = 2) in vec3 color;
 
 layout(location = 0) out vec3 fragColor;
 
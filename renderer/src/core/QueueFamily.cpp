@@ -12,18 +12,45 @@ void QueueFamilyIndices::findQueueIndices(VkPhysicalDevice physicalDevice, VkSur
 	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
 
-	size_t i = 0;
-	for (const VkQueueFamilyProperties& queueFamily : queueFamilies) {
-		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) graphicsFamily = i;
-		if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) transferFamily = i;
+	for (uint32 i = 0; i < queueFamilyCount; i++) {
+		const VkQueueFamilyProperties& queueFamily = queueFamilies[i];
 
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
-		if (presentSupport) presentFamily = i;
-		if (transferComplete()) break;
+		if (surface != VK_NULL_HANDLE) {
+			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+		}
+
+		// Prefer a family that can do both so graphics and present share a queue
+		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+			if (!graphicsFamily.has_value() || (presentSupport && graphicsFamily != presentFamily)) {
+				graphicsFamily = i;
+				if (presentSupport) presentFamily = i;
+			}
+		}
+		if (presentSupport && !presentFamily.has_value()) presentFamily = i;
 	}
 
+	// Headless, nothing is presented so the graphics family stands in
+	if (surface == VK_NULL_HANDLE) presentFamily = graphicsFamily;
+
+	// Graphics and compute queues support transfers implicitly, so the first family that only reports transfer
+	// is the DMA engine. Failing that, an async compute family still keeps uploads off the graphics queue
+	std::optional<uint32> computeTransferFamily;
+	for (uint32 i = 0; i < queueFamilyCount; i++) {
+		VkQueueFlags flags = queueFamilies[i].queueFlags;
+		if (flags & VK_QUEUE_GRAPHICS_BIT) continue;
+
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT)) {
+			transferFamily = i;
+			break;
+		}
+		if ((flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) && !computeTransferFamily.has_value()) {
+			computeTransferFamily = i;
+		}
+	}
 
+	if (!transferFamily.has_value()) transferFamily = computeTransferFamily;
+	if (!transferFamily.has_value()) transferFamily = graphicsFamily;
 }
 
 bool QueueFamilyIndices::isComplete() {
@@ -33,3 +60,7 @@ bool QueueFamilyIndices::isComplete() {
 bool QueueFamilyIndices::transferComplete() {
 	return presentFamily.has_value() && graphicsFamily.has_value() && transferFamily.has_value();
 }
+
+bool QueueFamilyIndices::dedicatedTransfer() {
+	return transferComplete() && transferFamily != graphicsFamily;
+}
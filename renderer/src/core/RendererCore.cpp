@@ -7,47 +7,278 @@
 #include <format>
 
 
+namespace {
+    // VkPhysicalDeviceVulkan12Features and VkPhysicalDeviceDescriptorIndexingFeatures name these the same
+    template<typename Features>
+    void enableBindless(Features& features) {
+        features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        features.descriptorBindingPartiallyBound = VK_TRUE;
+        features.runtimeDescriptorArray = VK_TRUE;
+    }
+}
+
 namespace SpRenderer {
     bool RendererCore::shouldClose() const {
         return mainWindow.quitWindow;
     }
 
-    void RendererCore::start(const char* ApplicationName) {
-        bool sResult = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
-        SpConsole::sdlErrorCheck(sResult);
-        mainWindow.windowName = std::string(ApplicationName);
-        startWindow();
-        createInstance();
-        createSurface();
-        getPhysicalDevice();
-        createLogicalDevice();
-        createSwapchain();
-        createImageViews();
-        createRenderpass();
-        createGraphicsPipeline();
+    VkExtent2D RendererCore::getWindowExtent() const {
+        return mainWindow.extent;
+    }
+
+    void RendererCore::start(const char* ApplicationName, uint32 framesInFlight) {
+        mHeadless = false;
+        startRenderer(ApplicationName, framesInFlight);
+    }
+
+    void RendererCore::startHeadless(const char* ApplicationName, const HeadlessSettings& settings, uint32 framesInFlight) {
+        if (settings.extent.width == 0 || settings.extent.height == 0) {
+            SpConsole::FatalExit("Headless extent must not be zero!", SP_FAILURE);
+        }
 
+        mHeadless = true;
+        mHeadlessSettings = settings;
+        startRenderer(ApplicationName, framesInFlight);
+    }
+
+    void RendererCore::startRenderer(const char* ApplicationName, uint32 framesInFlight) {
+        mStartTime = std::chrono::steady_clock::now();
+        mStartupStats = {};
+        mFrameContext.framesInFlight = std::clamp(framesInFlight, MinFramesInFlight, MaxFramesInFlight);
+
+        // Before anything else, so this thread becomes the job system's main thread
+        mJobSystem.init();
+
+        SP_PROFILE_ZONE("RendererCore::start");
+
+        mainWindow.windowName = std::string(ApplicationName);
 
-        std::vector<char> fileData = Utils::FileUtils::readTextFile(RENDERER_RESOURCE_DIR "/testText.txt");
-        std::string fileString(fileData.begin(), fileData.end());
-        Utils::FileUtils::writeTextFile(RENDERER_DATA_DIR "/awesomeGuy.txt", fileData);
+        StartupGraph startup(mJobSystem);
+
+        // Nothing here needs the device, it all overlaps with bringing the device up
+        StartupStageId shaderCache = startup.add("Shader cache", [this] {
+            mShaderCache.load(RENDERER_DATA_DIR "/shaders");
+        });
+        StartupStageId shaders = startup.add("Shader compile", [this] {
+            mShaderLibrary.compileAll(mShaderCache);
+        }, {shaderCache});
+        StartupStageId pipelineCacheFile = startup.add("Pipeline cache read", [this] {
+            mPipelineCache.preload();
+        });
+
+        // SDL video calls stay on the main thread
+        StartupStageId sdl = startup.addMainThread("SDL", [this] { startSdl(); });
+        StartupStageId window = startup.addMainThread("Window", [this] { startWindow(); }, {sdl});
+        StartupStageId instance = startup.add("Instance", [this] { createInstance(); }, {sdl});
+        StartupStageId surface = startup.addMainThread("Surface", [this] { createSurface(); }, {window, instance});
+
+        StartupStageId physicalDevice = startup.add("Physical device", [this] { getPhysicalDevice(); }, {surface});
+        StartupStageId device = startup.add("Logical device", [this] {
+            createLogicalDevice();
+            createAllocator();
+        }, {physicalDevice});
+        StartupStageId deviceServices = startup.add("Device services", [this] {
+            createGpuProfiler();
+            createRenderGraph();
+            createUploadManager();
+        }, {device});
+        StartupStageId pipelineCache = startup.add("Pipeline cache", [this] { createPipelineCache(); }, {device, pipelineCacheFile});
+        StartupStageId shaderModules = startup.add("Shader modules", [this] {
+            mShaderLibrary.createModules(mLogicalDevice.device);
+
+            SpConsole::Write(SP_MESSAGE_INFO, "Shader cache hits: " + std::to_string(mShaderCache.hitCount()) +
+                                              ", misses: " + std::to_string(mShaderCache.missCount()));
+            mShaderCache.save();
+        }, {device, shaders});
+
+        // Asks SDL for the window size
+        StartupStageId swapchain = startup.addMainThread("Swapchain", [this] {
+            if (mHeadless) {
+                createOffscreenTargets();
+            }else {
+                createSwapchain();
+            }
+            createImageViews();
+            createRenderpass();
+        }, {deviceServices});
+        // Waits on an upload, which is render thread only
+        StartupStageId textures = startup.addMainThread("Textures", [this] {
+            createTextureImage();
+            createBindlessTable();
+            createTextureManager();
+        }, {deviceServices});
+        StartupStageId frameResources = startup.add("Frame resources", [this] {
+            createCommandPool();
+            createCommandBuffers();
+            createUniformBuffers();
+            createSyncObjects();
+        }, {swapchain});
+
+        StartupStageId pipelines = startup.add("Pipelines", [this] {
+            createGraphicsPipeline();
+        }, {shaderModules, pipelineCache, swapchain, textures});
+        startup.add("Descriptors", [this] {
+            createDescriptorPool();
+            createDescriptorSets();
+        }, {pipelines, frameResources});
+        startup.add("Sprite batcher", [this] { createSpriteBatcher(); }, {pipelines});
+        startup.add("GPU scene", [this] { createGpuScene(); }, {pipelines});
+
+        startup.run();
+
+        mStartupStats.startup = startup.getReport();
+        startup.logReport();
     }
 
     void RendererCore::stop() {
+        vkDeviceWaitIdle(mLogicalDevice.device);
+
+        // Frames still in flight, oldest first
+        for (uint32 i = 0; i < mFrameContext.framesInFlight && !mOffscreenTargets.readbackFrames.empty(); i++) {
+            deliverReadback((mFrameContext.currentFrame + i) % mFrameContext.framesInFlight);
+        }
 
-        destroyRenderpass();
+        releaseRetiredSwapchains(true);
+        destroySpriteBatcher();
+        destroyGpuScene();
+        destroySyncObjects();
+        destroyCommandPool();
+        destroyDescriptorPool();
+        destroyUniformBuffers();
+        destroyGraphicsPipeline();
+        destroyTextureManager();
+        destroyBindlessTable();
+        destroyTextureImage();
+        mShaderLibrary.destroy();
+        mShaderCache.save();
         destroyImageviews();
-        destroySwapchain();
+        if (mHeadless) {
+            destroyOffscreenTargets();
+        }else {
+            destroySwapchain();
+        }
+        destroyPipelineCache();
+        destroyUploadManager();
+        destroyRenderGraph();
+        destroyGpuProfiler();
+        destroyAllocator();
         destroyLogicalDevice();
         destroySurface();
         destroyInstance();
         terminateWindow();
+        mJobSystem.destroy();
+
+        SpConsole::Flush();
     }
 
     void RendererCore::endFrame() {
+        SP_PROFILE_ZONE("RendererCore::endFrame");
+
+        mJobSystem.pumpMainThread();
         endWindowFrame();
+
+        if (mainWindow.quitWindow) {
+            return;
+        }
+
+        // Nothing can be presented to a minimized window, sleep until something happens instead of spinning
+        if (mainWindow.minimized) {
+            SDL_WaitEventTimeout(nullptr, 100);
+            return;
+        }
+
+        drawFrame();
+    }
+
+    const RendererCore::FrameStats& RendererCore::getFrameStats() const {
+        return mFrameStats;
+    }
+
+    const RendererCore::StartupStats& RendererCore::getStartupStats() const {
+        return mStartupStats;
+    }
+
+    void RendererCore::drawSprite(const Sprite& sprite) {
+        mSpriteBatcher.draw(sprite);
+    }
+
+    void RendererCore::drawSprites(std::span<const Sprite> sprites) {
+        mSpriteBatcher.draw(sprites);
+    }
+
+    const SpriteBatchStats& RendererCore::getSpriteStats() const {
+        return mSpriteBatcher.getStats();
+    }
+
+    TextureHandle RendererCore::loadTexture(const std::filesystem::path& filePath) {
+        return mTextureManager.load(filePath);
+    }
+
+    GpuScene& RendererCore::getScene() {
+        return mScene;
+    }
+
+    std::vector<MeshHandle> RendererCore::loadMeshes(const std::filesystem::path& filePath) {
+        SP_PROFILE_ZONE("RendererCore::loadMeshes");
+
+        // Only the header is parsed, the sections upload from the mapped pages as they are
+        Utils::MappedFile file = Utils::FileUtils::mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+        if (!file) {
+            SpConsole::Write(SP_MESSAGE_WARNING, "Failed to load meshes " + filePath.string() + ": could not open the file");
+            return {};
+        }
+
+        MeshFileView view{};
+        std::string error;
+        if (!parseMeshFile(file.bytes(), view, error)) {
+            SpConsole::Write(SP_MESSAGE_WARNING, "Failed to load meshes " + filePath.string() + ": " + error);
+            return {};
+        }
+
+        return mScene.addMeshes(view);
+    }
+
+    JobSystem& RendererCore::getJobSystem() {
+        return mJobSystem;
+    }
+
+    bool RendererCore::isHeadless() const {
+        return mHeadless;
+    }
+
+    void RendererCore::setReadbackCallback(ReadbackCallback callback) {
+        mReadbackCallback = std::move(callback);
+    }
+
+    BindlessIndex RendererCore::getTextureIndex(TextureHandle texture) {
+        return mTextureManager.getIndex(texture);
+    }
+
+    void RendererCore::startSdl() {
+        if (mHeadless) {
+            return;
+        }
+
+        bool sResult = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+        SpConsole::sdlErrorCheck(sResult);
+
+        // Queried here so the instance can be created off the main thread
+        uint32 instanceExtensionCount = 0;
+        const char* const* instanceExtensions = SDL_Vulkan_GetInstanceExtensions(&instanceExtensionCount);
+        mainWindow.instanceExtensions.assign(instanceExtensions, instanceExtensions + instanceExtensionCount);
     }
 
     void RendererCore::startWindow() {
+        if (mHeadless) {
+            mainWindow.window = nullptr;
+            mainWindow.extent = mHeadlessSettings.extent;
+            return;
+        }
+
         mainWindow.extent.width = 800;
         mainWindow.extent.height = 800;
 
@@ -57,10 +288,22 @@ namespace SpRenderer {
     }
 
     void RendererCore::endWindowFrame() {
+        if (mHeadless) {
+            // Nothing to close, the frame limit stands in for the window
+            if (mHeadlessSettings.frameLimit != 0 && mFrameContext.frameNumber >= mHeadlessSettings.frameLimit) {
+                mainWindow.quitWindow = true;
+            }
+            return;
+        }
+
         handleWindowEvent();
     }
 
     void RendererCore::terminateWindow() {
+        if (mHeadless) {
+            return;
+        }
+
         SDL_DestroyWindow(mainWindow.window);
         SDL_Quit();
     }
@@ -72,6 +315,20 @@ namespace SpRenderer {
                 case SDL_EVENT_QUIT:
                     mainWindow.quitWindow = true;
                     break;
+
+                case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+                    mSwapchain.outOfDate = true;
+                    break;
+
+                case SDL_EVENT_WINDOW_MINIMIZED:
+                    mainWindow.minimized = true;
+                    break;
+
+                case SDL_EVENT_WINDOW_RESTORED:
+                case SDL_EVENT_WINDOW_MAXIMIZED:
+                    mainWindow.minimized = false;
+                    mSwapchain.outOfDate = true;
+                    break;
             }
         }
     }
@@ -81,22 +338,28 @@ namespace SpRenderer {
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         appInfo.pApplicationName = mainWindow.windowName.c_str();
         appInfo.pEngineName = "Sparker-Engine";
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.3 for dynamic rendering and 1.2 for timeline semaphores when the loader has them, devices that lack
+        // them still work on the older paths. 1.1 is the least that can query descriptor indexing support
+        uint32 instanceVersion = VK_API_VERSION_1_0;
+        vkEnumerateInstanceVersion(&instanceVersion);
+        if (instanceVersion >= VK_API_VERSION_1_3) {
+            appInfo.apiVersion = VK_API_VERSION_1_3;
+        }else if (instanceVersion >= VK_API_VERSION_1_2) {
+            appInfo.apiVersion = VK_API_VERSION_1_2;
+        }else if (instanceVersion >= VK_API_VERSION_1_1) {
+            appInfo.apiVersion = VK_API_VERSION_1_1;
+        }else {
+            appInfo.apiVersion = VK_API_VERSION_1_0;
+        }
+        vulkanContext.apiVersion = appInfo.apiVersion;
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 
 
         std::vector<const char*> extensions = RequiredExtensions;
 
 
-        //Getting extensions
-        {
-            uint32 instanceExtensionCount = 0;
-            const char* const* instanceExtensions = SDL_Vulkan_GetInstanceExtensions(&instanceExtensionCount);
-            for (size_t i = 0; i < instanceExtensionCount; i++) {
-                extensions.push_back(instanceExtensions[i]);
-            }
-        }
-        //end Getting Extensions
+        // Empty when headless
+        extensions.insert(extensions.end(), mainWindow.instanceExtensions.begin(), mainWindow.instanceExtensions.end());
 
         VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = populateDebugMessenger();
 
@@ -115,7 +378,7 @@ namespace SpRenderer {
         vkEnumerateInstanceLayerProperties(&validationLayersCount, availableValidationLayers.data());
 
         for (size_t i = 0; i < availableValidationLayers.size(); i++) {
-            SpConsole::Write(SP_MESSAGE_VERBOSE, (std::string("Found layer: ") + availableValidationLayers[i].layerName).c_str());
+            SP_LOG(SP_MESSAGE_VERBOSE, std::string("Found layer: ") + availableValidationLayers[i].layerName);
         }
 
         // ReSharper disable once CppLocalVariableMayBeConst
@@ -145,6 +408,11 @@ namespace SpRenderer {
     }
 
     void RendererCore::createSurface() {
+        if (mHeadless) {
+            mainWindow.surface = VK_NULL_HANDLE;
+            return;
+        }
+
         bool result = SDL_Vulkan_CreateSurface(mainWindow.window, vulkanContext.instance, nullptr, &mainWindow.surface);
         if (!result) {
             SpConsole::sdlErrorCheck(false);
@@ -155,7 +423,6 @@ namespace SpRenderer {
     }
 
     void RendererCore::getPhysicalDevice() {
-        VkPhysicalDevice physicalDevice = nullptr;
         uint32 deviceCount = 0;
         vkEnumeratePhysicalDevices(vulkanContext.instance, &deviceCount, nullptr);
 
@@ -166,70 +433,122 @@ namespace SpRenderer {
             SpConsole::Write(SP_MESSAGE_INFO, message.c_str());
         }
 
-
         std::vector<VkPhysicalDevice> vkDevices(deviceCount);
         vkEnumeratePhysicalDevices(vulkanContext.instance, &deviceCount, vkDevices.data());
 
-        std::vector<PhysicalDeviceInfo> devices(deviceCount);
-        for (size_t i = 0; i < deviceCount; i++) {
-            devices[i].device = vkDevices[i];
+        std::vector<const char*> requiredExtensions = requiredDeviceExtensions();
+        std::filesystem::path profilePath = std::filesystem::path(RENDERER_DATA_DIR) / DEVICE_PROFILE_FILE_NAME;
+        uint64 configuration = deviceProfileConfiguration(vulkanContext.apiVersion, requiredExtensions, OptionalDeviceExtensions);
+        std::string preference = preferredDevice();
+
+        PhysicalDeviceInfo chosen{};
+        bool found = false;
+
+        // Last run's device, as long as its driver is unchanged and the override does not ask for another one. Only
+        // the properties are queried to find it, extensions and features come from the profile
+        DeviceCapabilities cached{};
+        if (loadDeviceProfile(profilePath, configuration, cached)) {
+            for (uint32 i = 0; i < deviceCount; i++) {
+                VkPhysicalDeviceProperties properties{};
+                vkGetPhysicalDeviceProperties(vkDevices[i], &properties);
+                if (!sameDevice(cached, properties) ||
+                    (!preference.empty() && !matchesDevicePreference(preference, i, properties.deviceName))) {
+                    continue;
+                }
+
+                chosen.device = vkDevices[i];
+                chosen.properties = properties;
+                chosen.capabilities = cached;
+                found = querySurfaceSupport(chosen);
+                break;
+            }
+
+            if (found) {
+                SpConsole::Write(SP_MESSAGE_INFO, std::string("Using the cached profile of ") + cached.deviceName);
+            }
         }
 
-        size_t i = 0;
-        int32 highestScore = -1000;
-        PhysicalDeviceInfo* highestDevice = nullptr;
-        for (PhysicalDeviceInfo& device : devices) {
-            if (isSuitableDevice(device) && device.score > highestScore) {
-                highestScore = device.score;
-                highestDevice = &devices[i];
+        if (!found) {
+            found = selectPhysicalDevice(vkDevices, preference, chosen);
+            if (found) {
+                saveDeviceProfile(profilePath, configuration, chosen.capabilities);
             }
-            i++;
         }
 
-        if (highestDevice == nullptr) {
+        if (!found) {
             SpConsole::FatalExit("Failed to find suitable GPU!", SP_FAILURE);
         }
 
-        vkGetPhysicalDeviceMemoryProperties(highestDevice->device, &highestDevice->memoryProperties);
-        mPhysicalDeviceInfo = *highestDevice;
-    }
+        vkGetPhysicalDeviceMemoryProperties(chosen.device, &chosen.memoryProperties);
 
-    int RendererCore::isSuitableDevice(PhysicalDeviceInfo& deviceInfo) {
-        if (deviceInfo.device == NULL) {
-            return std::numeric_limits<uint32>::min();
+        chosen.optionalExtensions.clear();
+        for (uint32 i = 0; i < OptionalDeviceExtensions.size(); i++) {
+            if (chosen.capabilities.optionalExtensionMask & (1u << i)) {
+                chosen.optionalExtensions.push_back(OptionalDeviceExtensions[i]);
+            }
         }
-        vkGetPhysicalDeviceProperties(deviceInfo.device, &deviceInfo.properties);
-        vkGetPhysicalDeviceFeatures(deviceInfo.device, &deviceInfo.features);
 
-        uint32 extensionCount = 0;
-        vkEnumerateDeviceExtensionProperties(deviceInfo.device, nullptr, &extensionCount, nullptr);
+        mPhysicalDeviceInfo = chosen;
 
-        std::vector<VkExtensionProperties> extensions(extensionCount);
-        vkEnumerateDeviceExtensionProperties(deviceInfo.device, nullptr, &extensionCount, extensions.data());
-
-        std::set<std::string> requestedExtensions(DeviceExtensions.begin(), DeviceExtensions.end());
+        mPhysicalDeviceInfo.renderingBackend = mPhysicalDeviceInfo.capabilities.dynamicRendering
+                                                   ? SP_RENDERING_BACKEND_DYNAMIC
+                                                   : SP_RENDERING_BACKEND_RENDER_PASS;
+        SpConsole::Write(SP_MESSAGE_INFO, std::string("Using ") + mPhysicalDeviceInfo.properties.deviceName + " with the " +
+                                          (mPhysicalDeviceInfo.capabilities.dynamicRendering ? "dynamic rendering" : "render pass") + " backend");
+    }
 
-        for (const VkExtensionProperties& extension : extensions) {
-            requestedExtensions.erase(extension.extensionName);
-        }
+    bool RendererCore::selectPhysicalDevice(const std::vector<VkPhysicalDevice>& devices, const std::string& preference,
+                                            PhysicalDeviceInfo& chosen) {
+        std::vector<const char*> requiredExtensions = requiredDeviceExtensions();
+
+        int64 highestScore = -1;
+        bool preferredFound = false;
+        for (uint32 i = 0; i < devices.size(); i++) {
+            PhysicalDeviceInfo deviceInfo{};
+            deviceInfo.device = devices[i];
+            vkGetPhysicalDeviceProperties(deviceInfo.device, &deviceInfo.properties);
+            deviceInfo.capabilities = queryDeviceCapabilities(deviceInfo.device, vulkanContext.apiVersion, requiredExtensions,
+                                                              OptionalDeviceExtensions);
+
+            int64 score = scoreDevice(deviceInfo.capabilities);
+            if (score >= 0 && !querySurfaceSupport(deviceInfo)) {
+                score = -1;
+            }
 
-        bool extensionsFound = requestedExtensions.empty();
+            bool preferred = matchesDevicePreference(preference, i, deviceInfo.properties.deviceName);
+            SpConsole::Write(SP_MESSAGE_INFO, "GPU " + std::to_string(i) + ": " + deviceInfo.properties.deviceName + ", " +
+                                              (score < 0 ? std::string("unsuitable") : "score " + std::to_string(score)) +
+                                              (preferred ? ", preferred" : ""));
+            if (score < 0) {
+                continue;
+            }
 
-        bool swapchainAdequate = false;
-        if (extensionsFound) {
-            querySwapchainSupport(deviceInfo);
-            swapchainAdequate = !deviceInfo.swapchainDetails.formats.empty() && !deviceInfo.swapchainDetails.presentModes.empty();
+            // A usable preferred device wins whatever its score
+            if ((preferred && !preferredFound) || (preferred == preferredFound && score > highestScore)) {
+                highestScore = score;
+                preferredFound = preferred;
+                chosen = deviceInfo;
+            }
         }
 
-        deviceInfo.indices.findQueueIndices(deviceInfo.device, mainWindow.surface);
+        if (!preference.empty() && !preferredFound) {
+            SpConsole::Write(SP_MESSAGE_WARNING, "No usable GPU matches the preferred device \"" + preference + "\", picking by score");
+        }
 
-        int validDevice = deviceInfo.indices.isComplete() && extensionsFound && swapchainAdequate ? 1 : 0;
-        int dedicatedGraphics = deviceInfo.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 1 : 0;
+        return highestScore >= 0;
+    }
 
+    bool RendererCore::querySurfaceSupport(PhysicalDeviceInfo& deviceInfo) {
+        deviceInfo.indices.findQueueIndices(deviceInfo.device, mainWindow.surface);
 
-        deviceInfo.score = validDevice + dedicatedGraphics;
+        // Offscreen images need nothing from a surface
+        bool swapchainAdequate = mHeadless;
+        if (!mHeadless) {
+            querySwapchainSupport(deviceInfo);
+            swapchainAdequate = deviceInfo.swapchainDetails.compatiable();
+        }
 
-        return deviceInfo.score > 0;
+        return deviceInfo.indices.isComplete() && swapchainAdequate;
     }
 
     void RendererCore::querySwapchainSupport(PhysicalDeviceInfo& deviceInfo) {
@@ -252,6 +571,22 @@ namespace SpRenderer {
         }
     }
 
+    bool RendererCore::optionalExtensionEnabled(const char* extensionName) const {
+        for (const char* extension : mPhysicalDeviceInfo.optionalExtensions) {
+            if (std::strcmp(extension, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<const char*> RendererCore::requiredDeviceExtensions() const {
+        if (mHeadless) {
+            return {};
+        }
+        return DeviceExtensions;
+    }
+
     void RendererCore::createLogicalDevice() {
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos{};
 
@@ -286,10 +621,48 @@ namespace SpRenderer {
         deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         deviceCreateInfo.queueCreateInfoCount = static_cast<uint32>(queueCreateInfos.size());
         deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
-        deviceCreateInfo.pEnabledFeatures = nullptr;
 
-        deviceCreateInfo.enabledExtensionCount = static_cast<uint32>(DeviceExtensions.size());
-        deviceCreateInfo.ppEnabledExtensionNames = DeviceExtensions.data();
+        // Culling writes the object index as the draw's first instance
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        enabledFeatures.multiDrawIndirect = mPhysicalDeviceInfo.capabilities.multiDrawIndirect;
+        enabledFeatures.drawIndirectFirstInstance = mPhysicalDeviceInfo.capabilities.drawIndirectFirstInstance;
+        deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+
+        VkPhysicalDeviceVulkan13Features vulkan13Features{};
+        vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        vulkan13Features.dynamicRendering = VK_TRUE;
+        vulkan13Features.synchronization2 = VK_TRUE;
+        if (mPhysicalDeviceInfo.renderingBackend == SP_RENDERING_BACKEND_DYNAMIC) {
+            vulkan13Features.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+            deviceCreateInfo.pNext = &vulkan13Features;
+        }
+
+        // Descriptor indexing comes from the 1.2 features when the device has them, they must not be chained twice
+        bool vulkan12 = mPhysicalDeviceInfo.capabilities.apiVersion >= VK_API_VERSION_1_2;
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.timelineSemaphore = mPhysicalDeviceInfo.capabilities.timelineSemaphores ? VK_TRUE : VK_FALSE;
+        vulkan12Features.drawIndirectCount = mPhysicalDeviceInfo.capabilities.drawIndirectCount ? VK_TRUE : VK_FALSE;
+        enableBindless(vulkan12Features);
+
+        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        enableBindless(indexingFeatures);
+
+        if (vulkan12) {
+            vulkan12Features.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+            deviceCreateInfo.pNext = &vulkan12Features;
+        }else {
+            indexingFeatures.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+            deviceCreateInfo.pNext = &indexingFeatures;
+        }
+
+        std::vector<const char*> enabledExtensions = requiredDeviceExtensions();
+        enabledExtensions.insert(enabledExtensions.end(), mPhysicalDeviceInfo.optionalExtensions.begin(), mPhysicalDeviceInfo.optionalExtensions.end());
+
+        deviceCreateInfo.enabledExtensionCount = static_cast<uint32>(enabledExtensions.size());
+        deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         deviceCreateInfo.enabledLayerCount = static_cast<uint32>(ValidationLayers.size());
         deviceCreateInfo.ppEnabledLayerNames = ValidationLayers.data();
@@ -309,6 +682,31 @@ namespace SpRenderer {
         }
     }
 
+    void RendererCore::createAllocator() {
+        mAllocator.init(mPhysicalDeviceInfo.device, mLogicalDevice.device);
+    }
+
+    void RendererCore::createGpuProfiler() {
+        mGpuProfiler.init(mLogicalDevice.device, mPhysicalDeviceInfo.indices.graphicsFamily.value(), mPhysicalDeviceInfo.capabilities.timestampValidBits,
+                          mPhysicalDeviceInfo.properties.limits, mFrameContext.framesInFlight);
+    }
+
+    void RendererCore::createRenderGraph() {
+        mRenderGraph.init(mLogicalDevice.device, mAllocator, mFrameContext.framesInFlight, mPhysicalDeviceInfo.renderingBackend);
+        mRenderGraph.setGpuProfiler(&mGpuProfiler);
+    }
+
+    void RendererCore::createUploadManager() {
+        mUploadManager.init(mLogicalDevice.device, mAllocator, mPhysicalDeviceInfo.indices, mLogicalDevice.transferQueue,
+                            mPhysicalDeviceInfo.capabilities.timelineSemaphores);
+    }
+
+    void RendererCore::createPipelineCache() {
+        mPipelineCache.init(mLogicalDevice.device, mPhysicalDeviceInfo.properties,
+                            optionalExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME));
+        mLayoutCache.init(mLogicalDevice.device);
+    }
+
     void RendererCore::createSwapchain() {
         mSwapchain.swapchainDetails = &mPhysicalDeviceInfo.swapchainDetails;
 
@@ -330,25 +728,7 @@ namespace SpRenderer {
             mSwapchain.presentMode = VK_PRESENT_MODE_FIFO_KHR;
         }
 
-        //Check if Extent2D is valid
-        if (mSwapchain.swapchainDetails->capabilities.currentExtent.width == std::numeric_limits<uint32_t>::max()) {
-            int width, height;
-            SDL_GetWindowSizeInPixels(mainWindow.window, &width, &height);
-
-            VkExtent2D swapchainExtent = {
-                static_cast<uint32_t>(width),
-                static_cast<uint32_t>(height)
-            };
-
-            swapchainExtent.width = std::clamp(swapchainExtent.width,
-                                               mSwapchain.swapchainDetails->capabilities.minImageExtent.width,
-                                               mSwapchain.swapchainDetails->capabilities.maxImageExtent.width);
-            swapchainExtent.height = std::clamp(swapchainExtent.height,
-                                                mSwapchain.swapchainDetails->capabilities.minImageExtent.height,
-                                                mSwapchain.swapchainDetails->capabilities.maxImageExtent.height);
-
-            mainWindow.extent.width = swapchainExtent.width;
-        }
+        mainWindow.extent = chooseSwapchainExtent();
 
         uint32 imageCount = mSwapchain.swapchainDetails->capabilities.minImageCount + 1;
 
@@ -356,20 +736,11 @@ namespace SpRenderer {
             imageCount = mSwapchain.swapchainDetails->capabilities.maxImageCount;
         }
 
-        std::vector<uint32> queueFamilyIndices;
-        bool transferComplete = mPhysicalDeviceInfo.indices.transferComplete();
-        if (transferComplete) {
-            queueFamilyIndices = {
-                mPhysicalDeviceInfo.indices.graphicsFamily.value(),
-                mPhysicalDeviceInfo.indices.presentFamily.value(),
-                mPhysicalDeviceInfo.indices.transferFamily.value()
-            };
-        }else {
-            queueFamilyIndices = {
-                mPhysicalDeviceInfo.indices.graphicsFamily.value(),
-                mPhysicalDeviceInfo.indices.presentFamily.value()
-            };
-        }
+        // Swapchain images are never touched by the transfer queue, and listing a family twice is invalid
+        std::vector<uint32> queueFamilyIndices = {
+            mPhysicalDeviceInfo.indices.graphicsFamily.value(),
+            mPhysicalDeviceInfo.indices.presentFamily.value()
+        };
 
         VkSwapchainCreateInfoKHR swapchainCreateInfo{};
         swapchainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -395,7 +766,8 @@ namespace SpRenderer {
         swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         swapchainCreateInfo.presentMode = mSwapchain.presentMode;
         swapchainCreateInfo.clipped = VK_TRUE;
-        swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+        // Lets the driver hand over resources from the previous swapchain, which stays alive until retired
+        swapchainCreateInfo.oldSwapchain = mSwapchain.swapchain;
 
         VkResult result = vkCreateSwapchainKHR(mLogicalDevice.device, &swapchainCreateInfo, nullptr, &mSwapchain.swapchain);
 
@@ -406,6 +778,131 @@ namespace SpRenderer {
         vkGetSwapchainImagesKHR(mLogicalDevice.device, mSwapchain.swapchain, &imageCount, mSwapchain.images.data());
     }
 
+    VkExtent2D RendererCore::chooseSwapchainExtent() const {
+        const VkSurfaceCapabilitiesKHR& capabilities = mSwapchain.swapchainDetails->capabilities;
+
+        // Most platforms dictate the extent, a max width means the window size decides
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+            return capabilities.currentExtent;
+        }
+
+        int width, height;
+        SDL_GetWindowSizeInPixels(mainWindow.window, &width, &height);
+
+        VkExtent2D swapchainExtent = {
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height)
+        };
+
+        swapchainExtent.width = std::clamp(swapchainExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        swapchainExtent.height = std::clamp(swapchainExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+
+        return swapchainExtent;
+    }
+
+    bool RendererCore::recreateSwapchain() {
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDeviceInfo.device, mainWindow.surface,
+                                                  &mPhysicalDeviceInfo.swapchainDetails.capabilities);
+
+        // Some platforms report a zero sized surface instead of sending a minimize event
+        VkExtent2D extent = chooseSwapchainExtent();
+        if (extent.width == 0 || extent.height == 0) {
+            return false;
+        }
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+        retireSwapchain();
+        createSwapchain();
+        createImageViews();
+        createSwapchainSyncObjects();
+        // Cached framebuffers point at the retired image views
+        mRenderGraph.retireFramebuffers();
+
+        mSwapchain.outOfDate = false;
+
+        double recreateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        SpConsole::Write(SP_MESSAGE_INFO, "Recreated swapchain at " + std::to_string(mainWindow.extent.width) + "x" +
+                                          std::to_string(mainWindow.extent.height) + " in " + std::to_string(recreateMs) + " ms");
+        return true;
+    }
+
+    void RendererCore::retireSwapchain() {
+        RetiredSwapchain retired{};
+        // The handle stays in mSwapchain so createSwapchain() can pass it as oldSwapchain
+        retired.swapchain = mSwapchain.swapchain;
+        retired.imageViews = std::move(mSwapchain.imageViews);
+        retired.renderFinishedSemaphores = std::move(mSwapchain.renderFinishedSemaphores);
+        retired.retireFrame = mFrameContext.frameNumber;
+
+        mSwapchain.imageViews.clear();
+        mSwapchain.renderFinishedSemaphores.clear();
+
+        mRetiredSwapchains.push_back(std::move(retired));
+    }
+
+    void RendererCore::releaseRetiredSwapchains(bool force) {
+        std::erase_if(mRetiredSwapchains, [this, force](RetiredSwapchain& retired) {
+            // After framesInFlight frames every frame slot was waited on since the swapchain was replaced, so the
+            // frames recorded against it are done. No fence covers presents, the extra frame is for those still
+            // waiting on its semaphores.
+            if (!force && mFrameContext.frameNumber < retired.retireFrame + mFrameContext.framesInFlight + 1) {
+                return false;
+            }
+
+            for (VkImageView imageView : retired.imageViews) {
+                vkDestroyImageView(mLogicalDevice.device, imageView, nullptr);
+            }
+            for (VkSemaphore semaphore : retired.renderFinishedSemaphores) {
+                vkDestroySemaphore(mLogicalDevice.device, semaphore, nullptr);
+            }
+            vkDestroySwapchainKHR(mLogicalDevice.device, retired.swapchain, nullptr);
+
+            SP_LOG(SP_MESSAGE_VERBOSE, "Destroyed retired swapchain from frame " + std::to_string(retired.retireFrame));
+            return true;
+        });
+    }
+
+    void RendererCore::createOffscreenTargets() {
+        // R8G8B8A8_UNORM is guaranteed as a color attachment and is what readbacks hand out
+        mSwapchain.swapchainDetails = &mPhysicalDeviceInfo.swapchainDetails;
+        mSwapchain.surfaceFormat = {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+
+        const uint32 imageCount = mFrameContext.framesInFlight;
+        mSwapchain.images.resize(imageCount);
+        mOffscreenTargets.imageAllocations.resize(imageCount);
+        for (uint32 i = 0; i < imageCount; i++) {
+            createImage(mSwapchain.images[i], mOffscreenTargets.imageAllocations[i], mainWindow.extent.width, mainWindow.extent.height,
+                        mSwapchain.surfaceFormat.format, VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        if (mHeadlessSettings.readback) {
+            VkBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferCreateInfo.size = static_cast<VkDeviceSize>(mainWindow.extent.width) * mainWindow.extent.height * 4;
+            bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            // The CPU reads every byte, cached memory makes that a memcpy instead of uncached reads over the bus
+            AllocationCreateInfo allocationInfo{};
+            allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+            mOffscreenTargets.readbackBuffers.resize(imageCount);
+            mOffscreenTargets.readbackAllocations.resize(imageCount);
+            mOffscreenTargets.readbackFrames.assign(imageCount, NoPendingReadback);
+            for (uint32 i = 0; i < imageCount; i++) {
+                mAllocator.createBuffer(bufferCreateInfo, allocationInfo, mOffscreenTargets.readbackBuffers[i],
+                                        mOffscreenTargets.readbackAllocations[i]);
+            }
+        }
+
+        SpConsole::Write(SP_MESSAGE_INFO, "Created " + std::to_string(imageCount) + " offscreen targets at " +
+                                          std::to_string(mainWindow.extent.width) + "x" + std::to_string(mainWindow.extent.height) +
+                                          (mHeadlessSettings.readback ? " with readback" : ""));
+    }
+
     void RendererCore::createImageViews() {
         mSwapchain.imageViews.resize(mSwapchain.images.size());
 
@@ -433,100 +930,717 @@ namespace SpRenderer {
     }
 
     void RendererCore::createRenderpass() {
-        VkSubpassDependency dependency{};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.srcAccessMask = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        mDepthFormat = findDepthFormat();
 
-        //-------------------//
+        // Pipelines are built against a render pass compatible with the graph's main pass, the graph owns it.
+        // Stays VK_NULL_HANDLE with dynamic rendering
+        VkFormat colorFormat = mSwapchain.surfaceFormat.format;
+        mRenderpass.renderPass = mRenderGraph.compatibleRenderPass(std::span(&colorFormat, 1), mDepthFormat);
 
-        VkAttachmentDescription colorAttachment{};
-        colorAttachment.format = mSwapchain.surfaceFormat.format;
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        if (mRenderpass.renderPass != VK_NULL_HANDLE) {
+            SpConsole::Write(SP_MESSAGE_INFO, "Created Renderpass");
+        }
+    }
 
-        VkAttachmentReference colorAttachmentRef{};
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    void RendererCore::createGraphicsPipeline() {
+        ShaderReflection mainInterface = mShaderLibrary.getReflection("Vertex2D Base.vert");
+        mainInterface.merge(mShaderLibrary.getReflection("Vertex2D Base.frag"));
+
+        ShaderReflection spriteInterface = mShaderLibrary.getReflection("Sprite.vert");
+        spriteInterface.merge(mShaderLibrary.getReflection("Sprite.frag"));
+
+        ShaderReflection meshInterface = mShaderLibrary.getReflection("Mesh.vert");
+        meshInterface.merge(mShaderLibrary.getReflection("Mesh.frag"));
+
+        // Every 2D pipeline gets the layout of all of their shaders together, so they share one pipeline layout and
+        // the sets bound once per frame stay valid whichever pipeline is bound after them. The bindless set needs
+        // update after bind flags reflection can't know about, the table's own layout is used for it
+        ShaderReflection sharedInterface = mainInterface;
+        sharedInterface.merge(spriteInterface);
+        // Meshes draw in the same secondaries as sprites, sharing the layout lets bindDrawState serve them too
+        sharedInterface.merge(meshInterface);
+        std::array<FixedSetLayout, 1> fixedSetLayouts = {{{BindlessDescriptorSet, mBindlessTable.getLayout()}}};
+
+        // Set 0, the per frame uniforms
+        m2DPipeline.descriptorSetLayout = mLayoutCache.getSetLayout(sharedInterface, 0, fixedSetLayouts);
+
+        m2DPipeline.layout = mLayoutCache.getPipelineLayout(sharedInterface, fixedSetLayouts);
+        mSpritePipeline.layout = m2DPipeline.layout;
+        mMeshPipeline.layout = m2DPipeline.layout;
+
+        // Culling binds only the bindless set, set 0 stays empty
+        ShaderReflection cullInterface = mShaderLibrary.getReflection("Cull.comp");
+        mCullPipeline.layout = mLayoutCache.getPipelineLayout(cullInterface, fixedSetLayouts);
+
+        mPipelineRegistry.init(mLogicalDevice.device, mPipelineCache, mShaderLibrary, mJobSystem, mRenderGraph);
+        mPipelineRegistry.registerLayout("2D", m2DPipeline.layout);
+
+        // Last run's pipelines start compiling on the workers while the ones needed right now are requested
+        mPipelineRegistry.prewarm();
+
+        // Without a render pass the attachment formats come from here, they match the graph's main pass
+        GraphicsPipelineDesc baseDesc{};
+        baseDesc.vertexShader = "Vertex2D Base.vert";
+        baseDesc.fragmentShader = "Vertex2D Base.frag";
+        baseDesc.layout = "2D";
+        baseDesc.setVertexInput<Vertex2D>();
+        baseDesc.colorFormats = {mSwapchain.surfaceFormat.format};
+        baseDesc.depthFormat = mDepthFormat;
+
+        GraphicsPipelineDesc spriteDesc = baseDesc;
+        spriteDesc.vertexShader = "Sprite.vert";
+        spriteDesc.fragmentShader = "Sprite.frag";
+        spriteDesc.setVertexInput<Vertex2DPacked, SpriteInstance>();
+
+        GraphicsPipelineDesc meshDesc = baseDesc;
+        meshDesc.vertexShader = "Mesh.vert";
+        meshDesc.fragmentShader = "Mesh.frag";
+        meshDesc.setVertexInput<VertexPacked>();
+
+        m2DPipeline.key = mPipelineRegistry.request(baseDesc);
+        mSpritePipeline.key = mPipelineRegistry.request(spriteDesc);
+        // Not waited on, the scene draws nothing until it is ready
+        mMeshPipeline.key = mPipelineRegistry.request(meshDesc);
+
+        VkComputePipelineCreateInfo cullPipelineInfo{};
+        cullPipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        cullPipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        cullPipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        cullPipelineInfo.stage.module = mShaderLibrary.getModule("Cull.comp");
+        cullPipelineInfo.stage.pName = "main";
+        cullPipelineInfo.layout = mCullPipeline.layout;
+
+        VkResult result = mPipelineCache.createComputePipeline(cullPipelineInfo, mCullPipeline.pipeline);
+        SpConsole::VulkanExitCheck(result, "Failed to create culling pipeline!", SP_FAILURE);
+
+        // Nothing can draw without these two, both compile in parallel before blocking
+        m2DPipeline.pipeline = mPipelineRegistry.wait(m2DPipeline.key);
+        mSpritePipeline.pipeline = mPipelineRegistry.wait(mSpritePipeline.key);
+        SpConsole::Write(SP_MESSAGE_INFO, "Created graphics pipeline");
+
+        mPipelineCache.logStats();
+        mLayoutCache.logStats();
+    }
 
-        //-------------------//
+    void RendererCore::createCommandPool() {
+        VkCommandPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolCreateInfo.queueFamilyIndex = mPhysicalDeviceInfo.indices.graphicsFamily.value();
 
-        mDepthResources.format = findDepthFormat();
+        VkResult result = vkCreateCommandPool(mLogicalDevice.device, &poolCreateInfo, nullptr, &mFrameContext.commandPool);
 
-        VkAttachmentDescription depthAttachment{};
-        depthAttachment.format = mDepthResources.format;
-        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        SpConsole::VulkanExitCheck(result, SP_MESSAGE_INFO, "Created command pool", "Failed to create command pool!", SP_FAILURE);
 
-        VkAttachmentReference depthAttachmentRef{};
-        depthAttachmentRef.attachment = 1;
-        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        mFrameContext.threadCommandPools.init(mLogicalDevice.device, mPhysicalDeviceInfo.indices.graphicsFamily.value(),
+                                              mFrameContext.framesInFlight, mJobSystem.getThreadCount());
+    }
+
+    void RendererCore::createCommandBuffers() {
+        mFrameContext.frames.resize(mFrameContext.framesInFlight);
+
+        std::vector<VkCommandBuffer> commandBuffers(mFrameContext.framesInFlight);
 
-        //-------------------//
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = mFrameContext.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = static_cast<uint32>(commandBuffers.size());
 
-        VkSubpassDescription subpass{};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
-        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+        VkResult result = vkAllocateCommandBuffers(mLogicalDevice.device, &allocInfo, commandBuffers.data());
+
+        SpConsole::VulkanExitCheck(result, SP_MESSAGE_INFO, "Allocated command buffers", "Failed to allocate command buffers!", SP_FAILURE);
+
+        for (size_t i = 0; i < commandBuffers.size(); i++) {
+            mFrameContext.frames[i].commandBuffer = commandBuffers[i];
+        }
+    }
 
-        //-------------------//
-        std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+    void RendererCore::createTextureImage() {
+        // Anything drawn without a texture samples this, so shaders never branch on a missing one
+        createImage(mDefaultTexture.image, mDefaultTexture.allocation, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        createImageView(mDefaultTexture.view, mDefaultTexture.image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
 
-        VkRenderPassCreateInfo renderPassCreateInfo{};
-        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassCreateInfo.attachmentCount = static_cast<uint32>(attachments.size());
-        renderPassCreateInfo.pAttachments = attachments.data();
-        renderPassCreateInfo.subpassCount = 1;
-        renderPassCreateInfo.pSubpasses = &subpass;
-        renderPassCreateInfo.dependencyCount = 1;
-        renderPassCreateInfo.pDependencies = &dependency;
+        const uint32 white = 0xFFFFFFFF;
 
-        VkResult result = vkCreateRenderPass(mLogicalDevice.device, &renderPassCreateInfo, nullptr, &mRenderpass.renderPass);
+        VkImageSubresourceLayers subresource{};
+        subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        subresource.mipLevel = 0;
+        subresource.baseArrayLayer = 0;
+        subresource.layerCount = 1;
 
-        SpConsole::VulkanExitCheck(result, SP_MESSAGE_INFO, "Created Renderpass", "Failed to create Renderpass!", SP_FAILURE);
+        UploadTicket ticket = mUploadManager.uploadImage(mDefaultTexture.image, subresource, {1, 1, 1}, &white, sizeof(white),
+                                                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        // Every bindless slot points at it, it has to be in its final layout before the first frame
+        mUploadManager.wait(ticket);
 
+        SpConsole::Write(SP_MESSAGE_INFO, "Created default texture");
     }
 
-    void RendererCore::createDescriptorSetLayout() {
+    void RendererCore::createBindlessTable() {
+        mBindlessTable.init(mPhysicalDeviceInfo.device, mLogicalDevice.device, mAllocator, mFrameContext.framesInFlight,
+                            mDefaultTexture.view);
     }
 
-    void RendererCore::createGraphicsPipeline() {
-        m2DMainShader.createShader(
-            std::string(RENDERER_RESOURCE_DIR "/shader/Vertex2D Base.vert"),
-            std::string(RENDERER_RESOURCE_DIR "/shader/Vertex2D Base.frag"),
-            mLogicalDevice.device);
-    }
-
-    void RendererCore::createDepthResources() {
-        createImage(
-            mDepthResources.image,
-            mDepthResources.imageMemory,
-            mainWindow.extent.width,
-            mainWindow.extent.height,
-            mDepthResources.format,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-            );
+    void RendererCore::createTextureManager() {
+        // Block compressed textures keep their format when the device samples it and are decoded to 8 bit per
+        // channel on the workers when it does not
+        TextureFormatMap uploadFormats;
+        for (VkFormat format : BlockCompressedFormats) {
+            VkFormat uploadFormat = findSupportedFormat({format, uncompressedFormat(format)}, VK_IMAGE_TILING_OPTIMAL,
+                                                        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+            if (uploadFormat != format) {
+                SpConsole::Write(SP_MESSAGE_WARNING, "Format " + std::to_string(format) + " is not supported, textures using it fall back to " +
+                                                     std::to_string(uploadFormat));
+            }
+            uploadFormats[format] = uploadFormat;
+        }
+
+        mTextureManager.init(mLogicalDevice.device, mAllocator, mUploadManager, mBindlessTable, mJobSystem,
+                             mFrameContext.framesInFlight, uploadFormats);
+    }
+
+    void RendererCore::createUniformBuffers() {
+        for (FrameData& frame : mFrameContext.frames) {
+            createBuffer(frame.uniformBuffer, frame.uniformAllocation, sizeof(FrameUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            updateUniformBuffer(static_cast<uint32>(&frame - mFrameContext.frames.data()));
+        }
+    }
+
+    void RendererCore::createDescriptorPool() {
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSize.descriptorCount = mFrameContext.framesInFlight;
+
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.maxSets = mFrameContext.framesInFlight;
+        poolCreateInfo.poolSizeCount = 1;
+        poolCreateInfo.pPoolSizes = &poolSize;
 
-        createImageView(mDepthResources.imageView, mDepthResources.image, mDepthResources.format, VK_IMAGE_ASPECT_DEPTH_BIT);
+        VkResult result = vkCreateDescriptorPool(mLogicalDevice.device, &poolCreateInfo, nullptr, &mDescriptorPool);
+
+        SpConsole::VulkanExitCheck(result, SP_MESSAGE_INFO, "Created descriptor pool", "Failed to create descriptor pool!", SP_FAILURE);
+    }
+
+    void RendererCore::createDescriptorSets() {
+        std::vector<VkDescriptorSetLayout> layouts(mFrameContext.framesInFlight, m2DPipeline.descriptorSetLayout);
+        std::vector<VkDescriptorSet> descriptorSets(mFrameContext.framesInFlight);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = mDescriptorPool;
+        allocInfo.descriptorSetCount = static_cast<uint32>(layouts.size());
+        allocInfo.pSetLayouts = layouts.data();
+
+        VkResult result = vkAllocateDescriptorSets(mLogicalDevice.device, &allocInfo, descriptorSets.data());
+
+        SpConsole::VulkanExitCheck(result, SP_MESSAGE_INFO, "Allocated descriptor sets", "Failed to allocate descriptor sets!", SP_FAILURE);
+
+        std::vector<VkDescriptorBufferInfo> bufferInfos(mFrameContext.framesInFlight);
+        std::vector<VkWriteDescriptorSet> writes(mFrameContext.framesInFlight);
+        for (size_t i = 0; i < mFrameContext.frames.size(); i++) {
+            FrameData& frame = mFrameContext.frames[i];
+            frame.descriptorSet = descriptorSets[i];
+
+            bufferInfos[i].buffer = frame.uniformBuffer;
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = sizeof(FrameUniforms);
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = 0;
+            writes[i].dstArrayElement = 0;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets(mLogicalDevice.device, static_cast<uint32>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    void RendererCore::updateUniformBuffer(uint32 frameIndex) {
+        FrameUniforms uniforms{};
+        uniforms.model = mat4(1.0f);
+        uniforms.view = mat4(1.0f);
+
+        std::memcpy(mFrameContext.frames[frameIndex].uniformAllocation.mappedData, &uniforms, sizeof(uniforms));
+    }
+
+    void RendererCore::createSpriteBatcher() {
+        mSpriteBatcher.init(mLogicalDevice.device, mAllocator, mFrameContext.framesInFlight);
+
+        uint32 pipelineId = mSpriteBatcher.registerPipeline(mPipelineRegistry, mSpritePipeline.key, mSpritePipeline.layout);
+        SpConsole::Write(SP_MESSAGE_INFO, "Created sprite batcher, default sprite pipeline is " + std::to_string(pipelineId));
+    }
+
+    void RendererCore::createGpuScene() {
+        const DeviceCapabilities& capabilities = mPhysicalDeviceInfo.capabilities;
+        bool vulkan12 = capabilities.apiVersion >= VK_API_VERSION_1_2;
+
+        IndirectDrawMode drawMode = SP_INDIRECT_DRAW_SINGLE;
+        if (!capabilities.drawIndirectFirstInstance) {
+            drawMode = SP_INDIRECT_DRAW_UNSUPPORTED;
+            SpConsole::Write(SP_MESSAGE_WARNING, "No drawIndirectFirstInstance, the GPU scene won't draw anything");
+        }else if (capabilities.drawIndirectCount) {
+            drawMode = SP_INDIRECT_DRAW_COUNT;
+        }else if (capabilities.multiDrawIndirect) {
+            drawMode = SP_INDIRECT_DRAW_MULTI;
+        }
+
+        // Core in 1.2, the extension's entry point before
+        PFN_vkCmdDrawIndexedIndirectCount drawIndexedIndirectCount = nullptr;
+        if (drawMode == SP_INDIRECT_DRAW_COUNT) {
+            drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+                vkGetDeviceProcAddr(mLogicalDevice.device, vulkan12 ? "vkCmdDrawIndexedIndirectCount" : "vkCmdDrawIndexedIndirectCountKHR"));
+            if (drawIndexedIndirectCount == nullptr) {
+                drawMode = capabilities.multiDrawIndirect ? SP_INDIRECT_DRAW_MULTI : SP_INDIRECT_DRAW_SINGLE;
+            }
+        }
+
+        mScene.init(mLogicalDevice.device, mAllocator, mUploadManager, mBindlessTable, mFrameContext.framesInFlight,
+                    drawMode, drawIndexedIndirectCount, mPhysicalDeviceInfo.properties.limits.maxDrawIndirectCount);
+        mScene.setPipelines(mCullPipeline.pipeline, mCullPipeline.layout, mPipelineRegistry, mMeshPipeline.key, mMeshPipeline.layout);
+
+        const char* modeNames[] = {"indirect count", "multi draw indirect", "single draw indirect", "unsupported"};
+        SpConsole::Write(SP_MESSAGE_INFO, std::string("Created GPU scene, draw mode is ") + modeNames[drawMode]);
+    }
+
+    void RendererCore::createSyncObjects() {
+        VkSemaphoreCreateInfo semaphoreCreateInfo{};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkFenceCreateInfo fenceCreateInfo{};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        for (FrameData& frame : mFrameContext.frames) {
+            VkResult result = vkCreateSemaphore(mLogicalDevice.device, &semaphoreCreateInfo, nullptr, &frame.imageAvailableSemaphore);
+            SpConsole::VulkanExitCheck(result, "Failed to create image available semaphore!", SP_FAILURE);
+
+            result = vkCreateFence(mLogicalDevice.device, &fenceCreateInfo, nullptr, &frame.inFlightFence);
+            SpConsole::VulkanExitCheck(result, "Failed to create in flight fence!", SP_FAILURE);
+        }
+
+        createSwapchainSyncObjects();
+
+        mFrameContext.lastFrameTime = std::chrono::steady_clock::now();
+        mFrameContext.lastReportTime = mFrameContext.lastFrameTime;
+
+        SpConsole::Write(SP_MESSAGE_INFO, "Created sync objects for " + std::to_string(mFrameContext.framesInFlight) + " frames in flight");
+    }
+
+    void RendererCore::createSwapchainSyncObjects() {
+        VkSemaphoreCreateInfo semaphoreCreateInfo{};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        // Nothing is presented when headless, so nothing waits on a render finished semaphore
+        mSwapchain.renderFinishedSemaphores.resize(mHeadless ? 0 : mSwapchain.images.size());
+        for (VkSemaphore& semaphore : mSwapchain.renderFinishedSemaphores) {
+            VkResult result = vkCreateSemaphore(mLogicalDevice.device, &semaphoreCreateInfo, nullptr, &semaphore);
+            SpConsole::VulkanExitCheck(result, "Failed to create render finished semaphore!", SP_FAILURE);
+        }
+
+        mSwapchain.imagesInFlight.assign(mSwapchain.images.size(), VK_NULL_HANDLE);
+    }
+
+    void RendererCore::drawFrame() {
+        using Clock = std::chrono::steady_clock;
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+
+        SP_PROFILE_ZONE("RendererCore::drawFrame");
+
+        FrameData& frame = mFrameContext.frames[mFrameContext.currentFrame];
+
+        // Only blocks when the GPU is still busy with the frame that used this slot framesInFlight frames ago
+        Clock::time_point waitStart = Clock::now();
+        {
+            SP_PROFILE_ZONE("Wait for frame fence");
+            vkWaitForFences(mLogicalDevice.device, 1, &frame.inFlightFence, VK_TRUE, std::numeric_limits<uint64>::max());
+        }
+        double fenceWaitMs = Milliseconds(Clock::now() - waitStart).count();
+
+        deliverReadback(mFrameContext.currentFrame);
+
+        // The fence guarantees the GPU is done reading this frame's instance and uniform buffers
+        mFrameContext.threadCommandPools.reset(mFrameContext.currentFrame);
+        mSpriteBatcher.prepare(mFrameContext.currentFrame);
+        mScene.prepare(mFrameContext.currentFrame, mFrameContext.frameNumber);
+        updateUniformBuffer(mFrameContext.currentFrame);
+        mTextureManager.update(mFrameContext.frameNumber);
+        mBindlessTable.commit(mFrameContext.frameNumber);
+
+        releaseRetiredSwapchains(false);
+
+        if (mSwapchain.outOfDate && !recreateSwapchain()) {
+            return;
+        }
+
+        // Each frame slot owns an offscreen image, its fence already says the GPU is done with it
+        uint32 imageIndex = mFrameContext.currentFrame;
+        double acquireWaitMs = 0.0;
+        VkResult result;
+        if (!mHeadless) {
+            Clock::time_point acquireStart = Clock::now();
+            {
+                SP_PROFILE_ZONE("Acquire swapchain image");
+                result = vkAcquireNextImageKHR(mLogicalDevice.device, mSwapchain.swapchain, std::numeric_limits<uint64>::max(),
+                                               frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+            }
+            acquireWaitMs = Milliseconds(Clock::now() - acquireStart).count();
+
+            // Nothing was acquired, so the image available semaphore is still unsignaled and can be reused next frame
+            if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+                mSwapchain.outOfDate = true;
+                return;
+            }
+            if (result == VK_SUBOPTIMAL_KHR) {
+                // Still presentable, finish this frame and recreate before the next one
+                mSwapchain.outOfDate = true;
+            }else if (result != VK_SUCCESS) {
+                SpConsole::VulkanExitCheck(result, "Failed to acquire swapchain image!", SP_FAILURE);
+            }
+        }
+
+        // With fewer frames in flight than swapchain images an older frame can still be rendering to this image
+        if (mSwapchain.imagesInFlight[imageIndex] != VK_NULL_HANDLE && mSwapchain.imagesInFlight[imageIndex] != frame.inFlightFence) {
+            waitStart = Clock::now();
+            vkWaitForFences(mLogicalDevice.device, 1, &mSwapchain.imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64>::max());
+            fenceWaitMs += Milliseconds(Clock::now() - waitStart).count();
+        }
+        mSwapchain.imagesInFlight[imageIndex] = frame.inFlightFence;
+
+        vkResetFences(mLogicalDevice.device, 1, &frame.inFlightFence);
+
+        vkResetCommandBuffer(frame.commandBuffer, 0);
+        recordCommandBuffer(frame.commandBuffer, imageIndex);
+
+        VkSemaphore waitSemaphores[] = {frame.imageAvailableSemaphore};
+        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        VkSemaphore signalSemaphores[] = {mHeadless ? VK_NULL_HANDLE : mSwapchain.renderFinishedSemaphores[imageIndex]};
+
+        // Headless frames are ordered by the queue alone, there is no acquire to wait on and no present to signal
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = mHeadless ? 0 : 1;
+        submitInfo.pWaitSemaphores = waitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frame.commandBuffer;
+        submitInfo.signalSemaphoreCount = mHeadless ? 0 : 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+
+        mGpuProfiler.markSubmit(mFrameContext.currentFrame);
+        result = vkQueueSubmit(mLogicalDevice.graphicsQueue, 1, &submitInfo, frame.inFlightFence);
+        SpConsole::VulkanExitCheck(result, "Failed to submit draw command buffer!", SP_FAILURE);
+
+        // Uploads queued during this frame go out as one batch and overlap with the frame just submitted
+        mUploadManager.flush();
+
+        if (mHeadless) {
+            mFrameContext.frameNumber++;
+            mFrameContext.currentFrame = (mFrameContext.currentFrame + 1) % mFrameContext.framesInFlight;
+
+            updateFrameStats(fenceWaitMs, acquireWaitMs);
+            return;
+        }
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = signalSemaphores;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &mSwapchain.swapchain;
+        presentInfo.pImageIndices = &imageIndex;
+
+        result = vkQueuePresentKHR(mLogicalDevice.presentQueue, &presentInfo);
+        if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR) {
+            mSwapchain.outOfDate = true;
+        }else if (result != VK_SUCCESS) {
+            SpConsole::VulkanExitCheck(result, "Failed to present swapchain image!", SP_FAILURE);
+        }
+
+        mFrameContext.frameNumber++;
+        mFrameContext.currentFrame = (mFrameContext.currentFrame + 1) % mFrameContext.framesInFlight;
+
+        updateFrameStats(fenceWaitMs, acquireWaitMs);
+    }
+
+    void RendererCore::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32 imageIndex) {
+        SP_PROFILE_ZONE("RendererCore::recordCommandBuffer");
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        SpConsole::VulkanExitCheck(result, "Failed to begin recording command buffer!", SP_FAILURE);
+
+        mGpuProfiler.beginFrame(commandBuffer, mFrameContext.currentFrame);
+        GpuZone frameZone = mGpuProfiler.beginZone(commandBuffer, "Frame");
+
+        mUploadManager.recordAcquireBarriers(commandBuffer);
+
+        mRenderGraph.beginFrame(mFrameContext.frameNumber);
+
+        GraphImageDesc backbufferDesc{};
+        backbufferDesc.format = mSwapchain.surfaceFormat.format;
+        backbufferDesc.extent = mainWindow.extent;
+
+        const bool readback = mHeadless && mHeadlessSettings.readback;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        if (mHeadless) {
+            finalLayout = readback ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        }
+
+        // The acquire semaphore is waited on at the color output stage, the first barrier has to chain onto it
+        GraphResource backbuffer = mRenderGraph.importImage("Backbuffer",
+                                                            mSwapchain.images[imageIndex],
+                                                            mSwapchain.imageViews[imageIndex],
+                                                            backbufferDesc,
+                                                            VK_IMAGE_LAYOUT_UNDEFINED,
+                                                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                                            finalLayout);
+
+        GraphImageDesc depthDesc{};
+        depthDesc.format = mDepthFormat;
+        depthDesc.extent = mainWindow.extent;
+        GraphResource depth = mRenderGraph.createImage("Depth", depthDesc);
+
+        VkClearColorValue clearColor = {{ClearColor.x / 255.0f, ClearColor.y / 255.0f, ClearColor.z / 255.0f, 1.0f}};
+
+        GpuScene::CullOutputs culled = mScene.addCullPass(mRenderGraph, mFrameContext.currentFrame);
+
+        RenderGraph::PassBuilder mainPass = mRenderGraph.addPass("Main", SP_GRAPH_PASS_GRAPHICS);
+        mainPass.writeColor(backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, clearColor)
+            .writeDepth(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, 1.0f)
+            .secondaryCommandBuffers();
+        if (culled.drawCommands != InvalidGraphResource) {
+            mainPass.read(culled.drawCommands, SP_GRAPH_ACCESS_INDIRECT);
+        }
+        if (culled.drawCount != InvalidGraphResource) {
+            mainPass.read(culled.drawCount, SP_GRAPH_ACCESS_INDIRECT);
+        }
+        mainPass.execute([this](VkCommandBuffer cmd, const RenderGraph::PassContext& context) {
+            recordScene(cmd, context);
+            recordSprites(cmd, context);
+        });
+
+        if (readback) {
+            const uint32 frameIndex = mFrameContext.currentFrame;
+            VkBuffer readbackBuffer = mOffscreenTargets.readbackBuffers[frameIndex];
+            GraphResource readbackTarget = mRenderGraph.importBuffer("Readback", readbackBuffer,
+                                                                     mOffscreenTargets.readbackAllocations[frameIndex].size);
+
+            mRenderGraph.addPass("Readback", SP_GRAPH_PASS_TRANSFER)
+                .read(backbuffer, SP_GRAPH_ACCESS_TRANSFER_SRC)
+                .write(readbackTarget, SP_GRAPH_ACCESS_TRANSFER_DST)
+                .sideEffects()
+                .execute([this, backbuffer, readbackBuffer](VkCommandBuffer cmd, const RenderGraph::PassContext& context) {
+                    VkBufferImageCopy region{};
+                    region.bufferOffset = 0;
+                    region.bufferRowLength = 0;
+                    region.bufferImageHeight = 0;
+                    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                    region.imageSubresource.mipLevel = 0;
+                    region.imageSubresource.baseArrayLayer = 0;
+                    region.imageSubresource.layerCount = 1;
+                    region.imageOffset = {0, 0, 0};
+                    region.imageExtent = {mainWindow.extent.width, mainWindow.extent.height, 1};
+                    vkCmdCopyImageToBuffer(cmd, context.getImage(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                           readbackBuffer, 1, &region);
+
+                    // The graph only orders GPU work, the host read after the fence needs its own barrier
+                    VkMemoryBarrier hostBarrier{};
+                    hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+                    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                                         1, &hostBarrier, 0, nullptr, 0, nullptr);
+                });
+            mOffscreenTargets.readbackFrames[frameIndex] = mFrameContext.frameNumber;
+        }
+
+        mRenderGraph.compile();
+        mRenderGraph.execute(commandBuffer);
+
+        mGpuProfiler.endZone(commandBuffer, frameZone);
+
+        result = vkEndCommandBuffer(commandBuffer);
+        SpConsole::VulkanExitCheck(result, "Failed to record command buffer!", SP_FAILURE);
+    }
+
+    void RendererCore::recordSprites(VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context) {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point recordStart = Clock::now();
+
+        const uint32 frameIndex = mFrameContext.currentFrame;
+        const uint32 spriteCount = mSpriteBatcher.getInstanceCount(frameIndex);
+        if (spriteCount == 0) {
+            mSpriteBatcher.setRecordStats(0, 0.0);
+            return;
+        }
+
+        const uint32 jobCount = std::clamp((spriteCount + MinSpritesPerRecordJob - 1) / MinSpritesPerRecordJob,
+                                           1u, mJobSystem.getThreadCount());
+        const uint32 spritesPerJob = (spriteCount + jobCount - 1) / jobCount;
+
+        // Each job writes only its own slot, the primary executes them in sprite order
+        std::vector<VkCommandBuffer> secondaryBuffers(jobCount, VK_NULL_HANDLE);
+        std::vector<uint32> pipelineBinds(jobCount, 0);
+
+        JobCounter counter;
+        mJobSystem.parallelFor(jobCount, 1, [&](uint32 begin, uint32 end) {
+            for (uint32 job = begin; job < end; job++) {
+                SP_PROFILE_ZONE("Record sprites");
+
+                VkCommandBuffer secondary = mFrameContext.threadCommandPools.beginSecondary(frameIndex, JobSystem::threadIndex(),
+                                                                                           *context.inheritance);
+                bindDrawState(secondary, context.extent);
+
+                uint32 firstSprite = job * spritesPerJob;
+                uint32 count = std::min(spritesPerJob, spriteCount - firstSprite);
+                pipelineBinds[job] = mSpriteBatcher.recordRange(secondary, frameIndex, context.extent, firstSprite, count);
+
+                VkResult result = vkEndCommandBuffer(secondary);
+                SpConsole::VulkanExitCheck(result, "Failed to record secondary command buffer!", SP_FAILURE);
+                secondaryBuffers[job] = secondary;
+            }
+        }, counter);
+        mJobSystem.wait(counter);
+
+        vkCmdExecuteCommands(commandBuffer, jobCount, secondaryBuffers.data());
+
+        uint32 totalPipelineBinds = 0;
+        for (uint32 binds : pipelineBinds) {
+            totalPipelineBinds += binds;
+        }
+        mSpriteBatcher.setRecordStats(totalPipelineBinds,
+                                      std::chrono::duration<double, std::milli>(Clock::now() - recordStart).count());
+    }
+
+    void RendererCore::recordScene(VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context) {
+        const uint32 frameIndex = mFrameContext.currentFrame;
+        if (!mScene.hasDraws(frameIndex)) {
+            return;
+        }
+
+        // A handful of indirect draws however big the scene, one secondary is plenty
+        VkCommandBuffer secondary = mFrameContext.threadCommandPools.beginSecondary(frameIndex, JobSystem::threadIndex(),
+                                                                                   *context.inheritance);
+        bindDrawState(secondary, context.extent);
+        mScene.record(secondary, frameIndex);
+
+        VkResult result = vkEndCommandBuffer(secondary);
+        SpConsole::VulkanExitCheck(result, "Failed to record secondary command buffer!", SP_FAILURE);
+        vkCmdExecuteCommands(commandBuffer, 1, &secondary);
+    }
+
+    void RendererCore::bindDrawState(VkCommandBuffer commandBuffer, VkExtent2D extent) {
+        // Secondary command buffers inherit none of this from the primary
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        // Textures and buffers are indexed out of the bindless set, so this is the only descriptor bind per command buffer
+        std::array<VkDescriptorSet, 2> descriptorSets = {
+            mFrameContext.frames[mFrameContext.currentFrame].descriptorSet, mBindlessTable.getSet()
+        };
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mSpritePipeline.layout, 0,
+                                static_cast<uint32>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+    }
+
+    void RendererCore::deliverReadback(uint32 frameIndex) {
+        if (mOffscreenTargets.readbackFrames.empty() || mOffscreenTargets.readbackFrames[frameIndex] == NoPendingReadback) {
+            return;
+        }
+
+        uint64 frameNumber = mOffscreenTargets.readbackFrames[frameIndex];
+        mOffscreenTargets.readbackFrames[frameIndex] = NoPendingReadback;
+        if (!mReadbackCallback) {
+            return;
+        }
+
+        SP_PROFILE_ZONE("Deliver readback");
+
+        const Allocation& allocation = mOffscreenTargets.readbackAllocations[frameIndex];
+        mAllocator.invalidate(allocation);
+
+        size_t byteCount = static_cast<size_t>(mainWindow.extent.width) * mainWindow.extent.height * 4;
+        mReadbackCallback(std::span(static_cast<const uint8*>(allocation.mappedData), byteCount), mainWindow.extent, frameNumber);
+    }
+
+    void RendererCore::updateFrameStats(double fenceWaitMs, double acquireWaitMs) {
+        using Clock = std::chrono::steady_clock;
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+
+        Clock::time_point now = Clock::now();
+        double frameMs = Milliseconds(now - mFrameContext.lastFrameTime).count();
+        mFrameContext.lastFrameTime = now;
+
+        // Whatever part of the frame was not spent blocked on the GPU or the presentation engine is CPU work
+        double cpuFrameMs = std::max(frameMs - fenceWaitMs - acquireWaitMs, 0.0);
+
+        if (mFrameStats.frameCount == 0) {
+            mStartupStats.timeToFirstFrameMs = Milliseconds(now - mStartTime).count();
+            SpConsole::Write(SP_MESSAGE_INFO, "First frame submitted " + std::to_string(mStartupStats.timeToFirstFrameMs) +
+                                              " ms after start");
+        }
+
+        mFrameStats.frameCount++;
+        mFrameStats.lastFenceWaitMs = fenceWaitMs;
+        mFrameStats.lastAcquireWaitMs = acquireWaitMs;
+        mFrameStats.lastCpuFrameMs = cpuFrameMs;
+
+        mFrameContext.reportFrameCount++;
+        mFrameContext.reportFenceWaitMs += fenceWaitMs;
+        mFrameContext.reportAcquireWaitMs += acquireWaitMs;
+        mFrameContext.reportCpuFrameMs += cpuFrameMs;
+
+        double reportWindowMs = Milliseconds(now - mFrameContext.lastReportTime).count();
+        if (reportWindowMs < 2000.0) {
+            return;
+        }
+
+        double frames = static_cast<double>(mFrameContext.reportFrameCount);
+        mFrameStats.avgFenceWaitMs = mFrameContext.reportFenceWaitMs / frames;
+        mFrameStats.avgAcquireWaitMs = mFrameContext.reportAcquireWaitMs / frames;
+        mFrameStats.avgCpuFrameMs = mFrameContext.reportCpuFrameMs / frames;
+
+        // If the CPU regularly sits on the frame fence the GPU is the bottleneck
+        const char* bound = mFrameStats.avgFenceWaitMs > mFrameStats.avgCpuFrameMs * 0.25 ? "GPU-bound" : "CPU-bound";
+
+        std::string message = std::to_string(frames * 1000.0 / reportWindowMs) + " fps | cpu " +
+                              std::to_string(mFrameStats.avgCpuFrameMs) + " ms | fence wait " +
+                              std::to_string(mFrameStats.avgFenceWaitMs) + " ms | acquire wait " +
+                              std::to_string(mFrameStats.avgAcquireWaitMs) + " ms | " + bound;
+        SpConsole::Write(SP_MESSAGE_INFO, message);
+
+        mFrameContext.lastReportTime = now;
+        mFrameContext.reportFrameCount = 0;
+        mFrameContext.reportFenceWaitMs = 0.0;
+        mFrameContext.reportAcquireWaitMs = 0.0;
+        mFrameContext.reportCpuFrameMs = 0.0;
     }
 
     void RendererCore::destroySurface() {
+        if (mainWindow.surface == VK_NULL_HANDLE) {
+            return;
+        }
+
         SDL_Vulkan_DestroySurface(vulkanContext.instance, mainWindow.surface, nullptr);
         SpConsole::Write(SP_MESSAGE_INFO, "Destroyed SDL surface");
     }
@@ -541,22 +1655,117 @@ namespace SpRenderer {
         SpConsole::Write(SP_MESSAGE_INFO, "Destroyed Logical device");
     }
 
+    void RendererCore::destroyRenderGraph() {
+        mRenderGraph.destroy();
+    }
+
+    void RendererCore::destroyGpuProfiler() {
+        mGpuProfiler.destroy();
+    }
+
+    void RendererCore::destroyAllocator() {
+        mAllocator.logStats();
+        mAllocator.destroy();
+    }
+
+    void RendererCore::destroyUploadManager() {
+        mUploadManager.destroy();
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed upload manager");
+    }
+
+    void RendererCore::destroyPipelineCache() {
+        mPipelineCache.destroy();
+        mLayoutCache.destroy();
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed pipeline and layout caches");
+    }
+
     void RendererCore::destroySwapchain() {
         vkDestroySwapchainKHR(mLogicalDevice.device, mSwapchain.swapchain, nullptr);
         SpConsole::Write(SP_MESSAGE_INFO, "Destroyed swapchain");
     }
 
+    void RendererCore::destroyOffscreenTargets() {
+        for (size_t i = 0; i < mSwapchain.images.size(); i++) {
+            mAllocator.destroyImage(mSwapchain.images[i], mOffscreenTargets.imageAllocations[i]);
+        }
+        for (size_t i = 0; i < mOffscreenTargets.readbackBuffers.size(); i++) {
+            mAllocator.destroyBuffer(mOffscreenTargets.readbackBuffers[i], mOffscreenTargets.readbackAllocations[i]);
+        }
+        mSwapchain.images.clear();
+        mOffscreenTargets = {};
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed offscreen targets");
+    }
+
     void RendererCore::destroyImageviews() {
         for (size_t i = 0; i < mSwapchain.imageViews.size(); i++) {
             vkDestroyImageView(mLogicalDevice.device, mSwapchain.imageViews[i], nullptr);
-            SpConsole::Write(SP_MESSAGE_VERBOSE, ("Destroyed image view: " + std::to_string(i)).c_str());
+            SP_LOG(SP_MESSAGE_VERBOSE, "Destroyed image view: " + std::to_string(i));
         }
         SpConsole::Write(SP_MESSAGE_INFO, "Destroyed image views");
     }
 
-    void RendererCore::destroyRenderpass() {
-        vkDestroyRenderPass(mLogicalDevice.device, mRenderpass.renderPass, nullptr);
-        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed render pass");
+    void RendererCore::destroyTextureImage() {
+        vkDestroyImageView(mLogicalDevice.device, mDefaultTexture.view, nullptr);
+        mAllocator.destroyImage(mDefaultTexture.image, mDefaultTexture.allocation);
+        mDefaultTexture = {};
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed default texture");
+    }
+
+    void RendererCore::destroyBindlessTable() {
+        mBindlessTable.destroy();
+    }
+
+    void RendererCore::destroyTextureManager() {
+        mTextureManager.destroy();
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed texture manager");
+    }
+
+    void RendererCore::destroyUniformBuffers() {
+        for (FrameData& frame : mFrameContext.frames) {
+            mAllocator.destroyBuffer(frame.uniformBuffer, frame.uniformAllocation);
+        }
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed uniform buffers");
+    }
+
+    void RendererCore::destroyDescriptorPool() {
+        // Frees the per frame sets with it
+        vkDestroyDescriptorPool(mLogicalDevice.device, mDescriptorPool, nullptr);
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed descriptor pool");
+    }
+
+    void RendererCore::destroyGraphicsPipeline() {
+        // Layouts belong to the layout cache, graphics pipelines to the registry
+        vkDestroyPipeline(mLogicalDevice.device, mCullPipeline.pipeline, nullptr);
+        mPipelineRegistry.logStats();
+        mPipelineRegistry.destroy();
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed graphics pipeline");
+    }
+
+    void RendererCore::destroySpriteBatcher() {
+        mSpriteBatcher.destroy();
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed sprite batcher");
+    }
+
+    void RendererCore::destroyGpuScene() {
+        mScene.destroy();
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed GPU scene");
+    }
+
+    void RendererCore::destroyCommandPool() {
+        mFrameContext.threadCommandPools.destroy();
+        vkDestroyCommandPool(mLogicalDevice.device, mFrameContext.commandPool, nullptr);
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed command pool");
+    }
+
+    void RendererCore::destroySyncObjects() {
+        for (FrameData& frame : mFrameContext.frames) {
+            vkDestroySemaphore(mLogicalDevice.device, frame.imageAvailableSemaphore, nullptr);
+            vkDestroyFence(mLogicalDevice.device, frame.inFlightFence, nullptr);
+        }
+        for (VkSemaphore semaphore : mSwapchain.renderFinishedSemaphores) {
+            vkDestroySemaphore(mLogicalDevice.device, semaphore, nullptr);
+        }
+        SpConsole::Write(SP_MESSAGE_INFO, "Destroyed sync objects");
     }
 
     VkFormat RendererCore::findSupportedFormat(const std::vector<VkFormat>& candidates,
@@ -580,16 +1789,8 @@ namespace SpRenderer {
         VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
     }
 
-    uint32 RendererCore::findMemoryType(uint32 typeFilter, VkMemoryPropertyFlags properties) {
-        for (size_t i = 0; i < mPhysicalDeviceInfo.memoryProperties.memoryTypeCount; i++) {
-            if (typeFilter & (1 << i) && (mPhysicalDeviceInfo.memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                return i;
-            }
-        }
-    }
-
     void RendererCore::createImage(VkImage& image,
-                                   VkDeviceMemory& imageMemory,
+                                   Allocation& allocation,
                                    uint32 width,
                                    uint32 height,
                                    VkFormat format,
@@ -612,21 +1813,30 @@ namespace SpRenderer {
         imageCreateInfo.usage = usage;
         imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 
+        AllocationCreateInfo allocationInfo{};
+        allocationInfo.requiredFlags = properties;
+
+        mAllocator.createImage(imageCreateInfo, allocationInfo, image, allocation);
+        SpConsole::Write(SP_MESSAGE_VERBOSE, "Created image");
+    }
 
-        VkResult result = vkCreateImage(mLogicalDevice.device, &imageCreateInfo, nullptr, &image);
-        SpConsole::VulkanResult(result, SP_MESSAGE_ERROR, SP_MESSAGE_INFO, "Failed to create image!", "Created image");
+    void RendererCore::createBuffer(VkBuffer& buffer,
+                                    Allocation& allocation,
+                                    VkDeviceSize size,
+                                    VkBufferUsageFlags usage,
+                                    VkMemoryPropertyFlags properties) {
 
-        VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(mLogicalDevice.device, image, &memRequirements);
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = size;
+        bufferCreateInfo.usage = usage;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VkMemoryAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        AllocationCreateInfo allocationInfo{};
+        allocationInfo.requiredFlags = properties;
 
-        result = vkAllocateMemory(mLogicalDevice.device, &allocInfo, nullptr, &imageMemory);
-        SpConsole::VulkanExitCheck(result, "Failed to allocate memory!", "Allocated memory", SP_FAILURE);
-        vkBindImageMemory(mLogicalDevice.device, image, imageMemory, 0);
+        mAllocator.createBuffer(bufferCreateInfo, allocationInfo, buffer, allocation);
+        SpConsole::Write(SP_MESSAGE_VERBOSE, "Created buffer");
     }
 
     void RendererCore::createImageView(VkImageView& imageView,
@@ -0,0 +1,378 @@
+//
+// Created by robsc on 11/30/25.
+//
+
+#include "BindlessTable.h"
+
+namespace SpRenderer {
+	void BindlessTable::init(VkPhysicalDevice physicalDevice,
+	                         VkDevice device,
+	                         MemoryAllocator& allocator,
+	                         uint32 framesInFlight,
+	                         VkImageView defaultImageView) {
+		mDevice = device;
+		mAllocator = &allocator;
+		mFramesInFlight = framesInFlight;
+		mDefaultImageView = defaultImageView;
+
+		mArrays[SP_BINDLESS_BINDING_SAMPLED_IMAGES].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		mArrays[SP_BINDLESS_BINDING_SAMPLERS].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		mArrays[SP_BINDLESS_BINDING_STORAGE_BUFFERS].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+		queryCapacities(physicalDevice);
+		createLayout();
+		createPool();
+		createDefaults();
+		writeDefaults();
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Created bindless table with " +
+		                                  std::to_string(mArrays[SP_BINDLESS_BINDING_SAMPLED_IMAGES].capacity) + " images, " +
+		                                  std::to_string(mArrays[SP_BINDLESS_BINDING_SAMPLERS].capacity) + " samplers and " +
+		                                  std::to_string(mArrays[SP_BINDLESS_BINDING_STORAGE_BUFFERS].capacity) + " storage buffers");
+	}
+
+	void BindlessTable::destroy() {
+		// Frees the set with it
+		vkDestroyDescriptorPool(mDevice, mPool, nullptr);
+		vkDestroyDescriptorSetLayout(mDevice, mLayout, nullptr);
+		vkDestroySampler(mDevice, mDefaultSampler, nullptr);
+		mAllocator->destroyBuffer(mDefaultBuffer, mDefaultBufferAllocation);
+
+		mPool = VK_NULL_HANDLE;
+		mLayout = VK_NULL_HANDLE;
+		mSet = VK_NULL_HANDLE;
+		mDefaultSampler = VK_NULL_HANDLE;
+		mDefaultBuffer = VK_NULL_HANDLE;
+
+		mArrays = {};
+		mPendingWrites.clear();
+		mStats = {};
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Destroyed bindless table");
+	}
+
+	BindlessIndex BindlessTable::registerImage(VkImageView imageView, VkImageLayout layout) {
+		std::lock_guard lock(mMutex);
+
+		PendingWrite write{};
+		write.binding = SP_BINDLESS_BINDING_SAMPLED_IMAGES;
+		write.index = acquireSlot(write.binding);
+		write.imageInfo.imageView = imageView;
+		write.imageInfo.imageLayout = layout;
+		mPendingWrites.push_back(write);
+
+		return write.index;
+	}
+
+	BindlessIndex BindlessTable::registerSampler(VkSampler sampler) {
+		std::lock_guard lock(mMutex);
+
+		PendingWrite write{};
+		write.binding = SP_BINDLESS_BINDING_SAMPLERS;
+		write.index = acquireSlot(write.binding);
+		write.imageInfo.sampler = sampler;
+		mPendingWrites.push_back(write);
+
+		return write.index;
+	}
+
+	BindlessIndex BindlessTable::registerBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+		std::lock_guard lock(mMutex);
+
+		PendingWrite write{};
+		write.binding = SP_BINDLESS_BINDING_STORAGE_BUFFERS;
+		write.index = acquireSlot(write.binding);
+		write.bufferInfo.buffer = buffer;
+		write.bufferInfo.offset = offset;
+		write.bufferInfo.range = range;
+		mPendingWrites.push_back(write);
+
+		return write.index;
+	}
+
+	void BindlessTable::releaseImage(BindlessIndex index) {
+		std::lock_guard lock(mMutex);
+		releaseSlot(SP_BINDLESS_BINDING_SAMPLED_IMAGES, index);
+	}
+
+	void BindlessTable::releaseSampler(BindlessIndex index) {
+		std::lock_guard lock(mMutex);
+		releaseSlot(SP_BINDLESS_BINDING_SAMPLERS, index);
+	}
+
+	void BindlessTable::releaseBuffer(BindlessIndex index) {
+		std::lock_guard lock(mMutex);
+		releaseSlot(SP_BINDLESS_BINDING_STORAGE_BUFFERS, index);
+	}
+
+	void BindlessTable::commit(uint64 frameNumber) {
+		std::lock_guard lock(mMutex);
+		mFrameNumber = frameNumber;
+
+		// Frames up to frameNumber - framesInFlight finished, nothing in flight can read these slots any more
+		for (uint32 binding = 0; binding < SP_BINDLESS_BINDING_COUNT; binding++) {
+			SlotArray& array = mArrays[binding];
+
+			size_t kept = 0;
+			for (const RetiredSlot& slot : array.retired) {
+				if (slot.retireFrame + mFramesInFlight <= frameNumber) {
+					mPendingWrites.push_back(defaultWrite(static_cast<BindlessBinding>(binding), slot.index));
+					array.freeIndices.push_back(slot.index);
+				}else {
+					array.retired[kept++] = slot;
+				}
+			}
+			array.retired.resize(kept);
+		}
+
+		mStats.lastCommitWrites = static_cast<uint32>(mPendingWrites.size());
+		if (mPendingWrites.empty()) {
+			return;
+		}
+
+		std::vector<VkWriteDescriptorSet> writes(mPendingWrites.size());
+		for (size_t i = 0; i < mPendingWrites.size(); i++) {
+			const PendingWrite& pending = mPendingWrites[i];
+
+			VkWriteDescriptorSet& write = writes[i];
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = mSet;
+			write.dstBinding = pending.binding;
+			write.dstArrayElement = pending.index;
+			write.descriptorCount = 1;
+			write.descriptorType = mArrays[pending.binding].type;
+			if (pending.binding == SP_BINDLESS_BINDING_STORAGE_BUFFERS) {
+				write.pBufferInfo = &pending.bufferInfo;
+			}else {
+				write.pImageInfo = &pending.imageInfo;
+			}
+		}
+
+		// Update after bind, so this is fine while earlier frames using the set are still executing
+		vkUpdateDescriptorSets(mDevice, static_cast<uint32>(writes.size()), writes.data(), 0, nullptr);
+
+		mPendingWrites.clear();
+		mStats.commitCount++;
+	}
+
+	BindlessStats BindlessTable::getStats() {
+		std::lock_guard lock(mMutex);
+
+		mStats.imageCount = mArrays[SP_BINDLESS_BINDING_SAMPLED_IMAGES].liveCount;
+		mStats.samplerCount = mArrays[SP_BINDLESS_BINDING_SAMPLERS].liveCount;
+		mStats.bufferCount = mArrays[SP_BINDLESS_BINDING_STORAGE_BUFFERS].liveCount;
+		mStats.imageCapacity = mArrays[SP_BINDLESS_BINDING_SAMPLED_IMAGES].capacity;
+		mStats.samplerCapacity = mArrays[SP_BINDLESS_BINDING_SAMPLERS].capacity;
+		mStats.bufferCapacity = mArrays[SP_BINDLESS_BINDING_STORAGE_BUFFERS].capacity;
+		return mStats;
+	}
+
+	void BindlessTable::queryCapacities(VkPhysicalDevice physicalDevice) {
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &indexingProperties;
+
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+		// Every binding is visible to all stages, so the per stage limits apply to the whole array
+		mArrays[SP_BINDLESS_BINDING_SAMPLED_IMAGES].capacity = std::min({
+			BindlessImageCapacity,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages
+		});
+		mArrays[SP_BINDLESS_BINDING_SAMPLERS].capacity = std::min({
+			BindlessSamplerCapacity,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+			indexingProperties.maxDescriptorSetUpdateAfterBindSamplers
+		});
+		mArrays[SP_BINDLESS_BINDING_STORAGE_BUFFERS].capacity = std::min({
+			BindlessBufferCapacity,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+			indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers
+		});
+
+		uint32 total = 0;
+		for (const SlotArray& array : mArrays) {
+			if (array.capacity <= DefaultBindlessIndex) {
+				SpConsole::FatalExit("Device does not allow update after bind descriptors of every bindless type", SP_FAILURE);
+			}
+			total += array.capacity;
+		}
+		if (total > indexingProperties.maxUpdateAfterBindDescriptorsInAllPools) {
+			SpConsole::FatalExit("Bindless table exceeds maxUpdateAfterBindDescriptorsInAllPools", SP_FAILURE);
+		}
+	}
+
+	void BindlessTable::createLayout() {
+		std::array<VkDescriptorSetLayoutBinding, SP_BINDLESS_BINDING_COUNT> bindings{};
+		std::array<VkDescriptorBindingFlags, SP_BINDLESS_BINDING_COUNT> bindingFlags{};
+
+		for (uint32 binding = 0; binding < SP_BINDLESS_BINDING_COUNT; binding++) {
+			bindings[binding].binding = binding;
+			bindings[binding].descriptorType = mArrays[binding].type;
+			bindings[binding].descriptorCount = mArrays[binding].capacity;
+			bindings[binding].stageFlags = VK_SHADER_STAGE_ALL;
+
+			// Slots a frame in flight does not read can be rewritten while it executes
+			bindingFlags[binding] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			                        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			                        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32>(bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.pNext = &bindingFlagsInfo;
+		layoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutCreateInfo.bindingCount = static_cast<uint32>(bindings.size());
+		layoutCreateInfo.pBindings = bindings.data();
+
+		VkResult result = vkCreateDescriptorSetLayout(mDevice, &layoutCreateInfo, nullptr, &mLayout);
+		SpConsole::VulkanExitCheck(result, "Failed to create bindless descriptor set layout!", SP_FAILURE);
+	}
+
+	void BindlessTable::createPool() {
+		std::array<VkDescriptorPoolSize, SP_BINDLESS_BINDING_COUNT> poolSizes{};
+		for (uint32 binding = 0; binding < SP_BINDLESS_BINDING_COUNT; binding++) {
+			poolSizes[binding].type = mArrays[binding].type;
+			poolSizes[binding].descriptorCount = mArrays[binding].capacity;
+		}
+
+		VkDescriptorPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolCreateInfo.maxSets = 1;
+		poolCreateInfo.poolSizeCount = static_cast<uint32>(poolSizes.size());
+		poolCreateInfo.pPoolSizes = poolSizes.data();
+
+		VkResult result = vkCreateDescriptorPool(mDevice, &poolCreateInfo, nullptr, &mPool);
+		SpConsole::VulkanExitCheck(result, "Failed to create bindless descriptor pool!", SP_FAILURE);
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = mPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &mLayout;
+
+		result = vkAllocateDescriptorSets(mDevice, &allocInfo, &mSet);
+		SpConsole::VulkanExitCheck(result, "Failed to allocate bindless descriptor set!", SP_FAILURE);
+	}
+
+	void BindlessTable::createDefaults() {
+		VkSamplerCreateInfo samplerCreateInfo{};
+		samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+		samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+		samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+		samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+		VkResult result = vkCreateSampler(mDevice, &samplerCreateInfo, nullptr, &mDefaultSampler);
+		SpConsole::VulkanExitCheck(result, "Failed to create default sampler!", SP_FAILURE);
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = DefaultBindlessBufferSize;
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// Host visible so it can be zeroed without a transfer, it is tiny and only read by mistake
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, mDefaultBuffer, mDefaultBufferAllocation);
+		std::memset(mDefaultBufferAllocation.mappedData, 0, DefaultBindlessBufferSize);
+	}
+
+	void BindlessTable::writeDefaults() {
+		std::array<std::vector<VkDescriptorImageInfo>, SP_BINDLESS_BINDING_COUNT> imageInfos;
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		std::array<VkWriteDescriptorSet, SP_BINDLESS_BINDING_COUNT> writes{};
+
+		// One write per array covering every slot
+		for (uint32 binding = 0; binding < SP_BINDLESS_BINDING_COUNT; binding++) {
+			const SlotArray& array = mArrays[binding];
+			PendingWrite slotDefault = defaultWrite(static_cast<BindlessBinding>(binding), 0);
+
+			VkWriteDescriptorSet& write = writes[binding];
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = mSet;
+			write.dstBinding = binding;
+			write.dstArrayElement = 0;
+			write.descriptorCount = array.capacity;
+			write.descriptorType = array.type;
+
+			if (binding == SP_BINDLESS_BINDING_STORAGE_BUFFERS) {
+				bufferInfos.assign(array.capacity, slotDefault.bufferInfo);
+				write.pBufferInfo = bufferInfos.data();
+			}else {
+				imageInfos[binding].assign(array.capacity, slotDefault.imageInfo);
+				write.pImageInfo = imageInfos[binding].data();
+			}
+		}
+
+		vkUpdateDescriptorSets(mDevice, static_cast<uint32>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	BindlessIndex BindlessTable::acquireSlot(BindlessBinding binding) {
+		SlotArray& array = mArrays[binding];
+
+		BindlessIndex index;
+		if (!array.freeIndices.empty()) {
+			index = array.freeIndices.back();
+			array.freeIndices.pop_back();
+		}else if (array.nextIndex < array.capacity) {
+			index = array.nextIndex++;
+		}else {
+			SpConsole::FatalExit("Bindless table is out of slots for binding " + std::to_string(binding), SP_FAILURE);
+		}
+
+		array.liveCount++;
+		return index;
+	}
+
+	void BindlessTable::releaseSlot(BindlessBinding binding, BindlessIndex index) {
+		if (index == DefaultBindlessIndex) {
+			return;
+		}
+
+		SlotArray& array = mArrays[binding];
+		array.retired.push_back({index, mFrameNumber});
+		array.liveCount--;
+	}
+
+	BindlessTable::PendingWrite BindlessTable::defaultWrite(BindlessBinding binding, BindlessIndex index) const {
+		PendingWrite write{};
+		write.binding = binding;
+		write.index = index;
+
+		switch (binding) {
+			case SP_BINDLESS_BINDING_SAMPLED_IMAGES:
+				write.imageInfo.imageView = mDefaultImageView;
+				write.imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				break;
+			case SP_BINDLESS_BINDING_SAMPLERS:
+				write.imageInfo.sampler = mDefaultSampler;
+				break;
+			case SP_BINDLESS_BINDING_STORAGE_BUFFERS:
+				write.bufferInfo.buffer = mDefaultBuffer;
+				write.bufferInfo.offset = 0;
+				write.bufferInfo.range = VK_WHOLE_SIZE;
+				break;
+			default:
+				break;
+		}
+
+		return write;
+	}
+} // SpRenderer
@@ -0,0 +1,302 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "DeviceProfile.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace SpRenderer {
+	// 'SPDP'
+	const uint32 DeviceProfileMagic = 0x50445053;
+	const uint32 DeviceProfileVersion = 2;
+
+	namespace {
+		struct DeviceProfileHeader {
+			uint32 magic;
+			uint32 version;
+			uint64 configuration;
+			uint32 capabilitiesSize;
+			uint32 reserved;
+		};
+
+		// VkPhysicalDeviceVulkan12Features and VkPhysicalDeviceDescriptorIndexingFeatures name these the same
+		template<typename Features>
+		bool supportsBindless(const Features& features) {
+			return features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE &&
+			       features.shaderStorageBufferArrayNonUniformIndexing == VK_TRUE &&
+			       features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+			       features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+			       features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE &&
+			       features.descriptorBindingPartiallyBound == VK_TRUE &&
+			       features.runtimeDescriptorArray == VK_TRUE;
+		}
+
+		bool hasExtension(const std::vector<VkExtensionProperties>& extensions, const char* name) {
+			for (const VkExtensionProperties& extension : extensions) {
+				if (std::strcmp(extension.extensionName, name) == 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice physicalDevice,
+	                                           uint32 instanceApiVersion,
+	                                           std::span<const char* const> requiredExtensions,
+	                                           std::span<const char* const> optionalExtensions) {
+		if (optionalExtensions.size() > 32) {
+			SpConsole::FatalExit("Device profiles track at most 32 optional extensions", SP_FAILURE);
+		}
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		DeviceCapabilities capabilities{};
+		capabilities.vendorID = properties.vendorID;
+		capabilities.deviceID = properties.deviceID;
+		capabilities.driverVersion = properties.driverVersion;
+		std::memcpy(capabilities.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		std::memcpy(capabilities.deviceName, properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE);
+		capabilities.deviceType = properties.deviceType;
+		capabilities.apiVersion = std::min(instanceApiVersion, properties.apiVersion);
+
+		//-------------------//
+
+		uint32 extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+		capabilities.requiredExtensions = VK_TRUE;
+		for (const char* extension : requiredExtensions) {
+			if (!hasExtension(extensions, extension)) {
+				capabilities.requiredExtensions = VK_FALSE;
+			}
+		}
+		for (uint32 i = 0; i < optionalExtensions.size(); i++) {
+			if (hasExtension(extensions, optionalExtensions[i])) {
+				capabilities.optionalExtensionMask |= 1u << i;
+			}
+		}
+
+		//-------------------//
+
+		if (capabilities.apiVersion >= VK_API_VERSION_1_1) {
+			bool vulkan12 = capabilities.apiVersion >= VK_API_VERSION_1_2;
+			bool vulkan13 = capabilities.apiVersion >= VK_API_VERSION_1_3;
+			// Descriptor indexing is core in 1.2, a 1.1 device needs the extension
+			bool indexingExtension = !vulkan12 && hasExtension(extensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+
+			VkPhysicalDeviceVulkan13Features vulkan13Features{};
+			vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+			VkPhysicalDeviceVulkan12Features vulkan12Features{};
+			vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			vulkan12Features.pNext = vulkan13 ? &vulkan13Features : nullptr;
+
+			VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+			indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+			VkPhysicalDeviceFeatures2 features2{};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			if (vulkan12) {
+				features2.pNext = &vulkan12Features;
+			}else if (indexingExtension) {
+				features2.pNext = &indexingFeatures;
+			}
+
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+			capabilities.timelineSemaphores = vulkan12 && vulkan12Features.timelineSemaphore == VK_TRUE;
+			capabilities.dynamicRendering = vulkan13 &&
+			                                vulkan13Features.dynamicRendering == VK_TRUE &&
+			                                vulkan13Features.synchronization2 == VK_TRUE;
+			capabilities.descriptorIndexing = vulkan12 ? supportsBindless(vulkan12Features)
+			                                           : indexingExtension && supportsBindless(indexingFeatures);
+			capabilities.drawIndirectCount = vulkan12 ? vulkan12Features.drawIndirectCount == VK_TRUE
+			                                          : hasExtension(extensions, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+			capabilities.multiDrawIndirect = features2.features.multiDrawIndirect;
+			capabilities.drawIndirectFirstInstance = features2.features.drawIndirectFirstInstance;
+		}
+
+		//-------------------//
+
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		for (uint32 i = 0; i < memoryProperties.memoryHeapCount; i++) {
+			const VkMemoryHeap& heap = memoryProperties.memoryHeaps[i];
+			if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+				capabilities.deviceLocalBytes = std::max<uint64>(capabilities.deviceLocalBytes, heap.size);
+			}
+		}
+
+		uint32 queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		bool foundGraphics = false;
+		for (const VkQueueFamilyProperties& family : queueFamilies) {
+			bool graphics = family.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+			bool compute = family.queueFlags & VK_QUEUE_COMPUTE_BIT;
+			bool transfer = family.queueFlags & VK_QUEUE_TRANSFER_BIT;
+
+			if (graphics && !foundGraphics) {
+				capabilities.timestampValidBits = properties.limits.timestampPeriod > 0.0f ? family.timestampValidBits : 0;
+				foundGraphics = true;
+			}
+			if (compute && !graphics) {
+				capabilities.asyncCompute = VK_TRUE;
+			}
+			if (transfer && !graphics && !compute) {
+				capabilities.dedicatedTransfer = VK_TRUE;
+			}
+		}
+
+		return capabilities;
+	}
+
+	int64 scoreDevice(const DeviceCapabilities& capabilities) {
+		// Everything is drawn through the bindless table, there is no fallback without descriptor indexing
+		if (!capabilities.requiredExtensions || !capabilities.descriptorIndexing) {
+			return -1;
+		}
+
+		int64 score = 0;
+		switch (capabilities.deviceType) {
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+				score += 10000;
+				break;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+				score += 4000;
+				break;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+				score += 2000;
+				break;
+			default:
+				break;
+		}
+
+		// A point per 16 MiB, capped at 16 GiB so an integrated GPU reporting all of system memory as local can't
+		// outweigh the device type
+		const uint64 MaxScoredLocalBytes = 16ull << 30;
+		score += static_cast<int64>(std::min(capabilities.deviceLocalBytes, MaxScoredLocalBytes) >> 24);
+
+		if (capabilities.asyncCompute) score += 500;
+		if (capabilities.dedicatedTransfer) score += 500;
+		if (capabilities.dynamicRendering) score += 400;
+		if (capabilities.timelineSemaphores) score += 300;
+		if (capabilities.drawIndirectCount) score += 200;
+		if (capabilities.timestampValidBits != 0) score += 100;
+
+		return score;
+	}
+
+	bool sameDevice(const DeviceCapabilities& capabilities, const VkPhysicalDeviceProperties& properties) {
+		return capabilities.vendorID == properties.vendorID &&
+		       capabilities.deviceID == properties.deviceID &&
+		       capabilities.driverVersion == properties.driverVersion &&
+		       std::memcmp(capabilities.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	uint64 deviceProfileConfiguration(uint32 instanceApiVersion,
+	                                  std::span<const char* const> requiredExtensions,
+	                                  std::span<const char* const> optionalExtensions) {
+		uint64 hash = Utils::hashCombine(Utils::HashSeed, instanceApiVersion);
+		hash = Utils::hashCombine(hash, sizeof(DeviceCapabilities));
+		for (const char* extension : requiredExtensions) {
+			hash = Utils::hash64(extension, hash);
+		}
+		// Separates the two lists, moving an extension from one to the other changes the key
+		hash = Utils::hashCombine(hash, requiredExtensions.size());
+		for (const char* extension : optionalExtensions) {
+			hash = Utils::hash64(extension, hash);
+		}
+		return hash;
+	}
+
+	std::string preferredDevice() {
+		if (const char* environment = std::getenv(DEVICE_OVERRIDE_ENV); environment != nullptr && environment[0] != '\0') {
+			return environment;
+		}
+#ifdef SP_PREFERRED_DEVICE
+		return SP_PREFERRED_DEVICE;
+#else
+		return {};
+#endif
+	}
+
+	bool matchesDevicePreference(const std::string& preference, uint32 index, const char* deviceName) {
+		if (preference.empty()) {
+			return false;
+		}
+
+		if (std::all_of(preference.begin(), preference.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+			return std::to_string(index) == preference;
+		}
+
+		auto lower = [](std::string string) {
+			std::transform(string.begin(), string.end(), string.begin(), [](char c) {
+				return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			});
+			return string;
+		};
+		return lower(deviceName).find(lower(preference)) != std::string::npos;
+	}
+
+	bool loadDeviceProfile(const fs::path& filePath, uint64 configuration, DeviceCapabilities& capabilities) {
+		if (!fs::exists(filePath)) {
+			return false;
+		}
+
+		Utils::MappedFile file = Utils::FileUtils::mapFile(filePath);
+		std::span<const char> data = file.data();
+		if (data.size() != sizeof(DeviceProfileHeader) + sizeof(DeviceCapabilities)) {
+			return false;
+		}
+
+		DeviceProfileHeader header{};
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != DeviceProfileMagic ||
+		    header.version != DeviceProfileVersion ||
+		    header.configuration != configuration ||
+		    header.capabilitiesSize != sizeof(DeviceCapabilities)) {
+			return false;
+		}
+
+		std::memcpy(&capabilities, data.data() + sizeof(header), sizeof(capabilities));
+		return true;
+	}
+
+	void saveDeviceProfile(const fs::path& filePath, uint64 configuration, const DeviceCapabilities& capabilities) {
+		DeviceProfileHeader header{};
+		header.magic = DeviceProfileMagic;
+		header.version = DeviceProfileVersion;
+		header.configuration = configuration;
+		header.capabilitiesSize = sizeof(DeviceCapabilities);
+
+		std::vector<char> data(sizeof(header) + sizeof(capabilities));
+		std::memcpy(data.data(), &header, sizeof(header));
+		std::memcpy(data.data() + sizeof(header), &capabilities, sizeof(capabilities));
+
+		if (!fs::exists(filePath.parent_path())) {
+			fs::create_directories(filePath.parent_path());
+		}
+
+		// Rename over the old profile so an interrupted write never leaves a torn one behind
+		fs::path tempPath = filePath;
+		tempPath += ".tmp";
+		Utils::FileUtils::writeBinaryFile(tempPath, data);
+
+		std::error_code error;
+		fs::rename(tempPath, filePath, error);
+		if (error) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to replace device profile: " + error.message());
+		}
+	}
+} // SpRenderer
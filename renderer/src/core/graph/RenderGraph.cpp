@@ -0,0 +1,1174 @@
+//
+// Created by robsc on 11/30/25.
+//
+
+#include "RenderGraph.h"
+
+namespace SpRenderer {
+	const VkAccessFlags WriteAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	                                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	                                      VK_ACCESS_SHADER_WRITE_BIT |
+	                                      VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	const uint32 UnusedPass = std::numeric_limits<uint32>::max();
+
+	static bool isAttachment(GraphAccess access) {
+		return access == SP_GRAPH_ACCESS_COLOR_ATTACHMENT ||
+		       access == SP_GRAPH_ACCESS_DEPTH_ATTACHMENT ||
+		       access == SP_GRAPH_ACCESS_DEPTH_READ;
+	}
+
+#pragma region PassBuilder
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeColor(GraphResource resource,
+	                                                               VkAttachmentLoadOp loadOp,
+	                                                               VkClearColorValue clearValue) {
+		Pass& pass = mGraph->addAccess(mPass, resource, SP_GRAPH_ACCESS_COLOR_ATTACHMENT, 0,
+		                               loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true);
+		if (pass.colorAttachments.size() >= MaxGraphColorAttachments) {
+			SpConsole::FatalExit(std::string("Too many color attachments in pass ") + pass.name, SP_FAILURE);
+		}
+
+		Attachment attachment{resource, loadOp, VK_ATTACHMENT_STORE_OP_DONT_CARE, {}, false};
+		attachment.clearValue.color = clearValue;
+		pass.colorAttachments.push_back(attachment);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(GraphResource resource,
+	                                                               VkAttachmentLoadOp loadOp,
+	                                                               float clearDepth) {
+		Pass& pass = mGraph->addAccess(mPass, resource, SP_GRAPH_ACCESS_DEPTH_ATTACHMENT, 0,
+		                               loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true);
+
+		pass.depthAttachment = {resource, loadOp, VK_ATTACHMENT_STORE_OP_DONT_CARE, {}, false};
+		pass.depthAttachment.clearValue.depthStencil = {clearDepth, 0};
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::readDepth(GraphResource resource) {
+		Pass& pass = mGraph->addAccess(mPass, resource, SP_GRAPH_ACCESS_DEPTH_READ, 0, true, false);
+
+		pass.depthAttachment = {resource, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_DONT_CARE, {}, true};
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(GraphResource resource, GraphAccess access, VkPipelineStageFlags stages) {
+		if (isAttachment(access)) {
+			SpConsole::FatalExit("Attachments are declared with writeColor, writeDepth and readDepth", SP_FAILURE);
+		}
+		mGraph->addAccess(mPass, resource, access, stages, true, false);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(GraphResource resource, GraphAccess access, VkPipelineStageFlags stages) {
+		if (isAttachment(access)) {
+			SpConsole::FatalExit("Attachments are declared with writeColor, writeDepth and readDepth", SP_FAILURE);
+		}
+		mGraph->addAccess(mPass, resource, access, stages, false, true);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::readWrite(GraphResource resource, GraphAccess access, VkPipelineStageFlags stages) {
+		if (isAttachment(access)) {
+			SpConsole::FatalExit("Attachments are declared with writeColor, writeDepth and readDepth", SP_FAILURE);
+		}
+		mGraph->addAccess(mPass, resource, access, stages, true, true);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffects() {
+		mGraph->mPasses[mPass].sideEffects = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::secondaryCommandBuffers() {
+		Pass& pass = mGraph->mPasses[mPass];
+		if (pass.type != SP_GRAPH_PASS_GRAPHICS) {
+			SpConsole::FatalExit(std::string("Pass ") + pass.name + " is not a graphics pass, only those record secondary command buffers", SP_FAILURE);
+		}
+		pass.secondaryCommandBuffers = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::execute(PassCallback callback) {
+		mGraph->mPasses[mPass].callback = std::move(callback);
+		return *this;
+	}
+#pragma endregion
+
+#pragma region PassContext
+	VkImage RenderGraph::PassContext::getImage(GraphResource resource) const {
+		return graph->mResources[resource].image;
+	}
+
+	VkImageView RenderGraph::PassContext::getImageView(GraphResource resource) const {
+		return graph->mResources[resource].imageView;
+	}
+
+	VkBuffer RenderGraph::PassContext::getBuffer(GraphResource resource) const {
+		return graph->mResources[resource].buffer;
+	}
+#pragma endregion
+
+	void RenderGraph::init(VkDevice device, MemoryAllocator& allocator, uint32 framesInFlight, RenderingBackend backend) {
+		mDevice = device;
+		mAllocator = &allocator;
+		mFramesInFlight = framesInFlight;
+		mBackend = backend;
+	}
+
+	void RenderGraph::destroy() {
+		retirePhysicalImages();
+		releaseRetired(true);
+
+		for (auto& [key, renderPass] : mRenderPasses) {
+			vkDestroyRenderPass(mDevice, renderPass, nullptr);
+		}
+		mRenderPasses.clear();
+
+		mResources.clear();
+		mPasses.clear();
+		mTransientLayoutHash = 0;
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Destroyed render graph");
+	}
+
+	void RenderGraph::beginFrame(uint64 frameNumber) {
+		mFrameNumber = frameNumber;
+
+		mResources.clear();
+		mPasses.clear();
+		mFinalBarriers = {};
+		mStats = {};
+
+		// Framebuffers no frame in flight has used
+		std::erase_if(mFramebuffers, [this](const auto& entry) {
+			if (mFrameNumber < entry.second.lastUsedFrame + mFramesInFlight) {
+				return false;
+			}
+			vkDestroyFramebuffer(mDevice, entry.second.framebuffer, nullptr);
+			return true;
+		});
+
+		releaseRetired(false);
+	}
+
+	GraphResource RenderGraph::importImage(const char* name,
+	                                       VkImage image,
+	                                       VkImageView imageView,
+	                                       const GraphImageDesc& desc,
+	                                       VkImageLayout initialLayout,
+	                                       VkPipelineStageFlags initialStage,
+	                                       VkImageLayout finalLayout) {
+		Resource resource{};
+		resource.name = name;
+		resource.kind = SP_GRAPH_RESOURCE_IMPORTED_IMAGE;
+		resource.desc = desc;
+		resource.image = image;
+		resource.imageView = imageView;
+		resource.finalLayout = finalLayout;
+		resource.output = true;
+
+		// The first barrier has to wait for whatever used the image before, for a swapchain image that is the
+		// acquire semaphore's wait stage
+		resource.state.layout = initialLayout;
+		resource.state.writeStages = initialStage;
+
+		mResources.push_back(resource);
+		return static_cast<GraphResource>(mResources.size() - 1);
+	}
+
+	GraphResource RenderGraph::importBuffer(const char* name, VkBuffer buffer, VkDeviceSize size) {
+		Resource resource{};
+		resource.name = name;
+		resource.kind = SP_GRAPH_RESOURCE_IMPORTED_BUFFER;
+		resource.buffer = buffer;
+		resource.bufferSize = size;
+		resource.output = true;
+
+		mResources.push_back(resource);
+		return static_cast<GraphResource>(mResources.size() - 1);
+	}
+
+	GraphResource RenderGraph::createImage(const char* name, const GraphImageDesc& desc) {
+		Resource resource{};
+		resource.name = name;
+		resource.kind = SP_GRAPH_RESOURCE_TRANSIENT_IMAGE;
+		resource.desc = desc;
+
+		mResources.push_back(resource);
+		return static_cast<GraphResource>(mResources.size() - 1);
+	}
+
+	RenderGraph::PassBuilder RenderGraph::addPass(const char* name, GraphPassType type) {
+		Pass pass{};
+		pass.name = name;
+		pass.type = type;
+
+		mPasses.push_back(std::move(pass));
+		return PassBuilder(this, static_cast<uint32>(mPasses.size() - 1));
+	}
+
+	void RenderGraph::markOutput(GraphResource resource) {
+		getResource(resource).output = true;
+	}
+
+	void RenderGraph::compile() {
+		cullPasses();
+		computeLifetimes();
+		allocateTransients();
+		buildRenderPasses();
+		computeBarriers();
+
+		SP_LOG(SP_MESSAGE_VERBOSE, "Render graph: " + std::to_string(mStats.passCount) + " passes, " +
+		                           std::to_string(mStats.culledPassCount) + " culled, " +
+		                           std::to_string(mStats.barrierBatchCount) + " barrier batches");
+	}
+
+	void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+		std::array<VkClearValue, MaxGraphColorAttachments + 1> clearValues{};
+		std::array<VkFormat, MaxGraphColorAttachments> inheritanceColorFormats{};
+		VkCommandBufferInheritanceRenderingInfo inheritanceRenderingInfo{};
+		VkCommandBufferInheritanceInfo inheritance{};
+
+		for (const Pass& pass : mPasses) {
+			if (pass.culled) {
+				continue;
+			}
+
+			GpuZone zone = mGpuProfiler != nullptr ? mGpuProfiler->beginZone(commandBuffer, pass.name) : InvalidGpuZone;
+			recordBarriers(commandBuffer, pass.barriers);
+
+			PassContext context{this, pass.renderPass, pass.extent, nullptr};
+			if (pass.secondaryCommandBuffers) {
+				inheritanceInfo(pass, inheritanceColorFormats, inheritanceRenderingInfo, inheritance);
+				context.inheritance = &inheritance;
+			}
+
+			if (pass.type == SP_GRAPH_PASS_GRAPHICS && mBackend == SP_RENDERING_BACKEND_DYNAMIC) {
+				beginRendering(commandBuffer, pass);
+			}else if (pass.type == SP_GRAPH_PASS_GRAPHICS) {
+				uint32 clearValueCount = 0;
+				for (const Attachment& attachment : pass.colorAttachments) {
+					clearValues[clearValueCount++] = attachment.clearValue;
+				}
+				if (pass.depthAttachment.resource != InvalidGraphResource) {
+					clearValues[clearValueCount++] = pass.depthAttachment.clearValue;
+				}
+
+				VkRenderPassBeginInfo renderPassBeginInfo{};
+				renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassBeginInfo.renderPass = pass.renderPass;
+				renderPassBeginInfo.framebuffer = pass.framebuffer;
+				renderPassBeginInfo.renderArea.offset = {0, 0};
+				renderPassBeginInfo.renderArea.extent = pass.extent;
+				renderPassBeginInfo.clearValueCount = clearValueCount;
+				renderPassBeginInfo.pClearValues = clearValues.data();
+
+				vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, pass.secondaryCommandBuffers
+					                                                          ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+					                                                          : VK_SUBPASS_CONTENTS_INLINE);
+			}
+
+			if (pass.callback) {
+				pass.callback(commandBuffer, context);
+			}
+
+			if (pass.type == SP_GRAPH_PASS_GRAPHICS && mBackend == SP_RENDERING_BACKEND_DYNAMIC) {
+				vkCmdEndRendering(commandBuffer);
+			}else if (pass.type == SP_GRAPH_PASS_GRAPHICS) {
+				vkCmdEndRenderPass(commandBuffer);
+			}
+
+			if (mGpuProfiler != nullptr) {
+				mGpuProfiler->endZone(commandBuffer, zone);
+			}
+		}
+
+		recordBarriers(commandBuffer, mFinalBarriers);
+	}
+
+	VkRenderPass RenderGraph::compatibleRenderPass(std::span<const VkFormat> colorFormats, VkFormat depthFormat) {
+		if (mBackend == SP_RENDERING_BACKEND_DYNAMIC) {
+			return VK_NULL_HANDLE;
+		}
+
+		// Compatibility only looks at formats and sample counts, the ops and layouts are whatever a pass would use
+		std::vector<AttachmentKey> colorAttachments;
+		for (VkFormat format : colorFormats) {
+			colorAttachments.push_back({format, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR,
+			                            VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+		}
+
+		AttachmentKey depthAttachment{depthFormat, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR,
+		                              VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+		return findRenderPass(colorAttachments, depthFormat != VK_FORMAT_UNDEFINED ? &depthAttachment : nullptr);
+	}
+
+	void RenderGraph::retireFramebuffers() {
+		RetiredObjects retired{};
+		retired.retireFrame = mFrameNumber;
+		for (auto& [key, cached] : mFramebuffers) {
+			retired.framebuffers.push_back(cached.framebuffer);
+		}
+		mFramebuffers.clear();
+
+		mRetired.push_back(std::move(retired));
+	}
+
+#pragma region Compile
+	void RenderGraph::cullPasses() {
+		// Walk back from the outputs, a pass survives if it writes something a later survivor or the outside world reads
+		std::vector<bool> needed(mResources.size(), false);
+		for (size_t i = 0; i < mResources.size(); i++) {
+			needed[i] = mResources[i].output;
+		}
+
+		mStats.passCount = static_cast<uint32>(mPasses.size());
+
+		for (size_t i = mPasses.size(); i-- > 0;) {
+			Pass& pass = mPasses[i];
+
+			bool keep = pass.sideEffects;
+			for (const ResourceAccess& access : pass.accesses) {
+				keep |= access.write && needed[access.resource];
+			}
+
+			if (!keep) {
+				pass.culled = true;
+				mStats.culledPassCount++;
+				SP_LOG(SP_MESSAGE_VERBOSE, std::string("Culled render graph pass ") + pass.name);
+				continue;
+			}
+
+			// Only attachments that are not loaded overwrite everything, any other write may be partial
+			for (const ResourceAccess& access : pass.accesses) {
+				if (access.write && !access.read && isAttachment(access.access)) {
+					needed[access.resource] = false;
+				}
+			}
+			for (const ResourceAccess& access : pass.accesses) {
+				if (access.read) {
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::computeLifetimes() {
+		for (uint32 i = 0; i < mPasses.size(); i++) {
+			if (mPasses[i].culled) {
+				continue;
+			}
+
+			for (const ResourceAccess& access : mPasses[i].accesses) {
+				Resource& resource = mResources[access.resource];
+				resource.firstPass = std::min(resource.firstPass, i);
+				resource.lastPass = std::max(resource.lastPass, i);
+			}
+		}
+	}
+
+	void RenderGraph::allocateTransients() {
+		std::vector<GraphResource> transients;
+		uint64 layoutHash = Utils::HashSeed;
+
+		for (GraphResource i = 0; i < mResources.size(); i++) {
+			const Resource& resource = mResources[i];
+			if (resource.kind != SP_GRAPH_RESOURCE_TRANSIENT_IMAGE || resource.firstPass == UnusedPass) {
+				continue;
+			}
+
+			transients.push_back(i);
+			layoutHash = Utils::hashCombine(layoutHash, Utils::hash64(&resource.desc, sizeof(resource.desc)));
+			layoutHash = Utils::hashCombine(layoutHash, resource.usage);
+			layoutHash = Utils::hashCombine(layoutHash, (static_cast<uint64>(resource.firstPass) << 32) | resource.lastPass);
+		}
+
+		// Most frames declare the same transients as the last one, the images and their placement carry over
+		if (layoutHash != mTransientLayoutHash || mPhysicalImages.size() != transients.size()) {
+			retirePhysicalImages();
+			mTransientLayoutHash = layoutHash;
+
+			for (GraphResource index : transients) {
+				const Resource& resource = mResources[index];
+
+				VkImageCreateInfo imageCreateInfo{};
+				imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageCreateInfo.extent.width = resource.desc.extent.width;
+				imageCreateInfo.extent.height = resource.desc.extent.height;
+				imageCreateInfo.extent.depth = 1;
+				imageCreateInfo.mipLevels = 1;
+				imageCreateInfo.arrayLayers = 1;
+				imageCreateInfo.format = resource.desc.format;
+				imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				imageCreateInfo.usage = resource.usage;
+				imageCreateInfo.samples = resource.desc.samples;
+				imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				PhysicalImage physicalImage{};
+				physicalImage.desc = resource.desc;
+				physicalImage.usage = resource.usage;
+
+				VkResult result = vkCreateImage(mDevice, &imageCreateInfo, nullptr, &physicalImage.image);
+				SpConsole::VulkanExitCheck(result, "Failed to create render graph image!", SP_FAILURE);
+
+				vkGetImageMemoryRequirements(mDevice, physicalImage.image, &physicalImage.requirements);
+				mPhysicalImages.push_back(physicalImage);
+			}
+
+			// Largest first, each image goes into the first slot nothing overlapping its lifetime lives in
+			std::vector<uint32> order(transients.size());
+			for (uint32 i = 0; i < order.size(); i++) {
+				order[i] = i;
+			}
+			std::stable_sort(order.begin(), order.end(), [this](uint32 a, uint32 b) {
+				return mPhysicalImages[a].requirements.size > mPhysicalImages[b].requirements.size;
+			});
+
+			std::vector<std::vector<uint32>> slotImages;
+			for (uint32 imageIndex : order) {
+				PhysicalImage& image = mPhysicalImages[imageIndex];
+				const Resource& resource = mResources[transients[imageIndex]];
+
+				uint32 slotIndex = 0;
+				for (; slotIndex < mMemorySlots.size(); slotIndex++) {
+					if ((mMemorySlots[slotIndex].requirements.memoryTypeBits & image.requirements.memoryTypeBits) == 0) {
+						continue;
+					}
+
+					bool overlaps = false;
+					for (uint32 other : slotImages[slotIndex]) {
+						const Resource& otherResource = mResources[transients[other]];
+						overlaps |= resource.firstPass <= otherResource.lastPass && otherResource.firstPass <= resource.lastPass;
+					}
+					if (!overlaps) {
+						break;
+					}
+				}
+
+				if (slotIndex == mMemorySlots.size()) {
+					MemorySlot slot{};
+					slot.requirements.memoryTypeBits = ~0u;
+					mMemorySlots.push_back(slot);
+					slotImages.emplace_back();
+				}
+
+				VkMemoryRequirements& slotRequirements = mMemorySlots[slotIndex].requirements;
+				slotRequirements.size = std::max(slotRequirements.size, image.requirements.size);
+				slotRequirements.alignment = std::max(slotRequirements.alignment, image.requirements.alignment);
+				slotRequirements.memoryTypeBits &= image.requirements.memoryTypeBits;
+
+				image.memorySlot = slotIndex;
+				slotImages[slotIndex].push_back(imageIndex);
+			}
+
+			AllocationCreateInfo allocationInfo{};
+			allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+			for (MemorySlot& slot : mMemorySlots) {
+				slot.allocation = mAllocator->allocateImageMemory(slot.requirements, allocationInfo);
+			}
+
+			for (PhysicalImage& image : mPhysicalImages) {
+				const Allocation& allocation = mMemorySlots[image.memorySlot].allocation;
+				VkResult result = vkBindImageMemory(mDevice, image.image, allocation.memory, allocation.offset);
+				SpConsole::VulkanExitCheck(result, "Failed to bind render graph image memory!", SP_FAILURE);
+
+				VkImageViewCreateInfo viewCreateInfo{};
+				viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewCreateInfo.image = image.image;
+				viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewCreateInfo.format = image.desc.format;
+				viewCreateInfo.subresourceRange.aspectMask = aspectMask(image.desc.format);
+				viewCreateInfo.subresourceRange.baseMipLevel = 0;
+				viewCreateInfo.subresourceRange.levelCount = 1;
+				viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+				viewCreateInfo.subresourceRange.layerCount = 1;
+
+				result = vkCreateImageView(mDevice, &viewCreateInfo, nullptr, &image.imageView);
+				SpConsole::VulkanExitCheck(result, "Failed to create render graph image view!", SP_FAILURE);
+			}
+
+			SpConsole::Write(SP_MESSAGE_INFO, "Render graph placed " + std::to_string(mPhysicalImages.size()) +
+			                                  " transient images in " + std::to_string(mMemorySlots.size()) + " memory slots");
+		}
+
+		for (uint32 i = 0; i < transients.size(); i++) {
+			Resource& resource = mResources[transients[i]];
+			resource.physicalImage = i;
+			resource.image = mPhysicalImages[i].image;
+			resource.imageView = mPhysicalImages[i].imageView;
+
+			mStats.transientBytes += mPhysicalImages[i].requirements.size;
+		}
+		for (const MemorySlot& slot : mMemorySlots) {
+			mStats.aliasedBytes += slot.requirements.size;
+		}
+		mStats.transientImageCount = static_cast<uint32>(transients.size());
+		mStats.memorySlotCount = static_cast<uint32>(mMemorySlots.size());
+	}
+
+	void RenderGraph::buildRenderPasses() {
+		for (uint32 i = 0; i < mPasses.size(); i++) {
+			Pass& pass = mPasses[i];
+			if (pass.culled || pass.type != SP_GRAPH_PASS_GRAPHICS) {
+				continue;
+			}
+
+			if (pass.colorAttachments.empty() && pass.depthAttachment.resource == InvalidGraphResource) {
+				SpConsole::FatalExit(std::string("Graphics pass ") + pass.name + " has no attachments", SP_FAILURE);
+			}
+
+			// Contents only need to reach memory when a later pass or the outside world looks at them
+			auto finishAttachment = [&](Attachment& attachment) {
+				const Resource& resource = mResources[attachment.resource];
+				bool readLater = resource.output || resource.lastPass > i;
+				attachment.storeOp = readLater ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+				if (pass.extent.width == 0) {
+					pass.extent = resource.desc.extent;
+				}else if (pass.extent.width != resource.desc.extent.width || pass.extent.height != resource.desc.extent.height) {
+					SpConsole::FatalExit(std::string("Attachments of pass ") + pass.name + " differ in size", SP_FAILURE);
+				}
+			};
+
+			std::array<AttachmentKey, MaxGraphColorAttachments> colorKeys{};
+			for (uint32 c = 0; c < pass.colorAttachments.size(); c++) {
+				Attachment& attachment = pass.colorAttachments[c];
+				finishAttachment(attachment);
+
+				const GraphImageDesc& desc = mResources[attachment.resource].desc;
+				colorKeys[c] = {desc.format, desc.samples, attachment.loadOp, attachment.storeOp,
+				                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+			}
+
+			AttachmentKey depthKey{};
+			bool hasDepth = pass.depthAttachment.resource != InvalidGraphResource;
+			if (hasDepth) {
+				Attachment& attachment = pass.depthAttachment;
+				finishAttachment(attachment);
+
+				const GraphImageDesc& desc = mResources[attachment.resource].desc;
+				depthKey = {desc.format, desc.samples, attachment.loadOp, attachment.storeOp,
+				            attachment.readOnly
+					            ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+					            : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+			}
+
+			// Dynamic rendering takes the attachments straight from the pass when it is recorded
+			if (mBackend == SP_RENDERING_BACKEND_DYNAMIC) {
+				continue;
+			}
+
+			pass.renderPass = findRenderPass(std::span(colorKeys.data(), pass.colorAttachments.size()),
+			                                 hasDepth ? &depthKey : nullptr);
+			pass.framebuffer = findFramebuffer(pass);
+		}
+	}
+
+	void RenderGraph::computeBarriers() {
+		for (uint32 i = 0; i < mPasses.size(); i++) {
+			Pass& pass = mPasses[i];
+			if (pass.culled) {
+				continue;
+			}
+
+			for (const ResourceAccess& access : pass.accesses) {
+				Resource& resource = mResources[access.resource];
+
+				// A transient image takes over its memory from whatever used the slot last, possibly last frame
+				if (resource.kind == SP_GRAPH_RESOURCE_TRANSIENT_IMAGE && resource.firstPass == i &&
+				    resource.state.layout == VK_IMAGE_LAYOUT_UNDEFINED && resource.state.writeStages == 0) {
+					const MemorySlot& slot = mMemorySlots[mPhysicalImages[resource.physicalImage].memorySlot];
+					resource.state.writeStages = slot.lastStages;
+					resource.state.writeAccess = slot.lastWriteAccess;
+				}
+
+				VkImageLayout layout;
+				VkPipelineStageFlags stages;
+				VkAccessFlags accessMask;
+				accessInfo(access, pass.type, layout, stages, accessMask);
+
+				// Attachments that are cleared or not loaded overwrite everything, the old contents can be dropped
+				bool discard = access.write && !access.read && isAttachment(access.access);
+				transition(access.resource, layout, stages, accessMask, access.write, discard, pass.barriers);
+			}
+
+			for (const ResourceAccess& access : pass.accesses) {
+				Resource& resource = mResources[access.resource];
+				if (resource.kind == SP_GRAPH_RESOURCE_TRANSIENT_IMAGE && resource.lastPass == i) {
+					MemorySlot& slot = mMemorySlots[mPhysicalImages[resource.physicalImage].memorySlot];
+					slot.lastStages = resource.state.writeStages | resource.state.readStages;
+					slot.lastWriteAccess = resource.state.writeAccess;
+				}
+			}
+
+			if (!pass.barriers.barriers.empty()) {
+				mStats.barrierBatchCount++;
+			}
+		}
+
+		for (GraphResource i = 0; i < mResources.size(); i++) {
+			Resource& resource = mResources[i];
+			if (resource.kind != SP_GRAPH_RESOURCE_IMPORTED_IMAGE || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+			    resource.state.layout == resource.finalLayout) {
+				continue;
+			}
+
+			transition(i, resource.finalLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, false, false, mFinalBarriers);
+		}
+		if (!mFinalBarriers.barriers.empty()) {
+			mStats.barrierBatchCount++;
+		}
+	}
+
+	void RenderGraph::transition(GraphResource resourceIndex,
+	                             VkImageLayout layout,
+	                             VkPipelineStageFlags stages,
+	                             VkAccessFlags access,
+	                             bool write,
+	                             bool discard,
+	                             BarrierBatch& batch) {
+		Resource& resource = mResources[resourceIndex];
+		ResourceState& state = resource.state;
+
+		bool isImage = resource.kind != SP_GRAPH_RESOURCE_IMPORTED_BUFFER;
+		bool layoutChange = isImage && state.layout != layout;
+
+		if (write || layoutChange) {
+			// Writes and layout transitions wait for every earlier access, not just the last write
+			VkPipelineStageFlags srcStages = state.writeStages | state.readStages;
+
+			if (layoutChange || srcStages != 0) {
+				batch.barriers.push_back({resourceIndex,
+				                          discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout,
+				                          isImage ? layout : VK_IMAGE_LAYOUT_UNDEFINED,
+				                          srcStages,
+				                          stages,
+				                          state.writeAccess,
+				                          access});
+				batch.srcStages |= srcStages;
+				batch.dstStages |= stages;
+
+				if (isImage) {
+					mStats.imageBarrierCount++;
+				}else {
+					mStats.bufferBarrierCount++;
+				}
+			}
+
+			// A layout transition counts as a write the access has already waited for
+			state.layout = isImage ? layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			state.writeStages = stages;
+			state.writeAccess = write ? access & WriteAccessMask : 0;
+			state.readStages = write ? 0 : stages;
+			state.visibleStages = stages;
+			state.visibleAccess = access;
+			return;
+		}
+
+		// Reads in the same layout only need the last write made visible, once per stage and access
+		bool visible = (state.visibleStages & stages) == stages && (state.visibleAccess & access) == access;
+		if (state.writeAccess != 0 && !visible) {
+			batch.barriers.push_back({resourceIndex, state.layout, state.layout, state.writeStages, stages, state.writeAccess, access});
+			batch.srcStages |= state.writeStages;
+			batch.dstStages |= stages;
+
+			state.visibleStages |= stages;
+			state.visibleAccess |= access;
+
+			if (isImage) {
+				mStats.imageBarrierCount++;
+			}else {
+				mStats.bufferBarrierCount++;
+			}
+		}
+
+		state.readStages |= stages;
+	}
+
+	void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch) {
+		if (batch.barriers.empty()) {
+			return;
+		}
+
+		if (mBackend == SP_RENDERING_BACKEND_DYNAMIC) {
+			recordBarriers2(commandBuffer, batch);
+			return;
+		}
+
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+		for (const Barrier& barrier : batch.barriers) {
+			const Resource& resource = mResources[barrier.resource];
+
+			if (resource.kind == SP_GRAPH_RESOURCE_IMPORTED_BUFFER) {
+				VkBufferMemoryBarrier bufferBarrier{};
+				bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				bufferBarrier.srcAccessMask = barrier.srcAccess;
+				bufferBarrier.dstAccessMask = barrier.dstAccess;
+				bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.buffer = resource.buffer;
+				bufferBarrier.offset = 0;
+				bufferBarrier.size = VK_WHOLE_SIZE;
+				bufferBarriers.push_back(bufferBarrier);
+				continue;
+			}
+
+			VkImageMemoryBarrier imageBarrier{};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = barrier.srcAccess;
+			imageBarrier.dstAccessMask = barrier.dstAccess;
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.image;
+			imageBarrier.subresourceRange.aspectMask = aspectMask(resource.desc.format);
+			imageBarrier.subresourceRange.baseMipLevel = 0;
+			imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			imageBarriers.push_back(imageBarrier);
+		}
+
+		// Zero stage masks are not allowed without synchronization2, nothing to wait for means the top of the pipe
+		VkPipelineStageFlags srcStages = batch.srcStages != 0 ? batch.srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		VkPipelineStageFlags dstStages = batch.dstStages != 0 ? batch.dstStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0,
+		                     0, nullptr,
+		                     static_cast<uint32>(bufferBarriers.size()), bufferBarriers.data(),
+		                     static_cast<uint32>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	void RenderGraph::recordBarriers2(VkCommandBuffer commandBuffer, const BarrierBatch& batch) {
+		std::vector<VkImageMemoryBarrier2> imageBarriers;
+		std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+
+		// The legacy stage and access bits have the same values in the 64 bit flags. Every barrier keeps its own
+		// stages here, so one resource's transition does not make the others in the pass wait longer.
+		for (const Barrier& barrier : batch.barriers) {
+			const Resource& resource = mResources[barrier.resource];
+
+			if (resource.kind == SP_GRAPH_RESOURCE_IMPORTED_BUFFER) {
+				VkBufferMemoryBarrier2 bufferBarrier{};
+				bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+				bufferBarrier.srcStageMask = barrier.srcStages;
+				bufferBarrier.srcAccessMask = barrier.srcAccess;
+				bufferBarrier.dstStageMask = barrier.dstStages;
+				bufferBarrier.dstAccessMask = barrier.dstAccess;
+				bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.buffer = resource.buffer;
+				bufferBarrier.offset = 0;
+				bufferBarrier.size = VK_WHOLE_SIZE;
+				bufferBarriers.push_back(bufferBarrier);
+				continue;
+			}
+
+			VkImageMemoryBarrier2 imageBarrier{};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			imageBarrier.srcStageMask = barrier.srcStages;
+			imageBarrier.srcAccessMask = barrier.srcAccess;
+			imageBarrier.dstStageMask = barrier.dstStages;
+			imageBarrier.dstAccessMask = barrier.dstAccess;
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.image;
+			imageBarrier.subresourceRange.aspectMask = aspectMask(resource.desc.format);
+			imageBarrier.subresourceRange.baseMipLevel = 0;
+			imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			imageBarriers.push_back(imageBarrier);
+		}
+
+		VkDependencyInfo dependencyInfo{};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32>(bufferBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32>(imageBarriers.size());
+		dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+
+		vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+	}
+
+	void RenderGraph::beginRendering(VkCommandBuffer commandBuffer, const Pass& pass) {
+		std::array<VkRenderingAttachmentInfo, MaxGraphColorAttachments> colorAttachments{};
+		for (uint32 i = 0; i < pass.colorAttachments.size(); i++) {
+			const Attachment& attachment = pass.colorAttachments[i];
+
+			colorAttachments[i].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			colorAttachments[i].imageView = mResources[attachment.resource].imageView;
+			colorAttachments[i].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			colorAttachments[i].resolveMode = VK_RESOLVE_MODE_NONE;
+			colorAttachments[i].loadOp = attachment.loadOp;
+			colorAttachments[i].storeOp = attachment.storeOp;
+			colorAttachments[i].clearValue = attachment.clearValue;
+		}
+
+		VkRenderingInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+		if (pass.secondaryCommandBuffers) {
+			renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+		}
+		renderingInfo.renderArea.offset = {0, 0};
+		renderingInfo.renderArea.extent = pass.extent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = static_cast<uint32>(pass.colorAttachments.size());
+		renderingInfo.pColorAttachments = colorAttachments.data();
+
+		VkRenderingAttachmentInfo depthAttachment{};
+		if (pass.depthAttachment.resource != InvalidGraphResource) {
+			const Resource& resource = mResources[pass.depthAttachment.resource];
+
+			depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			depthAttachment.imageView = resource.imageView;
+			depthAttachment.imageLayout = pass.depthAttachment.readOnly
+				                              ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+				                              : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			depthAttachment.resolveMode = VK_RESOLVE_MODE_NONE;
+			depthAttachment.loadOp = pass.depthAttachment.loadOp;
+			depthAttachment.storeOp = pass.depthAttachment.storeOp;
+			depthAttachment.clearValue = pass.depthAttachment.clearValue;
+
+			renderingInfo.pDepthAttachment = &depthAttachment;
+			// Combined formats have to be bound as both, same view and layout
+			if (aspectMask(resource.desc.format) & VK_IMAGE_ASPECT_STENCIL_BIT) {
+				renderingInfo.pStencilAttachment = &depthAttachment;
+			}
+		}
+
+		vkCmdBeginRendering(commandBuffer, &renderingInfo);
+	}
+
+	void RenderGraph::inheritanceInfo(const Pass& pass,
+	                                  std::array<VkFormat, MaxGraphColorAttachments>& colorFormats,
+	                                  VkCommandBufferInheritanceRenderingInfo& renderingInfo,
+	                                  VkCommandBufferInheritanceInfo& inheritance) const {
+		inheritance = {};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+		if (mBackend == SP_RENDERING_BACKEND_RENDER_PASS) {
+			inheritance.renderPass = pass.renderPass;
+			inheritance.subpass = 0;
+			inheritance.framebuffer = pass.framebuffer;
+			return;
+		}
+
+		// Without a render pass the secondary command buffers are told the attachment formats instead
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+		for (uint32 i = 0; i < pass.colorAttachments.size(); i++) {
+			const Resource& resource = mResources[pass.colorAttachments[i].resource];
+			colorFormats[i] = resource.desc.format;
+			samples = resource.desc.samples;
+		}
+
+		renderingInfo = {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		renderingInfo.colorAttachmentCount = static_cast<uint32>(pass.colorAttachments.size());
+		renderingInfo.pColorAttachmentFormats = colorFormats.data();
+		renderingInfo.depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+		if (pass.depthAttachment.resource != InvalidGraphResource) {
+			const Resource& resource = mResources[pass.depthAttachment.resource];
+			renderingInfo.depthAttachmentFormat = resource.desc.format;
+			if (aspectMask(resource.desc.format) & VK_IMAGE_ASPECT_STENCIL_BIT) {
+				renderingInfo.stencilAttachmentFormat = resource.desc.format;
+			}
+			samples = resource.desc.samples;
+		}
+		renderingInfo.rasterizationSamples = samples;
+
+		inheritance.pNext = &renderingInfo;
+	}
+#pragma endregion
+
+#pragma region Caches
+	VkRenderPass RenderGraph::findRenderPass(std::span<const AttachmentKey> colorAttachments, const AttachmentKey* depthAttachment) {
+		uint64 key = Utils::hash64(colorAttachments.data(), colorAttachments.size_bytes());
+		if (depthAttachment != nullptr) {
+			key = Utils::hash64(depthAttachment, sizeof(AttachmentKey), key);
+		}
+
+		std::lock_guard lock(mRenderPassMutex);
+		auto found = mRenderPasses.find(key);
+		if (found != mRenderPasses.end()) {
+			return found->second;
+		}
+
+		// Layouts never change inside the render pass, the graph's barriers do every transition
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorReferences;
+
+		auto describe = [&](const AttachmentKey& attachmentKey) {
+			VkAttachmentDescription description{};
+			description.format = attachmentKey.format;
+			description.samples = attachmentKey.samples;
+			description.loadOp = attachmentKey.loadOp;
+			description.storeOp = attachmentKey.storeOp;
+			description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.initialLayout = attachmentKey.layout;
+			description.finalLayout = attachmentKey.layout;
+			attachments.push_back(description);
+
+			return VkAttachmentReference{static_cast<uint32>(attachments.size() - 1), attachmentKey.layout};
+		};
+
+		for (const AttachmentKey& attachmentKey : colorAttachments) {
+			colorReferences.push_back(describe(attachmentKey));
+		}
+
+		VkAttachmentReference depthReference{};
+		if (depthAttachment != nullptr) {
+			depthReference = describe(*depthAttachment);
+		}
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32>(colorReferences.size());
+		subpass.pColorAttachments = colorReferences.data();
+		subpass.pDepthStencilAttachment = depthAttachment != nullptr ? &depthReference : nullptr;
+
+		VkRenderPassCreateInfo renderPassCreateInfo{};
+		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassCreateInfo.attachmentCount = static_cast<uint32>(attachments.size());
+		renderPassCreateInfo.pAttachments = attachments.data();
+		renderPassCreateInfo.subpassCount = 1;
+		renderPassCreateInfo.pSubpasses = &subpass;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkResult result = vkCreateRenderPass(mDevice, &renderPassCreateInfo, nullptr, &renderPass);
+		SpConsole::VulkanExitCheck(result, "Failed to create render graph render pass!", SP_FAILURE);
+
+		SP_LOG(SP_MESSAGE_VERBOSE, "Created render graph render pass with " + std::to_string(attachments.size()) + " attachments");
+
+		mRenderPasses.emplace(key, renderPass);
+		return renderPass;
+	}
+
+	VkFramebuffer RenderGraph::findFramebuffer(const Pass& pass) {
+		std::array<VkImageView, MaxGraphColorAttachments + 1> views{};
+		uint32 viewCount = 0;
+		for (const Attachment& attachment : pass.colorAttachments) {
+			views[viewCount++] = mResources[attachment.resource].imageView;
+		}
+		if (pass.depthAttachment.resource != InvalidGraphResource) {
+			views[viewCount++] = mResources[pass.depthAttachment.resource].imageView;
+		}
+
+		uint64 key = Utils::hash64(views.data(), viewCount * sizeof(VkImageView));
+		key = Utils::hash64(&pass.renderPass, sizeof(pass.renderPass), key);
+		key = Utils::hash64(&pass.extent, sizeof(pass.extent), key);
+
+		auto found = mFramebuffers.find(key);
+		if (found != mFramebuffers.end()) {
+			found->second.lastUsedFrame = mFrameNumber;
+			return found->second.framebuffer;
+		}
+
+		VkFramebufferCreateInfo framebufferCreateInfo{};
+		framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferCreateInfo.renderPass = pass.renderPass;
+		framebufferCreateInfo.attachmentCount = viewCount;
+		framebufferCreateInfo.pAttachments = views.data();
+		framebufferCreateInfo.width = pass.extent.width;
+		framebufferCreateInfo.height = pass.extent.height;
+		framebufferCreateInfo.layers = 1;
+
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkResult result = vkCreateFramebuffer(mDevice, &framebufferCreateInfo, nullptr, &framebuffer);
+		SpConsole::VulkanExitCheck(result, "Failed to create render graph framebuffer!", SP_FAILURE);
+
+		SP_LOG(SP_MESSAGE_VERBOSE, std::string("Created framebuffer for pass ") + pass.name);
+
+		mFramebuffers.emplace(key, CachedFramebuffer{framebuffer, mFrameNumber});
+		return framebuffer;
+	}
+
+	void RenderGraph::retirePhysicalImages() {
+		if (mPhysicalImages.empty() && mMemorySlots.empty()) {
+			return;
+		}
+
+		// Framebuffers hold on to the views, a new view may even reuse a destroyed one's handle
+		retireFramebuffers();
+
+		RetiredObjects retired{};
+		retired.retireFrame = mFrameNumber;
+		retired.images = std::move(mPhysicalImages);
+		retired.memorySlots = std::move(mMemorySlots);
+		mRetired.push_back(std::move(retired));
+
+		mPhysicalImages.clear();
+		mMemorySlots.clear();
+		mTransientLayoutHash = 0;
+	}
+
+	void RenderGraph::releaseRetired(bool force) {
+		std::erase_if(mRetired, [this, force](RetiredObjects& retired) {
+			if (!force && mFrameNumber < retired.retireFrame + mFramesInFlight) {
+				return false;
+			}
+
+			for (VkFramebuffer framebuffer : retired.framebuffers) {
+				vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+			}
+			for (PhysicalImage& image : retired.images) {
+				vkDestroyImageView(mDevice, image.imageView, nullptr);
+				vkDestroyImage(mDevice, image.image, nullptr);
+			}
+			for (MemorySlot& slot : retired.memorySlots) {
+				mAllocator->free(slot.allocation);
+			}
+			return true;
+		});
+	}
+#pragma endregion
+
+	RenderGraph::Resource& RenderGraph::getResource(GraphResource resource) {
+		if (resource >= mResources.size()) {
+			SpConsole::FatalExit("Unknown render graph resource " + std::to_string(resource), SP_FAILURE);
+		}
+		return mResources[resource];
+	}
+
+	RenderGraph::Pass& RenderGraph::addAccess(uint32 passIndex,
+	                                          GraphResource resourceIndex,
+	                                          GraphAccess access,
+	                                          VkPipelineStageFlags stages,
+	                                          bool read,
+	                                          bool write) {
+		Resource& resource = getResource(resourceIndex);
+		Pass& pass = mPasses[passIndex];
+
+		bool bufferAccess = access == SP_GRAPH_ACCESS_INDIRECT || access == SP_GRAPH_ACCESS_VERTEX_INPUT;
+		if (bufferAccess && resource.kind != SP_GRAPH_RESOURCE_IMPORTED_BUFFER) {
+			SpConsole::FatalExit(std::string(resource.name) + " is not a buffer, in pass " + pass.name, SP_FAILURE);
+		}
+		if (isAttachment(access) && resource.kind == SP_GRAPH_RESOURCE_IMPORTED_BUFFER) {
+			SpConsole::FatalExit(std::string(resource.name) + " is a buffer, in pass " + pass.name, SP_FAILURE);
+		}
+
+		resource.usage |= accessUsage(access);
+		pass.accesses.push_back({resourceIndex, access, stages, write, read});
+		return pass;
+	}
+
+	void RenderGraph::accessInfo(const ResourceAccess& access,
+	                             GraphPassType type,
+	                             VkImageLayout& layout,
+	                             VkPipelineStageFlags& stages,
+	                             VkAccessFlags& accessMask) {
+		VkPipelineStageFlags shaderStages = type == SP_GRAPH_PASS_COMPUTE
+			                                    ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+			                                    : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		switch (access.access) {
+			case SP_GRAPH_ACCESS_COLOR_ATTACHMENT:
+				layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				accessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (access.read ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0);
+				break;
+			case SP_GRAPH_ACCESS_DEPTH_ATTACHMENT:
+				// Depth testing reads even when the attachment is cleared
+				layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				accessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+				break;
+			case SP_GRAPH_ACCESS_DEPTH_READ:
+				layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+				stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				accessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+				break;
+			case SP_GRAPH_ACCESS_SAMPLED:
+				layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				stages = shaderStages;
+				accessMask = VK_ACCESS_SHADER_READ_BIT;
+				break;
+			case SP_GRAPH_ACCESS_STORAGE_READ:
+				layout = VK_IMAGE_LAYOUT_GENERAL;
+				stages = shaderStages;
+				accessMask = VK_ACCESS_SHADER_READ_BIT;
+				break;
+			case SP_GRAPH_ACCESS_STORAGE_WRITE:
+				layout = VK_IMAGE_LAYOUT_GENERAL;
+				stages = shaderStages;
+				accessMask = VK_ACCESS_SHADER_WRITE_BIT | (access.read ? VK_ACCESS_SHADER_READ_BIT : 0);
+				break;
+			case SP_GRAPH_ACCESS_TRANSFER_SRC:
+				layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				accessMask = VK_ACCESS_TRANSFER_READ_BIT;
+				break;
+			case SP_GRAPH_ACCESS_TRANSFER_DST:
+				layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				accessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				break;
+			case SP_GRAPH_ACCESS_INDIRECT:
+				layout = VK_IMAGE_LAYOUT_UNDEFINED;
+				stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+				accessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+				break;
+			case SP_GRAPH_ACCESS_VERTEX_INPUT:
+				layout = VK_IMAGE_LAYOUT_UNDEFINED;
+				stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+				accessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+				break;
+		}
+
+		if (access.stages != 0) {
+			stages = access.stages;
+		}
+	}
+
+	VkImageUsageFlags RenderGraph::accessUsage(GraphAccess access) {
+		switch (access) {
+			case SP_GRAPH_ACCESS_COLOR_ATTACHMENT:
+				return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			case SP_GRAPH_ACCESS_DEPTH_ATTACHMENT:
+			case SP_GRAPH_ACCESS_DEPTH_READ:
+				return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			case SP_GRAPH_ACCESS_SAMPLED:
+				return VK_IMAGE_USAGE_SAMPLED_BIT;
+			case SP_GRAPH_ACCESS_STORAGE_READ:
+			case SP_GRAPH_ACCESS_STORAGE_WRITE:
+				return VK_IMAGE_USAGE_STORAGE_BIT;
+			case SP_GRAPH_ACCESS_TRANSFER_SRC:
+				return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			case SP_GRAPH_ACCESS_TRANSFER_DST:
+				return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			case SP_GRAPH_ACCESS_INDIRECT:
+			case SP_GRAPH_ACCESS_VERTEX_INPUT:
+				return 0;
+		}
+		return 0;
+	}
+
+	VkImageAspectFlags RenderGraph::aspectMask(VkFormat format) {
+		switch (format) {
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_D32_SFLOAT:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			default:
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+} // SpRenderer
@@ -0,0 +1,243 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace SpRenderer {
+	namespace {
+		thread_local uint32 tThreadIndex = InvalidJobThread;
+	}
+
+	void JobSystem::init(uint32 threadCount) {
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		mStopping = false;
+		mQueues.clear();
+		for (uint32 i = 0; i < threadCount; i++) {
+			mQueues.push_back(std::make_unique<WorkQueue>());
+		}
+
+		tThreadIndex = MainJobThread;
+		Profiler::get().setThreadName("Main");
+		mWorkers.reserve(threadCount - 1);
+		for (uint32 i = 1; i < threadCount; i++) {
+			mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Created job system with " + std::to_string(threadCount) + " threads");
+	}
+
+	void JobSystem::destroy() {
+		{
+			std::lock_guard lock(mSleepMutex);
+			mStopping = true;
+		}
+		mWakeCondition.notify_all();
+		for (std::thread& worker : mWorkers) {
+			worker.join();
+		}
+		mWorkers.clear();
+
+		// Anything left was never waited on, there is no one to run it for
+		if (mQueuedCount.load() > 0 || !mDeferred.empty() || !mMainJobs.empty()) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Job system destroyed with jobs still queued");
+		}
+		mQueues.clear();
+		mDeferred.clear();
+		mMainJobs.clear();
+		mQueuedCount = 0;
+		mDeferredCount = 0;
+	}
+
+	void JobSystem::run(Job job, JobCounter* counter, const JobCounter* dependency) {
+		if (counter != nullptr) {
+			counter->mCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		QueuedJob queued{std::move(job), counter};
+		if (dependency == nullptr || dependency->done()) {
+			push(std::move(queued));
+			return;
+		}
+
+		{
+			std::lock_guard lock(mDeferredMutex);
+			// Counted before checking again, so whoever finishes the dependency either sees this job or we see it done
+			mDeferredCount.fetch_add(1);
+			if (!dependency->done()) {
+				mDeferred.push_back({std::move(queued), dependency});
+				mTotalDeferredCount.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			mDeferredCount.fetch_sub(1);
+		}
+		push(std::move(queued));
+	}
+
+	void JobSystem::runOnMainThread(Job job, JobCounter* counter) {
+		if (counter != nullptr) {
+			counter->mCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		std::lock_guard lock(mMainMutex);
+		mMainJobs.push_back({std::move(job), counter});
+	}
+
+	void JobSystem::parallelFor(uint32 count, uint32 batchSize, RangeJob job, JobCounter& counter) {
+		batchSize = std::max(batchSize, 1u);
+
+		// Shared so every batch does not copy whatever the function captured
+		std::shared_ptr<RangeJob> rangeJob = std::make_shared<RangeJob>(std::move(job));
+		for (uint32 begin = 0; begin < count; begin += batchSize) {
+			uint32 end = std::min(begin + batchSize, count);
+			run([rangeJob, begin, end]() { (*rangeJob)(begin, end); }, &counter);
+		}
+	}
+
+	void JobSystem::wait(const JobCounter& counter) {
+		uint32 index = tThreadIndex;
+
+		while (!counter.done()) {
+			QueuedJob job;
+			if (index == MainJobThread && popMainThread(job)) {
+				execute(job);
+			}else if (index != InvalidJobThread && pop(index, job)) {
+				execute(job);
+			}else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::pumpMainThread() {
+		QueuedJob job;
+		while (popMainThread(job)) {
+			execute(job);
+		}
+	}
+
+	uint32 JobSystem::threadIndex() {
+		return tThreadIndex;
+	}
+
+	JobStats JobSystem::getStats() const {
+		JobStats stats;
+		stats.threadCount = getThreadCount();
+		stats.jobCount = mJobCount.load(std::memory_order_relaxed);
+		stats.stealCount = mStealCount.load(std::memory_order_relaxed);
+		stats.deferredCount = mTotalDeferredCount.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void JobSystem::workerLoop(uint32 index) {
+		tThreadIndex = index;
+		Profiler::get().setThreadName("Job worker " + std::to_string(index));
+
+		while (true) {
+			QueuedJob job;
+			if (pop(index, job)) {
+				execute(job);
+				continue;
+			}
+
+			std::unique_lock lock(mSleepMutex);
+			mWakeCondition.wait(lock, [this]() { return mStopping || mQueuedCount.load() > 0; });
+			if (mStopping) {
+				return;
+			}
+		}
+	}
+
+	void JobSystem::push(QueuedJob job) {
+		uint32 index = tThreadIndex;
+		if (index == InvalidJobThread) {
+			index = mNextQueue.fetch_add(1, std::memory_order_relaxed) % getThreadCount();
+		}
+
+		{
+			std::lock_guard lock(mQueues[index]->mutex);
+			mQueues[index]->jobs.push_back(std::move(job));
+		}
+		mQueuedCount.fetch_add(1);
+
+		// Taking the lock orders this against a worker between checking the count and going to sleep
+		{
+			std::lock_guard lock(mSleepMutex);
+		}
+		mWakeCondition.notify_one();
+	}
+
+	bool JobSystem::pop(uint32 index, QueuedJob& job) {
+		{
+			WorkQueue& queue = *mQueues[index];
+			std::lock_guard lock(queue.mutex);
+			if (!queue.jobs.empty()) {
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				mQueuedCount.fetch_sub(1);
+				return true;
+			}
+		}
+
+		uint32 threadCount = getThreadCount();
+		for (uint32 offset = 1; offset < threadCount; offset++) {
+			WorkQueue& queue = *mQueues[(index + offset) % threadCount];
+			std::lock_guard lock(queue.mutex);
+			if (!queue.jobs.empty()) {
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				mQueuedCount.fetch_sub(1);
+				mStealCount.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool JobSystem::popMainThread(QueuedJob& job) {
+		std::lock_guard lock(mMainMutex);
+		if (mMainJobs.empty()) {
+			return false;
+		}
+
+		job = std::move(mMainJobs.front());
+		mMainJobs.pop_front();
+		return true;
+	}
+
+	void JobSystem::execute(QueuedJob& job) {
+		job.job();
+		mJobCount.fetch_add(1, std::memory_order_relaxed);
+
+		// The counter may be gone as soon as it reads done, so nothing touches it after the decrement
+		if (job.counter != nullptr && job.counter->mCount.fetch_sub(1) == 1) {
+			if (mDeferredCount.load() > 0) {
+				releaseDeferred();
+			}
+		}
+	}
+
+	void JobSystem::releaseDeferred() {
+		std::vector<QueuedJob> ready;
+		{
+			std::lock_guard lock(mDeferredMutex);
+			std::erase_if(mDeferred, [&ready](DeferredJob& deferred) {
+				if (!deferred.dependency->done()) {
+					return false;
+				}
+				ready.push_back(std::move(deferred.job));
+				return true;
+			});
+			mDeferredCount.fetch_sub(static_cast<uint32>(ready.size()));
+		}
+
+		for (QueuedJob& job : ready) {
+			push(std::move(job));
+		}
+	}
+} // SpRenderer
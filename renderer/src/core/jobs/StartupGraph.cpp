@@ -0,0 +1,179 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "StartupGraph.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace SpRenderer {
+	namespace {
+		std::string milliseconds(double value) {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "%8.2f", value);
+			return buffer;
+		}
+	}
+
+	StartupStageId StartupGraph::add(const char* name, Job job, std::initializer_list<StartupStageId> dependencies) {
+		return addStage(name, std::move(job), dependencies, false);
+	}
+
+	StartupStageId StartupGraph::addMainThread(const char* name, Job job, std::initializer_list<StartupStageId> dependencies) {
+		return addStage(name, std::move(job), dependencies, true);
+	}
+
+	void StartupGraph::run() {
+		if (mRan) {
+			SpConsole::FatalExit("A startup graph can only run once", SP_FAILURE);
+		}
+		if (JobSystem::threadIndex() != MainJobThread) {
+			SpConsole::FatalExit("Startup graphs have to run on the main thread", SP_FAILURE);
+		}
+		mRan = true;
+
+		mStartTime = std::chrono::steady_clock::now();
+
+		for (Stage& stage : mStages) {
+			submit(stage);
+		}
+		for (const Stage& stage : mStages) {
+			mJobSystem.wait(stage.counter);
+		}
+
+		buildReport();
+	}
+
+	void StartupGraph::logReport() const {
+		uint32 mainThreadStages = 0;
+		for (const StartupStageTiming& stage : mReport.stages) {
+			if (stage.thread == MainJobThread) mainThreadStages++;
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Startup took " + std::to_string(mReport.totalMs) + " ms, " +
+		                                  std::to_string(mReport.stageMs) + " ms of stages, " +
+		                                  std::to_string(mainThreadStages) + " of " + std::to_string(mReport.stages.size()) +
+		                                  " on the main thread. * marks the critical path");
+
+		size_t nameWidth = 0;
+		for (const StartupStageTiming& stage : mReport.stages) {
+			nameWidth = std::max(nameWidth, std::strlen(stage.name));
+		}
+
+		for (const StartupStageTiming& stage : mReport.stages) {
+			std::string name = stage.name;
+			name.resize(nameWidth, ' ');
+
+			std::string thread = stage.thread == MainJobThread ? "main" : "worker " + std::to_string(stage.thread);
+			SpConsole::Write(SP_MESSAGE_INFO, std::string(stage.critical ? "  * " : "    ") + name + " at" +
+			                                  milliseconds(stage.startMs) + " ms, took" +
+			                                  milliseconds(stage.durationMs) + " ms on " + thread);
+		}
+	}
+
+	StartupStageId StartupGraph::addStage(const char* name, Job job, std::initializer_list<StartupStageId> dependencies, bool mainThread) {
+		if (mRan) {
+			SpConsole::FatalExit("Can't add stages to a startup graph that already ran", SP_FAILURE);
+		}
+
+		StartupStageId id = static_cast<StartupStageId>(mStages.size());
+		for (StartupStageId dependency : dependencies) {
+			if (dependency >= id) {
+				SpConsole::FatalExit(std::string("Startup stage ") + name + " depends on a stage added after it", SP_FAILURE);
+			}
+		}
+
+		Stage& stage = mStages.emplace_back();
+		stage.name = name;
+		stage.job = std::move(job);
+		stage.dependencies.assign(dependencies.begin(), dependencies.end());
+		stage.mainThread = mainThread;
+		return id;
+	}
+
+	void StartupGraph::submit(Stage& stage) {
+		const JobCounter* dependency = nullptr;
+		if (stage.dependencies.size() == 1) {
+			dependency = &mStages[stage.dependencies[0]].counter;
+		}else if (stage.dependencies.size() > 1) {
+			// Jobs only take one dependency. An empty job per dependency counts on the join counter instead, which is
+			// done once all of them ran
+			for (StartupStageId id : stage.dependencies) {
+				mJobSystem.run([] {}, &stage.dependencyCounter, &mStages[id].counter);
+			}
+			dependency = &stage.dependencyCounter;
+		}
+
+		Stage* stagePointer = &stage;
+		if (!stage.mainThread) {
+			mJobSystem.run([this, stagePointer] { execute(*stagePointer); }, &stage.counter, dependency);
+			return;
+		}
+
+		if (dependency == nullptr) {
+			mJobSystem.runOnMainThread([this, stagePointer] { execute(*stagePointer); }, &stage.counter);
+			return;
+		}
+
+		// Main thread jobs can't wait on a dependency, a worker job does and hands the stage over. It counts on the
+		// stage's counter too, so the counter never drops to zero between the two
+		mJobSystem.run([this, stagePointer] {
+			mJobSystem.runOnMainThread([this, stagePointer] { execute(*stagePointer); }, &stagePointer->counter);
+		}, &stage.counter, dependency);
+	}
+
+	void StartupGraph::execute(Stage& stage) {
+		ProfileZone zone(stage.name);
+
+		stage.thread = JobSystem::threadIndex();
+		stage.startTime = std::chrono::steady_clock::now();
+		stage.job();
+		stage.endTime = std::chrono::steady_clock::now();
+	}
+
+	void StartupGraph::buildReport() {
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+
+		mReport = {};
+		mReport.totalMs = Milliseconds(std::chrono::steady_clock::now() - mStartTime).count();
+
+		for (const Stage& stage : mStages) {
+			StartupStageTiming timing{};
+			timing.name = stage.name;
+			timing.thread = stage.thread;
+			timing.startMs = Milliseconds(stage.startTime - mStartTime).count();
+			timing.durationMs = Milliseconds(stage.endTime - stage.startTime).count();
+			timing.critical = false;
+
+			mReport.stageMs += timing.durationMs;
+			mReport.stages.push_back(timing);
+		}
+
+		if (mStages.empty()) {
+			return;
+		}
+
+		// Walk back from the stage that finished last, always through the dependency that held it up the longest
+		StartupStageId current = 0;
+		for (StartupStageId id = 1; id < mStages.size(); id++) {
+			if (mStages[id].endTime > mStages[current].endTime) current = id;
+		}
+
+		while (true) {
+			mReport.stages[current].critical = true;
+
+			const std::vector<StartupStageId>& dependencies = mStages[current].dependencies;
+			if (dependencies.empty()) {
+				break;
+			}
+
+			StartupStageId latest = dependencies[0];
+			for (StartupStageId id : dependencies) {
+				if (mStages[id].endTime > mStages[latest].endTime) latest = id;
+			}
+			current = latest;
+		}
+	}
+} // SpRenderer
@@ -0,0 +1,77 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "ThreadCommandPools.h"
+
+namespace SpRenderer {
+	void ThreadCommandPools::init(VkDevice device, uint32 queueFamilyIndex, uint32 framesInFlight, uint32 threadCount) {
+		mDevice = device;
+		mThreadCount = threadCount;
+		mPools.resize(static_cast<size_t>(framesInFlight) * threadCount);
+
+		VkCommandPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+		for (ThreadPool& pool : mPools) {
+			VkResult result = vkCreateCommandPool(mDevice, &poolCreateInfo, nullptr, &pool.pool);
+			SpConsole::VulkanExitCheck(result, "Failed to create thread command pool!", SP_FAILURE);
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Created " + std::to_string(mPools.size()) + " thread command pools");
+	}
+
+	void ThreadCommandPools::destroy() {
+		// Destroying a pool frees its buffers
+		for (ThreadPool& pool : mPools) {
+			vkDestroyCommandPool(mDevice, pool.pool, nullptr);
+		}
+		mPools.clear();
+	}
+
+	void ThreadCommandPools::reset(uint32 frameIndex) {
+		for (uint32 thread = 0; thread < mThreadCount; thread++) {
+			ThreadPool& pool = mPools[frameIndex * mThreadCount + thread];
+			if (pool.usedCount == 0) {
+				continue;
+			}
+
+			vkResetCommandPool(mDevice, pool.pool, 0);
+			pool.usedCount = 0;
+		}
+	}
+
+	VkCommandBuffer ThreadCommandPools::beginSecondary(uint32 frameIndex, uint32 threadIndex, const VkCommandBufferInheritanceInfo& inheritance) {
+		if (threadIndex >= mThreadCount) {
+			SpConsole::FatalExit("Secondary command buffers can only be recorded on job system threads", SP_FAILURE);
+		}
+
+		ThreadPool& pool = mPools[frameIndex * mThreadCount + threadIndex];
+		if (pool.usedCount == pool.buffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = pool.pool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkResult result = vkAllocateCommandBuffers(mDevice, &allocInfo, &commandBuffer);
+			SpConsole::VulkanExitCheck(result, "Failed to allocate secondary command buffer!", SP_FAILURE);
+			pool.buffers.push_back(commandBuffer);
+		}
+
+		VkCommandBuffer commandBuffer = pool.buffers[pool.usedCount++];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritance;
+
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		SpConsole::VulkanExitCheck(result, "Failed to begin secondary command buffer!", SP_FAILURE);
+
+		return commandBuffer;
+	}
+} // SpRenderer
@@ -0,0 +1,585 @@
+//
+// Created by robsc on 11/22/25.
+//
+
+#include "MemoryAllocator.h"
+
+namespace SpRenderer {
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) {
+		return value & ~(alignment - 1);
+	}
+
+#pragma region BuddyAllocator
+
+	BuddyAllocator::BuddyAllocator(VkDeviceSize size, VkDeviceSize minBlockSize) {
+		mSize = nextPowerOfTwo(size);
+		mMinBlockSize = std::min(nextPowerOfTwo(minBlockSize), mSize);
+
+		mLevelCount = 1;
+		while ((mSize >> (mLevelCount - 1)) > mMinBlockSize) {
+			mLevelCount++;
+		}
+
+		mFreeLists.resize(mLevelCount);
+		mFreeLists[0].insert(0);
+	}
+
+	VkDeviceSize BuddyAllocator::nextPowerOfTwo(VkDeviceSize value) {
+		VkDeviceSize power = 1;
+		while (power < value) {
+			power <<= 1;
+		}
+		return power;
+	}
+
+	uint32 BuddyAllocator::levelForSize(VkDeviceSize size) const {
+		uint32 level = 0;
+		while (level + 1 < mLevelCount && (mSize >> (level + 1)) >= size) {
+			level++;
+		}
+		return level;
+	}
+
+	bool BuddyAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+		// Every block is aligned to its own size, so a block at least as big as the alignment is always aligned
+		VkDeviceSize blockSize = std::max({size, alignment, mMinBlockSize});
+		if (blockSize > mSize) {
+			return false;
+		}
+
+		uint32 targetLevel = levelForSize(blockSize);
+
+		int32 level = static_cast<int32>(targetLevel);
+		while (level >= 0 && mFreeLists[level].empty()) {
+			level--;
+		}
+		if (level < 0) {
+			return false;
+		}
+
+		// Lowest offset first keeps allocations packed toward the start of the block
+		VkDeviceSize blockOffset = *mFreeLists[level].begin();
+		mFreeLists[level].erase(mFreeLists[level].begin());
+
+		while (static_cast<uint32>(level) < targetLevel) {
+			level++;
+			mFreeLists[level].insert(blockOffset + (mSize >> level));
+		}
+
+		mAllocations[blockOffset] = {targetLevel, size};
+		mAllocatedBytes += mSize >> targetLevel;
+		mRequestedBytes += size;
+
+		offset = blockOffset;
+		return true;
+	}
+
+	void BuddyAllocator::free(VkDeviceSize offset) {
+		auto it = mAllocations.find(offset);
+		if (it == mAllocations.end()) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Freeing unknown buddy allocation at offset " + std::to_string(offset));
+			return;
+		}
+
+		uint32 level = it->second.level;
+		mAllocatedBytes -= mSize >> level;
+		mRequestedBytes -= it->second.requestedSize;
+		mAllocations.erase(it);
+
+		while (level > 0) {
+			VkDeviceSize buddy = offset ^ (mSize >> level);
+			auto buddyIt = mFreeLists[level].find(buddy);
+			if (buddyIt == mFreeLists[level].end()) {
+				break;
+			}
+
+			mFreeLists[level].erase(buddyIt);
+			offset = std::min(offset, buddy);
+			level--;
+		}
+
+		mFreeLists[level].insert(offset);
+	}
+
+	VkDeviceSize BuddyAllocator::largestFreeBlock() const {
+		for (uint32 level = 0; level < mLevelCount; level++) {
+			if (!mFreeLists[level].empty()) {
+				return mSize >> level;
+			}
+		}
+		return 0;
+	}
+
+#pragma endregion BuddyAllocator
+
+#pragma region LinearPool
+
+	bool LinearPool::allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) {
+		VkDeviceSize offset = alignUp(mHead, std::max<VkDeviceSize>(alignment, 1));
+		if (offset + size > mSize) {
+			return false;
+		}
+
+		mHead = offset + size;
+
+		allocation.memory = mMemory;
+		allocation.offset = offset;
+		allocation.size = size;
+		allocation.mappedData = mMappedData != nullptr ? static_cast<char*>(mMappedData) + offset : nullptr;
+		allocation.memoryTypeIndex = mMemoryTypeIndex;
+		allocation.blockIndex = mPoolIndex;
+		allocation.kind = SP_ALLOCATION_KIND_LINEAR;
+		return true;
+	}
+
+	void LinearPool::reset() {
+		mHead = 0;
+	}
+
+#pragma endregion LinearPool
+
+	void MemoryAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device) {
+		mDevice = device;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		mNonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+		mMaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		mPools.resize(mMemoryProperties.memoryTypeCount * SP_RESOURCE_TYPE_COUNT);
+		for (uint32 i = 0; i < mMemoryProperties.memoryTypeCount; i++) {
+			for (uint32 type = 0; type < SP_RESOURCE_TYPE_COUNT; type++) {
+				MemoryPool& pool = mPools[i * SP_RESOURCE_TYPE_COUNT + type];
+				pool.memoryTypeIndex = i;
+				pool.blockSize = blockSizeForType(i);
+			}
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Created memory allocator over " + std::to_string(mMemoryProperties.memoryTypeCount) +
+		                                  " memory types (max " + std::to_string(mMaxAllocationCount) + " device allocations)");
+	}
+
+	void MemoryAllocator::destroy() {
+		std::lock_guard lock(mMutex);
+
+		for (MemoryPool& pool : mPools) {
+			for (MemoryBlock& block : pool.blocks) {
+				if (block.memory == VK_NULL_HANDLE) continue;
+
+				if (!block.buddy->empty()) {
+					SpConsole::Write(SP_MESSAGE_WARNING, std::to_string(block.buddy->allocationCount()) +
+					                                     " allocations leaked in memory type " + std::to_string(pool.memoryTypeIndex));
+				}
+				freeDeviceMemory(block.memory);
+			}
+			pool.blocks.clear();
+		}
+
+		for (std::unique_ptr<LinearPool>& linearPool : mLinearPools) {
+			if (linearPool) freeDeviceMemory(linearPool->mMemory);
+		}
+		mLinearPools.clear();
+
+		if (mDedicatedCount > 0) {
+			SpConsole::Write(SP_MESSAGE_WARNING, std::to_string(mDedicatedCount) + " dedicated allocations leaked");
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Destroyed memory allocator");
+	}
+
+	void MemoryAllocator::createImage(const VkImageCreateInfo& imageCreateInfo,
+	                                  const AllocationCreateInfo& allocationInfo,
+	                                  VkImage& image,
+	                                  Allocation& allocation) {
+		VkResult result = vkCreateImage(mDevice, &imageCreateInfo, nullptr, &image);
+		SpConsole::VulkanExitCheck(result, "Failed to create image!", SP_FAILURE);
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(mDevice, image, &memRequirements);
+
+		AllocationCreateInfo info = allocationInfo;
+		bool renderTarget = imageCreateInfo.usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		if (renderTarget && memRequirements.size >= DedicatedRenderTargetSize) {
+			info.strategy = SP_ALLOCATION_DEDICATED;
+		}
+
+		ResourceType resourceType = imageCreateInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? SP_RESOURCE_OPTIMAL : SP_RESOURCE_LINEAR;
+
+		{
+			std::lock_guard lock(mMutex);
+			allocation = allocate(memRequirements, info, resourceType);
+		}
+
+		result = vkBindImageMemory(mDevice, image, allocation.memory, allocation.offset);
+		SpConsole::VulkanExitCheck(result, "Failed to bind image memory!", SP_FAILURE);
+	}
+
+	void MemoryAllocator::destroyImage(VkImage image, Allocation& allocation) {
+		vkDestroyImage(mDevice, image, nullptr);
+		free(allocation);
+	}
+
+	Allocation MemoryAllocator::allocateImageMemory(const VkMemoryRequirements& requirements, const AllocationCreateInfo& allocationInfo) {
+		std::lock_guard lock(mMutex);
+		return allocate(requirements, allocationInfo, SP_RESOURCE_OPTIMAL);
+	}
+
+	void MemoryAllocator::createBuffer(const VkBufferCreateInfo& bufferCreateInfo,
+	                                   const AllocationCreateInfo& allocationInfo,
+	                                   VkBuffer& buffer,
+	                                   Allocation& allocation) {
+		VkResult result = vkCreateBuffer(mDevice, &bufferCreateInfo, nullptr, &buffer);
+		SpConsole::VulkanExitCheck(result, "Failed to create buffer!", SP_FAILURE);
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(mDevice, buffer, &memRequirements);
+
+		{
+			std::lock_guard lock(mMutex);
+			allocation = allocate(memRequirements, allocationInfo, SP_RESOURCE_LINEAR);
+		}
+
+		result = vkBindBufferMemory(mDevice, buffer, allocation.memory, allocation.offset);
+		SpConsole::VulkanExitCheck(result, "Failed to bind buffer memory!", SP_FAILURE);
+	}
+
+	void MemoryAllocator::destroyBuffer(VkBuffer buffer, Allocation& allocation) {
+		vkDestroyBuffer(mDevice, buffer, nullptr);
+		free(allocation);
+	}
+
+	LinearPool* MemoryAllocator::createLinearPool(VkDeviceSize size, const AllocationCreateInfo& allocationInfo) {
+		std::lock_guard lock(mMutex);
+
+		uint32 memoryTypeIndex = findMemoryTypeIndex(~0u, allocationInfo.requiredFlags, allocationInfo.preferredFlags);
+		if (memoryTypeIndex == std::numeric_limits<uint32>::max()) {
+			SpConsole::FatalExit("Failed to find memory type for linear pool!", SP_FAILURE);
+		}
+
+		std::unique_ptr<LinearPool> pool = std::make_unique<LinearPool>();
+		pool->mMemory = allocateDeviceMemory(size, memoryTypeIndex);
+		if (pool->mMemory == VK_NULL_HANDLE) {
+			SpConsole::FatalExit("Failed to allocate linear pool!", SP_FAILURE);
+		}
+		pool->mMappedData = mapIfHostVisible(pool->mMemory, memoryTypeIndex);
+		pool->mMemoryTypeIndex = memoryTypeIndex;
+		pool->mSize = size;
+
+		// Reuse a slot freed by destroyLinearPool so the index stays small
+		size_t slot = 0;
+		while (slot < mLinearPools.size() && mLinearPools[slot]) {
+			slot++;
+		}
+		if (slot == mLinearPools.size()) {
+			mLinearPools.emplace_back();
+		}
+
+		pool->mPoolIndex = static_cast<uint32>(slot);
+		mLinearPools[slot] = std::move(pool);
+
+		return mLinearPools[slot].get();
+	}
+
+	void MemoryAllocator::destroyLinearPool(LinearPool* pool) {
+		if (pool == nullptr) return;
+
+		std::lock_guard lock(mMutex);
+		freeDeviceMemory(pool->mMemory);
+		mLinearPools[pool->mPoolIndex].reset();
+	}
+
+	void MemoryAllocator::free(Allocation& allocation) {
+		std::lock_guard lock(mMutex);
+
+		switch (allocation.kind) {
+			case SP_ALLOCATION_KIND_POOLED: {
+				MemoryPool& pool = mPools[allocation.memoryTypeIndex * SP_RESOURCE_TYPE_COUNT + allocation.poolIndex];
+				MemoryBlock& block = pool.blocks[allocation.blockIndex];
+				block.buddy->free(allocation.offset);
+
+				// Give empty blocks back to the driver, but keep one around so alloc/free cycles do not thrash
+				if (block.buddy->empty()) {
+					size_t liveBlocks = 0;
+					for (const MemoryBlock& other : pool.blocks) {
+						if (other.memory != VK_NULL_HANDLE) liveBlocks++;
+					}
+					if (liveBlocks > 1) {
+						freeDeviceMemory(block.memory);
+						block.memory = VK_NULL_HANDLE;
+						block.mappedData = nullptr;
+						block.buddy.reset();
+					}
+				}
+				break;
+			}
+			case SP_ALLOCATION_KIND_DEDICATED:
+				freeDeviceMemory(allocation.memory);
+				mDedicatedCount--;
+				mDedicatedBytes -= allocation.size;
+				break;
+
+			case SP_ALLOCATION_KIND_LINEAR:
+			case SP_ALLOCATION_KIND_NONE:
+				break;
+		}
+
+		allocation = Allocation{};
+	}
+
+	void MemoryAllocator::flush(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+		VkMappedMemoryRange range{};
+		if (mappedRange(allocation, offset, size, range)) {
+			vkFlushMappedMemoryRanges(mDevice, 1, &range);
+		}
+	}
+
+	void MemoryAllocator::invalidate(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+		VkMappedMemoryRange range{};
+		if (mappedRange(allocation, offset, size, range)) {
+			vkInvalidateMappedMemoryRanges(mDevice, 1, &range);
+		}
+	}
+
+	bool MemoryAllocator::mappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange& range) const {
+		VkMemoryPropertyFlags flags = mMemoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+		if (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+			return false;
+		}
+
+		if (size == VK_WHOLE_SIZE) {
+			size = allocation.size - offset;
+		}
+
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = alignDown(allocation.offset + offset, mNonCoherentAtomSize);
+		range.size = alignUp(allocation.offset + offset + size, mNonCoherentAtomSize) - range.offset;
+
+		// Dedicated memory is exactly the allocation size, rounding up could run past its end
+		if (allocation.kind == SP_ALLOCATION_KIND_DEDICATED && range.offset + range.size > allocation.size) {
+			range.size = VK_WHOLE_SIZE;
+		}
+
+		return true;
+	}
+
+	AllocatorStats MemoryAllocator::getStats() {
+		std::lock_guard lock(mMutex);
+
+		AllocatorStats stats{};
+		VkDeviceSize largestFreeSum = 0;
+
+		for (const MemoryPool& pool : mPools) {
+			for (const MemoryBlock& block : pool.blocks) {
+				if (block.memory == VK_NULL_HANDLE) continue;
+
+				stats.blockCount++;
+				stats.allocationCount += block.buddy->allocationCount();
+				stats.reservedBytes += block.buddy->size();
+				stats.usedBytes += block.buddy->usedBytes();
+				stats.freeBytes += block.buddy->freeBytes();
+				stats.largestFreeRange = std::max(stats.largestFreeRange, block.buddy->largestFreeBlock());
+				largestFreeSum += block.buddy->largestFreeBlock();
+			}
+		}
+
+		for (const std::unique_ptr<LinearPool>& linearPool : mLinearPools) {
+			if (!linearPool) continue;
+			stats.linearPoolCount++;
+			stats.reservedBytes += linearPool->capacity();
+			stats.usedBytes += linearPool->usedBytes();
+		}
+
+		stats.dedicatedCount = mDedicatedCount;
+		stats.allocationCount += mDedicatedCount;
+		stats.reservedBytes += mDedicatedBytes;
+		stats.usedBytes += mDedicatedBytes;
+		stats.deviceMemoryCount = mDeviceMemoryCount;
+
+		if (stats.freeBytes > 0) {
+			stats.fragmentation = 1.0f - static_cast<float>(static_cast<double>(largestFreeSum) / static_cast<double>(stats.freeBytes));
+		}
+
+		return stats;
+	}
+
+	void MemoryAllocator::logStats() {
+		AllocatorStats stats = getStats();
+
+		const double mib = 1024.0 * 1024.0;
+		std::string message = "GPU memory: " + std::to_string(stats.allocationCount) + " allocations in " +
+		                      std::to_string(stats.blockCount) + " blocks, " + std::to_string(stats.dedicatedCount) + " dedicated, " +
+		                      std::to_string(stats.linearPoolCount) + " linear pools | " +
+		                      std::to_string(stats.usedBytes / mib) + " / " + std::to_string(stats.reservedBytes / mib) + " MiB used | " +
+		                      "fragmentation " + std::to_string(stats.fragmentation) + " | " +
+		                      std::to_string(stats.deviceMemoryCount) + " / " + std::to_string(mMaxAllocationCount) + " device allocations";
+		SpConsole::Write(SP_MESSAGE_INFO, message);
+	}
+
+	uint32 MemoryAllocator::findMemoryTypeIndex(uint32 typeFilter,
+	                                            VkMemoryPropertyFlags requiredFlags,
+	                                            VkMemoryPropertyFlags preferredFlags) const {
+		VkMemoryPropertyFlags wantedFlags = requiredFlags | preferredFlags;
+		for (uint32 i = 0; i < mMemoryProperties.memoryTypeCount; i++) {
+			if (typeFilter & (1 << i) && (mMemoryProperties.memoryTypes[i].propertyFlags & wantedFlags) == wantedFlags) {
+				return i;
+			}
+		}
+
+		for (uint32 i = 0; i < mMemoryProperties.memoryTypeCount; i++) {
+			if (typeFilter & (1 << i) && (mMemoryProperties.memoryTypes[i].propertyFlags & requiredFlags) == requiredFlags) {
+				return i;
+			}
+		}
+
+		return std::numeric_limits<uint32>::max();
+	}
+
+	Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+	                                     const AllocationCreateInfo& allocationInfo,
+	                                     ResourceType resourceType) {
+		uint32 memoryTypeIndex = findMemoryTypeIndex(requirements.memoryTypeBits, allocationInfo.requiredFlags, allocationInfo.preferredFlags);
+		if (memoryTypeIndex == std::numeric_limits<uint32>::max()) {
+			SpConsole::FatalExit("Failed to find suitable memory type!", SP_FAILURE);
+		}
+
+		Allocation allocation{};
+		MemoryPool& pool = mPools[memoryTypeIndex * SP_RESOURCE_TYPE_COUNT + resourceType];
+
+		if (allocationInfo.strategy == SP_ALLOCATION_DEDICATED || requirements.size > pool.blockSize / 2) {
+			if (!allocateDedicated(requirements.size, memoryTypeIndex, allocation)) {
+				SpConsole::FatalExit("Failed to allocate dedicated memory!", SP_FAILURE);
+			}
+			return allocation;
+		}
+
+		VkDeviceSize offset = 0;
+		int32 blockIndex = -1;
+		for (size_t i = 0; i < pool.blocks.size(); i++) {
+			if (pool.blocks[i].memory != VK_NULL_HANDLE &&
+			    pool.blocks[i].buddy->allocate(requirements.size, requirements.alignment, offset)) {
+				blockIndex = static_cast<int32>(i);
+				break;
+			}
+		}
+
+		if (blockIndex < 0) {
+			size_t slot = 0;
+			while (slot < pool.blocks.size() && pool.blocks[slot].memory != VK_NULL_HANDLE) {
+				slot++;
+			}
+			if (slot == pool.blocks.size()) {
+				pool.blocks.emplace_back();
+			}
+
+			if (!allocateBlock(pool, pool.blocks[slot]) ||
+			    !pool.blocks[slot].buddy->allocate(requirements.size, requirements.alignment, offset)) {
+				// The heap may still fit the resource on its own even when a whole block does not
+				if (!allocateDedicated(requirements.size, memoryTypeIndex, allocation)) {
+					SpConsole::FatalExit("Out of device memory!", SP_FAILURE);
+				}
+				return allocation;
+			}
+			blockIndex = static_cast<int32>(slot);
+		}
+
+		MemoryBlock& block = pool.blocks[blockIndex];
+		allocation.memory = block.memory;
+		allocation.offset = offset;
+		allocation.size = requirements.size;
+		allocation.mappedData = block.mappedData != nullptr ? static_cast<char*>(block.mappedData) + offset : nullptr;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.blockIndex = static_cast<uint32>(blockIndex);
+		allocation.poolIndex = static_cast<uint8>(resourceType);
+		allocation.kind = SP_ALLOCATION_KIND_POOLED;
+
+		return allocation;
+	}
+
+	bool MemoryAllocator::allocateDedicated(VkDeviceSize size, uint32 memoryTypeIndex, Allocation& allocation) {
+		VkDeviceMemory memory = allocateDeviceMemory(size, memoryTypeIndex);
+		if (memory == VK_NULL_HANDLE) {
+			return false;
+		}
+
+		allocation.memory = memory;
+		allocation.offset = 0;
+		allocation.size = size;
+		allocation.mappedData = mapIfHostVisible(memory, memoryTypeIndex);
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.kind = SP_ALLOCATION_KIND_DEDICATED;
+
+		mDedicatedCount++;
+		mDedicatedBytes += size;
+		return true;
+	}
+
+	bool MemoryAllocator::allocateBlock(MemoryPool& pool, MemoryBlock& block) {
+		block.memory = allocateDeviceMemory(pool.blockSize, pool.memoryTypeIndex);
+		if (block.memory == VK_NULL_HANDLE) {
+			return false;
+		}
+
+		block.mappedData = mapIfHostVisible(block.memory, pool.memoryTypeIndex);
+		block.buddy = std::make_unique<BuddyAllocator>(pool.blockSize, MinBuddySize);
+
+		SP_LOG(SP_MESSAGE_VERBOSE, "Allocated " + std::to_string(pool.blockSize / (1024 * 1024)) +
+		                                     " MiB block for memory type " + std::to_string(pool.memoryTypeIndex));
+		return true;
+	}
+
+	VkDeviceMemory MemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32 memoryTypeIndex) {
+		if (mDeviceMemoryCount >= mMaxAllocationCount) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Reached maxMemoryAllocationCount (" + std::to_string(mMaxAllocationCount) + ")");
+			return VK_NULL_HANDLE;
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkResult result = vkAllocateMemory(mDevice, &allocInfo, nullptr, &memory);
+		if (result != VK_SUCCESS) {
+			SpConsole::VulkanResult(result, SP_MESSAGE_WARNING, "Failed to allocate device memory!");
+			return VK_NULL_HANDLE;
+		}
+
+		mDeviceMemoryCount++;
+		return memory;
+	}
+
+	void* MemoryAllocator::mapIfHostVisible(VkDeviceMemory memory, uint32 memoryTypeIndex) {
+		if (!(mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+			return nullptr;
+		}
+
+		void* mappedData = nullptr;
+		VkResult result = vkMapMemory(mDevice, memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+		SpConsole::VulkanExitCheck(result, "Failed to map device memory!", SP_FAILURE);
+		return mappedData;
+	}
+
+	void MemoryAllocator::freeDeviceMemory(VkDeviceMemory memory) {
+		vkFreeMemory(mDevice, memory, nullptr);
+		mDeviceMemoryCount--;
+	}
+
+	VkDeviceSize MemoryAllocator::blockSizeForType(uint32 memoryTypeIndex) const {
+		uint32 heapIndex = mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[heapIndex].size;
+
+		// Small heaps (BAR memory, integrated carve-outs) would be eaten by a couple of full sized blocks
+		if (heapSize <= SmallHeapLimit) {
+			VkDeviceSize blockSize = BuddyAllocator::nextPowerOfTwo(heapSize / 8 + 1) / 2;
+			return std::clamp(blockSize, MinBuddySize, SmallHeapBlockSize);
+		}
+		return PreferredBlockSize;
+	}
+} // SpRenderer
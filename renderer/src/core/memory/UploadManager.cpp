@@ -0,0 +1,521 @@
+//
+// Created by robsc on 11/27/25.
+//
+
+#include "UploadManager.h"
+
+namespace SpRenderer {
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	void UploadManager::init(VkDevice device,
+	                         MemoryAllocator& allocator,
+	                         QueueFamilyIndices indices,
+	                         VkQueue transferQueue,
+	                         bool timelineSemaphores,
+	                         VkDeviceSize stagingSize) {
+		mDevice = device;
+		mAllocator = &allocator;
+		mIndices = indices;
+		mTransferQueue = transferQueue;
+		mTimelineSemaphores = timelineSemaphores;
+		mOwnershipTransfer = mIndices.dedicatedTransfer();
+
+		VkCommandPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = mIndices.transferFamily.value();
+
+		VkResult result = vkCreateCommandPool(mDevice, &poolCreateInfo, nullptr, &mCommandPool);
+		SpConsole::VulkanExitCheck(result, "Failed to create upload command pool!", SP_FAILURE);
+
+		std::array<VkCommandBuffer, UploadBatchCount> commandBuffers{};
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = mCommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = UploadBatchCount;
+
+		result = vkAllocateCommandBuffers(mDevice, &allocInfo, commandBuffers.data());
+		SpConsole::VulkanExitCheck(result, "Failed to allocate upload command buffers!", SP_FAILURE);
+
+		for (uint32 i = 0; i < UploadBatchCount; i++) {
+			mBatches[i].commandBuffer = commandBuffers[i];
+
+			if (!mTimelineSemaphores) {
+				VkFenceCreateInfo fenceCreateInfo{};
+				fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+				result = vkCreateFence(mDevice, &fenceCreateInfo, nullptr, &mBatches[i].fence);
+				SpConsole::VulkanExitCheck(result, "Failed to create upload fence!", SP_FAILURE);
+			}
+		}
+
+		if (mTimelineSemaphores) {
+			VkSemaphoreTypeCreateInfo typeCreateInfo{};
+			typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			typeCreateInfo.initialValue = 0;
+
+			VkSemaphoreCreateInfo semaphoreCreateInfo{};
+			semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+			result = vkCreateSemaphore(mDevice, &semaphoreCreateInfo, nullptr, &mTimelineSemaphore);
+			SpConsole::VulkanExitCheck(result, "Failed to create upload timeline semaphore!", SP_FAILURE);
+		}
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = stagingSize;
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		allocationInfo.strategy = SP_ALLOCATION_DEDICATED;
+
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, mStagingBuffer, mStagingAllocation);
+		mStagingSize = stagingSize;
+		mRingHead = 0;
+		mRingTail = 0;
+
+		SpConsole::Write(SP_MESSAGE_INFO, std::string("Created upload manager on ") +
+		                                  (mOwnershipTransfer ? "a dedicated transfer queue" : "the graphics queue") +
+		                                  (mTimelineSemaphores ? " with timeline semaphores" : " with fences"));
+	}
+
+	void UploadManager::destroy() {
+		{
+			std::lock_guard lock(mMutex);
+
+			submitRecording();
+			while (mInFlightCount > 0) {
+				waitOldest();
+			}
+		}
+
+		for (UploadBatch& batch : mBatches) {
+			if (batch.fence != VK_NULL_HANDLE) {
+				vkDestroyFence(mDevice, batch.fence, nullptr);
+			}
+			for (std::pair<VkBuffer, Allocation>& staging : batch.oversizeStaging) {
+				mAllocator->destroyBuffer(staging.first, staging.second);
+			}
+			batch = {};
+		}
+
+		if (mTimelineSemaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(mDevice, mTimelineSemaphore, nullptr);
+			mTimelineSemaphore = VK_NULL_HANDLE;
+		}
+
+		vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+		mCommandPool = VK_NULL_HANDLE;
+
+		mAllocator->destroyBuffer(mStagingBuffer, mStagingAllocation);
+		mStagingBuffer = VK_NULL_HANDLE;
+
+		mReadyBufferAcquires.clear();
+		mReadyImageAcquires.clear();
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Upload manager: " + std::to_string(mStats.copyCount) + " copies, " +
+		                                  std::to_string(mStats.uploadedBytes) + " bytes in " +
+		                                  std::to_string(mStats.submitCount) + " submits, " +
+		                                  std::to_string(mStats.stallCount) + " stalls");
+	}
+
+	UploadTicket UploadManager::uploadBuffer(VkBuffer buffer,
+	                                         VkDeviceSize offset,
+	                                         const void* data,
+	                                         VkDeviceSize size,
+	                                         VkPipelineStageFlags dstStageMask,
+	                                         VkAccessFlags dstAccessMask) {
+		std::lock_guard lock(mMutex);
+
+		UploadBatch& batch = beginRecording();
+
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		VkDeviceSize stagingOffset = 0;
+		void* stagingData = allocateStaging(size, stagingBuffer, stagingOffset);
+		std::memcpy(stagingData, data, size);
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = stagingOffset;
+		copyRegion.dstOffset = offset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer, buffer, 1, &copyRegion);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		if (mOwnershipTransfer) {
+			// Release half of the ownership transfer, the graphics queue records the matching acquire
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = mIndices.transferFamily.value();
+			barrier.dstQueueFamilyIndex = mIndices.graphicsFamily.value();
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			                     0, nullptr, 1, &barrier, 0, nullptr);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccessMask;
+			batch.bufferAcquires.push_back(barrier);
+			batch.acquireStageMask |= dstStageMask;
+		}else {
+			barrier.dstAccessMask = dstAccessMask;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0,
+			                     0, nullptr, 1, &barrier, 0, nullptr);
+		}
+
+		batch.copyCount++;
+		mStats.copyCount++;
+		mStats.uploadedBytes += size;
+
+		return batch.ticket;
+	}
+
+	UploadTicket UploadManager::uploadImage(VkImage image,
+	                                        const VkImageSubresourceLayers& subresource,
+	                                        VkExtent3D extent,
+	                                        const void* data,
+	                                        VkDeviceSize size,
+	                                        VkImageLayout finalLayout,
+	                                        VkPipelineStageFlags dstStageMask,
+	                                        VkAccessFlags dstAccessMask) {
+		std::lock_guard lock(mMutex);
+
+		UploadBatch& batch = beginRecording();
+
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		VkDeviceSize stagingOffset = 0;
+		void* stagingData = allocateStaging(size, stagingBuffer, stagingOffset);
+		std::memcpy(stagingData, data, size);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = subresource.aspectMask;
+		barrier.subresourceRange.baseMipLevel = subresource.mipLevel;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = subresource.baseArrayLayer;
+		barrier.subresourceRange.layerCount = subresource.layerCount;
+
+		vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		                     0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy copyRegion{};
+		copyRegion.bufferOffset = stagingOffset;
+		copyRegion.bufferRowLength = 0;
+		copyRegion.bufferImageHeight = 0;
+		copyRegion.imageSubresource = subresource;
+		copyRegion.imageOffset = {0, 0, 0};
+		copyRegion.imageExtent = extent;
+		vkCmdCopyBufferToImage(batch.commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = finalLayout;
+
+		if (mOwnershipTransfer) {
+			// Both halves of an ownership transfer have to do the same layout transition
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = mIndices.transferFamily.value();
+			barrier.dstQueueFamilyIndex = mIndices.graphicsFamily.value();
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			                     0, nullptr, 0, nullptr, 1, &barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccessMask;
+			batch.imageAcquires.push_back(barrier);
+			batch.acquireStageMask |= dstStageMask;
+		}else {
+			barrier.dstAccessMask = dstAccessMask;
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0,
+			                     0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		batch.copyCount++;
+		mStats.copyCount++;
+		mStats.uploadedBytes += size;
+
+		return batch.ticket;
+	}
+
+	void UploadManager::flush() {
+		std::lock_guard lock(mMutex);
+
+		submitRecording();
+		retireCompleted();
+	}
+
+	void UploadManager::recordAcquireBarriers(VkCommandBuffer commandBuffer) {
+		std::lock_guard lock(mMutex);
+
+		retireCompleted();
+
+		if (mReadyBufferAcquires.empty() && mReadyImageAcquires.empty()) {
+			return;
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mReadyStageMask, 0,
+		                     0, nullptr,
+		                     static_cast<uint32>(mReadyBufferAcquires.size()), mReadyBufferAcquires.data(),
+		                     static_cast<uint32>(mReadyImageAcquires.size()), mReadyImageAcquires.data());
+
+		mReadyBufferAcquires.clear();
+		mReadyImageAcquires.clear();
+		mReadyStageMask = 0;
+	}
+
+	bool UploadManager::isComplete(UploadTicket ticket) {
+		std::lock_guard lock(mMutex);
+
+		retireCompleted();
+		return mCompletedTicket >= ticket;
+	}
+
+	void UploadManager::wait(UploadTicket ticket) {
+		std::lock_guard lock(mMutex);
+
+		UploadBatch& recordingBatch = mBatches[mRecordingBatch];
+		if (recordingBatch.recording && recordingBatch.ticket <= ticket) {
+			submitRecording();
+		}
+
+		retireCompleted();
+		while (mCompletedTicket < ticket && mInFlightCount > 0) {
+			waitOldest();
+		}
+	}
+
+	UploadStats UploadManager::getStats() {
+		std::lock_guard lock(mMutex);
+		return mStats;
+	}
+
+	UploadManager::UploadBatch& UploadManager::beginRecording() {
+		UploadBatch& batch = mBatches[mRecordingBatch];
+		if (batch.recording) {
+			return batch;
+		}
+
+		// Every batch slot is still on the GPU, the oldest one has to finish before its command buffer is reused
+		retireCompleted();
+		while (batch.submitted) {
+			waitOldest();
+		}
+
+		vkResetCommandBuffer(batch.commandBuffer, 0);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkResult result = vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+		SpConsole::VulkanExitCheck(result, "Failed to begin upload command buffer!", SP_FAILURE);
+
+		batch.ticket = mNextTicket++;
+		batch.recording = true;
+		batch.copyCount = 0;
+		batch.acquireStageMask = 0;
+		batch.bufferAcquires.clear();
+		batch.imageAcquires.clear();
+
+		return batch;
+	}
+
+	void UploadManager::submitRecording() {
+		UploadBatch& batch = mBatches[mRecordingBatch];
+		if (!batch.recording) {
+			return;
+		}
+
+		VkResult result = vkEndCommandBuffer(batch.commandBuffer);
+		SpConsole::VulkanExitCheck(result, "Failed to record upload command buffer!", SP_FAILURE);
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &batch.ticket;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		if (mTimelineSemaphores) {
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &mTimelineSemaphore;
+		}
+
+		result = vkQueueSubmit(mTransferQueue, 1, &submitInfo, batch.fence);
+		SpConsole::VulkanExitCheck(result, "Failed to submit upload batch!", SP_FAILURE);
+
+		batch.ringEnd = mRingHead;
+		batch.recording = false;
+		batch.submitted = true;
+
+		mInFlightCount++;
+		mRecordingBatch = (mRecordingBatch + 1) % UploadBatchCount;
+		mStats.submitCount++;
+	}
+
+	void UploadManager::retireCompleted() {
+		if (mInFlightCount == 0) {
+			return;
+		}
+
+		mCompletedTicket = std::max(mCompletedTicket, queryCompletedTicket());
+
+		while (mInFlightCount > 0 && mBatches[mOldestBatch].ticket <= mCompletedTicket) {
+			UploadBatch& batch = mBatches[mOldestBatch];
+
+			mReadyBufferAcquires.insert(mReadyBufferAcquires.end(), batch.bufferAcquires.begin(), batch.bufferAcquires.end());
+			mReadyImageAcquires.insert(mReadyImageAcquires.end(), batch.imageAcquires.begin(), batch.imageAcquires.end());
+			mReadyStageMask |= batch.acquireStageMask;
+
+			for (std::pair<VkBuffer, Allocation>& staging : batch.oversizeStaging) {
+				mAllocator->destroyBuffer(staging.first, staging.second);
+			}
+			batch.oversizeStaging.clear();
+
+			if (batch.fence != VK_NULL_HANDLE) {
+				vkResetFences(mDevice, 1, &batch.fence);
+			}
+
+			mRingTail = batch.ringEnd;
+			batch.submitted = false;
+
+			mOldestBatch = (mOldestBatch + 1) % UploadBatchCount;
+			mInFlightCount--;
+		}
+
+		// Head only meets tail once everything was consumed, start over so the next upload gets the whole ring
+		if (mRingHead == mRingTail) {
+			mRingHead = 0;
+			mRingTail = 0;
+		}
+	}
+
+	void UploadManager::waitOldest() {
+		if (mInFlightCount == 0) {
+			return;
+		}
+
+		UploadBatch& batch = mBatches[mOldestBatch];
+
+		if (mTimelineSemaphores) {
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &mTimelineSemaphore;
+			waitInfo.pValues = &batch.ticket;
+
+			vkWaitSemaphores(mDevice, &waitInfo, std::numeric_limits<uint64>::max());
+		}else {
+			vkWaitForFences(mDevice, 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64>::max());
+		}
+
+		mStats.stallCount++;
+		retireCompleted();
+	}
+
+	UploadTicket UploadManager::queryCompletedTicket() {
+		if (mTimelineSemaphores) {
+			uint64 value = 0;
+			vkGetSemaphoreCounterValue(mDevice, mTimelineSemaphore, &value);
+			return value;
+		}
+
+		// Batches finish in submission order on the queue, so stop at the first fence that is not signaled yet
+		UploadTicket completed = mCompletedTicket;
+		for (uint32 i = 0; i < mInFlightCount; i++) {
+			const UploadBatch& batch = mBatches[(mOldestBatch + i) % UploadBatchCount];
+			if (vkGetFenceStatus(mDevice, batch.fence) != VK_SUCCESS) {
+				break;
+			}
+			completed = batch.ticket;
+		}
+		return completed;
+	}
+
+	void* UploadManager::allocateStaging(VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset) {
+		if (size <= mStagingSize / 2) {
+			retireCompleted();
+
+			bool allocated = allocateRing(size, offset);
+			while (!allocated && mInFlightCount > 0) {
+				waitOldest();
+				allocated = allocateRing(size, offset);
+			}
+
+			if (allocated) {
+				buffer = mStagingBuffer;
+				return static_cast<char*>(mStagingAllocation.mappedData) + offset;
+			}
+		}
+
+		// Too large for the ring, or the ring is full of copies recorded but not yet flushed. Submitting from here
+		// could race the render thread on a shared queue, so the upload gets its own staging buffer instead
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = size;
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		std::pair<VkBuffer, Allocation> staging;
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, staging.first, staging.second);
+		mBatches[mRecordingBatch].oversizeStaging.push_back(staging);
+		mStats.oversizeCount++;
+
+		buffer = staging.first;
+		offset = 0;
+		return staging.second.mappedData;
+	}
+
+	bool UploadManager::allocateRing(VkDeviceSize size, VkDeviceSize& offset) {
+		VkDeviceSize alignedHead = alignUp(mRingHead, StagingAlignment);
+
+		if (mRingHead >= mRingTail) {
+			// Free space is [head, end) and [0, tail)
+			if (alignedHead + size <= mStagingSize) {
+				offset = alignedHead;
+				mRingHead = alignedHead + size;
+				return true;
+			}
+			// Strictly less so head never catches up with tail, which would read as empty
+			if (size < mRingTail) {
+				offset = 0;
+				mRingHead = size;
+				return true;
+			}
+			return false;
+		}
+
+		// Wrapped, free space is [head, tail)
+		if (alignedHead + size < mRingTail) {
+			offset = alignedHead;
+			mRingHead = alignedHead + size;
+			return true;
+		}
+		return false;
+	}
+} // SpRenderer
@@ -0,0 +1,225 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "LayoutCache.h"
+
+#include <bit>
+
+namespace SpRenderer {
+	void LayoutCache::init(VkDevice device) {
+		mDevice = device;
+	}
+
+	void LayoutCache::destroy() {
+		std::lock_guard lock(mMutex);
+
+		for (auto& [key, layout] : mPipelineLayouts) {
+			vkDestroyPipelineLayout(mDevice, layout, nullptr);
+		}
+		for (auto& [key, layout] : mSetLayouts) {
+			vkDestroyDescriptorSetLayout(mDevice, layout, nullptr);
+		}
+
+		mPipelineLayouts.clear();
+		mSetLayouts.clear();
+		mStats = {};
+	}
+
+	VkDescriptorSetLayout LayoutCache::getSetLayout(std::span<const VkDescriptorSetLayoutBinding> bindings,
+	                                                VkDescriptorSetLayoutCreateFlags flags,
+	                                                std::span<const VkDescriptorBindingFlags> bindingFlags) {
+		if (!bindingFlags.empty() && bindingFlags.size() != bindings.size()) {
+			SpConsole::FatalExit("Descriptor binding flags need one entry per binding", SP_FAILURE);
+		}
+
+		// Sort bindings and their flags together, so the same set written in another order is the same key
+		std::vector<uint32> order(bindings.size());
+		for (uint32 i = 0; i < order.size(); i++) {
+			order[i] = i;
+			if (bindings[i].pImmutableSamplers != nullptr) {
+				SpConsole::FatalExit("The layout cache does not support immutable samplers", SP_FAILURE);
+			}
+		}
+		std::sort(order.begin(), order.end(), [&bindings](uint32 a, uint32 b) {
+			return bindings[a].binding < bindings[b].binding;
+		});
+
+		SetLayoutKey key{};
+		key.flags = flags;
+		for (uint32 index : order) {
+			key.bindings.push_back(bindings[index]);
+			if (!bindingFlags.empty()) {
+				key.bindingFlags.push_back(bindingFlags[index]);
+			}
+		}
+
+		std::lock_guard lock(mMutex);
+
+		auto it = mSetLayouts.find(key);
+		if (it != mSetLayouts.end()) {
+			mStats.hits++;
+			return it->second;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32>(key.bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = key.bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.pNext = key.bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+		layoutCreateInfo.flags = flags;
+		layoutCreateInfo.bindingCount = static_cast<uint32>(key.bindings.size());
+		layoutCreateInfo.pBindings = key.bindings.data();
+
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		VkResult result = vkCreateDescriptorSetLayout(mDevice, &layoutCreateInfo, nullptr, &layout);
+		SpConsole::VulkanExitCheck(result, "Failed to create descriptor set layout!", SP_FAILURE);
+
+		mStats.misses++;
+		mStats.setLayoutCount++;
+		mSetLayouts.emplace(std::move(key), layout);
+		return layout;
+	}
+
+	VkPipelineLayout LayoutCache::getPipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts,
+	                                                std::span<const VkPushConstantRange> pushConstantRanges) {
+		PipelineLayoutKey key{};
+		key.setLayouts.assign(setLayouts.begin(), setLayouts.end());
+		key.pushConstantRanges.assign(pushConstantRanges.begin(), pushConstantRanges.end());
+		std::sort(key.pushConstantRanges.begin(), key.pushConstantRanges.end(), [](const VkPushConstantRange& a, const VkPushConstantRange& b) {
+			return a.stageFlags < b.stageFlags;
+		});
+
+		std::lock_guard lock(mMutex);
+
+		auto it = mPipelineLayouts.find(key);
+		if (it != mPipelineLayouts.end()) {
+			mStats.hits++;
+			return it->second;
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32>(key.setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = key.setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32>(key.pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = key.pushConstantRanges.data();
+
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkResult result = vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &layout);
+		SpConsole::VulkanExitCheck(result, "Failed to create pipeline layout!", SP_FAILURE);
+
+		mStats.misses++;
+		mStats.pipelineLayoutCount++;
+		mPipelineLayouts.emplace(std::move(key), layout);
+		return layout;
+	}
+
+	VkPipelineLayout LayoutCache::getPipelineLayout(const ShaderReflection& reflection, std::span<const FixedSetLayout> fixedSetLayouts) {
+		uint32 setCount = reflection.setCount();
+		for (const FixedSetLayout& fixed : fixedSetLayouts) {
+			setCount = std::max(setCount, fixed.set + 1);
+		}
+
+		std::vector<VkDescriptorSetLayout> setLayouts(setCount);
+		for (uint32 set = 0; set < setCount; set++) {
+			setLayouts[set] = getSetLayout(reflection, set, fixedSetLayouts);
+		}
+
+		return getPipelineLayout(setLayouts, reflection.pushConstants);
+	}
+
+	VkDescriptorSetLayout LayoutCache::getSetLayout(const ShaderReflection& reflection, uint32 set, std::span<const FixedSetLayout> fixedSetLayouts) {
+		for (const FixedSetLayout& fixed : fixedSetLayouts) {
+			if (fixed.set == set) {
+				return fixed.layout;
+			}
+		}
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings = reflection.setLayoutBindings(set);
+		for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+			if (binding.descriptorCount == 0) {
+				SpConsole::FatalExit("Set " + std::to_string(set) + " binding " + std::to_string(binding.binding) +
+				                     " is an unsized array, the set needs a fixed layout", SP_FAILURE);
+			}
+		}
+
+		return getSetLayout(bindings);
+	}
+
+	LayoutCacheStats LayoutCache::getStats() {
+		std::lock_guard lock(mMutex);
+		return mStats;
+	}
+
+	void LayoutCache::logStats() {
+		LayoutCacheStats stats = getStats();
+		SpConsole::Write(SP_MESSAGE_INFO, "Layout cache: " + std::to_string(stats.setLayoutCount) + " set layouts, " +
+		                                  std::to_string(stats.pipelineLayoutCount) + " pipeline layouts, " +
+		                                  std::to_string(stats.hits) + " hits, " + std::to_string(stats.misses) + " misses");
+	}
+
+#pragma region Keys
+
+	bool LayoutCache::SetLayoutKey::operator==(const SetLayoutKey& other) const {
+		if (flags != other.flags || bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags) {
+			return false;
+		}
+
+		for (size_t i = 0; i < bindings.size(); i++) {
+			const VkDescriptorSetLayoutBinding& a = bindings[i];
+			const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+			if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+			    a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool LayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey& other) const {
+		if (setLayouts != other.setLayouts || pushConstantRanges.size() != other.pushConstantRanges.size()) {
+			return false;
+		}
+
+		for (size_t i = 0; i < pushConstantRanges.size(); i++) {
+			const VkPushConstantRange& a = pushConstantRanges[i];
+			const VkPushConstantRange& b = other.pushConstantRanges[i];
+			if (a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t LayoutCache::KeyHash::operator()(const SetLayoutKey& key) const {
+		uint64 hash = Utils::hashCombine(Utils::HashSeed, key.flags);
+		for (const VkDescriptorSetLayoutBinding& binding : key.bindings) {
+			hash = Utils::hashCombine(hash, binding.binding);
+			hash = Utils::hashCombine(hash, binding.descriptorType);
+			hash = Utils::hashCombine(hash, binding.descriptorCount);
+			hash = Utils::hashCombine(hash, binding.stageFlags);
+		}
+		for (VkDescriptorBindingFlags flags : key.bindingFlags) {
+			hash = Utils::hashCombine(hash, flags);
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	size_t LayoutCache::KeyHash::operator()(const PipelineLayoutKey& key) const {
+		uint64 hash = Utils::HashSeed;
+		for (VkDescriptorSetLayout layout : key.setLayouts) {
+			hash = Utils::hashCombine(hash, std::bit_cast<uint64>(layout));
+		}
+		for (const VkPushConstantRange& range : key.pushConstantRanges) {
+			hash = Utils::hashCombine(hash, range.stageFlags);
+			hash = Utils::hashCombine(hash, (static_cast<uint64>(range.offset) << 32) | range.size);
+		}
+		return static_cast<size_t>(hash);
+	}
+
+#pragma endregion Keys
+} // SpRenderer
@@ -0,0 +1,258 @@
+//
+// Created by robsc on 11/26/25.
+//
+
+#include "PipelineCache.h"
+#include "Profiler.h"
+
+namespace fs = std::filesystem;
+
+namespace SpRenderer {
+	// 'SPPC'
+	const uint32 PipelineCacheMagic = 0x43505053;
+	const uint32 PipelineCacheVersion = 1;
+
+	void PipelineCache::preload() {
+		SP_PROFILE_ZONE("PipelineCache::preload");
+
+		mCachePath = fs::path(RENDERER_DATA_DIR) / PIPELINE_CACHE_FILE_NAME;
+		mPreloadedFile = readCacheFile();
+		mPreloaded = true;
+	}
+
+	void PipelineCache::init(VkDevice device, const VkPhysicalDeviceProperties& properties, bool creationFeedback) {
+		mDevice = device;
+		mProperties = properties;
+		mCreationFeedback = creationFeedback;
+		mStats = {};
+
+		fs::path dataDirectory = RENDERER_DATA_DIR;
+		if (!fs::exists(dataDirectory)) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Creating Directory " + dataDirectory.string());
+			fs::create_directories(dataDirectory);
+		}
+		mCachePath = dataDirectory / PIPELINE_CACHE_FILE_NAME;
+
+		// The driver copies the data out, so the mapping only has to live until the cache is created
+		Utils::MappedFile cacheFile = mPreloaded ? std::move(mPreloadedFile) : readCacheFile();
+		mPreloaded = false;
+		if (cacheFile.size() != 0 && !matchesDevice(cacheFile.data())) {
+			cacheFile = {};
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		if (cacheFile.size() != 0) {
+			createInfo.initialDataSize = cacheFile.size() - sizeof(CacheFileHeader);
+			createInfo.pInitialData = cacheFile.data().data() + sizeof(CacheFileHeader);
+		}
+
+		VkResult result = vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mPipelineCache);
+
+		if (result != VK_SUCCESS && createInfo.initialDataSize != 0) {
+			// Drivers may still reject data that passed validation, fall back to starting cold
+			SpConsole::Write(SP_MESSAGE_WARNING, "Driver rejected the pipeline cache, starting empty");
+			createInfo.initialDataSize = 0;
+			createInfo.pInitialData = nullptr;
+			result = vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mPipelineCache);
+		}
+
+		SpConsole::VulkanExitCheck(result, SP_MESSAGE_INFO,
+		                           cacheFile.size() == 0 ? "Created empty pipeline cache" : "Loaded pipeline cache",
+		                           "Failed to create pipeline cache!", SP_FAILURE);
+	}
+
+	void PipelineCache::destroy() {
+		if (mPipelineCache == VK_NULL_HANDLE) {
+			return;
+		}
+
+		save();
+		vkDestroyPipelineCache(mDevice, mPipelineCache, nullptr);
+		mPipelineCache = VK_NULL_HANDLE;
+	}
+
+	void PipelineCache::save() {
+		size_t dataSize = 0;
+		VkResult result = vkGetPipelineCacheData(mDevice, mPipelineCache, &dataSize, nullptr);
+		if (result != VK_SUCCESS || dataSize == 0) {
+			return;
+		}
+
+		std::vector<char> fileData(sizeof(CacheFileHeader) + dataSize);
+		result = vkGetPipelineCacheData(mDevice, mPipelineCache, &dataSize, fileData.data() + sizeof(CacheFileHeader));
+		if (result != VK_SUCCESS) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to read back pipeline cache data");
+			return;
+		}
+		fileData.resize(sizeof(CacheFileHeader) + dataSize);
+
+		CacheFileHeader header{};
+		header.magic = PipelineCacheMagic;
+		header.version = PipelineCacheVersion;
+		header.vendorID = mProperties.vendorID;
+		header.deviceID = mProperties.deviceID;
+		header.driverVersion = mProperties.driverVersion;
+		std::memcpy(header.pipelineCacheUUID, mProperties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = dataSize;
+		header.dataHash = Utils::hash64(fileData.data() + sizeof(CacheFileHeader), dataSize);
+		std::memcpy(fileData.data(), &header, sizeof(header));
+
+		// Rename over the old file so an interrupted write can never leave a torn cache behind
+		fs::path tempPath = mCachePath;
+		tempPath += ".tmp";
+		Utils::FileUtils::writeBinaryFile(tempPath, fileData);
+
+		std::error_code error;
+		fs::rename(tempPath, mCachePath, error);
+		if (error) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to replace pipeline cache: " + error.message());
+			return;
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Saved pipeline cache (" + std::to_string(dataSize) + " bytes)");
+	}
+
+	VkResult PipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline& pipeline) {
+		VkPipelineCreationFeedback feedback{};
+		VkPipelineCreationFeedbackCreateInfo feedbackInfo{};
+		feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+		feedbackInfo.pNext = createInfo.pNext;
+		feedbackInfo.pPipelineCreationFeedback = &feedback;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = createInfo;
+		if (mCreationFeedback) {
+			pipelineInfo.pNext = &feedbackInfo;
+		}
+
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		VkResult result = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+		double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		if (result == VK_SUCCESS) {
+			recordCreation(feedback, createMs);
+		}
+		return result;
+	}
+
+	VkResult PipelineCache::createComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline& pipeline) {
+		VkPipelineCreationFeedback feedback{};
+		VkPipelineCreationFeedbackCreateInfo feedbackInfo{};
+		feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+		feedbackInfo.pNext = createInfo.pNext;
+		feedbackInfo.pPipelineCreationFeedback = &feedback;
+
+		VkComputePipelineCreateInfo pipelineInfo = createInfo;
+		if (mCreationFeedback) {
+			pipelineInfo.pNext = &feedbackInfo;
+		}
+
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		VkResult result = vkCreateComputePipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+		double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		if (result == VK_SUCCESS) {
+			recordCreation(feedback, createMs);
+		}
+		return result;
+	}
+
+	PipelineCacheStats PipelineCache::getStats() {
+		std::lock_guard lock(mMutex);
+		return mStats;
+	}
+
+	void PipelineCache::logStats() {
+		PipelineCacheStats stats = getStats();
+
+		std::string message = "Pipeline cache: " + std::to_string(stats.pipelineCount) + " pipelines in " +
+		                      std::to_string(stats.totalCreateMs) + " ms, " + std::to_string(stats.cacheHits) + " hits, " +
+		                      std::to_string(stats.cacheMisses) + " misses";
+		if (stats.unknown != 0) {
+			message += ", " + std::to_string(stats.unknown) + " without creation feedback";
+		}
+
+		SpConsole::Write(SP_MESSAGE_INFO, message);
+	}
+
+	Utils::MappedFile PipelineCache::readCacheFile() const {
+		if (!fs::exists(mCachePath)) {
+			return {};
+		}
+
+		// Hashing reads it front to back, then the driver does the same
+		Utils::MappedFile cacheFile = Utils::FileUtils::mapFile(mCachePath, SP_FILE_ACCESS_SEQUENTIAL);
+		if (!validateCacheFile(cacheFile.data())) {
+			return {};
+		}
+
+		return cacheFile;
+	}
+
+	bool PipelineCache::validateCacheFile(std::span<const char> fileData) const {
+		if (fileData.size() < sizeof(CacheFileHeader) + sizeof(VkPipelineCacheHeaderVersionOne)) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Pipeline cache is truncated, ignoring it");
+			return false;
+		}
+
+		CacheFileHeader header{};
+		std::memcpy(&header, fileData.data(), sizeof(header));
+
+		if (header.magic != PipelineCacheMagic || header.version != PipelineCacheVersion) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Pipeline cache has an unknown format, ignoring it");
+			return false;
+		}
+
+		size_t dataSize = fileData.size() - sizeof(CacheFileHeader);
+		const char* data = fileData.data() + sizeof(CacheFileHeader);
+		if (header.dataSize != dataSize || header.dataHash != Utils::hash64(data, dataSize)) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Pipeline cache is corrupt, ignoring it");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool PipelineCache::matchesDevice(std::span<const char> fileData) const {
+		CacheFileHeader header{};
+		std::memcpy(&header, fileData.data(), sizeof(header));
+
+		if (header.vendorID != mProperties.vendorID ||
+		    header.deviceID != mProperties.deviceID ||
+		    header.driverVersion != mProperties.driverVersion ||
+		    std::memcmp(header.pipelineCacheUUID, mProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			SpConsole::Write(SP_MESSAGE_INFO, "Pipeline cache was made by another device or driver, ignoring it");
+			return false;
+		}
+
+		const char* data = fileData.data() + sizeof(CacheFileHeader);
+
+		// Check the header the driver wrote as well, in case the file was copied around by hand
+		VkPipelineCacheHeaderVersionOne driverHeader{};
+		std::memcpy(&driverHeader, data, sizeof(driverHeader));
+		if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		    driverHeader.vendorID != mProperties.vendorID ||
+		    driverHeader.deviceID != mProperties.deviceID ||
+		    std::memcmp(driverHeader.pipelineCacheUUID, mProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Pipeline cache data does not match this device, ignoring it");
+			return false;
+		}
+
+		return true;
+	}
+
+	void PipelineCache::recordCreation(const VkPipelineCreationFeedback& feedback, double createMs) {
+		std::lock_guard lock(mMutex);
+
+		mStats.pipelineCount++;
+		mStats.totalCreateMs += createMs;
+
+		if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) {
+			mStats.unknown++;
+		}else if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) {
+			mStats.cacheHits++;
+		}else {
+			mStats.cacheMisses++;
+		}
+	}
+} // SpRenderer
@@ -0,0 +1,607 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "PipelineRegistry.h"
+#include "Profiler.h"
+
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace SpRenderer {
+	// 'SPPU'
+	const uint32 PipelineUsageMagic = 0x55505053;
+	// Bump when GraphicsPipelineDesc::serialize changes
+	const uint32 PipelineUsageVersion = 1;
+
+	namespace {
+		template<typename T>
+		void write(std::vector<char>& data, const T& value) {
+			const char* bytes = reinterpret_cast<const char*>(&value);
+			data.insert(data.end(), bytes, bytes + sizeof(T));
+		}
+
+		void writeString(std::vector<char>& data, const std::string& string) {
+			write(data, static_cast<uint32>(string.size()));
+			data.insert(data.end(), string.begin(), string.end());
+		}
+
+		template<typename T>
+		void writeVector(std::vector<char>& data, const std::vector<T>& values) {
+			write(data, static_cast<uint32>(values.size()));
+			for (const T& value : values) {
+				write(data, value);
+			}
+		}
+
+		template<typename T>
+		bool read(std::span<const char> data, size_t& offset, T& value) {
+			if (data.size() - offset < sizeof(T)) {
+				return false;
+			}
+			std::memcpy(&value, data.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+
+		bool readString(std::span<const char> data, size_t& offset, std::string& string) {
+			uint32 size = 0;
+			if (!read(data, offset, size) || data.size() - offset < size) {
+				return false;
+			}
+			string.assign(data.data() + offset, size);
+			offset += size;
+			return true;
+		}
+
+		template<typename T>
+		bool readVector(std::span<const char> data, size_t& offset, std::vector<T>& values) {
+			uint32 count = 0;
+			if (!read(data, offset, count) || (data.size() - offset) / sizeof(T) < count) {
+				return false;
+			}
+			values.resize(count);
+			for (T& value : values) {
+				read(data, offset, value);
+			}
+			return true;
+		}
+
+		VkPipelineColorBlendAttachmentState blendAttachment(PipelineBlendMode blendMode) {
+			VkPipelineColorBlendAttachmentState attachment{};
+			attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+			                            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+			attachment.colorBlendOp = VK_BLEND_OP_ADD;
+			attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+			switch (blendMode) {
+				case SP_BLEND_MODE_OPAQUE:
+					attachment.blendEnable = VK_FALSE;
+					break;
+				case SP_BLEND_MODE_ALPHA:
+					attachment.blendEnable = VK_TRUE;
+					attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+					attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+					attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+					attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+					break;
+				case SP_BLEND_MODE_PREMULTIPLIED_ALPHA:
+					attachment.blendEnable = VK_TRUE;
+					attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+					attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+					attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+					attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+					break;
+				case SP_BLEND_MODE_ADDITIVE:
+					attachment.blendEnable = VK_TRUE;
+					attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+					attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+					attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+					attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+					break;
+			}
+
+			return attachment;
+		}
+	}
+
+#pragma region GraphicsPipelineDesc
+
+	PipelineKey GraphicsPipelineDesc::key() const {
+		std::vector<char> data;
+		serialize(data);
+		return Utils::hash64(data.data(), data.size());
+	}
+
+	void GraphicsPipelineDesc::serialize(std::vector<char>& data) const {
+		writeString(data, vertexShader);
+		writeString(data, fragmentShader);
+		writeString(data, layout);
+
+		writeVector(data, vertexBindings);
+		writeVector(data, vertexAttributes);
+
+		write(data, topology);
+		write(data, cullMode);
+		write(data, frontFace);
+		write(data, blendMode);
+
+		write(data, static_cast<uint32>(depthTest));
+		write(data, static_cast<uint32>(depthWrite));
+		write(data, depthCompareOp);
+
+		writeVector(data, colorFormats);
+		write(data, depthFormat);
+
+		writeVector(data, specializationConstants);
+	}
+
+	bool GraphicsPipelineDesc::deserialize(std::span<const char> data, size_t& offset) {
+		uint32 depthTestValue = 0;
+		uint32 depthWriteValue = 0;
+
+		bool valid = readString(data, offset, vertexShader) &&
+		             readString(data, offset, fragmentShader) &&
+		             readString(data, offset, layout) &&
+		             readVector(data, offset, vertexBindings) &&
+		             readVector(data, offset, vertexAttributes) &&
+		             read(data, offset, topology) &&
+		             read(data, offset, cullMode) &&
+		             read(data, offset, frontFace) &&
+		             read(data, offset, blendMode) &&
+		             read(data, offset, depthTestValue) &&
+		             read(data, offset, depthWriteValue) &&
+		             read(data, offset, depthCompareOp) &&
+		             readVector(data, offset, colorFormats) &&
+		             read(data, offset, depthFormat) &&
+		             readVector(data, offset, specializationConstants);
+
+		depthTest = depthTestValue != 0;
+		depthWrite = depthWriteValue != 0;
+		return valid;
+	}
+
+#pragma endregion GraphicsPipelineDesc
+
+	void PipelineRegistry::init(VkDevice device,
+	                            PipelineCache& pipelineCache,
+	                            const ShaderLibrary& shaderLibrary,
+	                            JobSystem& jobSystem,
+	                            RenderGraph& renderGraph) {
+		mDevice = device;
+		mPipelineCache = &pipelineCache;
+		mShaderLibrary = &shaderLibrary;
+		mJobSystem = &jobSystem;
+		mRenderGraph = &renderGraph;
+
+		mUsagePath = fs::path(RENDERER_DATA_DIR) / PIPELINE_USAGE_FILE_NAME;
+	}
+
+	void PipelineRegistry::destroy() {
+		if (mDevice == VK_NULL_HANDLE) {
+			return;
+		}
+
+		// Compiles read the entries, nothing can be torn down under them
+		for (auto& [key, entry] : mEntries) {
+			mJobSystem->wait(entry->counter);
+		}
+
+		saveUsage();
+
+		std::unique_lock lock(mMutex);
+		for (auto& [key, entry] : mEntries) {
+			VkPipeline pipeline = entry->pipeline.load(std::memory_order_acquire);
+			if (pipeline != VK_NULL_HANDLE) {
+				vkDestroyPipeline(mDevice, pipeline, nullptr);
+			}
+		}
+		mEntries.clear();
+		mLayouts.clear();
+		mDevice = VK_NULL_HANDLE;
+	}
+
+	void PipelineRegistry::registerLayout(const std::string& name, VkPipelineLayout layout) {
+		std::unique_lock lock(mMutex);
+		mLayouts[name] = layout;
+	}
+
+	PipelineKey PipelineRegistry::request(const GraphicsPipelineDesc& desc) {
+		return request(desc, false);
+	}
+
+	VkPipeline PipelineRegistry::get(PipelineKey key, VkPipeline fallback) const {
+		std::shared_lock lock(mMutex);
+
+		auto it = mEntries.find(key);
+		if (it == mEntries.end()) {
+			return fallback;
+		}
+
+		VkPipeline pipeline = it->second->pipeline.load(std::memory_order_acquire);
+		return pipeline != VK_NULL_HANDLE ? pipeline : fallback;
+	}
+
+	PipelineState PipelineRegistry::getState(PipelineKey key) const {
+		std::shared_lock lock(mMutex);
+
+		auto it = mEntries.find(key);
+		if (it == mEntries.end()) {
+			return SP_PIPELINE_STATE_FAILED;
+		}
+		return it->second->state.load(std::memory_order_acquire);
+	}
+
+	VkPipeline PipelineRegistry::wait(PipelineKey key) {
+		Entry* entry = nullptr;
+		{
+			std::shared_lock lock(mMutex);
+			auto it = mEntries.find(key);
+			if (it == mEntries.end()) {
+				SpConsole::FatalExit("Waited on a pipeline that was never requested", SP_FAILURE);
+			}
+			entry = it->second.get();
+		}
+
+		// Entries are never removed before destroy(), the pointer stays valid without the lock
+		mJobSystem->wait(entry->counter);
+
+		if (entry->state.load(std::memory_order_acquire) != SP_PIPELINE_STATE_READY) {
+			SpConsole::FatalExit("Pipeline " + entry->desc.vertexShader + " + " + entry->desc.fragmentShader +
+			                     " failed to compile", SP_FAILURE);
+		}
+		return entry->pipeline.load(std::memory_order_acquire);
+	}
+
+	uint32 PipelineRegistry::prewarm() {
+		SP_PROFILE_ZONE("PipelineRegistry::prewarm");
+
+		uint32 queued = 0;
+		uint32 dropped = 0;
+		for (const GraphicsPipelineDesc& desc : loadUsage()) {
+			std::string error;
+			if (resolveLayout(desc, error) == VK_NULL_HANDLE) {
+				SP_LOG(SP_MESSAGE_VERBOSE, "Not prewarming pipeline: " + error);
+				dropped++;
+				continue;
+			}
+
+			request(desc, true);
+			queued++;
+		}
+
+		if (queued != 0 || dropped != 0) {
+			SpConsole::Write(SP_MESSAGE_INFO, "Prewarming " + std::to_string(queued) + " pipelines (" +
+			                                  std::to_string(dropped) + " stale descriptions dropped)");
+		}
+		return queued;
+	}
+
+	PipelineRegistryStats PipelineRegistry::getStats() const {
+		std::shared_lock lock(mMutex);
+
+		PipelineRegistryStats stats{};
+		stats.pipelineCount = static_cast<uint32>(mEntries.size());
+		for (const auto& [key, entry] : mEntries) {
+			switch (entry->state.load(std::memory_order_acquire)) {
+				case SP_PIPELINE_STATE_PENDING:
+					stats.pendingCount++;
+					break;
+				case SP_PIPELINE_STATE_READY:
+					stats.readyCount++;
+					stats.totalCompileMs += entry->compileMs;
+					break;
+				case SP_PIPELINE_STATE_FAILED:
+					stats.failedCount++;
+					break;
+			}
+			if (entry->prewarmed) {
+				stats.prewarmedCount++;
+			}
+		}
+		return stats;
+	}
+
+	void PipelineRegistry::logStats() const {
+		PipelineRegistryStats stats = getStats();
+		SpConsole::Write(SP_MESSAGE_INFO, "Pipeline registry: " + std::to_string(stats.pipelineCount) + " pipelines (" +
+		                                  std::to_string(stats.readyCount) + " ready, " +
+		                                  std::to_string(stats.pendingCount) + " compiling, " +
+		                                  std::to_string(stats.failedCount) + " failed, " +
+		                                  std::to_string(stats.prewarmedCount) + " only prewarmed), " +
+		                                  std::to_string(stats.totalCompileMs) + " ms compiling");
+	}
+
+	VkPipelineLayout PipelineRegistry::resolveLayout(const GraphicsPipelineDesc& desc, std::string& error) const {
+		if (mShaderLibrary->findShader(desc.vertexShader) == nullptr) {
+			error = "no shader " + desc.vertexShader;
+			return VK_NULL_HANDLE;
+		}
+		if (mShaderLibrary->findShader(desc.fragmentShader) == nullptr) {
+			error = "no shader " + desc.fragmentShader;
+			return VK_NULL_HANDLE;
+		}
+
+		std::shared_lock lock(mMutex);
+		auto it = mLayouts.find(desc.layout);
+		if (it == mLayouts.end()) {
+			error = "no layout " + desc.layout;
+			return VK_NULL_HANDLE;
+		}
+		return it->second;
+	}
+
+	PipelineKey PipelineRegistry::request(const GraphicsPipelineDesc& desc, bool prewarm) {
+		PipelineKey key = desc.key();
+
+		{
+			std::shared_lock lock(mMutex);
+			auto it = mEntries.find(key);
+			if (it != mEntries.end()) {
+				// Racing with another request only ever clears the flag, which is what both of them want
+				if (!prewarm) {
+					it->second->prewarmed = false;
+				}
+				return key;
+			}
+		}
+
+		std::string error;
+		VkPipelineLayout layout = resolveLayout(desc, error);
+		if (layout == VK_NULL_HANDLE) {
+			SpConsole::FatalExit("Can't create pipeline, " + error, SP_FAILURE);
+		}
+
+		// The formats are part of the key, so every description gets a render pass it is actually used with
+		VkRenderPass renderPass = mRenderGraph->compatibleRenderPass(desc.colorFormats, desc.depthFormat);
+
+		std::unique_lock lock(mMutex);
+		auto [it, inserted] = mEntries.try_emplace(key);
+		if (!inserted) {
+			// Another thread requested it between the two locks
+			if (!prewarm) {
+				it->second->prewarmed = false;
+			}
+			return key;
+		}
+
+		it->second = std::make_unique<Entry>();
+		Entry* entry = it->second.get();
+		entry->desc = desc;
+		entry->layout = layout;
+		entry->renderPass = renderPass;
+		entry->prewarmed = prewarm;
+
+		// Queued under the lock so the counter is raised before anyone else can find the entry and wait on it
+		mJobSystem->run([this, entry] { compile(*entry); }, &entry->counter);
+		return key;
+	}
+
+	void PipelineRegistry::compile(Entry& entry) {
+		SP_PROFILE_ZONE("PipelineRegistry::compile");
+
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		const GraphicsPipelineDesc& desc = entry.desc;
+
+		const ShaderModuleInfo* vertexShader = mShaderLibrary->findShader(desc.vertexShader);
+		const ShaderModuleInfo* fragmentShader = mShaderLibrary->findShader(desc.fragmentShader);
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32>(desc.vertexBindings.size());
+		vertexInputInfo.pVertexBindingDescriptions = desc.vertexBindings.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32>(desc.vertexAttributes.size());
+		vertexInputInfo.pVertexAttributeDescriptions = desc.vertexAttributes.data();
+
+		// Catches vertex layouts drifting from the shader before the driver reads garbage attributes
+		std::string vertexInputError;
+		if (!vertexShader->reflection.validateVertexInput(vertexInputInfo, vertexInputError)) {
+			SpConsole::Write(SP_MESSAGE_ERROR, desc.vertexShader + ": " + vertexInputError);
+			entry.state.store(SP_PIPELINE_STATE_FAILED, std::memory_order_release);
+			return;
+		}
+
+		//-------------------//
+
+		std::vector<VkSpecializationMapEntry> specializationEntries(desc.specializationConstants.size());
+		for (uint32 i = 0; i < specializationEntries.size(); i++) {
+			specializationEntries[i].constantID = desc.specializationConstants[i].id;
+			specializationEntries[i].offset = i * sizeof(SpecializationConstant) + offsetof(SpecializationConstant, value);
+			specializationEntries[i].size = sizeof(uint32);
+		}
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32>(specializationEntries.size());
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = desc.specializationConstants.size() * sizeof(SpecializationConstant);
+		specializationInfo.pData = desc.specializationConstants.data();
+
+		const VkSpecializationInfo* specialization = specializationEntries.empty() ? nullptr : &specializationInfo;
+
+		VkPipelineShaderStageCreateInfo vertexStageInfo{};
+		vertexStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		vertexStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		vertexStageInfo.module = vertexShader->module;
+		vertexStageInfo.pName = "main";
+		vertexStageInfo.pSpecializationInfo = specialization;
+
+		VkPipelineShaderStageCreateInfo fragmentStageInfo{};
+		fragmentStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		fragmentStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		fragmentStageInfo.module = fragmentShader->module;
+		fragmentStageInfo.pName = "main";
+		fragmentStageInfo.pSpecializationInfo = specialization;
+
+		std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages = {vertexStageInfo, fragmentStageInfo};
+
+		//-------------------//
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = desc.topology;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		// Viewport and scissor are set while recording so the pipeline survives swapchain resizes
+		std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = static_cast<uint32>(dynamicStates.size());
+		dynamicState.pDynamicStates = dynamicStates.data();
+
+		VkPipelineViewportStateCreateInfo viewportState{};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = desc.cullMode;
+		rasterizer.frontFace = desc.frontFace;
+		rasterizer.depthBiasEnable = VK_FALSE;
+
+		VkPipelineMultisampleStateCreateInfo multisampling{};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+		depthStencil.depthCompareOp = desc.depthCompareOp;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.stencilTestEnable = VK_FALSE;
+
+		std::vector<VkPipelineColorBlendAttachmentState> blendAttachments(desc.colorFormats.size(), blendAttachment(desc.blendMode));
+
+		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.attachmentCount = static_cast<uint32>(blendAttachments.size());
+		colorBlending.pAttachments = blendAttachments.data();
+
+		//-------------------//
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = static_cast<uint32>(shaderStages.size());
+		pipelineInfo.pStages = shaderStages.data();
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.layout = entry.layout;
+		pipelineInfo.renderPass = entry.renderPass;
+		pipelineInfo.subpass = 0;
+
+		// Without a render pass the attachment formats come from the description
+		bool depthHasStencil = desc.depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || desc.depthFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+
+		VkPipelineRenderingCreateInfo renderingCreateInfo{};
+		renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		renderingCreateInfo.colorAttachmentCount = static_cast<uint32>(desc.colorFormats.size());
+		renderingCreateInfo.pColorAttachmentFormats = desc.colorFormats.data();
+		renderingCreateInfo.depthAttachmentFormat = desc.depthFormat;
+		renderingCreateInfo.stencilAttachmentFormat = depthHasStencil ? desc.depthFormat : VK_FORMAT_UNDEFINED;
+
+		if (entry.renderPass == VK_NULL_HANDLE) {
+			pipelineInfo.pNext = &renderingCreateInfo;
+		}
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkResult result = mPipelineCache->createGraphicsPipeline(pipelineInfo, pipeline);
+
+		entry.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		if (result != VK_SUCCESS) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to create pipeline " + desc.vertexShader + " + " + desc.fragmentShader +
+			                                   " (VkResult " + std::to_string(result) + ")");
+			entry.state.store(SP_PIPELINE_STATE_FAILED, std::memory_order_release);
+			return;
+		}
+
+		entry.pipeline.store(pipeline, std::memory_order_release);
+		entry.state.store(SP_PIPELINE_STATE_READY, std::memory_order_release);
+		SP_LOG(SP_MESSAGE_VERBOSE, "Compiled pipeline " + desc.vertexShader + " + " + desc.fragmentShader + " in " +
+		                           std::to_string(entry.compileMs) + " ms");
+	}
+
+	std::vector<GraphicsPipelineDesc> PipelineRegistry::loadUsage() const {
+		std::vector<GraphicsPipelineDesc> descs;
+		if (!fs::exists(mUsagePath)) {
+			return descs;
+		}
+
+		Utils::MappedFile file = Utils::FileUtils::mapFile(mUsagePath, SP_FILE_ACCESS_SEQUENTIAL);
+		std::span<const char> data = file.data();
+
+		size_t offset = 0;
+		PipelineUsageHeader header{};
+		if (!read(data, offset, header) || header.magic != PipelineUsageMagic || header.version != PipelineUsageVersion) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Ignoring pipeline usage list from another version");
+			return descs;
+		}
+
+		// A description with empty strings and vectors is the smallest there is, a count beyond what the rest of the
+		// file could hold comes from a corrupt file and must not size the allocation
+		std::vector<char> emptyDesc;
+		GraphicsPipelineDesc{}.serialize(emptyDesc);
+		if (header.count > (data.size() - offset) / emptyDesc.size()) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Pipeline usage list is truncated, ignoring it");
+			return descs;
+		}
+
+		descs.resize(header.count);
+		for (GraphicsPipelineDesc& desc : descs) {
+			if (!desc.deserialize(data, offset)) {
+				SpConsole::Write(SP_MESSAGE_WARNING, "Pipeline usage list is truncated, ignoring it");
+				return {};
+			}
+		}
+		return descs;
+	}
+
+	void PipelineRegistry::saveUsage() const {
+		std::vector<char> data;
+		PipelineUsageHeader header{};
+		header.magic = PipelineUsageMagic;
+		header.version = PipelineUsageVersion;
+		write(data, header);
+
+		{
+			std::shared_lock lock(mMutex);
+			for (const auto& [key, entry] : mEntries) {
+				if (entry->prewarmed || entry->state.load(std::memory_order_acquire) != SP_PIPELINE_STATE_READY) {
+					continue;
+				}
+				entry->desc.serialize(data);
+				header.count++;
+			}
+		}
+		std::memcpy(data.data(), &header, sizeof(header));
+
+		// Rename over the old list so an interrupted write never leaves a torn one behind
+		fs::path tempPath = mUsagePath;
+		tempPath += ".tmp";
+		Utils::FileUtils::writeBinaryFile(tempPath, data);
+
+		std::error_code error;
+		fs::rename(tempPath, mUsagePath, error);
+		if (error) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to replace pipeline usage list: " + error.message());
+			return;
+		}
+
+		SP_LOG(SP_MESSAGE_VERBOSE, "Saved pipeline usage list with " + std::to_string(header.count) + " pipelines");
+	}
+} // SpRenderer
@@ -0,0 +1,124 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "GpuProfiler.h"
+
+namespace SpRenderer {
+	void GpuProfiler::init(VkDevice device,
+	                       uint32 queueFamilyIndex,
+	                       uint32 timestampValidBits,
+	                       const VkPhysicalDeviceLimits& limits,
+	                       uint32 framesInFlight) {
+		mDevice = device;
+		mTimestampPeriod = static_cast<double>(limits.timestampPeriod);
+
+		mSupported = timestampValidBits != 0 && limits.timestampPeriod > 0.0f;
+		if (!mSupported) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Queue family " + std::to_string(queueFamilyIndex) + " has no timestamps, GPU zones are off");
+			return;
+		}
+		mTimestampMask = timestampValidBits >= 64 ? std::numeric_limits<uint64>::max() : (1ull << timestampValidBits) - 1;
+
+		VkQueryPoolCreateInfo queryPoolCreateInfo{};
+		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = MaxGpuZonesPerFrame * 2;
+
+		mFrames.resize(framesInFlight);
+		for (FrameQueries& frame : mFrames) {
+			VkResult result = vkCreateQueryPool(mDevice, &queryPoolCreateInfo, nullptr, &frame.queryPool);
+			SpConsole::VulkanExitCheck(result, "Failed to create timestamp query pool!", SP_FAILURE);
+			frame.zoneNames.reserve(MaxGpuZonesPerFrame);
+		}
+		mTimestamps.resize(MaxGpuZonesPerFrame * 2);
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Created GPU profiler, " + std::to_string(limits.timestampPeriod) + " ns per tick, " +
+		                                  std::to_string(timestampValidBits) + " valid bits");
+	}
+
+	void GpuProfiler::destroy() {
+		for (FrameQueries& frame : mFrames) {
+			vkDestroyQueryPool(mDevice, frame.queryPool, nullptr);
+		}
+		mFrames.clear();
+		mSupported = false;
+	}
+
+	void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32 frameIndex) {
+		if (!mSupported) {
+			return;
+		}
+
+		mCurrentFrame = frameIndex;
+		FrameQueries& frame = mFrames[frameIndex];
+		if (frame.active) {
+			collect(frame);
+		}
+
+		frame.zoneNames.clear();
+		frame.active = Profiler::enabled();
+		if (frame.active) {
+			vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, MaxGpuZonesPerFrame * 2);
+		}
+	}
+
+	void GpuProfiler::markSubmit(uint32 frameIndex) {
+		if (!mSupported) {
+			return;
+		}
+		mFrames[frameIndex].submitNs = Profiler::get().nowNs();
+	}
+
+	GpuZone GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name) {
+		if (!mSupported) {
+			return InvalidGpuZone;
+		}
+
+		FrameQueries& frame = mFrames[mCurrentFrame];
+		if (!frame.active || frame.zoneNames.size() == MaxGpuZonesPerFrame) {
+			return InvalidGpuZone;
+		}
+
+		GpuZone zone = static_cast<GpuZone>(frame.zoneNames.size());
+		frame.zoneNames.push_back(name);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, zone * 2);
+		return zone;
+	}
+
+	void GpuProfiler::endZone(VkCommandBuffer commandBuffer, GpuZone zone) {
+		if (zone == InvalidGpuZone) {
+			return;
+		}
+
+		FrameQueries& frame = mFrames[mCurrentFrame];
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, zone * 2 + 1);
+	}
+
+	void GpuProfiler::collect(FrameQueries& frame) {
+		frame.active = false;
+		if (frame.zoneNames.empty()) {
+			return;
+		}
+
+		uint32 queryCount = static_cast<uint32>(frame.zoneNames.size()) * 2;
+		// The frame's fence was waited on, so no WAIT_BIT. NOT_READY means the frame was never submitted
+		VkResult result = vkGetQueryPoolResults(mDevice, frame.queryPool, 0, queryCount, queryCount * sizeof(uint64),
+		                                        mTimestamps.data(), sizeof(uint64), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS) {
+			return;
+		}
+
+		uint64 firstTick = mTimestamps[0] & mTimestampMask;
+		auto toCpuNs = [&](uint64 tick) {
+			// Masked difference handles the counter wrapping within the frame
+			uint64 ticks = ((tick & mTimestampMask) - firstTick) & mTimestampMask;
+			return frame.submitNs + static_cast<uint64>(static_cast<double>(ticks) * mTimestampPeriod);
+		};
+
+		Profiler& profiler = Profiler::get();
+		for (uint32 zone = 0; zone < frame.zoneNames.size(); zone++) {
+			profiler.recordGpuZone(frame.zoneNames[zone], toCpuNs(mTimestamps[zone * 2]), toCpuNs(mTimestamps[zone * 2 + 1]));
+		}
+	}
+} // SpRenderer
@@ -0,0 +1,176 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Profiler.h"
+
+namespace fs = std::filesystem;
+
+namespace SpRenderer {
+	namespace {
+		thread_local std::shared_ptr<ProfileBuffer> tThreadBuffer;
+
+		void appendJsonString(std::string& json, std::string_view text) {
+			json += '"';
+			for (char c : text) {
+				if (c == '"' || c == '\\') {
+					json += '\\';
+				}
+				json += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+			}
+			json += '"';
+		}
+
+		void appendThreadName(std::string& json, uint32 threadId, const std::string& name) {
+			json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(threadId) + ",\"args\":{\"name\":";
+			appendJsonString(json, name);
+			json += "}},\n";
+		}
+
+		// Chrome traces are in microseconds, fractions keep the nanoseconds
+		void appendEvent(std::string& json, uint32 threadId, const ProfileEvent& event) {
+			json += "{\"name\":";
+			appendJsonString(json, event.name);
+			json += ",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(threadId) +
+			        ",\"ts\":" + std::to_string(static_cast<double>(event.startNs) / 1000.0) +
+			        ",\"dur\":" + std::to_string(static_cast<double>(event.endNs - event.startNs) / 1000.0) + "},\n";
+		}
+	}
+
+#pragma region ProfileBuffer
+	ProfileBuffer::ProfileBuffer(uint32 threadId, std::string name) : mThreadId(threadId), mName(std::move(name)) {}
+
+	ProfileBuffer::~ProfileBuffer() {
+		uint32 blockCount = mBlockCount.load(std::memory_order_acquire);
+		for (uint32 i = 0; i < blockCount; i++) {
+			delete mBlocks[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	bool ProfileBuffer::push(const ProfileEvent& event) {
+		uint32 blockCount = mBlockCount.load(std::memory_order_relaxed);
+		Block* block = blockCount == 0 ? nullptr : mBlocks[blockCount - 1].load(std::memory_order_relaxed);
+
+		if (block == nullptr || block->count.load(std::memory_order_relaxed) == ProfileBlockSize) {
+			if (blockCount == MaxProfileBlocksPerThread) {
+				return false;
+			}
+
+			block = new Block();
+			mBlocks[blockCount].store(block, std::memory_order_release);
+			mBlockCount.store(blockCount + 1, std::memory_order_release);
+		}
+
+		uint32 count = block->count.load(std::memory_order_relaxed);
+		block->events[count] = event;
+		block->count.store(count + 1, std::memory_order_release);
+		return true;
+	}
+
+	void ProfileBuffer::setName(std::string name) {
+		mName = std::move(name);
+	}
+#pragma endregion
+
+#pragma region Profiler
+	Profiler& Profiler::get() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	Profiler::Profiler() : mStartTime(std::chrono::steady_clock::now()), mGpuBuffer(GpuProfileThreadId, "GPU") {}
+
+	void Profiler::setEnabled(bool enabled) {
+		sEnabled.store(enabled, std::memory_order_relaxed);
+		SpConsole::Write(SP_MESSAGE_INFO, enabled ? "Profiler enabled" : "Profiler disabled");
+	}
+
+	uint64 Profiler::nowNs() const {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStartTime).count();
+	}
+
+	void Profiler::recordZone(const char* name, uint64 startNs, uint64 endNs) {
+		if (!threadBuffer().push({name, startNs, endNs})) {
+			mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void Profiler::recordGpuZone(const char* name, uint64 startNs, uint64 endNs) {
+		if (!mGpuBuffer.push({name, startNs, endNs})) {
+			mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void Profiler::setThreadName(const std::string& name) {
+		ProfileBuffer& buffer = threadBuffer();
+
+		std::lock_guard lock(mBufferMutex);
+		buffer.setName(name);
+	}
+
+	bool Profiler::exportChromeTrace(const fs::path& filePath) {
+		std::vector<std::shared_ptr<ProfileBuffer>> buffers;
+		std::string json = "{\"traceEvents\":[\n";
+		{
+			std::lock_guard lock(mBufferMutex);
+			buffers = mBuffers;
+			for (const std::shared_ptr<ProfileBuffer>& buffer : buffers) {
+				appendThreadName(json, buffer->threadId(), buffer->name());
+			}
+		}
+		appendThreadName(json, mGpuBuffer.threadId(), mGpuBuffer.name());
+
+		uint64 eventCount = 0;
+		auto appendBuffer = [&](const ProfileBuffer& buffer) {
+			buffer.forEach([&](const ProfileEvent& event) {
+				appendEvent(json, buffer.threadId(), event);
+				eventCount++;
+			});
+		};
+		for (const std::shared_ptr<ProfileBuffer>& buffer : buffers) {
+			appendBuffer(*buffer);
+		}
+		appendBuffer(mGpuBuffer);
+
+		// Trailing comma of the last event
+		json.resize(json.size() - 2);
+		json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		std::error_code error;
+		fs::create_directories(filePath.parent_path(), error);
+		if (error) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "Failed to create " + filePath.parent_path().string() + ": " + error.message());
+			return false;
+		}
+
+		Utils::FileUtils::writeTextFile(filePath, json);
+		SpConsole::Write(SP_MESSAGE_INFO, "Wrote " + std::to_string(eventCount) + " profile events to " + filePath.string());
+		return true;
+	}
+
+	ProfilerStats Profiler::getStats() {
+		ProfilerStats stats;
+		stats.droppedCount = mDroppedCount.load(std::memory_order_relaxed);
+
+		auto countEvents = [&stats](const ProfileEvent&) { stats.eventCount++; };
+		mGpuBuffer.forEach(countEvents);
+
+		std::lock_guard lock(mBufferMutex);
+		for (const std::shared_ptr<ProfileBuffer>& buffer : mBuffers) {
+			buffer->forEach(countEvents);
+		}
+		stats.threadCount = mNextThreadId;
+		return stats;
+	}
+
+	ProfileBuffer& Profiler::threadBuffer() {
+		if (!tThreadBuffer) {
+			std::lock_guard lock(mBufferMutex);
+			uint32 threadId = mNextThreadId++;
+			tThreadBuffer = std::make_shared<ProfileBuffer>(threadId, "Thread " + std::to_string(threadId));
+			mBuffers.push_back(tThreadBuffer);
+		}
+		return *tThreadBuffer;
+	}
+#pragma endregion
+} // SpRenderer
@@ -0,0 +1,624 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "GpuScene.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace SpRenderer {
+	namespace {
+		// Push constants of Cull.comp
+		struct CullConstants {
+			std::array<vec4, 6> planes;
+			uint32 objectCount;
+			BindlessIndex objectBuffer;
+			BindlessIndex meshBuffer;
+			BindlessIndex commandBuffer;
+			BindlessIndex countBuffer;
+			VkBool32 compact; // Visible draws packed to the front and counted, otherwise one draw per object
+		};
+		static_assert(sizeof(CullConstants) == 120);
+
+		// Push constants of Mesh.vert
+		struct MeshConstants {
+			mat4 viewProjection;
+			BindlessIndex objectBuffer;
+		};
+		static_assert(sizeof(MeshConstants) == 68);
+
+		// Positions are stored divided by the mesh's scale, the transform multiplies it back in
+		mat4 packedTransform(const mat4& transform, float positionScale) {
+			mat4 packed = transform;
+			packed[0] *= positionScale;
+			packed[1] *= positionScale;
+			packed[2] *= positionScale;
+			return packed;
+		}
+	}
+
+	void GpuScene::init(VkDevice device,
+	                    MemoryAllocator& allocator,
+	                    UploadManager& uploadManager,
+	                    BindlessTable& bindlessTable,
+	                    uint32 framesInFlight,
+	                    IndirectDrawMode drawMode,
+	                    PFN_vkCmdDrawIndexedIndirectCount drawIndexedIndirectCount,
+	                    uint32 maxDrawIndirectCount) {
+		mDevice = device;
+		mAllocator = &allocator;
+		mUploadManager = &uploadManager;
+		mBindlessTable = &bindlessTable;
+		mFramesInFlight = framesInFlight;
+		mDrawMode = drawMode;
+		mDrawIndexedIndirectCount = drawIndexedIndirectCount;
+		mMaxDrawIndirectCount = maxDrawIndirectCount;
+
+		if (mDrawMode == SP_INDIRECT_DRAW_COUNT && mDrawIndexedIndirectCount == nullptr) {
+			SpConsole::FatalExit("vkCmdDrawIndexedIndirectCount is missing!", SP_FAILURE);
+		}
+
+		// The compacted draws share one count, they can't be split across calls like the multi draw ones
+		if (mDrawMode == SP_INDIRECT_DRAW_COUNT && mMaxDrawIndirectCount < std::numeric_limits<uint32>::max()) {
+			mMaxObjects = mMaxDrawIndirectCount;
+			SpConsole::Write(SP_MESSAGE_WARNING, "maxDrawIndirectCount limits the scene to " + std::to_string(mMaxObjects) + " objects");
+		}
+
+		createGeometryBuffers();
+
+		mFrames.resize(framesInFlight);
+		for (FrameBuffers& frame : mFrames) {
+			createBuffer(frame.count, sizeof(uint32),
+			             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+			reserveObjects(frame, InitialSceneObjectCapacity);
+			reserveMeshes(frame, InitialSceneMeshCapacity);
+		}
+
+		mObjects.reserve(InitialSceneObjectCapacity);
+	}
+
+	void GpuScene::destroy() {
+		releaseRetired(true);
+
+		for (FrameBuffers& frame : mFrames) {
+			for (SceneBuffer* buffer : {&frame.objects, &frame.meshes, &frame.commands, &frame.count}) {
+				if (buffer->buffer != VK_NULL_HANDLE) {
+					mBindlessTable->releaseBuffer(buffer->index);
+					mAllocator->destroyBuffer(buffer->buffer, buffer->allocation);
+				}
+			}
+		}
+		mFrames.clear();
+
+		if (mVertexBuffer != VK_NULL_HANDLE) {
+			mAllocator->destroyBuffer(mVertexBuffer, mVertexAllocation);
+			mVertexBuffer = VK_NULL_HANDLE;
+		}
+		if (mIndexBuffer != VK_NULL_HANDLE) {
+			mAllocator->destroyBuffer(mIndexBuffer, mIndexAllocation);
+			mIndexBuffer = VK_NULL_HANDLE;
+		}
+
+		mMeshes.clear();
+		mPendingMeshes.clear();
+		mMeshScales.clear();
+		mObjects.clear();
+		mObjectHandles.clear();
+		mObjectDirtyFrames.clear();
+		mHandleSlots.clear();
+		mFreeHandles.clear();
+		mStats = {};
+	}
+
+	void GpuScene::setPipelines(VkPipeline cullPipeline,
+	                            VkPipelineLayout cullLayout,
+	                            const PipelineRegistry& registry,
+	                            PipelineKey meshPipeline,
+	                            VkPipelineLayout meshLayout) {
+		mCullPipeline = cullPipeline;
+		mCullLayout = cullLayout;
+		mRegistry = &registry;
+		mMeshPipeline = meshPipeline;
+		mMeshLayout = meshLayout;
+	}
+
+	MeshHandle GpuScene::addMesh(std::span<const Vertex> vertices, std::span<const uint32> indices) {
+		// Same scale packVertex expects, the largest absolute coordinate maps to 1
+		float positionScale = 0.0f;
+		for (const Vertex& vertex : vertices) {
+			positionScale = std::max({positionScale, std::abs(vertex.position.x), std::abs(vertex.position.y), std::abs(vertex.position.z)});
+		}
+		if (positionScale == 0.0f) {
+			positionScale = 1.0f;
+		}
+
+		std::vector<VertexPacked> packed(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			packed[i] = packVertex(vertices[i], positionScale);
+		}
+
+		return addMesh(packed, indices, positionScale, boundingSphere(vertices));
+	}
+
+	MeshHandle GpuScene::addMesh(std::span<const VertexPacked> vertices,
+	                             std::span<const uint32> indices,
+	                             float positionScale,
+	                             vec4 boundingSphere) {
+		if (indices.empty()) {
+			SpConsole::FatalExit("Meshes need at least one triangle", SP_FAILURE);
+		}
+
+		uint32 firstVertex;
+		uint32 firstIndex;
+		UploadTicket ticket = uploadGeometry(vertices, indices, firstVertex, firstIndex);
+
+		GpuMesh resident{};
+		resident.boundingSphere = vec4(vec3(boundingSphere) / positionScale, boundingSphere.w / positionScale);
+		resident.indexCount = static_cast<uint32>(indices.size());
+		resident.firstIndex = firstIndex;
+		resident.vertexOffset = static_cast<int32>(firstVertex);
+
+		return addPendingMesh(resident, positionScale, ticket);
+	}
+
+	std::vector<MeshHandle> GpuScene::addMeshes(const MeshFileView& file) {
+		SP_PROFILE_ZONE("GpuScene::addMeshes");
+
+		if (file.meshes.empty()) {
+			return {};
+		}
+
+		// Meshes are laid out back to back in the file, their ranges just move by where the file lands
+		uint32 firstVertex;
+		uint32 firstIndex;
+		UploadTicket ticket = uploadGeometry(file.vertices, file.indices, firstVertex, firstIndex);
+
+		std::vector<MeshHandle> handles;
+		handles.reserve(file.meshes.size());
+		for (const MeshFileMesh& mesh : file.meshes) {
+			GpuMesh resident{};
+			resident.boundingSphere = vec4(vec3(mesh.boundingSphere) / mesh.positionScale, mesh.boundingSphere.w / mesh.positionScale);
+			resident.indexCount = mesh.indexCount;
+			resident.firstIndex = firstIndex + mesh.firstIndex;
+			resident.vertexOffset = static_cast<int32>(firstVertex + mesh.firstVertex);
+
+			handles.push_back(addPendingMesh(resident, mesh.positionScale, ticket));
+		}
+		return handles;
+	}
+
+	ObjectHandle GpuScene::addObject(const SceneObject& object) {
+		if (mObjects.size() >= mMaxObjects) {
+			SpConsole::FatalExit("Scene is full, the device draws at most " + std::to_string(mMaxObjects) + " objects at once", SP_FAILURE);
+		}
+
+		ObjectHandle handle;
+		if (!mFreeHandles.empty()) {
+			handle = mFreeHandles.back();
+			mFreeHandles.pop_back();
+		}else {
+			handle = static_cast<ObjectHandle>(mHandleSlots.size());
+			mHandleSlots.push_back(InvalidSceneHandle);
+		}
+
+		uint32 slot = static_cast<uint32>(mObjects.size());
+		mObjects.push_back(packObject(object));
+		mObjectHandles.push_back(handle);
+		mObjectDirtyFrames.push_back(0);
+		mHandleSlots[handle] = slot;
+
+		markDirty(slot);
+		return handle;
+	}
+
+	void GpuScene::updateObject(ObjectHandle handle, const SceneObject& object) {
+		uint32 slot = slotOf(handle);
+		mObjects[slot] = packObject(object);
+		markDirty(slot);
+	}
+
+	void GpuScene::setTransform(ObjectHandle handle, const mat4& transform) {
+		uint32 slot = slotOf(handle);
+
+		GpuObject& object = mObjects[slot];
+		object.transform = packedTransform(transform, mMeshScales[object.mesh]);
+		markDirty(slot);
+	}
+
+	void GpuScene::removeObject(ObjectHandle handle) {
+		uint32 slot = slotOf(handle);
+		uint32 last = static_cast<uint32>(mObjects.size() - 1);
+
+		if (slot != last) {
+			mObjects[slot] = mObjects[last];
+			mObjectHandles[slot] = mObjectHandles[last];
+			mHandleSlots[mObjectHandles[slot]] = slot;
+			markDirty(slot);
+		}
+
+		mObjects.pop_back();
+		mObjectHandles.pop_back();
+		mObjectDirtyFrames.pop_back();
+
+		mHandleSlots[handle] = InvalidSceneHandle;
+		mFreeHandles.push_back(handle);
+	}
+
+	void GpuScene::prepare(uint32 frameIndex, uint64 frameNumber) {
+		SP_PROFILE_ZONE("GpuScene::prepare");
+
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point prepareStart = Clock::now();
+
+		mFrameNumber = frameNumber;
+		releaseRetired(false);
+		updateResidentMeshes();
+
+		FrameBuffers& frame = mFrames[frameIndex];
+		const uint32 frameBit = 1u << frameIndex;
+		const uint32 objectCount = static_cast<uint32>(mObjects.size());
+
+		uint32 objectWrites = 0;
+		GpuObject* objects = static_cast<GpuObject*>(frame.objects.allocation.mappedData);
+		if (frame.objectCapacity < objectCount) {
+			// A new buffer holds nothing yet, everything is written and the dirty list is moot
+			reserveObjects(frame, objectCount);
+			objects = static_cast<GpuObject*>(frame.objects.allocation.mappedData);
+
+			std::memcpy(objects, mObjects.data(), static_cast<size_t>(objectCount) * sizeof(GpuObject));
+			for (uint8& dirtyFrames : mObjectDirtyFrames) {
+				dirtyFrames &= ~frameBit;
+			}
+			frame.dirtyObjects.clear();
+			objectWrites = objectCount;
+		}else {
+			// Slots past the end belonged to objects removed since
+			for (uint32 slot : frame.dirtyObjects) {
+				if (slot >= objectCount) {
+					continue;
+				}
+				objects[slot] = mObjects[slot];
+				mObjectDirtyFrames[slot] &= ~frameBit;
+				objectWrites++;
+			}
+			frame.dirtyObjects.clear();
+		}
+		if (objectWrites != 0) {
+			mAllocator->flush(frame.objects.allocation, 0, static_cast<VkDeviceSize>(objectCount) * sizeof(GpuObject));
+		}
+		frame.objectCount = objectCount;
+
+		if (frame.meshVersion != mMeshVersion) {
+			reserveMeshes(frame, static_cast<uint32>(mMeshes.size()));
+			std::memcpy(frame.meshes.allocation.mappedData, mMeshes.data(), mMeshes.size() * sizeof(GpuMesh));
+			mAllocator->flush(frame.meshes.allocation, 0, static_cast<VkDeviceSize>(mMeshes.size()) * sizeof(GpuMesh));
+			frame.meshVersion = mMeshVersion;
+		}
+
+		mStats.meshCount = static_cast<uint32>(mMeshes.size());
+		mStats.objectCount = objectCount;
+		mStats.objectWrites = objectWrites;
+		mStats.prepareMs = std::chrono::duration<double, std::milli>(Clock::now() - prepareStart).count();
+	}
+
+	GpuScene::CullOutputs GpuScene::addCullPass(RenderGraph& graph, uint32 frameIndex) const {
+		CullOutputs outputs{};
+		if (!hasDraws(frameIndex)) {
+			return outputs;
+		}
+
+		const FrameBuffers& frame = mFrames[frameIndex];
+		const bool compact = mDrawMode == SP_INDIRECT_DRAW_COUNT;
+
+		outputs.drawCommands = graph.importBuffer("Draw commands", frame.commands.buffer,
+		                                          static_cast<VkDeviceSize>(frame.objectCapacity) * sizeof(VkDrawIndexedIndirectCommand));
+		if (compact) {
+			outputs.drawCount = graph.importBuffer("Draw count", frame.count.buffer, sizeof(uint32));
+
+			VkBuffer countBuffer = frame.count.buffer;
+			graph.addPass("Clear draw count", SP_GRAPH_PASS_TRANSFER)
+				.write(outputs.drawCount, SP_GRAPH_ACCESS_TRANSFER_DST)
+				.execute([countBuffer](VkCommandBuffer cmd, const RenderGraph::PassContext&) {
+					vkCmdFillBuffer(cmd, countBuffer, 0, sizeof(uint32), 0);
+				});
+		}
+
+		// Object and mesh buffers are written by the host before the submit, which makes them visible on its own
+		CullConstants constants{};
+		constants.planes = frustumPlanes(mViewProjection);
+		constants.objectCount = frame.objectCount;
+		constants.objectBuffer = frame.objects.index;
+		constants.meshBuffer = frame.meshes.index;
+		constants.commandBuffer = frame.commands.index;
+		constants.countBuffer = frame.count.index;
+		constants.compact = compact ? VK_TRUE : VK_FALSE;
+
+		RenderGraph::PassBuilder cullPass = graph.addPass("Cull", SP_GRAPH_PASS_COMPUTE);
+		cullPass.write(outputs.drawCommands, SP_GRAPH_ACCESS_STORAGE_WRITE);
+		if (compact) {
+			// Visible draws take their slot with an atomic add on the count
+			cullPass.readWrite(outputs.drawCount, SP_GRAPH_ACCESS_STORAGE_WRITE);
+		}
+		cullPass.execute([this, constants](VkCommandBuffer cmd, const RenderGraph::PassContext&) {
+			VkDescriptorSet bindlessSet = mBindlessTable->getSet();
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mCullLayout, BindlessDescriptorSet, 1, &bindlessSet, 0, nullptr);
+			vkCmdPushConstants(cmd, mCullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+			vkCmdDispatch(cmd, (constants.objectCount + CullWorkgroupSize - 1) / CullWorkgroupSize, 1, 1);
+		});
+
+		return outputs;
+	}
+
+	void GpuScene::record(VkCommandBuffer commandBuffer, uint32 frameIndex) const {
+		if (!hasDraws(frameIndex)) {
+			return;
+		}
+
+		VkPipeline pipeline = mRegistry->get(mMeshPipeline);
+		if (pipeline == VK_NULL_HANDLE) {
+			// Still compiling, the scene shows up once it is done
+			return;
+		}
+
+		const FrameBuffers& frame = mFrames[frameIndex];
+
+		MeshConstants constants{};
+		constants.viewProjection = mViewProjection;
+		constants.objectBuffer = frame.objects.index;
+
+		VkDescriptorSet bindlessSet = mBindlessTable->getSet();
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mMeshLayout, BindlessDescriptorSet, 1, &bindlessSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, mMeshLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+
+		VkDeviceSize vertexOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mVertexBuffer, &vertexOffset);
+		vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+		const uint32 stride = sizeof(VkDrawIndexedIndirectCommand);
+		switch (mDrawMode) {
+			case SP_INDIRECT_DRAW_COUNT:
+				// init() capped the scene at maxDrawIndirectCount objects
+				mDrawIndexedIndirectCount(commandBuffer, frame.commands.buffer, 0, frame.count.buffer, 0, frame.objectCount, stride);
+				break;
+			case SP_INDIRECT_DRAW_MULTI:
+				for (uint32 first = 0; first < frame.objectCount; first += mMaxDrawIndirectCount) {
+					uint32 drawCount = std::min(frame.objectCount - first, mMaxDrawIndirectCount);
+					vkCmdDrawIndexedIndirect(commandBuffer, frame.commands.buffer, static_cast<VkDeviceSize>(first) * stride, drawCount, stride);
+				}
+				break;
+			case SP_INDIRECT_DRAW_SINGLE:
+				// Back to a call per object, still no per object work besides recording it
+				for (uint32 i = 0; i < frame.objectCount; i++) {
+					vkCmdDrawIndexedIndirect(commandBuffer, frame.commands.buffer, static_cast<VkDeviceSize>(i) * stride, 1, stride);
+				}
+				break;
+			case SP_INDIRECT_DRAW_UNSUPPORTED:
+				break;
+		}
+	}
+
+	bool GpuScene::hasDraws(uint32 frameIndex) const {
+		return mDrawMode != SP_INDIRECT_DRAW_UNSUPPORTED && mCullPipeline != VK_NULL_HANDLE && mFrames[frameIndex].objectCount != 0;
+	}
+
+	std::array<vec4, 6> GpuScene::frustumPlanes(const mat4& viewProjection) {
+		// Rows of the matrix, glm stores columns
+		auto row = [&viewProjection](uint32 i) {
+			return vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		};
+
+		std::array<vec4, 6> planes = {
+			row(3) + row(0),
+			row(3) - row(0),
+			row(3) + row(1),
+			row(3) - row(1),
+			row(2), // Clip space depth starts at 0, not -w
+			row(3) - row(2)
+		};
+
+		for (vec4& plane : planes) {
+			float length = glm::length(vec3(plane));
+			if (length > 0.0f) {
+				plane /= length;
+			}
+		}
+		return planes;
+	}
+
+	vec4 GpuScene::boundingSphere(std::span<const Vertex> vertices) {
+		if (vertices.empty()) {
+			return vec4(0.0f);
+		}
+
+		vec3 minimum = vertices[0].position;
+		vec3 maximum = vertices[0].position;
+		for (const Vertex& vertex : vertices) {
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+
+		vec3 center = (minimum + maximum) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (const Vertex& vertex : vertices) {
+			vec3 offset = vertex.position - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		return vec4(center, std::sqrt(radiusSquared));
+	}
+
+	void GpuScene::createGeometryBuffers() {
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		bufferCreateInfo.size = static_cast<VkDeviceSize>(SceneVertexCapacity) * sizeof(VertexPacked);
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, mVertexBuffer, mVertexAllocation);
+
+		bufferCreateInfo.size = static_cast<VkDeviceSize>(SceneIndexCapacity) * sizeof(uint32);
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, mIndexBuffer, mIndexAllocation);
+	}
+
+	void GpuScene::createBuffer(SceneBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible) {
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = size;
+		bufferCreateInfo.usage = usage;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// Host written buffers go to VRAM too when the device exposes host visible device local memory
+		AllocationCreateInfo allocationInfo{};
+		if (hostVisible) {
+			allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		}else {
+			allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		}
+
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, buffer.buffer, buffer.allocation);
+		buffer.index = mBindlessTable->registerBuffer(buffer.buffer);
+	}
+
+	void GpuScene::retireBuffer(SceneBuffer& buffer) {
+		if (buffer.buffer == VK_NULL_HANDLE) {
+			return;
+		}
+
+		mBindlessTable->releaseBuffer(buffer.index);
+		mRetired.push_back({buffer, mFrameNumber});
+		buffer = {};
+	}
+
+	void GpuScene::releaseRetired(bool force) {
+		// One frame more than the bindless table waits, by then it has pointed the slot elsewhere
+		auto released = [this, force](RetiredBuffer& retired) {
+			if (!force && mFrameNumber <= retired.retireFrame + mFramesInFlight) {
+				return false;
+			}
+			mAllocator->destroyBuffer(retired.buffer.buffer, retired.buffer.allocation);
+			return true;
+		};
+		std::erase_if(mRetired, released);
+	}
+
+	UploadTicket GpuScene::uploadGeometry(std::span<const VertexPacked> vertices, std::span<const uint32> indices,
+	                                      uint32& firstVertex, uint32& firstIndex) {
+		if (vertices.size() > SceneVertexCapacity - mVertexCount || indices.size() > SceneIndexCapacity - mIndexCount) {
+			SpConsole::FatalExit("Scene geometry buffers are full, " + std::to_string(mVertexCount) + " vertices and " +
+			                     std::to_string(mIndexCount) + " indices in use", SP_FAILURE);
+		}
+
+		firstVertex = mVertexCount;
+		firstIndex = mIndexCount;
+
+		VkPipelineStageFlags stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		UploadTicket vertexTicket = mUploadManager->uploadBuffer(mVertexBuffer, static_cast<VkDeviceSize>(firstVertex) * sizeof(VertexPacked),
+		                                                         vertices.data(), vertices.size_bytes(), stages,
+		                                                         VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+		UploadTicket indexTicket = mUploadManager->uploadBuffer(mIndexBuffer, static_cast<VkDeviceSize>(firstIndex) * sizeof(uint32),
+		                                                        indices.data(), indices.size_bytes(), stages, VK_ACCESS_INDEX_READ_BIT);
+		mVertexCount += static_cast<uint32>(vertices.size());
+		mIndexCount += static_cast<uint32>(indices.size());
+
+		return std::max(vertexTicket, indexTicket);
+	}
+
+	MeshHandle GpuScene::addPendingMesh(const GpuMesh& resident, float positionScale, UploadTicket ticket) {
+		MeshHandle handle = static_cast<MeshHandle>(mMeshes.size());
+
+		// Culled until the upload is done, the bounds are already known
+		GpuMesh pending = resident;
+		pending.indexCount = 0;
+		mMeshes.push_back(pending);
+		mMeshScales.push_back(positionScale);
+		mPendingMeshes.push_back({handle, resident, ticket});
+		mMeshVersion++;
+
+		return handle;
+	}
+
+	void GpuScene::updateResidentMeshes() {
+		auto resident = [this](const PendingMesh& pending) {
+			if (!mUploadManager->isComplete(pending.ticket)) {
+				return false;
+			}
+			mMeshes[pending.mesh] = pending.resident;
+			mMeshVersion++;
+			return true;
+		};
+		std::erase_if(mPendingMeshes, resident);
+	}
+
+	void GpuScene::reserveObjects(FrameBuffers& frame, uint32 objectCount) {
+		if (frame.objectCapacity >= objectCount && frame.objects.buffer != VK_NULL_HANDLE) {
+			return;
+		}
+
+		uint32 capacity = std::max(frame.objectCapacity, InitialSceneObjectCapacity);
+		while (capacity < objectCount) {
+			capacity *= 2;
+		}
+
+		retireBuffer(frame.objects);
+		retireBuffer(frame.commands);
+
+		createBuffer(frame.objects, static_cast<VkDeviceSize>(capacity) * sizeof(GpuObject), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		createBuffer(frame.commands, static_cast<VkDeviceSize>(capacity) * sizeof(VkDrawIndexedIndirectCommand),
+		             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false);
+		frame.objectCapacity = capacity;
+	}
+
+	void GpuScene::reserveMeshes(FrameBuffers& frame, uint32 meshCount) {
+		if (frame.meshCapacity >= meshCount && frame.meshes.buffer != VK_NULL_HANDLE) {
+			return;
+		}
+
+		uint32 capacity = std::max(frame.meshCapacity, InitialSceneMeshCapacity);
+		while (capacity < meshCount) {
+			capacity *= 2;
+		}
+
+		retireBuffer(frame.meshes);
+		createBuffer(frame.meshes, static_cast<VkDeviceSize>(capacity) * sizeof(GpuMesh), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		frame.meshCapacity = capacity;
+	}
+
+	GpuObject GpuScene::packObject(const SceneObject& object) const {
+		if (object.mesh >= mMeshes.size()) {
+			SpConsole::FatalExit("Scene object uses unknown mesh " + std::to_string(object.mesh), SP_FAILURE);
+		}
+
+		GpuObject packed{};
+		packed.transform = packedTransform(object.transform, mMeshScales[object.mesh]);
+		packed.mesh = object.mesh;
+		packed.texture = object.texture;
+		packed.color = object.color;
+		return packed;
+	}
+
+	uint32 GpuScene::slotOf(ObjectHandle handle) const {
+		if (handle >= mHandleSlots.size() || mHandleSlots[handle] == InvalidSceneHandle) {
+			SpConsole::FatalExit("Invalid scene object handle " + std::to_string(handle), SP_FAILURE);
+		}
+		return mHandleSlots[handle];
+	}
+
+	void GpuScene::markDirty(uint32 slot) {
+		// Every frame buffer has to catch up on the change, each only once however often it changes
+		for (uint32 i = 0; i < mFrames.size(); i++) {
+			uint8 frameBit = static_cast<uint8>(1u << i);
+			if ((mObjectDirtyFrames[slot] & frameBit) == 0) {
+				mObjectDirtyFrames[slot] |= frameBit;
+				mFrames[i].dirtyObjects.push_back(slot);
+			}
+		}
+	}
+} // SpRenderer
@@ -0,0 +1,88 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "MeshFile.h"
+
+#include <bit>
+#include <cstring>
+
+namespace SpRenderer {
+	// Sections are used in place, which only works when the file's byte order is the host's
+	static_assert(std::endian::native == std::endian::little, "Mesh files are little endian");
+
+	namespace {
+		/*!
+		 * count elements of T at offset, aligned and inside the file
+		 */
+		template<typename T>
+		bool sectionInFile(std::span<const uint8> file, uint64 offset, uint32 count) {
+			if (offset % MeshFileAlignment != 0 || offset > file.size()) {
+				return false;
+			}
+			return static_cast<uint64>(count) * sizeof(T) <= file.size() - offset;
+		}
+
+		template<typename T>
+		std::span<const T> section(std::span<const uint8> file, uint64 offset, uint32 count) {
+			return {reinterpret_cast<const T*>(file.data() + offset), count};
+		}
+	}
+
+	bool parseMeshFile(std::span<const uint8> file, MeshFileView& view, std::string& error) {
+		MeshFileHeader header{};
+		if (file.size() < sizeof(header)) {
+			error = "not a mesh file";
+			return false;
+		}
+		std::memcpy(&header, file.data(), sizeof(header));
+
+		if (header.magic != MeshFileMagic) {
+			error = "not a mesh file";
+			return false;
+		}
+		if (header.version != MeshFileVersion) {
+			error = "version " + std::to_string(header.version) + ", expected " + std::to_string(MeshFileVersion) +
+			        ", cook it again";
+			return false;
+		}
+		if (header.fileSize != file.size()) {
+			error = "truncated, " + std::to_string(file.size()) + " of " + std::to_string(header.fileSize) + " bytes";
+			return false;
+		}
+		if (reinterpret_cast<uintptr_t>(file.data()) % MeshFileAlignment != 0) {
+			error = "file data is not aligned";
+			return false;
+		}
+
+		if (!sectionInFile<MeshFileMesh>(file, header.meshOffset, header.meshCount) ||
+		    !sectionInFile<MeshFileMeshlet>(file, header.meshletOffset, header.meshletCount) ||
+		    !sectionInFile<VertexPacked>(file, header.vertexOffset, header.vertexCount) ||
+		    !sectionInFile<uint32>(file, header.indexOffset, header.indexCount)) {
+			error = "a section is misaligned or out of bounds";
+			return false;
+		}
+
+		view.meshes = section<MeshFileMesh>(file, header.meshOffset, header.meshCount);
+		view.meshlets = section<MeshFileMeshlet>(file, header.meshletOffset, header.meshletCount);
+		view.vertices = section<VertexPacked>(file, header.vertexOffset, header.vertexCount);
+		view.indices = section<uint32>(file, header.indexOffset, header.indexCount);
+
+		// Ranges only, checking every index against its mesh would touch every page of the file
+		for (size_t i = 0; i < view.meshes.size(); i++) {
+			const MeshFileMesh& mesh = view.meshes[i];
+
+			bool valid = mesh.vertexCount <= header.vertexCount && mesh.firstVertex <= header.vertexCount - mesh.vertexCount &&
+			             mesh.indexCount <= header.indexCount && mesh.firstIndex <= header.indexCount - mesh.indexCount &&
+			             mesh.meshletCount <= header.meshletCount && mesh.firstMeshlet <= header.meshletCount - mesh.meshletCount &&
+			             mesh.indexCount % 3 == 0 && mesh.indexCount != 0 && mesh.positionScale > 0.0f &&
+			             std::memchr(mesh.name, 0, MeshNameSize) != nullptr;
+			if (!valid) {
+				error = "mesh " + std::to_string(i) + " is out of bounds";
+				return false;
+			}
+		}
+
+		return true;
+	}
+} // SpRenderer
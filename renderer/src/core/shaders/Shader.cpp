@@ -3,207 +3,117 @@
 //
 
 #include "Shader.h"
+#include "Profiler.h"
 
 namespace fs = std::filesystem;
 
-std::string Shader::shaderExtension(ShaderType type) {
-	switch (type) {
-		case ShaderType::SHADER_VERTEX:
-			return ".vert";
-			break;
-
-		case ShaderType::SHADER_FRAGMENT:
-			return ".frag";
-			break;
-	}
-}
-
-void Shader::createShader(const std::string vertexShaderFilePath,
-                          const std::string fragmentShaderFilePath,
-                          VkDevice device) {
-
-	fs::path vertexShaderPath(vertexShaderFilePath);
-	fs::path fragmentShaderPath(fragmentShaderFilePath);
-
-	if (vertexShaderPath.extension() != ".vert") {
-		SpConsole::FatalExit("Incorrect file extension. NEEDS TO BE .vert !!!", SP_FAILURE);
-	}
-	if (fragmentShaderPath.extension() != ".frag") {
-		SpConsole::FatalExit("Incorrect file extension. NEEDS TO BE .frag !!!", SP_FAILURE);
-	}
-
-	std::string vertexName = vertexShaderPath.stem().string();
-	std::string fragmentName = fragmentShaderPath.stem().string();
-
-	compiledCheck(vertexName, SHADER_VERTEX);
-	compiledCheck(fragmentName, SHADER_FRAGMENT);
-
-	recompileDateCheck(vertexName, SHADER_VERTEX);
-	recompileDateCheck(fragmentName, SHADER_FRAGMENT);
+namespace {
+	// Resolves #include relative to the including file and records every file it opens
+	class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface {
+	public:
+		explicit ShaderIncluder(std::vector<std::string>& includedFiles) : mIncludedFiles(includedFiles) {}
+
+		shaderc_include_result* GetInclude(const char* requestedSource,
+		                                   shaderc_include_type type,
+		                                   const char* requestingSource,
+		                                   size_t /*includeDepth*/) override {
+			IncludeData* data = new IncludeData();
+
+			fs::path includePath = type == shaderc_include_type_relative
+				                       ? fs::path(requestingSource).parent_path() / requestedSource
+				                       : fs::path(RENDERER_RESOURCE_DIR "/shaders") / requestedSource;
+			includePath = includePath.lexically_normal();
+
+			if (fs::exists(includePath)) {
+				// shaderc reads the include straight out of the mapping, it stays mapped until ReleaseInclude
+				data->file = Utils::FileUtils::mapFile(includePath, SP_FILE_ACCESS_SEQUENTIAL);
+				data->name = includePath.generic_string();
+
+				if (std::find(mIncludedFiles.begin(), mIncludedFiles.end(), data->name) == mIncludedFiles.end()) {
+					mIncludedFiles.push_back(data->name);
+				}
+			}else {
+				// An empty source name tells shaderc the include failed, content becomes the error message
+				data->content = "Could not find include " + std::string(requestedSource);
+			}
 
-	if (mCompileFlags == 0) {
-		return;
-	}
+			data->result.source_name = data->name.c_str();
+			data->result.source_name_length = data->name.size();
+			if (data->file) {
+				data->result.content = data->file.data().data();
+				data->result.content_length = data->file.size();
+			}else {
+				data->result.content = data->content.c_str();
+				data->result.content_length = data->content.size();
+			}
+			data->result.user_data = data;
+			return &data->result;
+		}
 
-	if (mCompileFlags & CompileVertex) {
-		mVertSPIRV = compileShader(vertexShaderPath);
-		writeToFile(vertexName, SHADER_VERTEX);
-	}
-	if (mCompileFlags & CompileFragment) {
-		mFragSPIRV = compileShader(fragmentShaderPath);
-		writeToFile(fragmentName, SHADER_FRAGMENT);
-	}
+		void ReleaseInclude(shaderc_include_result* result) override {
+			delete static_cast<IncludeData*>(result->user_data);
+		}
 
-	readFromFile(vertexName, SHADER_VERTEX);
-	readFromFile(fragmentName, SHADER_FRAGMENT);
+	private:
+		struct IncludeData {
+			shaderc_include_result result{};
+			std::string name;
+			Utils::MappedFile file;
+			std::string content; // Error message when the include was not found
+		};
 
+		std::vector<std::string>& mIncludedFiles;
+	};
 }
 
+std::vector<uint32> Shader::compileShader(const shaderc::Compiler& compiler,
+                                          const fs::path& filePath,
+                                          ShaderStage stage,
+                                          const ShaderCompileSettings& settings,
+                                          std::vector<std::string>& includedFiles) {
+	SP_PROFILE_ZONE("Shader::compileShader");
 
-std::vector<uint32> Shader::compileShader(std::filesystem::path filePath) {
-	shaderc::Compiler compiler;
 	shaderc::CompileOptions compileOptions;
-	shaderc::SpvCompilationResult result;
+	settings.apply(compileOptions);
+	compileOptions.SetIncluder(std::make_unique<ShaderIncluder>(includedFiles));
 
-	if (!compiler.IsValid()) {
-		SpConsole::FatalExit("Compiler is not valid!", SP_FAILURE);
-	}
+	Utils::MappedFile rawCode = Utils::FileUtils::mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+	std::string inputName = filePath.lexically_normal().generic_string();
 
-	if (!exists(filePath)) {
-		SpConsole::FatalExit("File does not exist", SP_FAILURE);
-	}
-
-	std::vector<char> rawCode = Utils::FileUtils::readTextFile(filePath);
-	size_t codeSize = rawCode.size() * sizeof(char);
-
-	result = compiler.AssembleToSpv(rawCode.data(),  codeSize, compileOptions);
+	shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
+		rawCode.data().data(), rawCode.size(), shaderKind(stage), inputName.c_str(), compileOptions);
 
 	if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-		std::string message = result.GetErrorMessage();
-		SpConsole::Write(SP_MESSAGE_FATAL, message);
-		SpConsole::FatalExit("Shader compilation error", SP_FAILURE);
+		SpConsole::Write(SP_MESSAGE_ERROR, result.GetErrorMessage());
+		return {};
 	}
 
-	std::vector<uint32> compiledData(result.cbegin(), result.cend());
-
-	return compiledData;
+	return std::vector<uint32>(result.cbegin(), result.cend());
 }
 
-void Shader::compiledCheck(std::string fileName, ShaderType type) {
-	std::string dataFolder = RENDERER_DATA_DIR "/shaders/";
-	fs::path shaderPath = dataFolder;
+VkShaderModule Shader::createShaderModule(VkDevice device, std::span<const uint32> spirv) {
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = spirv.size_bytes();
+	createInfo.pCode = spirv.data();
 
-	if (!fs::exists(shaderPath)) {
-		SpConsole::Write(SP_MESSAGE_WARNING, "Creating Directory " + shaderPath.string());
-		fs::create_directory(shaderPath);
-	}
-	for (const auto& entry : fs::directory_iterator(shaderPath)) {
-		if (fileName.compare(entry.path().filename().string())) {
-			SpConsole::Write(SP_MESSAGE_INFO, fileName + " has been compiled");
-			return;
-		}
-	}
+	VkShaderModule shaderModule = VK_NULL_HANDLE;
+	VkResult result = vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule);
 
-	SpConsole::Write(SP_MESSAGE_VERBOSE, "Did not find compiled shader for " + fileName);
-
-	switch (type) {
-		case ShaderType::SHADER_VERTEX:
-			mCompileFlags = mCompileFlags | CompileVertex;
-			break;
-		case ShaderType::SHADER_FRAGMENT:
-			mCompileFlags = mCompileFlags | CompileFragment;
-			break;
-	}
+	SpConsole::VulkanExitCheck(result, "Failed to create shader module!", SP_FAILURE);
 
+	return shaderModule;
 }
 
-
-void Shader::recompileDateCheck(std::string fileName, ShaderType type) {
-	switch (type) {
-		case ShaderType::SHADER_VERTEX:
-			if (mCompileFlags & CompileVertex) {
-				SpConsole::Write(SP_MESSAGE_INFO, fileName + ".vert has not been compiled before!");
-				return;
-			}
-			break; // end case Vertex
-		case ShaderType::SHADER_FRAGMENT:
-			if (mCompileFlags & CompileFragment) {
-				SpConsole::Write(SP_MESSAGE_INFO, fileName + ".frag has not been compiled before!");
-				return;
-			}
-			break; // end case Fragment
-	}
-
-	std::string dataFolder = std::string(RENDERER_DATA_DIR "/shaders/") + fileName.c_str() + SHADER_EXTENSION_COMPILED;
-	fs::path compiledShaderPath = dataFolder;
-
-	dataFolder = std::string(RENDERER_RESOURCE_DIR "/shaders/") + fileName.c_str();
-	fs::path shaderPath = dataFolder;
-
-	const auto compiledFileTime = std::filesystem::last_write_time(compiledShaderPath);
-	const auto fileTime = std::filesystem::last_write_time(shaderPath);
-
-	if (compiledFileTime > fileTime) {
-		switch (type) {
-			case ShaderType::SHADER_VERTEX:
-				mCompileFlags = mCompileFlags | CompileVertex;
-				break;
-			case ShaderType::SHADER_FRAGMENT:
-				mCompileFlags = mCompileFlags | CompileFragment;
-				break;
-		}
-	}
-}
-
-void Shader::writeToFile(std::string fileName, ShaderType type) {
-	std::vector<char> code = {};
-	switch (type) {
-		case ShaderType::SHADER_VERTEX:
-			if (mVertSPIRV.size() == 0) SpConsole::FatalExit("Vertex shader has not been compiled!", SP_FAILURE);
-			code.assign(mVertSPIRV.begin(), mVertSPIRV.end());
-			Utils::FileUtils::writeBinaryFile(RENDERER_DATA_DIR "/" + fileName + SHADER_EXTENSION_COMPILED_VERTEX, code);
-			break;
-
-		case ShaderType::SHADER_FRAGMENT:
-			if (mFragSPIRV.size() == 0) SpConsole::FatalExit("Fragment shader has not been compiled!", SP_FAILURE);
-			code.assign(mFragSPIRV.begin(), mFragSPIRV.end());
-			Utils::FileUtils::writeBinaryFile(RENDERER_DATA_DIR "/" + fileName + SHADER_EXTENSION_COMPILED_FRAGMENT, code);
-			break;
-	}
-}
-
-std::vector<uint32> Shader::readFromFile(std::string fileName, ShaderType type) {
-	std::vector<char> code = {};
-	fs::path shaderPath = RENDERER_DATA_DIR "/" + fileName;
-
-	switch (type) {
-		case ShaderType::SHADER_VERTEX:
-			if (!mVertSPIRV.empty()) {
-				SpConsole::Write(SP_MESSAGE_INFO, fileName + ".vert has just been compiled");
-				return mVertSPIRV;
-			}
-			shaderPath = shaderPath.string() + SHADER_EXTENSION_COMPILED_VERTEX;
-			if (!fs::exists(shaderPath)) SpConsole::FatalExit(fileName + SHADER_EXTENSION_COMPILED_VERTEX + " does not exist!", SP_FAILURE);
-
-			code = Utils::FileUtils::readBinaryFile(shaderPath.string() + SHADER_EXTENSION_COMPILED_VERTEX);
-			return std::vector<uint32>(code.begin(), code.end());
-			break;
-
-		case ShaderType::SHADER_FRAGMENT:
-			if (!mFragSPIRV.empty()) {
-				SpConsole::Write(SP_MESSAGE_INFO, fileName + ".frag has just been compiled");
-				return mFragSPIRV;
-			}
-			shaderPath = shaderPath.string() + SHADER_EXTENSION_COMPILED_FRAGMENT;
-
-			if (!fs::exists(shaderPath)) SpConsole::FatalExit(fileName + SHADER_EXTENSION_COMPILED_FRAGMENT + " does not exist!", SP_FAILURE);
-
-			code = Utils::FileUtils::readTextFile(shaderPath.string() + SHADER_EXTENSION_COMPILED_FRAGMENT);
-			return std::vector<uint32>(code.begin(), code.end());
-			break;
-
+shaderc_shader_kind Shader::shaderKind(ShaderStage stage) {
+	switch (stage) {
+		case SP_SHADER_STAGE_VERTEX:
+			return shaderc_glsl_vertex_shader;
+		case SP_SHADER_STAGE_FRAGMENT:
+			return shaderc_glsl_fragment_shader;
+		case SP_SHADER_STAGE_COMPUTE:
+			return shaderc_glsl_compute_shader;
 	}
 
-	SpConsole::FatalExit("You're not supposed to be able to get here???", SP_FAILURE);
-	return {};
+	return shaderc_glsl_infer_from_source;
 }
@@ -0,0 +1,317 @@
+//
+// Created by robsc on 11/24/25.
+//
+
+#include "ShaderCache.h"
+
+namespace fs = std::filesystem;
+
+// 'SPSC'
+const uint32 ShaderCacheMagic = 0x43535053;
+// Bump when the layout of the cache file changes
+const uint32 ShaderCacheVersion = 1;
+
+void ShaderCompileSettings::apply(shaderc::CompileOptions& options) const {
+	options.SetOptimizationLevel(optimizationLevel);
+	options.SetTargetEnvironment(shaderc_target_env_vulkan, targetEnvironmentVersion);
+	if (generateDebugInfo) {
+		options.SetGenerateDebugInfo();
+	}
+	for (const std::pair<std::string, std::string>& macro : macros) {
+		options.AddMacroDefinition(macro.first, macro.second);
+	}
+}
+
+uint64 ShaderCompileSettings::fingerprint() const {
+	uint64 hash = Utils::hash64(&optimizationLevel, sizeof(optimizationLevel));
+	hash = Utils::hashCombine(hash, generateDebugInfo ? 1 : 0);
+	hash = Utils::hashCombine(hash, targetEnvironmentVersion);
+	for (const std::pair<std::string, std::string>& macro : macros) {
+		hash = Utils::hashCombine(hash, Utils::hash64(macro.first));
+		hash = Utils::hashCombine(hash, Utils::hash64(macro.second));
+	}
+	return hash;
+}
+
+ShaderCache::~ShaderCache() {
+	unmapCacheFile();
+}
+
+void ShaderCache::load(const fs::path& cacheDirectory) {
+	if (!fs::exists(cacheDirectory)) {
+		SpConsole::Write(SP_MESSAGE_WARNING, "Creating Directory " + cacheDirectory.string());
+		fs::create_directories(cacheDirectory);
+	}
+
+	mCachePath = cacheDirectory / SHADER_CACHE_FILE_NAME;
+
+	if (!mapCacheFile()) {
+		SpConsole::Write(SP_MESSAGE_INFO, "No usable shader cache, starting empty");
+		return;
+	}
+
+	SpConsole::Write(SP_MESSAGE_INFO, "Mapped shader cache with " + std::to_string(mEntryCount) + " entries");
+}
+
+void ShaderCache::save() {
+	std::lock_guard lock(mMutex);
+
+	if (mPending.empty() || mCachePath.empty()) {
+		return;
+	}
+
+	struct OutputEntry {
+		CacheEntry entry;
+		std::span<const uint8> data;
+	};
+
+	std::vector<OutputEntry> outputEntries;
+	outputEntries.reserve(mEntryCount + mPending.size());
+
+	for (uint32 i = 0; i < mEntryCount; i++) {
+		if (mPending.contains(mEntries[i].key)) continue;
+		outputEntries.push_back({mEntries[i], std::span(mMappedData + mEntries[i].offset, mEntries[i].size)});
+	}
+	for (const auto& [key, pending] : mPending) {
+		CacheEntry entry{};
+		entry.key = key;
+		entry.kind = pending.kind;
+		outputEntries.push_back({entry, std::span(pending.data.data(), pending.data.size())});
+	}
+
+	std::sort(outputEntries.begin(), outputEntries.end(), [](const OutputEntry& a, const OutputEntry& b) {
+		return a.entry.key < b.entry.key;
+	});
+
+	size_t dataOffset = sizeof(CacheHeader) + outputEntries.size() * sizeof(CacheEntry);
+	size_t totalSize = dataOffset;
+	for (OutputEntry& output : outputEntries) {
+		output.entry.offset = totalSize;
+		output.entry.size = output.data.size();
+		// Keep every blob 8 byte aligned so mapped SPIR-V can be read as uint32 in place
+		totalSize += (output.data.size() + 7) & ~static_cast<size_t>(7);
+	}
+
+	std::vector<char> fileData(totalSize, 0);
+
+	CacheHeader header{};
+	header.magic = ShaderCacheMagic;
+	header.version = ShaderCacheVersion;
+	header.compilerVersion = compilerVersion();
+	header.entryCount = static_cast<uint32>(outputEntries.size());
+	std::memcpy(fileData.data(), &header, sizeof(header));
+
+	for (size_t i = 0; i < outputEntries.size(); i++) {
+		std::memcpy(fileData.data() + sizeof(CacheHeader) + i * sizeof(CacheEntry), &outputEntries[i].entry, sizeof(CacheEntry));
+		std::memcpy(fileData.data() + outputEntries[i].entry.offset, outputEntries[i].data.data(), outputEntries[i].data.size());
+	}
+
+	// Write next to the cache and rename over it, so a crash mid-write never leaves a torn cache behind
+	fs::path tempPath = mCachePath;
+	tempPath += ".tmp";
+	Utils::FileUtils::writeBinaryFile(tempPath, fileData);
+
+	unmapCacheFile();
+
+	std::error_code error;
+	fs::rename(tempPath, mCachePath, error);
+	if (error) {
+		SpConsole::Write(SP_MESSAGE_ERROR, "Failed to replace shader cache: " + error.message());
+	}else {
+		SpConsole::Write(SP_MESSAGE_INFO, "Saved shader cache with " + std::to_string(outputEntries.size()) + " entries");
+	}
+
+	mPending.clear();
+	mapCacheFile();
+}
+
+bool ShaderCache::find(const fs::path& sourcePath,
+                       ShaderStage stage,
+                       const ShaderCompileSettings& settings,
+                       std::span<const uint32>& spirv) {
+	std::span<const uint8> dependencyData;
+	if (!lookup(dependencyKey(sourcePath, stage, settings), SP_SHADER_CACHE_DEPENDENCIES, dependencyData)) {
+		mMisses++;
+		return false;
+	}
+
+	std::vector<std::string> includedFiles;
+	std::string_view dependencies(reinterpret_cast<const char*>(dependencyData.data()), dependencyData.size());
+	while (!dependencies.empty()) {
+		size_t end = dependencies.find('\n');
+		includedFiles.emplace_back(dependencies.substr(0, end));
+		dependencies = end == std::string_view::npos ? std::string_view() : dependencies.substr(end + 1);
+	}
+
+	uint64 key = 0;
+	std::span<const uint8> spirvData;
+	if (!contentKey(sourcePath, stage, settings, includedFiles, key) || !lookup(key, SP_SHADER_CACHE_SPIRV, spirvData)) {
+		mMisses++;
+		return false;
+	}
+
+	spirv = std::span(reinterpret_cast<const uint32*>(spirvData.data()), spirvData.size() / sizeof(uint32));
+	mHits++;
+	return true;
+}
+
+void ShaderCache::store(const fs::path& sourcePath,
+                        ShaderStage stage,
+                        const ShaderCompileSettings& settings,
+                        const std::vector<std::string>& includedFiles,
+                        const std::vector<uint32>& spirv) {
+	uint64 key = 0;
+	if (!contentKey(sourcePath, stage, settings, includedFiles, key)) {
+		SpConsole::Write(SP_MESSAGE_WARNING, "Not caching " + sourcePath.filename().string() + ", an include went missing");
+		return;
+	}
+
+	std::string dependencies;
+	for (const std::string& includedFile : includedFiles) {
+		dependencies += includedFile + '\n';
+	}
+
+	PendingEntry spirvEntry{SP_SHADER_CACHE_SPIRV, {}};
+	spirvEntry.data.resize(spirv.size() * sizeof(uint32));
+	std::memcpy(spirvEntry.data.data(), spirv.data(), spirvEntry.data.size());
+
+	PendingEntry dependencyEntry{SP_SHADER_CACHE_DEPENDENCIES, std::vector<uint8>(dependencies.begin(), dependencies.end())};
+
+	std::lock_guard lock(mMutex);
+	mPending.insert_or_assign(dependencyKey(sourcePath, stage, settings), std::move(dependencyEntry));
+	// Identical content always produces the same SPIR-V, keep the first so handed out spans stay valid
+	mPending.try_emplace(key, std::move(spirvEntry));
+}
+
+uint64 ShaderCache::compilerVersion() {
+	// shaderc has no runtime version query, the build identifier comes from configure time. The SPIR-V version
+	// alone would survive a glslang upgrade and keep serving its old output
+	unsigned int version = 0;
+	unsigned int revision = 0;
+	shaderc_get_spv_version(&version, &revision);
+	uint64 hash = Utils::hash64(SHADER_COMPILER_VERSION);
+	hash = Utils::hashCombine(hash, version);
+	return Utils::hashCombine(hash, revision);
+}
+
+bool ShaderCache::lookup(uint64 key, EntryKind kind, std::span<const uint8>& data) {
+	{
+		std::lock_guard lock(mMutex);
+		auto it = mPending.find(key);
+		if (it != mPending.end()) {
+			if (it->second.kind != kind) return false;
+			data = std::span(it->second.data.data(), it->second.data.size());
+			return true;
+		}
+	}
+
+	const CacheEntry* end = mEntries + mEntryCount;
+	const CacheEntry* entry = std::lower_bound(mEntries, end, key, [](const CacheEntry& cacheEntry, uint64 value) {
+		return cacheEntry.key < value;
+	});
+
+	if (entry == end || entry->key != key || entry->kind != kind) {
+		return false;
+	}
+
+	data = std::span(mMappedData + entry->offset, entry->size);
+	return true;
+}
+
+uint64 ShaderCache::dependencyKey(const fs::path& sourcePath, ShaderStage stage, const ShaderCompileSettings& settings) {
+	uint64 key = Utils::hash64(sourcePath.lexically_normal().generic_string(), ~Utils::HashSeed);
+	key = Utils::hashCombine(key, stage);
+	key = Utils::hashCombine(key, settings.fingerprint());
+	return Utils::hashCombine(key, compilerVersion());
+}
+
+bool ShaderCache::contentKey(const fs::path& sourcePath,
+                             ShaderStage stage,
+                             const ShaderCompileSettings& settings,
+                             const std::vector<std::string>& includedFiles,
+                             uint64& key) {
+	if (!fs::exists(sourcePath)) {
+		return false;
+	}
+
+	// Hashing the source plus everything it includes sees exactly what the preprocessor would, minus the
+	// macros from the settings which are part of the fingerprint
+	Utils::MappedFile source = Utils::FileUtils::mapFile(sourcePath, SP_FILE_ACCESS_SEQUENTIAL);
+	key = Utils::hash64(source.data().data(), source.size());
+	key = Utils::hashCombine(key, stage);
+	key = Utils::hashCombine(key, settings.fingerprint());
+	key = Utils::hashCombine(key, compilerVersion());
+
+	for (const std::string& includedFile : includedFiles) {
+		if (!fs::exists(includedFile)) {
+			return false;
+		}
+
+		Utils::MappedFile includeSource = Utils::FileUtils::mapFile(includedFile, SP_FILE_ACCESS_SEQUENTIAL);
+		key = Utils::hashCombine(key, Utils::hash64(includedFile));
+		key = Utils::hashCombine(key, Utils::hash64(includeSource.data().data(), includeSource.size()));
+	}
+
+	return true;
+}
+
+bool ShaderCache::mapCacheFile() {
+	mEntries = nullptr;
+	mEntryCount = 0;
+
+	if (!fs::exists(mCachePath)) {
+		return false;
+	}
+
+	// The index and most blobs are touched on startup, read them ahead instead of faulting page by page
+	mCacheFile = Utils::MappedFile::open(mCachePath, SP_FILE_ACCESS_WILLNEED);
+	mMappedData = mCacheFile.bytes().data();
+	mMappedSize = mCacheFile.size();
+
+	if (mMappedData == nullptr || mMappedSize < sizeof(CacheHeader)) {
+		unmapCacheFile();
+		return false;
+	}
+
+	const CacheHeader* header = reinterpret_cast<const CacheHeader*>(mMappedData);
+	if (header->magic != ShaderCacheMagic || header->version != ShaderCacheVersion) {
+		SpConsole::Write(SP_MESSAGE_WARNING, "Shader cache has an unknown format, ignoring it");
+		unmapCacheFile();
+		return false;
+	}
+	if (header->compilerVersion != compilerVersion()) {
+		SpConsole::Write(SP_MESSAGE_INFO, "Shader compiler changed, ignoring shader cache");
+		unmapCacheFile();
+		return false;
+	}
+
+	size_t indexEnd = sizeof(CacheHeader) + static_cast<size_t>(header->entryCount) * sizeof(CacheEntry);
+	if (indexEnd > mMappedSize) {
+		SpConsole::Write(SP_MESSAGE_WARNING, "Shader cache is truncated, ignoring it");
+		unmapCacheFile();
+		return false;
+	}
+
+	const CacheEntry* entries = reinterpret_cast<const CacheEntry*>(mMappedData + sizeof(CacheHeader));
+	for (uint32 i = 0; i < header->entryCount; i++) {
+		// Compared without adding, a corrupt offset near the top of the range would wrap around the sum
+		if (entries[i].offset < indexEnd || entries[i].offset > mMappedSize || entries[i].size > mMappedSize - entries[i].offset) {
+			SpConsole::Write(SP_MESSAGE_WARNING, "Shader cache is corrupt, ignoring it");
+			unmapCacheFile();
+			return false;
+		}
+	}
+
+	mEntries = entries;
+	mEntryCount = header->entryCount;
+	return true;
+}
+
+void ShaderCache::unmapCacheFile() {
+	mCacheFile.close();
+
+	mMappedData = nullptr;
+	mMappedSize = 0;
+	mEntries = nullptr;
+	mEntryCount = 0;
+}
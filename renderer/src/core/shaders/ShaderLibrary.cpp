@@ -0,0 +1,214 @@
+//
+// Created by robsc on 11/25/25.
+//
+
+#include "ShaderLibrary.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+	bool stageFromExtension(const fs::path& path, ShaderStage& stage) {
+		std::string extension = path.extension().string();
+
+		if (extension == ".vert") {
+			stage = SP_SHADER_STAGE_VERTEX;
+		}else if (extension == ".frag") {
+			stage = SP_SHADER_STAGE_FRAGMENT;
+		}else if (extension == ".comp") {
+			stage = SP_SHADER_STAGE_COMPUTE;
+		}else {
+			return false;
+		}
+
+		return true;
+	}
+}
+
+void ShaderLibrary::compileAll(ShaderCache& shaderCache, const ShaderCompileSettings& settings, uint32 threadCount) {
+	SP_PROFILE_ZONE("ShaderLibrary::compileAll");
+
+	destroy();
+
+	const fs::path shaderDirectory = RENDERER_RESOURCE_DIR "/shaders";
+	for (const fs::path& path : findShaderSources(shaderDirectory)) {
+		ShaderModuleInfo info{};
+		info.name = path.lexically_relative(shaderDirectory).generic_string();
+		info.path = path;
+		stageFromExtension(path, info.stage);
+
+		mShaderIndices[info.name] = mShaders.size();
+		mShaders.push_back(info);
+	}
+
+	if (mShaders.empty()) {
+		SpConsole::Write(SP_MESSAGE_WARNING, "No shaders found in " RENDERER_RESOURCE_DIR "/shaders");
+		return;
+	}
+
+	if (threadCount == 0) {
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	mThreadCount = std::min(threadCount, static_cast<uint32>(mShaders.size()));
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	std::atomic<size_t> nextShader = 0;
+	std::vector<std::string> errors(mShaders.size());
+
+	auto worker = [&]() {
+		// Only built once this thread actually misses the cache
+		std::unique_ptr<shaderc::Compiler> compiler;
+
+		for (size_t i = nextShader++; i < mShaders.size(); i = nextShader++) {
+			SP_PROFILE_ZONE("Load shader");
+
+			ShaderModuleInfo& info = mShaders[i];
+			std::chrono::steady_clock::time_point shaderStart = std::chrono::steady_clock::now();
+
+			std::span<const uint32> cachedSpirv;
+			if (shaderCache.find(info.path, info.stage, settings, cachedSpirv)) {
+				if (!info.reflection.reflect(cachedSpirv)) {
+					errors[i] = info.name;
+				}
+				info.spirv.assign(cachedSpirv.begin(), cachedSpirv.end());
+				info.cached = true;
+			}else {
+				if (!compiler) {
+					compiler = std::make_unique<shaderc::Compiler>();
+				}
+
+				std::vector<std::string> includedFiles;
+				std::vector<uint32> spirv = Shader::compileShader(*compiler, info.path, info.stage, settings, includedFiles);
+
+				if (spirv.empty() || !info.reflection.reflect(spirv)) {
+					errors[i] = info.name;
+				}else {
+					shaderCache.store(info.path, info.stage, settings, includedFiles, spirv);
+					info.spirv = std::move(spirv);
+				}
+			}
+
+			info.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(mThreadCount - 1);
+	for (uint32 i = 1; i < mThreadCount; i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	mTotalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	bool failed = false;
+	for (const std::string& error : errors) {
+		if (error.empty()) continue;
+		SpConsole::Write(SP_MESSAGE_ERROR, "Failed to compile or reflect " + error);
+		failed = true;
+	}
+	if (failed) {
+		SpConsole::FatalExit("Shader compilation error", SP_FAILURE);
+	}
+
+	logCompileTimes();
+}
+
+void ShaderLibrary::createModules(VkDevice device) {
+	SP_PROFILE_ZONE("ShaderLibrary::createModules");
+
+	mDevice = device;
+	for (ShaderModuleInfo& info : mShaders) {
+		if (info.module == VK_NULL_HANDLE) {
+			info.module = Shader::createShaderModule(mDevice, info.spirv);
+		}
+
+		// The driver keeps its own copy
+		info.spirv.clear();
+		info.spirv.shrink_to_fit();
+	}
+}
+
+void ShaderLibrary::destroy() {
+	for (ShaderModuleInfo& info : mShaders) {
+		if (info.module != VK_NULL_HANDLE) {
+			vkDestroyShaderModule(mDevice, info.module, nullptr);
+		}
+	}
+
+	mShaders.clear();
+	mShaderIndices.clear();
+	mTotalMs = 0.0;
+	mThreadCount = 0;
+}
+
+VkShaderModule ShaderLibrary::getModule(const std::string& name) const {
+	auto it = mShaderIndices.find(name);
+	if (it == mShaderIndices.end()) {
+		SpConsole::FatalExit("Shader " + name + " is not in the shader library", SP_FAILURE);
+	}
+
+	return mShaders[it->second].module;
+}
+
+const SpRenderer::ShaderReflection& ShaderLibrary::getReflection(const std::string& name) const {
+	auto it = mShaderIndices.find(name);
+	if (it == mShaderIndices.end()) {
+		SpConsole::FatalExit("Shader " + name + " is not in the shader library", SP_FAILURE);
+	}
+
+	return mShaders[it->second].reflection;
+}
+
+const ShaderModuleInfo* ShaderLibrary::findShader(const std::string& name) const {
+	auto it = mShaderIndices.find(name);
+	if (it == mShaderIndices.end()) {
+		return nullptr;
+	}
+
+	return &mShaders[it->second];
+}
+
+const std::vector<ShaderModuleInfo>& ShaderLibrary::getShaders() const {
+	return mShaders;
+}
+
+void ShaderLibrary::logCompileTimes() const {
+	uint32 cachedCount = 0;
+	for (const ShaderModuleInfo& info : mShaders) {
+		if (info.cached) cachedCount++;
+
+		SP_LOG(SP_MESSAGE_VERBOSE, info.name + ": " + std::to_string(info.compileMs) + " ms" +
+		                                     (info.cached ? " (cached)" : ""));
+	}
+
+	SpConsole::Write(SP_MESSAGE_INFO, "Prepared " + std::to_string(mShaders.size()) + " shaders (" +
+	                                  std::to_string(cachedCount) + " cached) on " + std::to_string(mThreadCount) +
+	                                  " threads in " + std::to_string(mTotalMs) + " ms");
+}
+
+std::vector<fs::path> ShaderLibrary::findShaderSources(const fs::path& directory) {
+	std::vector<fs::path> sources;
+	if (!fs::exists(directory)) {
+		return sources;
+	}
+
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory)) {
+		ShaderStage stage;
+		if (entry.is_regular_file() && stageFromExtension(entry.path(), stage)) {
+			sources.push_back(entry.path());
+		}
+	}
+
+	// Directory iteration order is unspecified, keep the library order stable between runs
+	std::sort(sources.begin(), sources.end());
+	return sources;
+}
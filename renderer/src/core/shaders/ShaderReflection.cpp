@@ -0,0 +1,656 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "ShaderReflection.h"
+
+#include <cstring>
+
+namespace SpRenderer {
+	namespace {
+		const uint32 SpirvMagic = 0x07230203;
+		const uint32 SpirvHeaderWords = 5;
+		const uint32 NoDecoration = ~0u;
+		// Universal limits of the SPIR-V specification, anything past them comes from a corrupt module
+		const uint32 SpirvMaxIdBound = 0x3FFFFF;
+		const uint32 SpirvMaxStructMembers = 16383;
+
+		// The subset of the SPIR-V enums reflection looks at, values from the SPIR-V specification
+		enum SpirvOp : uint32 {
+			SPIRV_OP_NAME = 5,
+			SPIRV_OP_ENTRY_POINT = 15,
+			SPIRV_OP_TYPE_BOOL = 20,
+			SPIRV_OP_TYPE_INT = 21,
+			SPIRV_OP_TYPE_FLOAT = 22,
+			SPIRV_OP_TYPE_VECTOR = 23,
+			SPIRV_OP_TYPE_MATRIX = 24,
+			SPIRV_OP_TYPE_IMAGE = 25,
+			SPIRV_OP_TYPE_SAMPLER = 26,
+			SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+			SPIRV_OP_TYPE_ARRAY = 28,
+			SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+			SPIRV_OP_TYPE_STRUCT = 30,
+			SPIRV_OP_TYPE_POINTER = 32,
+			SPIRV_OP_CONSTANT = 43,
+			SPIRV_OP_SPEC_CONSTANT_TRUE = 48,
+			SPIRV_OP_SPEC_CONSTANT_FALSE = 49,
+			SPIRV_OP_SPEC_CONSTANT = 50,
+			SPIRV_OP_FUNCTION = 54,
+			SPIRV_OP_VARIABLE = 59,
+			SPIRV_OP_DECORATE = 71,
+			SPIRV_OP_MEMBER_DECORATE = 72,
+			SPIRV_OP_TYPE_ACCELERATION_STRUCTURE = 5341
+		};
+
+		enum SpirvDecoration : uint32 {
+			SPIRV_DECORATION_SPEC_ID = 1,
+			SPIRV_DECORATION_BLOCK = 2,
+			SPIRV_DECORATION_BUFFER_BLOCK = 3,
+			SPIRV_DECORATION_ARRAY_STRIDE = 6,
+			SPIRV_DECORATION_MATRIX_STRIDE = 7,
+			SPIRV_DECORATION_BUILT_IN = 11,
+			SPIRV_DECORATION_LOCATION = 30,
+			SPIRV_DECORATION_BINDING = 33,
+			SPIRV_DECORATION_DESCRIPTOR_SET = 34,
+			SPIRV_DECORATION_OFFSET = 35
+		};
+
+		enum SpirvStorageClass : uint32 {
+			SPIRV_STORAGE_UNIFORM_CONSTANT = 0,
+			SPIRV_STORAGE_INPUT = 1,
+			SPIRV_STORAGE_UNIFORM = 2,
+			SPIRV_STORAGE_PUSH_CONSTANT = 9,
+			SPIRV_STORAGE_STORAGE_BUFFER = 12
+		};
+
+		const uint32 SpirvDimBuffer = 5;
+		const uint32 SpirvDimSubpassData = 6;
+
+		struct SpirvMember {
+			uint32 offset = 0;
+			uint32 matrixStride = 0;
+		};
+
+		// Everything reflection needs to know about one result id
+		struct SpirvId {
+			uint32 opcode = 0;
+			const uint32* instruction = nullptr;
+			uint32 wordCount = 0;
+
+			std::string name;
+			uint32 set = NoDecoration;
+			uint32 binding = NoDecoration;
+			uint32 location = NoDecoration;
+			uint32 specId = NoDecoration;
+			uint32 arrayStride = 0;
+			bool builtIn = false;
+			bool bufferBlock = false;
+			std::vector<SpirvMember> members;
+		};
+
+		class SpirvModule {
+		public:
+			std::vector<SpirvId> ids;
+			std::vector<uint32> variables;
+			std::vector<uint32> specConstants;
+			VkShaderStageFlags stage = 0;
+			// Set by id() when an operand points past the bound, reflect() fails on it once it is done walking
+			mutable bool invalidReference = false;
+
+			bool parse(std::span<const uint32> spirv, std::string& error) {
+				if (spirv.size() < SpirvHeaderWords || spirv[0] != SpirvMagic) {
+					error = "Not SPIR-V";
+					return false;
+				}
+				if (spirv[3] > SpirvMaxIdBound) {
+					error = "Id bound " + std::to_string(spirv[3]) + " is past the SPIR-V limit";
+					return false;
+				}
+				ids.resize(spirv[3]);
+
+				for (size_t i = SpirvHeaderWords; i < spirv.size();) {
+					const uint32* instruction = spirv.data() + i;
+					uint32 wordCount = instruction[0] >> 16;
+					uint32 opcode = instruction[0] & 0xFFFF;
+					if (wordCount == 0 || i + wordCount > spirv.size()) {
+						error = "Truncated instruction at word " + std::to_string(i);
+						return false;
+					}
+
+					// Types, variables and decorations all come before the first function
+					if (opcode == SPIRV_OP_FUNCTION) {
+						break;
+					}
+					if (!parseInstruction(opcode, instruction, wordCount, error)) {
+						return false;
+					}
+					i += wordCount;
+				}
+
+				if (stage == 0) {
+					error = "No entry point with a supported execution model";
+					return false;
+				}
+				return true;
+			}
+
+			/*!
+			 * An empty id, which matches no opcode, when the id is past the bound
+			 */
+			const SpirvId& id(uint32 id) const {
+				static const SpirvId InvalidId{};
+				if (id >= ids.size()) {
+					invalidReference = true;
+					return InvalidId;
+				}
+				return ids[id];
+			}
+
+			/*!
+			 * 0 when the instruction is shorter, which is never a valid id
+			 */
+			uint32 operand(uint32 resultId, uint32 index) const {
+				const SpirvId& result = id(resultId);
+				return index < result.wordCount ? result.instruction[index] : 0;
+			}
+
+			uint32 constantValue(uint32 constantId) const {
+				const SpirvId& constant = id(constantId);
+				return constant.opcode == SPIRV_OP_CONSTANT ? constant.instruction[3] : 0;
+			}
+
+			uint32 typeSize(uint32 typeId, uint32 matrixStride = 0) const {
+				// record() made sure the fixed operands read here exist
+				const SpirvId& type = id(typeId);
+				switch (type.opcode) {
+					case SPIRV_OP_TYPE_BOOL:
+						return 4;
+					case SPIRV_OP_TYPE_INT:
+					case SPIRV_OP_TYPE_FLOAT:
+						return type.instruction[2] / 8;
+					case SPIRV_OP_TYPE_VECTOR:
+						return type.instruction[3] * typeSize(type.instruction[2]);
+					case SPIRV_OP_TYPE_MATRIX:
+						return type.instruction[3] * (matrixStride != 0 ? matrixStride : typeSize(type.instruction[2]));
+					case SPIRV_OP_TYPE_ARRAY: {
+						uint32 stride = type.arrayStride != 0 ? type.arrayStride : typeSize(type.instruction[2]);
+						return constantValue(type.instruction[3]) * stride;
+					}
+					case SPIRV_OP_TYPE_STRUCT: {
+						uint32 size = 0;
+						for (uint32 member = 0; member < type.wordCount - 2; member++) {
+							SpirvMember layout = member < type.members.size() ? type.members[member] : SpirvMember{};
+							size = std::max(size, layout.offset + typeSize(type.instruction[2 + member], layout.matrixStride));
+						}
+						return size;
+					}
+					default:
+						return 0;
+				}
+			}
+
+		private:
+			static std::string literalString(const uint32* words, uint32 wordCount) {
+				const char* characters = reinterpret_cast<const char*>(words);
+				return std::string(characters, strnlen(characters, wordCount * sizeof(uint32)));
+			}
+
+			bool validId(uint32 id, std::string& error) const {
+				if (id >= ids.size()) {
+					error = "Id " + std::to_string(id) + " is past the bound of the module";
+					return false;
+				}
+				return true;
+			}
+
+			SpirvMember& member(SpirvId& structId, uint32 index) {
+				if (structId.members.size() <= index) {
+					structId.members.resize(index + 1);
+				}
+				return structId.members[index];
+			}
+
+			bool parseInstruction(uint32 opcode, const uint32* instruction, uint32 wordCount, std::string& error) {
+				switch (opcode) {
+					case SPIRV_OP_NAME:
+						if (wordCount < 2 || !validId(instruction[1], error)) return false;
+						ids[instruction[1]].name = literalString(instruction + 2, wordCount - 2);
+						return true;
+
+					case SPIRV_OP_ENTRY_POINT:
+						// The first entry point decides the stage, the renderer compiles one per module
+						if (stage == 0 && wordCount >= 3) {
+							stage = executionModelStage(instruction[1]);
+						}
+						return true;
+
+					case SPIRV_OP_DECORATE: {
+						if (wordCount < 3 || !validId(instruction[1], error)) return false;
+						SpirvId& target = ids[instruction[1]];
+						uint32 value = wordCount > 3 ? instruction[3] : 0;
+						switch (instruction[2]) {
+							case SPIRV_DECORATION_SPEC_ID: target.specId = value; break;
+							case SPIRV_DECORATION_BUFFER_BLOCK: target.bufferBlock = true; break;
+							case SPIRV_DECORATION_ARRAY_STRIDE: target.arrayStride = value; break;
+							case SPIRV_DECORATION_BUILT_IN: target.builtIn = true; break;
+							case SPIRV_DECORATION_LOCATION: target.location = value; break;
+							case SPIRV_DECORATION_BINDING: target.binding = value; break;
+							case SPIRV_DECORATION_DESCRIPTOR_SET: target.set = value; break;
+							default: break;
+						}
+						return true;
+					}
+
+					case SPIRV_OP_MEMBER_DECORATE: {
+						if (wordCount < 4 || !validId(instruction[1], error)) return false;
+						if (instruction[2] >= SpirvMaxStructMembers) {
+							error = "Member " + std::to_string(instruction[2]) + " is past the SPIR-V limit";
+							return false;
+						}
+						SpirvId& target = ids[instruction[1]];
+						uint32 value = wordCount > 4 ? instruction[4] : 0;
+						if (instruction[3] == SPIRV_DECORATION_OFFSET) {
+							member(target, instruction[2]).offset = value;
+						}else if (instruction[3] == SPIRV_DECORATION_MATRIX_STRIDE) {
+							member(target, instruction[2]).matrixStride = value;
+						}else if (instruction[3] == SPIRV_DECORATION_BUILT_IN) {
+							target.builtIn = true;
+						}
+						return true;
+					}
+
+					case SPIRV_OP_TYPE_BOOL:
+					case SPIRV_OP_TYPE_INT:
+					case SPIRV_OP_TYPE_FLOAT:
+					case SPIRV_OP_TYPE_VECTOR:
+					case SPIRV_OP_TYPE_MATRIX:
+					case SPIRV_OP_TYPE_IMAGE:
+					case SPIRV_OP_TYPE_SAMPLER:
+					case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+					case SPIRV_OP_TYPE_ARRAY:
+					case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+					case SPIRV_OP_TYPE_STRUCT:
+					case SPIRV_OP_TYPE_POINTER:
+					case SPIRV_OP_TYPE_ACCELERATION_STRUCTURE:
+						return record(instruction[1], opcode, instruction, wordCount, error);
+
+					case SPIRV_OP_CONSTANT:
+						return wordCount >= 4 && record(instruction[2], opcode, instruction, wordCount, error);
+
+					case SPIRV_OP_SPEC_CONSTANT_TRUE:
+					case SPIRV_OP_SPEC_CONSTANT_FALSE:
+					case SPIRV_OP_SPEC_CONSTANT:
+						if (wordCount < 3 || !record(instruction[2], opcode, instruction, wordCount, error)) return false;
+						specConstants.push_back(instruction[2]);
+						return true;
+
+					case SPIRV_OP_VARIABLE:
+						if (wordCount < 4 || !record(instruction[2], opcode, instruction, wordCount, error)) return false;
+						variables.push_back(instruction[2]);
+						return true;
+
+					default:
+						return true;
+				}
+			}
+
+			bool record(uint32 resultId, uint32 opcode, const uint32* instruction, uint32 wordCount, std::string& error) {
+				if (wordCount < fixedWordCount(opcode)) {
+					error = "Instruction with opcode " + std::to_string(opcode) + " is missing operands";
+					return false;
+				}
+				if (!validId(resultId, error)) {
+					return false;
+				}
+				ids[resultId].opcode = opcode;
+				ids[resultId].instruction = instruction;
+				ids[resultId].wordCount = wordCount;
+				return true;
+			}
+
+			// Words up to the last operand reflection reads without checking, the result id is always one of them
+			static uint32 fixedWordCount(uint32 opcode) {
+				switch (opcode) {
+					case SPIRV_OP_TYPE_IMAGE: return 9;
+					case SPIRV_OP_TYPE_INT:
+					case SPIRV_OP_TYPE_VECTOR:
+					case SPIRV_OP_TYPE_MATRIX:
+					case SPIRV_OP_TYPE_ARRAY:
+					case SPIRV_OP_TYPE_POINTER:
+					case SPIRV_OP_CONSTANT:
+					case SPIRV_OP_VARIABLE: return 4;
+					case SPIRV_OP_TYPE_FLOAT:
+					case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+					case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+					case SPIRV_OP_SPEC_CONSTANT_TRUE:
+					case SPIRV_OP_SPEC_CONSTANT_FALSE:
+					case SPIRV_OP_SPEC_CONSTANT: return 3;
+					default: return 2;
+				}
+			}
+
+			static VkShaderStageFlags executionModelStage(uint32 executionModel) {
+				switch (executionModel) {
+					case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+					case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+					case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+					case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+					case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+					case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+					default: return 0;
+				}
+			}
+		};
+
+		VkDescriptorType descriptorType(const SpirvModule& module, uint32 storageClass, uint32 typeId) {
+			const SpirvId& type = module.id(typeId);
+
+			if (storageClass == SPIRV_STORAGE_STORAGE_BUFFER) {
+				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			}
+			if (storageClass == SPIRV_STORAGE_UNIFORM) {
+				// Older GLSL output marks storage buffers as BufferBlock in the Uniform storage class
+				return type.bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+
+			switch (type.opcode) {
+				case SPIRV_OP_TYPE_SAMPLER:
+					return VK_DESCRIPTOR_TYPE_SAMPLER;
+				case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+					return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				case SPIRV_OP_TYPE_ACCELERATION_STRUCTURE:
+					return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+				case SPIRV_OP_TYPE_IMAGE: {
+					uint32 dim = type.instruction[3];
+					bool storage = type.instruction[7] == 2;
+					if (dim == SpirvDimBuffer) {
+						return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					}
+					if (dim == SpirvDimSubpassData) {
+						return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					}
+					return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+				}
+				default:
+					return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			}
+		}
+
+		bool reflectVertexInput(const SpirvModule& module, const SpirvId& variable, uint32 typeId,
+		                        ReflectedVertexInput& input, std::string& error) {
+			const SpirvId* type = &module.id(typeId);
+			input.componentCount = 1;
+			if (type->opcode == SPIRV_OP_TYPE_VECTOR) {
+				input.componentCount = type->instruction[3];
+				type = &module.id(type->instruction[2]);
+			}
+
+			if (type->opcode == SPIRV_OP_TYPE_FLOAT) {
+				input.type = SP_VERTEX_INPUT_FLOAT;
+			}else if (type->opcode == SPIRV_OP_TYPE_INT) {
+				input.type = type->instruction[3] != 0 ? SP_VERTEX_INPUT_SINT : SP_VERTEX_INPUT_UINT;
+			}else {
+				error = "Vertex input " + variable.name + " is not a scalar or vector, arrays and matrices are not supported";
+				return false;
+			}
+
+			input.location = variable.location;
+			input.name = variable.name;
+			return true;
+		}
+	}
+
+	bool ShaderReflection::reflect(std::span<const uint32> spirv) {
+		*this = {};
+
+		SpirvModule module;
+		std::string error;
+		if (!module.parse(spirv, error)) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "SPIR-V reflection failed: " + error);
+			return false;
+		}
+		stages = module.stage;
+
+		for (uint32 variableId : module.variables) {
+			const SpirvId& variable = module.id(variableId);
+			uint32 pointerId = variable.instruction[1];
+			uint32 storageClass = variable.instruction[3];
+			uint32 typeId = module.operand(pointerId, 3);
+
+			switch (storageClass) {
+				case SPIRV_STORAGE_UNIFORM_CONSTANT:
+				case SPIRV_STORAGE_UNIFORM:
+				case SPIRV_STORAGE_STORAGE_BUFFER: {
+					ReflectedBinding binding{};
+					binding.set = variable.set != NoDecoration ? variable.set : 0;
+					binding.binding = variable.binding != NoDecoration ? variable.binding : 0;
+					binding.stages = stages;
+					binding.name = variable.name;
+
+					// Arrays of resources become the descriptor count, arrays of arrays multiply
+					while (module.id(typeId).opcode == SPIRV_OP_TYPE_ARRAY || module.id(typeId).opcode == SPIRV_OP_TYPE_RUNTIME_ARRAY) {
+						if (module.id(typeId).opcode == SPIRV_OP_TYPE_RUNTIME_ARRAY) {
+							binding.count = 0;
+						}else {
+							binding.count *= module.constantValue(module.operand(typeId, 3));
+						}
+						typeId = module.operand(typeId, 2);
+					}
+
+					binding.type = descriptorType(module, storageClass, typeId);
+					if (binding.type == VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+						SpConsole::Write(SP_MESSAGE_ERROR, "SPIR-V reflection failed: unknown descriptor type for " + variable.name);
+						return false;
+					}
+					if (binding.name.empty()) {
+						binding.name = module.id(typeId).name;
+					}
+					bindings.push_back(binding);
+					break;
+				}
+
+				case SPIRV_STORAGE_PUSH_CONSTANT: {
+					const SpirvId& block = module.id(typeId);
+					uint32 offset = std::numeric_limits<uint32>::max();
+					for (const SpirvMember& member : block.members) {
+						offset = std::min(offset, member.offset);
+					}
+					if (block.members.empty()) {
+						offset = 0;
+					}
+
+					VkPushConstantRange range{};
+					range.stageFlags = stages;
+					range.offset = offset;
+					range.size = module.typeSize(typeId) - offset;
+					pushConstants.push_back(range);
+					break;
+				}
+
+				case SPIRV_STORAGE_INPUT: {
+					if (stages != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn || module.id(typeId).builtIn ||
+					    variable.location == NoDecoration) {
+						break;
+					}
+
+					ReflectedVertexInput input{};
+					if (!reflectVertexInput(module, variable, typeId, input, error)) {
+						SpConsole::Write(SP_MESSAGE_ERROR, "SPIR-V reflection failed: " + error);
+						return false;
+					}
+					inputs.push_back(input);
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+
+		for (uint32 constantId : module.specConstants) {
+			const SpirvId& constant = module.id(constantId);
+			if (constant.specId == NoDecoration) {
+				continue;
+			}
+
+			ReflectedSpecConstant specConstant{};
+			specConstant.id = constant.specId;
+			specConstant.name = constant.name;
+			if (constant.opcode == SPIRV_OP_SPEC_CONSTANT) {
+				specConstant.size = module.typeSize(constant.instruction[1]);
+				specConstant.defaultValue = constant.wordCount > 3 ? constant.instruction[3] : 0;
+			}else {
+				specConstant.size = sizeof(VkBool32);
+				specConstant.defaultValue = constant.opcode == SPIRV_OP_SPEC_CONSTANT_TRUE ? VK_TRUE : VK_FALSE;
+			}
+			specConstants.push_back(specConstant);
+		}
+
+		if (module.invalidReference) {
+			SpConsole::Write(SP_MESSAGE_ERROR, "SPIR-V reflection failed: an operand refers to an id past the bound of the module");
+			*this = {};
+			return false;
+		}
+
+		std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		std::sort(inputs.begin(), inputs.end(), [](const ReflectedVertexInput& a, const ReflectedVertexInput& b) {
+			return a.location < b.location;
+		});
+		return true;
+	}
+
+	void ShaderReflection::merge(const ShaderReflection& other) {
+		stages |= other.stages;
+
+		for (const ReflectedBinding& binding : other.bindings) {
+			auto it = std::find_if(bindings.begin(), bindings.end(), [&binding](const ReflectedBinding& existing) {
+				return existing.set == binding.set && existing.binding == binding.binding;
+			});
+
+			if (it == bindings.end()) {
+				bindings.push_back(binding);
+				continue;
+			}
+			if (it->type != binding.type || it->count != binding.count) {
+				SpConsole::FatalExit("Set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) +
+				                     " is declared differently by " + it->name + " and " + binding.name, SP_FAILURE);
+			}
+			it->stages |= binding.stages;
+		}
+
+		for (const VkPushConstantRange& range : other.pushConstants) {
+			auto it = std::find_if(pushConstants.begin(), pushConstants.end(), [&range](const VkPushConstantRange& existing) {
+				return existing.stageFlags == range.stageFlags;
+			});
+
+			if (it == pushConstants.end()) {
+				pushConstants.push_back(range);
+				continue;
+			}
+			uint32 end = std::max(it->offset + it->size, range.offset + range.size);
+			it->offset = std::min(it->offset, range.offset);
+			it->size = end - it->offset;
+		}
+
+		for (const ReflectedVertexInput& input : other.inputs) {
+			auto it = std::find_if(inputs.begin(), inputs.end(), [&input](const ReflectedVertexInput& existing) {
+				return existing.location == input.location;
+			});
+			if (it == inputs.end()) {
+				inputs.push_back(input);
+			}
+		}
+
+		for (const ReflectedSpecConstant& specConstant : other.specConstants) {
+			auto it = std::find_if(specConstants.begin(), specConstants.end(), [&specConstant](const ReflectedSpecConstant& existing) {
+				return existing.id == specConstant.id;
+			});
+			if (it == specConstants.end()) {
+				specConstants.push_back(specConstant);
+			}
+		}
+
+		std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		std::sort(inputs.begin(), inputs.end(), [](const ReflectedVertexInput& a, const ReflectedVertexInput& b) {
+			return a.location < b.location;
+		});
+	}
+
+	uint32 ShaderReflection::setCount() const {
+		return bindings.empty() ? 0 : bindings.back().set + 1;
+	}
+
+	std::vector<VkDescriptorSetLayoutBinding> ShaderReflection::setLayoutBindings(uint32 set) const {
+		std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+		for (const ReflectedBinding& binding : bindings) {
+			if (binding.set != set) continue;
+
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding.binding;
+			layoutBinding.descriptorType = binding.type;
+			layoutBinding.descriptorCount = binding.count;
+			layoutBinding.stageFlags = binding.stages;
+			layoutBindings.push_back(layoutBinding);
+		}
+		return layoutBindings;
+	}
+
+	bool ShaderReflection::validateVertexInput(const VkPipelineVertexInputStateCreateInfo& vertexInputInfo, std::string& error) const {
+		std::span<const VkVertexInputAttributeDescription> attributes(vertexInputInfo.pVertexAttributeDescriptions,
+		                                                              vertexInputInfo.vertexAttributeDescriptionCount);
+
+		for (const ReflectedVertexInput& input : inputs) {
+			auto it = std::find_if(attributes.begin(), attributes.end(), [&input](const VkVertexInputAttributeDescription& attribute) {
+				return attribute.location == input.location;
+			});
+
+			if (it == attributes.end()) {
+				error = "Vertex input " + input.name + " at location " + std::to_string(input.location) + " has no attribute";
+				return false;
+			}
+			if (vertexInputType(it->format) != input.type) {
+				error = "Vertex input " + input.name + " at location " + std::to_string(input.location) +
+				        " is read as a different numeric type than its attribute format provides";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	VertexInputType vertexInputType(VkFormat format) {
+		switch (format) {
+			case VK_FORMAT_R8_UINT:
+			case VK_FORMAT_R8G8_UINT:
+			case VK_FORMAT_R8G8B8A8_UINT:
+			case VK_FORMAT_R16_UINT:
+			case VK_FORMAT_R16G16_UINT:
+			case VK_FORMAT_R16G16B16A16_UINT:
+			case VK_FORMAT_R32_UINT:
+			case VK_FORMAT_R32G32_UINT:
+			case VK_FORMAT_R32G32B32_UINT:
+			case VK_FORMAT_R32G32B32A32_UINT:
+			case VK_FORMAT_A2B10G10R10_UINT_PACK32:
+				return SP_VERTEX_INPUT_UINT;
+
+			case VK_FORMAT_R8_SINT:
+			case VK_FORMAT_R8G8_SINT:
+			case VK_FORMAT_R8G8B8A8_SINT:
+			case VK_FORMAT_R16_SINT:
+			case VK_FORMAT_R16G16_SINT:
+			case VK_FORMAT_R16G16B16A16_SINT:
+			case VK_FORMAT_R32_SINT:
+			case VK_FORMAT_R32G32_SINT:
+			case VK_FORMAT_R32G32B32_SINT:
+			case VK_FORMAT_R32G32B32A32_SINT:
+			case VK_FORMAT_A2B10G10R10_SINT_PACK32:
+				return SP_VERTEX_INPUT_SINT;
+
+			default:
+				return SP_VERTEX_INPUT_FLOAT;
+		}
+	}
+} // SpRenderer
@@ -0,0 +1,346 @@
+//
+// Created by robsc on 11/28/25.
+//
+
+#include "SpriteBatcher.h"
+#include "Profiler.h"
+
+#include <bit>
+
+namespace SpRenderer {
+	// The shader scales the corners by the sprite size, snorm16 rounding moves them by under 1/32767 of it
+	const std::array<Vertex2DPacked, 4> QuadVertices = {{
+		packVertex(Vertex2D{vec2(-0.5f, -0.5f), vec2(0.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f)}),
+		packVertex(Vertex2D{vec2(0.5f, -0.5f), vec2(1.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f)}),
+		packVertex(Vertex2D{vec2(0.5f, 0.5f), vec2(1.0f, 1.0f), vec3(1.0f, 1.0f, 1.0f)}),
+		packVertex(Vertex2D{vec2(-0.5f, 0.5f), vec2(0.0f, 1.0f), vec3(1.0f, 1.0f, 1.0f)})
+	}};
+	const std::array<uint16, 6> QuadIndices = {0, 1, 2, 2, 3, 0};
+
+	void SpriteBatcher::init(VkDevice device, MemoryAllocator& allocator, uint32 framesInFlight) {
+		mDevice = device;
+		mAllocator = &allocator;
+
+		createQuadBuffer();
+
+		mFrames.resize(framesInFlight);
+		for (FrameInstances& frame : mFrames) {
+			reserveInstances(frame, InitialSpriteCapacity);
+		}
+
+		mSprites.reserve(InitialSpriteCapacity);
+	}
+
+	void SpriteBatcher::destroy() {
+		for (FrameInstances& frame : mFrames) {
+			if (frame.buffer != VK_NULL_HANDLE) {
+				mAllocator->destroyBuffer(frame.buffer, frame.allocation);
+			}
+		}
+		mFrames.clear();
+
+		if (mQuadBuffer != VK_NULL_HANDLE) {
+			mAllocator->destroyBuffer(mQuadBuffer, mQuadAllocation);
+			mQuadBuffer = VK_NULL_HANDLE;
+		}
+
+		mPipelines.clear();
+		mSprites.clear();
+	}
+
+	uint32 SpriteBatcher::registerPipeline(VkPipeline pipeline, VkPipelineLayout layout) {
+		if (mPipelines.size() >= MaxSpritePipelines) {
+			SpConsole::FatalExit("Too many sprite pipelines registered!", SP_FAILURE);
+		}
+
+		mPipelines.push_back({pipeline, layout});
+		return static_cast<uint32>(mPipelines.size() - 1);
+	}
+
+	uint32 SpriteBatcher::registerPipeline(const PipelineRegistry& registry, PipelineKey key, VkPipelineLayout layout) {
+		if (mPipelines.size() >= MaxSpritePipelines) {
+			SpConsole::FatalExit("Too many sprite pipelines registered!", SP_FAILURE);
+		}
+
+		mPipelines.push_back({VK_NULL_HANDLE, layout, &registry, key});
+		return static_cast<uint32>(mPipelines.size() - 1);
+	}
+
+	void SpriteBatcher::draw(const Sprite& sprite) {
+		mSprites.push_back(sprite);
+	}
+
+	void SpriteBatcher::draw(std::span<const Sprite> sprites) {
+		mSprites.insert(mSprites.end(), sprites.begin(), sprites.end());
+	}
+
+	void SpriteBatcher::prepare(uint32 frameIndex) {
+		SP_PROFILE_ZONE("SpriteBatcher::prepare");
+
+		using Clock = std::chrono::steady_clock;
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+
+		FrameInstances& frame = mFrames[frameIndex];
+		frame.batches.clear();
+
+		uint32 spriteCount = static_cast<uint32>(mSprites.size());
+		mStats.spriteCount = spriteCount;
+		mStats.batchCount = 0;
+		if (spriteCount == 0) {
+			mStats.sortMs = 0.0;
+			mStats.writeMs = 0.0;
+			return;
+		}
+
+		Clock::time_point sortStart = Clock::now();
+
+		mKeys.resize(spriteCount);
+		mOrder.resize(spriteCount);
+		mKeysScratch.resize(spriteCount);
+		mOrderScratch.resize(spriteCount);
+
+		for (uint32 i = 0; i < spriteCount; i++) {
+			mKeys[i] = sortKey(mSprites[i]);
+			mOrder[i] = i;
+		}
+
+		radixSort(mKeys, mOrder, mKeysScratch, mOrderScratch);
+
+		Clock::time_point writeStart = Clock::now();
+
+		reserveInstances(frame, spriteCount);
+		packInstances(mSprites, mKeys, mOrder, static_cast<SpriteInstance*>(frame.allocation.mappedData), frame.batches);
+
+		mAllocator->flush(frame.allocation, 0, static_cast<VkDeviceSize>(spriteCount) * sizeof(SpriteInstance));
+		mSprites.clear();
+
+		Clock::time_point writeEnd = Clock::now();
+		mStats.sortMs = Milliseconds(writeStart - sortStart).count();
+		mStats.writeMs = Milliseconds(writeEnd - writeStart).count();
+		mStats.batchCount = static_cast<uint32>(frame.batches.size());
+	}
+
+	void SpriteBatcher::record(VkCommandBuffer commandBuffer, uint32 frameIndex, VkExtent2D extent) {
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point recordStart = Clock::now();
+
+		uint32 pipelineBinds = recordRange(commandBuffer, frameIndex, extent, 0, getInstanceCount(frameIndex));
+
+		setRecordStats(pipelineBinds, std::chrono::duration<double, std::milli>(Clock::now() - recordStart).count());
+	}
+
+	uint32 SpriteBatcher::recordRange(VkCommandBuffer commandBuffer,
+	                                  uint32 frameIndex,
+	                                  VkExtent2D extent,
+	                                  uint32 firstInstance,
+	                                  uint32 instanceCount) const {
+		const FrameInstances& frame = mFrames[frameIndex];
+		uint32 endInstance = firstInstance + instanceCount;
+		uint32 pipelineBinds = 0;
+
+		if (instanceCount == 0 || frame.batches.empty()) {
+			return pipelineBinds;
+		}
+
+		// Pixels with the origin in the top left to clip space
+		std::array<float, 4> viewportTransform = {
+			2.0f / static_cast<float>(extent.width), 2.0f / static_cast<float>(extent.height), -1.0f, -1.0f
+		};
+
+		std::array<VkBuffer, 2> vertexBuffers = {mQuadBuffer, frame.buffer};
+		std::array<VkDeviceSize, 2> offsets = {0, 0};
+		vkCmdBindVertexBuffers(commandBuffer, 0, static_cast<uint32>(vertexBuffers.size()), vertexBuffers.data(), offsets.data());
+		vkCmdBindIndexBuffer(commandBuffer, mQuadBuffer, mQuadIndexOffset, VK_INDEX_TYPE_UINT16);
+
+		uint32 boundPipeline = std::numeric_limits<uint32>::max();
+		for (const SpriteBatch& batch : frame.batches) {
+			// Only the part of the batch inside the range
+			uint32 batchBegin = std::max(batch.firstInstance, firstInstance);
+			uint32 batchEnd = std::min(batch.firstInstance + batch.instanceCount, endInstance);
+			if (batchBegin >= batchEnd) {
+				continue;
+			}
+
+			if (batch.pipeline != boundPipeline) {
+				const PipelineEntry& entry = mPipelines.at(batch.pipeline);
+				VkPipeline pipeline = entry.registry != nullptr ? entry.registry->get(entry.key) : entry.pipeline;
+				if (pipeline == VK_NULL_HANDLE) {
+					// Still compiling, the sprites show up once it is done
+					continue;
+				}
+
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				vkCmdPushConstants(commandBuffer, entry.layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+				                   sizeof(viewportTransform), viewportTransform.data());
+				boundPipeline = batch.pipeline;
+				pipelineBinds++;
+			}
+
+			vkCmdDrawIndexed(commandBuffer, static_cast<uint32>(QuadIndices.size()), batchEnd - batchBegin, 0, 0, batchBegin);
+		}
+
+		return pipelineBinds;
+	}
+
+	uint32 SpriteBatcher::getInstanceCount(uint32 frameIndex) const {
+		const FrameInstances& frame = mFrames[frameIndex];
+		if (frame.batches.empty()) {
+			return 0;
+		}
+
+		const SpriteBatch& last = frame.batches.back();
+		return last.firstInstance + last.instanceCount;
+	}
+
+	void SpriteBatcher::setRecordStats(uint32 pipelineBinds, double recordMs) {
+		mStats.pipelineBinds = pipelineBinds;
+		mStats.recordMs = recordMs;
+	}
+
+	void SpriteBatcher::radixSort(std::vector<uint64>& keys,
+	                              std::vector<uint32>& values,
+	                              std::vector<uint64>& keysScratch,
+	                              std::vector<uint32>& valuesScratch) {
+		const size_t count = keys.size();
+		if (count < 2) {
+			return;
+		}
+
+		// One read of the keys builds the histograms of all eight passes
+		std::array<std::array<uint32, 256>, 8> histograms{};
+		for (size_t i = 0; i < count; i++) {
+			uint64 key = keys[i];
+			for (uint32 pass = 0; pass < 8; pass++) {
+				histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+			}
+		}
+
+		uint64* sourceKeys = keys.data();
+		uint32* sourceValues = values.data();
+		uint64* destinationKeys = keysScratch.data();
+		uint32* destinationValues = valuesScratch.data();
+
+		for (uint32 pass = 0; pass < 8; pass++) {
+			std::array<uint32, 256>& histogram = histograms[pass];
+
+			uint32 shift = pass * 8;
+			if (histogram[(sourceKeys[0] >> shift) & 0xFF] == count) {
+				continue;
+			}
+
+			uint32 offset = 0;
+			for (uint32& bucket : histogram) {
+				uint32 bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				uint32 destination = histogram[(sourceKeys[i] >> shift) & 0xFF]++;
+				destinationKeys[destination] = sourceKeys[i];
+				destinationValues[destination] = sourceValues[i];
+			}
+
+			std::swap(sourceKeys, destinationKeys);
+			std::swap(sourceValues, destinationValues);
+		}
+
+		// An odd number of passes ran, the sorted data is in the scratch buffers
+		if (sourceKeys != keys.data()) {
+			keys.swap(keysScratch);
+			values.swap(valuesScratch);
+		}
+	}
+
+	void SpriteBatcher::createQuadBuffer() {
+		mQuadIndexOffset = sizeof(QuadVertices);
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = sizeof(QuadVertices) + sizeof(QuadIndices);
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// Small enough that reading it from host visible memory costs nothing, and it needs no upload
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, mQuadBuffer, mQuadAllocation);
+
+		char* data = static_cast<char*>(mQuadAllocation.mappedData);
+		std::memcpy(data, QuadVertices.data(), sizeof(QuadVertices));
+		std::memcpy(data + mQuadIndexOffset, QuadIndices.data(), sizeof(QuadIndices));
+		mAllocator->flush(mQuadAllocation);
+	}
+
+	void SpriteBatcher::reserveInstances(FrameInstances& frame, uint32 spriteCount) {
+		if (frame.capacity >= spriteCount) {
+			return;
+		}
+
+		// Only called once the frame's fence was waited on, so the old buffer is no longer read
+		if (frame.buffer != VK_NULL_HANDLE) {
+			mAllocator->destroyBuffer(frame.buffer, frame.allocation);
+		}
+
+		uint32 capacity = std::max(frame.capacity, InitialSpriteCapacity);
+		while (capacity < spriteCount) {
+			capacity *= 2;
+		}
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = static_cast<VkDeviceSize>(capacity) * sizeof(SpriteInstance);
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// Device local and host visible when the device exposes it, so the GPU reads instances from VRAM
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		mAllocator->createBuffer(bufferCreateInfo, allocationInfo, frame.buffer, frame.allocation);
+		frame.capacity = capacity;
+	}
+
+	void SpriteBatcher::packInstances(std::span<const Sprite> sprites,
+	                                  std::span<const uint64> keys,
+	                                  std::span<const uint32> order,
+	                                  SpriteInstance* instances,
+	                                  std::vector<SpriteBatch>& batches) {
+		// Written front to back in one pass, the mapped memory is usually write combined
+		uint64 batchKey = ~0ull;
+		for (uint32 i = 0; i < static_cast<uint32>(order.size()); i++) {
+			const Sprite& sprite = sprites[order[i]];
+
+			SpriteInstance instance;
+			instance.position = sprite.position;
+			instance.size = sprite.size;
+			instance.uvRect = sprite.uvRect;
+			instance.color = std::bit_cast<Unorm8x4>(sprite.color);
+			instance.rotation = sprite.rotation;
+			instance.depth = sprite.depth;
+			instance.texture = sprite.texture;
+			instances[i] = instance;
+
+			// Textures are indexed out of the bindless table per instance, only a new pipeline needs a new draw
+			uint64 key = keys[i] >> 56;
+			if (key != batchKey) {
+				batches.push_back({sprite.pipeline, i, 0});
+				batchKey = key;
+			}
+			batches.back().instanceCount++;
+		}
+	}
+
+	uint64 SpriteBatcher::sortKey(const Sprite& sprite) {
+		// Flip floats so their bit patterns order like their values, negatives included
+		uint32 depthBits = std::bit_cast<uint32>(sprite.depth);
+		depthBits ^= (depthBits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+
+		return (static_cast<uint64>(sprite.pipeline & 0xFF) << 56) |
+		       (static_cast<uint64>(sprite.texture & 0xFFFFFF) << 32) |
+		       depthBits;
+	}
+} // SpRenderer
@@ -0,0 +1,114 @@
+//
+// Created by robsc on 11/28/25.
+//
+
+#include "SpriteBenchmark.h"
+#include "RendererCore.h"
+
+namespace SpRenderer {
+	const double SpriteBenchmarkLogSeconds = 2.0;
+
+	void SpriteBenchmark::init(uint32 spriteCount, uint32 textureCount, uint32 pipelineCount, uint32 seed) {
+		mRandom.seed(seed);
+		mSprites.resize(spriteCount);
+		mMotion.resize(spriteCount);
+
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_int_distribution<uint32> color(0, 0xFFFFFF);
+		std::uniform_int_distribution<uint32> texture(0, std::max(textureCount, 1u) - 1);
+		std::uniform_int_distribution<uint32> pipeline(0, std::max(pipelineCount, 1u) - 1);
+
+		for (uint32 i = 0; i < spriteCount; i++) {
+			Sprite& sprite = mSprites[i];
+			// Positions start normalized and are scaled to the window on the first update
+			sprite.position = vec2(unit(mRandom), unit(mRandom));
+			sprite.size = vec2(4.0f + unit(mRandom) * 28.0f);
+			sprite.color = color(mRandom) | 0xFF000000;
+			sprite.rotation = unit(mRandom) * 6.2831853f;
+			sprite.depth = unit(mRandom);
+			sprite.texture = texture(mRandom);
+			sprite.pipeline = pipeline(mRandom);
+
+			mMotion[i].velocity = (vec2(unit(mRandom), unit(mRandom)) - 0.5f) * 400.0f;
+			mMotion[i].spin = (unit(mRandom) - 0.5f) * 4.0f;
+		}
+
+		mFrameCount = 0;
+		mSpritesDrawn = 0;
+		mCpuMs = 0.0;
+		mSecondsSinceLog = 0.0;
+		mWindowFrames = 0;
+		mWindowSprites = 0;
+		mWindowCpuMs = 0.0;
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Sprite benchmark: " + std::to_string(spriteCount) + " sprites, " +
+		                 std::to_string(textureCount) + " textures, " + std::to_string(pipelineCount) + " pipelines");
+	}
+
+	void SpriteBenchmark::update(RendererCore& renderer, double deltaSeconds) {
+		VkExtent2D extent = renderer.getWindowExtent();
+		vec2 bounds(static_cast<float>(extent.width), static_cast<float>(extent.height));
+		float delta = static_cast<float>(deltaSeconds);
+
+		if (mFrameCount == 0) {
+			for (Sprite& sprite : mSprites) {
+				sprite.position = sprite.position * bounds;
+			}
+		}
+
+		// The previous frame's batcher timings belong to the sprites submitted last update
+		if (mFrameCount != 0) {
+			const SpriteBatchStats& stats = renderer.getSpriteStats();
+			double batcherMs = stats.sortMs + stats.writeMs + stats.recordMs;
+			mCpuMs += batcherMs;
+			mWindowCpuMs += batcherMs;
+			mLastBatchCount = stats.batchCount;
+		}
+
+		std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < mSprites.size(); i++) {
+			Sprite& sprite = mSprites[i];
+			SpriteMotion& motion = mMotion[i];
+
+			sprite.position = sprite.position + motion.velocity * delta;
+			sprite.rotation += motion.spin * delta;
+
+			if (sprite.position.x < 0.0f || sprite.position.x > bounds.x) {
+				motion.velocity.x = -motion.velocity.x;
+			}
+			if (sprite.position.y < 0.0f || sprite.position.y > bounds.y) {
+				motion.velocity.y = -motion.velocity.y;
+			}
+		}
+		renderer.drawSprites(mSprites);
+
+		double submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+
+		mCpuMs += submitMs;
+		mWindowCpuMs += submitMs;
+		mSpritesDrawn += mSprites.size();
+		mWindowSprites += mSprites.size();
+		mFrameCount++;
+		mWindowFrames++;
+
+		mSecondsSinceLog += deltaSeconds;
+		if (mSecondsSinceLog >= SpriteBenchmarkLogSeconds) {
+			double spritesPerMs = mWindowCpuMs > 0.0 ? static_cast<double>(mWindowSprites) / mWindowCpuMs : 0.0;
+			SpConsole::Write(SP_MESSAGE_INFO, "Sprite benchmark: " + std::to_string(spritesPerMs) + " sprites/ms CPU, " +
+			                 std::to_string(mWindowCpuMs / static_cast<double>(mWindowFrames)) + " ms/frame, " +
+			                 std::to_string(mLastBatchCount) + " batches");
+
+			mSecondsSinceLog = 0.0;
+			mWindowFrames = 0;
+			mWindowSprites = 0;
+			mWindowCpuMs = 0.0;
+		}
+	}
+
+	void SpriteBenchmark::logResults() const {
+		double spritesPerMs = mCpuMs > 0.0 ? static_cast<double>(mSpritesDrawn) / mCpuMs : 0.0;
+		SpConsole::Write(SP_MESSAGE_INFO, "Sprite benchmark finished: " + std::to_string(mFrameCount) + " frames, " +
+		                 std::to_string(spritesPerMs) + " sprites/ms CPU");
+	}
+} // SpRenderer
@@ -0,0 +1,234 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "BlockCompression.h"
+
+namespace SpRenderer {
+	namespace {
+		uint16 readUint16(const uint8* data) {
+			return static_cast<uint16>(data[0] | (data[1] << 8));
+		}
+
+		uint32 readUint32(const uint8* data) {
+			return static_cast<uint32>(data[0]) | (static_cast<uint32>(data[1]) << 8) |
+			       (static_cast<uint32>(data[2]) << 16) | (static_cast<uint32>(data[3]) << 24);
+		}
+
+		void unpack565(uint16 color, uint8* rgb) {
+			uint8 r = (color >> 11) & 0x1F;
+			uint8 g = (color >> 5) & 0x3F;
+			uint8 b = color & 0x1F;
+			rgb[0] = static_cast<uint8>((r << 3) | (r >> 2));
+			rgb[1] = static_cast<uint8>((g << 2) | (g >> 4));
+			rgb[2] = static_cast<uint8>((b << 3) | (b >> 2));
+		}
+
+		/**
+		 * BC1 color block, also the color half of BC3
+		 *
+		 * @param texels 16 RGBA texels, row major
+		 * @param alwaysOpaque BC3 color blocks never use the three color mode with transparent black
+		 */
+		void decodeColorBlock(const uint8* block, uint8* texels, bool alwaysOpaque) {
+			uint16 color0 = readUint16(block);
+			uint16 color1 = readUint16(block + 2);
+			uint32 indices = readUint32(block + 4);
+
+			std::array<std::array<uint8, 4>, 4> palette{};
+			unpack565(color0, palette[0].data());
+			unpack565(color1, palette[1].data());
+			palette[0][3] = 255;
+			palette[1][3] = 255;
+
+			bool fourColors = alwaysOpaque || color0 > color1;
+			for (uint32 channel = 0; channel < 3; channel++) {
+				uint32 c0 = palette[0][channel];
+				uint32 c1 = palette[1][channel];
+				if (fourColors) {
+					palette[2][channel] = static_cast<uint8>((2 * c0 + c1) / 3);
+					palette[3][channel] = static_cast<uint8>((c0 + 2 * c1) / 3);
+				}else {
+					palette[2][channel] = static_cast<uint8>((c0 + c1) / 2);
+					palette[3][channel] = 0;
+				}
+			}
+			palette[2][3] = 255;
+			palette[3][3] = fourColors ? 255 : 0;
+
+			for (uint32 i = 0; i < 16; i++) {
+				const std::array<uint8, 4>& color = palette[(indices >> (2 * i)) & 0x3];
+				std::memcpy(texels + 4 * i, color.data(), 4);
+			}
+		}
+
+		/**
+		 * BC4 block, also the alpha half of BC3 and each channel of BC5
+		 *
+		 * @param values 16 values written stride bytes apart
+		 */
+		void decodeSingleChannelBlock(const uint8* block, uint8* values, uint32 stride) {
+			uint32 value0 = block[0];
+			uint32 value1 = block[1];
+
+			std::array<uint8, 8> palette{};
+			palette[0] = static_cast<uint8>(value0);
+			palette[1] = static_cast<uint8>(value1);
+			if (value0 > value1) {
+				for (uint32 i = 1; i < 7; i++) {
+					palette[i + 1] = static_cast<uint8>(((7 - i) * value0 + i * value1) / 7);
+				}
+			}else {
+				for (uint32 i = 1; i < 5; i++) {
+					palette[i + 1] = static_cast<uint8>(((5 - i) * value0 + i * value1) / 5);
+				}
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+
+			// 16 three bit indices packed into the remaining 48 bits
+			uint64 indices = 0;
+			for (uint32 i = 0; i < 6; i++) {
+				indices |= static_cast<uint64>(block[2 + i]) << (8 * i);
+			}
+
+			for (uint32 i = 0; i < 16; i++) {
+				values[i * stride] = palette[(indices >> (3 * i)) & 0x7];
+			}
+		}
+	}
+
+	uint32 blockSize(VkFormat format) {
+		switch (format) {
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				return 8;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+			case VK_FORMAT_BC5_SNORM_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				return 16;
+			default:
+				return 0;
+		}
+	}
+
+	uint32 texelSize(VkFormat format) {
+		switch (format) {
+			case VK_FORMAT_R8_UNORM:
+				return 1;
+			case VK_FORMAT_R8G8_UNORM:
+				return 2;
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SRGB:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+	VkDeviceSize imageSize(VkFormat format, uint32 width, uint32 height) {
+		if (uint32 bytes = blockSize(format); bytes != 0) {
+			return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * bytes;
+		}
+		return static_cast<VkDeviceSize>(width) * height * texelSize(format);
+	}
+
+	VkFormat uncompressedFormat(VkFormat format) {
+		switch (format) {
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+				return VK_FORMAT_R8G8B8A8_UNORM;
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				return VK_FORMAT_R8G8B8A8_SRGB;
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				return VK_FORMAT_R8_UNORM;
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+				return VK_FORMAT_R8G8_UNORM;
+			default:
+				return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	bool canDecodeBlocks(VkFormat format) {
+		switch (format) {
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				return false;
+			default:
+				return uncompressedFormat(format) != VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	void decodeBlocks(VkFormat format, std::span<const uint8> blocks, uint32 width, uint32 height, std::vector<uint8>& pixels) {
+		VkFormat outputFormat = uncompressedFormat(format);
+		uint32 outputTexelSize = texelSize(outputFormat);
+		uint32 inputBlockSize = blockSize(format);
+
+		if (!canDecodeBlocks(format) || blocks.size() < imageSize(format, width, height)) {
+			SpConsole::FatalExit("Cannot decode block compressed format " + std::to_string(format), SP_FAILURE);
+		}
+
+		pixels.resize(imageSize(outputFormat, width, height));
+
+		uint32 blocksX = (width + 3) / 4;
+		uint32 blocksY = (height + 3) / 4;
+
+		// Decoded as RGBA regardless of the output so every format shares the copy out below
+		std::array<uint8, 16 * 4> texels{};
+		for (uint32 blockY = 0; blockY < blocksY; blockY++) {
+			for (uint32 blockX = 0; blockX < blocksX; blockX++) {
+				const uint8* block = blocks.data() + (static_cast<size_t>(blockY) * blocksX + blockX) * inputBlockSize;
+
+				switch (format) {
+					case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+					case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+						decodeColorBlock(block, texels.data(), false);
+						// No alpha in the RGB variants, the transparent black entry is plain black
+						for (uint32 i = 0; i < 16; i++) {
+							texels[4 * i + 3] = 255;
+						}
+						break;
+					case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+					case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+						decodeColorBlock(block, texels.data(), false);
+						break;
+					case VK_FORMAT_BC3_UNORM_BLOCK:
+					case VK_FORMAT_BC3_SRGB_BLOCK:
+						decodeColorBlock(block + 8, texels.data(), true);
+						decodeSingleChannelBlock(block, texels.data() + 3, 4);
+						break;
+					case VK_FORMAT_BC4_UNORM_BLOCK:
+						decodeSingleChannelBlock(block, texels.data(), 4);
+						break;
+					case VK_FORMAT_BC5_UNORM_BLOCK:
+						decodeSingleChannelBlock(block, texels.data(), 4);
+						decodeSingleChannelBlock(block + 8, texels.data() + 1, 4);
+						break;
+					default:
+						break;
+				}
+
+				uint32 columns = std::min(4u, width - blockX * 4);
+				uint32 rows = std::min(4u, height - blockY * 4);
+				for (uint32 row = 0; row < rows; row++) {
+					for (uint32 column = 0; column < columns; column++) {
+						size_t x = blockX * 4 + column;
+						size_t y = blockY * 4 + row;
+						std::memcpy(pixels.data() + (y * width + x) * outputTexelSize, texels.data() + (row * 4 + column) * 4, outputTexelSize);
+					}
+				}
+			}
+		}
+	}
+} // SpRenderer
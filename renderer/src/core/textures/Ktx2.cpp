@@ -0,0 +1,91 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Ktx2.h"
+#include "BlockCompression.h"
+
+#include <bit>
+
+namespace SpRenderer {
+	namespace {
+		const std::array<uint8, 12> Ktx2Identifier = {
+			0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+		};
+
+		// Identifier, nine uint32 fields, the four uint32 and two uint64 offsets of the index
+		const size_t Ktx2HeaderSize = 80;
+		const size_t Ktx2LevelIndexEntrySize = 24;
+
+		template<typename T>
+		T readLittleEndian(std::span<const uint8> file, size_t offset) {
+			T value = 0;
+			for (size_t i = 0; i < sizeof(T); i++) {
+				value |= static_cast<T>(file[offset + i]) << (8 * i);
+			}
+			return value;
+		}
+	}
+
+	bool parseKtx2(std::span<const uint8> file, Ktx2Texture& texture, std::string& error) {
+		if (file.size() < Ktx2HeaderSize || !std::equal(Ktx2Identifier.begin(), Ktx2Identifier.end(), file.begin())) {
+			error = "not a KTX2 file";
+			return false;
+		}
+
+		uint32 vkFormat = readLittleEndian<uint32>(file, 12);
+		uint32 pixelWidth = readLittleEndian<uint32>(file, 20);
+		uint32 pixelHeight = readLittleEndian<uint32>(file, 24);
+		uint32 pixelDepth = readLittleEndian<uint32>(file, 28);
+		uint32 layerCount = readLittleEndian<uint32>(file, 32);
+		uint32 faceCount = readLittleEndian<uint32>(file, 36);
+		uint32 levelCount = readLittleEndian<uint32>(file, 40);
+		uint32 supercompressionScheme = readLittleEndian<uint32>(file, 44);
+
+		texture.format = static_cast<VkFormat>(vkFormat);
+		if (imageSize(texture.format, 1, 1) == 0) {
+			error = "unsupported format " + std::to_string(vkFormat);
+			return false;
+		}
+		if (pixelWidth == 0 || pixelHeight == 0 || pixelDepth > 1 || layerCount > 1 || faceCount != 1) {
+			error = "only single 2D images are supported";
+			return false;
+		}
+		if (supercompressionScheme != 0) {
+			error = "supercompression scheme " + std::to_string(supercompressionScheme) + " is not supported";
+			return false;
+		}
+
+		// 0 asks the loader to generate mips, which we do not, so it is just the base level
+		levelCount = std::max(levelCount, 1u);
+		uint32 maxLevels = std::bit_width(std::max(pixelWidth, pixelHeight));
+		if (levelCount > maxLevels || file.size() < Ktx2HeaderSize + levelCount * Ktx2LevelIndexEntrySize) {
+			error = "invalid level count " + std::to_string(levelCount);
+			return false;
+		}
+
+		texture.width = pixelWidth;
+		texture.height = pixelHeight;
+		texture.levels.resize(levelCount);
+
+		for (uint32 level = 0; level < levelCount; level++) {
+			size_t entry = Ktx2HeaderSize + level * Ktx2LevelIndexEntrySize;
+			uint64 byteOffset = readLittleEndian<uint64>(file, entry);
+			uint64 byteLength = readLittleEndian<uint64>(file, entry + 8);
+
+			Ktx2Level& textureLevel = texture.levels[level];
+			textureLevel.width = std::max(pixelWidth >> level, 1u);
+			textureLevel.height = std::max(pixelHeight >> level, 1u);
+
+			VkDeviceSize expectedSize = imageSize(texture.format, textureLevel.width, textureLevel.height);
+			if (byteOffset > file.size() || byteLength > file.size() - byteOffset || byteLength < expectedSize) {
+				error = "level " + std::to_string(level) + " is out of bounds or truncated";
+				return false;
+			}
+
+			textureLevel.data = file.subspan(byteOffset, expectedSize);
+		}
+
+		return true;
+	}
+} // SpRenderer
@@ -0,0 +1,341 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "TextureManager.h"
+#include "BlockCompression.h"
+#include "Ktx2.h"
+#include "Profiler.h"
+
+namespace fs = std::filesystem;
+
+namespace SpRenderer {
+	void TextureManager::init(VkDevice device,
+	                          MemoryAllocator& allocator,
+	                          UploadManager& uploadManager,
+	                          BindlessTable& bindlessTable,
+	                          JobSystem& jobSystem,
+	                          uint32 framesInFlight,
+	                          const TextureFormatMap& uploadFormats) {
+		mDevice = device;
+		mAllocator = &allocator;
+		mUploadManager = &uploadManager;
+		mBindlessTable = &bindlessTable;
+		mJobSystem = &jobSystem;
+		mFramesInFlight = framesInFlight;
+		mUploadFormats = uploadFormats;
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Created texture manager");
+	}
+
+	void TextureManager::destroy() {
+		mJobSystem->wait(mDecodeCounter);
+		mResults.clear();
+
+		logStats();
+
+		std::lock_guard lock(mTextureMutex);
+		releaseRetiredViews(0, true);
+		for (Texture& texture : mTextures) {
+			if (texture.view != VK_NULL_HANDLE) {
+				vkDestroyImageView(mDevice, texture.view, nullptr);
+			}
+			if (texture.image != VK_NULL_HANDLE) {
+				mAllocator->destroyImage(texture.image, texture.allocation);
+			}
+		}
+		mTextures.clear();
+		mStats = {};
+	}
+
+	TextureHandle TextureManager::load(const fs::path& filePath) {
+		TextureHandle handle;
+		{
+			std::lock_guard lock(mTextureMutex);
+			handle = static_cast<TextureHandle>(mTextures.size());
+			mTextures.emplace_back();
+			mTextures.back().path = filePath;
+		}
+
+		mJobSystem->run([this, handle, filePath]() { decodeJob(handle, filePath); }, &mDecodeCounter);
+
+		return handle;
+	}
+
+	BindlessIndex TextureManager::getIndex(TextureHandle texture) {
+		std::lock_guard lock(mTextureMutex);
+		if (texture >= mTextures.size()) {
+			return DefaultBindlessIndex;
+		}
+		return mTextures[texture].index;
+	}
+
+	TextureState TextureManager::getState(TextureHandle texture) {
+		std::lock_guard lock(mTextureMutex);
+		if (texture >= mTextures.size()) {
+			return SP_TEXTURE_FAILED;
+		}
+		return mTextures[texture].state;
+	}
+
+	void TextureManager::update(uint64 frameNumber) {
+		SP_PROFILE_ZONE("TextureManager::update");
+
+		std::vector<DecodeResult> results;
+		{
+			std::lock_guard lock(mResultMutex);
+			results.swap(mResults);
+		}
+
+		std::lock_guard lock(mTextureMutex);
+		releaseRetiredViews(frameNumber, false);
+
+		for (DecodeResult& result : results) {
+			Texture& texture = mTextures[result.texture];
+			if (!result.source) {
+				texture.state = SP_TEXTURE_FAILED;
+				SpConsole::Write(SP_MESSAGE_WARNING, "Failed to load texture " + texture.path.string() + ": " + result.error);
+				continue;
+			}
+
+			createTexture(texture, std::move(result.source));
+		}
+
+		// Coarse mips of every texture go first, a texture only moves on once the mips it has in flight landed
+		VkDeviceSize streamedBytes = 0;
+		for (Texture& texture : mTextures) {
+			if (texture.state != SP_TEXTURE_STREAMING) {
+				continue;
+			}
+
+			if (texture.uploadedMip != texture.residentMip && mUploadManager->isComplete(texture.ticket)) {
+				texture.residentMip = texture.uploadedMip;
+				updateView(texture, frameNumber);
+			}
+
+			if (texture.residentMip == 0) {
+				texture.state = SP_TEXTURE_RESIDENT;
+				SP_LOG(SP_MESSAGE_VERBOSE, texture.path.filename().string() + " is fully resident");
+				continue;
+			}
+
+			if (texture.uploadedMip != texture.residentMip) {
+				continue;
+			}
+
+			while (texture.uploadedMip > 0) {
+				VkDeviceSize mipSize = texture.source->levels[texture.uploadedMip - 1].size();
+				if (streamedBytes > 0 && streamedBytes + mipSize > mStreamBudget) {
+					break;
+				}
+				streamedBytes += uploadMip(texture, texture.uploadedMip - 1);
+			}
+
+			// Everything was copied into staging, the file or decoded data is no longer needed
+			if (texture.uploadedMip == 0) {
+				texture.source.reset();
+			}
+		}
+	}
+
+	TextureStats TextureManager::getStats() {
+		std::lock_guard lock(mTextureMutex);
+
+		mStats.textureCount = static_cast<uint32>(mTextures.size());
+		mStats.streamingCount = 0;
+		mStats.residentCount = 0;
+		mStats.failedCount = 0;
+		for (const Texture& texture : mTextures) {
+			mStats.streamingCount += texture.state == SP_TEXTURE_STREAMING ? 1 : 0;
+			mStats.residentCount += texture.state == SP_TEXTURE_RESIDENT ? 1 : 0;
+			mStats.failedCount += texture.state == SP_TEXTURE_FAILED ? 1 : 0;
+		}
+		return mStats;
+	}
+
+	void TextureManager::logStats() {
+		TextureStats stats = getStats();
+
+		double memoryMb = static_cast<double>(stats.memoryBytes) / (1024.0 * 1024.0);
+		double rgba8Mb = static_cast<double>(stats.rgba8Bytes) / (1024.0 * 1024.0);
+
+		SpConsole::Write(SP_MESSAGE_INFO, "Textures: " + std::to_string(stats.textureCount) + " (" +
+		                                  std::to_string(stats.residentCount) + " resident, " +
+		                                  std::to_string(stats.streamingCount) + " streaming, " +
+		                                  std::to_string(stats.failedCount) + " failed, " +
+		                                  std::to_string(stats.fallbackCount) + " decoded on the CPU), " +
+		                                  std::to_string(memoryMb) + " MB of device memory, " +
+		                                  std::to_string(rgba8Mb) + " MB as RGBA8, " +
+		                                  std::to_string(stats.decodeMs) + " ms decoding");
+	}
+
+	void TextureManager::decodeJob(TextureHandle texture, const fs::path& filePath) {
+		SP_PROFILE_ZONE("Decode texture");
+
+		DecodeResult result;
+		result.texture = texture;
+		result.source = decode(filePath, result.error);
+
+		std::lock_guard lock(mResultMutex);
+		mResults.push_back(std::move(result));
+	}
+
+	std::unique_ptr<TextureManager::TextureSource> TextureManager::decode(const fs::path& filePath, std::string& error) const {
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point decodeStart = Clock::now();
+
+		std::unique_ptr<TextureSource> source = std::make_unique<TextureSource>();
+		source->file = Utils::FileUtils::mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+		if (!source->file) {
+			error = "could not open the file";
+			return nullptr;
+		}
+
+		Ktx2Texture ktx;
+		if (!parseKtx2(source->file.bytes(), ktx, error)) {
+			return nullptr;
+		}
+
+		source->width = ktx.width;
+		source->height = ktx.height;
+
+		VkFormat uploadFormat = ktx.format;
+		if (auto entry = mUploadFormats.find(ktx.format); entry != mUploadFormats.end()) {
+			uploadFormat = entry->second;
+		}
+
+		if (uploadFormat == ktx.format) {
+			// Uploaded straight out of the mapping, fault it in now rather than on the render thread
+			source->file.advise(SP_FILE_ACCESS_WILLNEED);
+			for (const Ktx2Level& level : ktx.levels) {
+				source->levels.push_back(level.data);
+			}
+			source->format = ktx.format;
+		}else {
+			if (!canDecodeBlocks(ktx.format) || uncompressedFormat(ktx.format) != uploadFormat) {
+				error = "the device cannot sample format " + std::to_string(ktx.format) + " and there is no CPU decoder for it";
+				return nullptr;
+			}
+
+			source->decodedLevels.resize(ktx.levels.size());
+			for (size_t level = 0; level < ktx.levels.size(); level++) {
+				const Ktx2Level& ktxLevel = ktx.levels[level];
+				decodeBlocks(ktx.format, ktxLevel.data, ktxLevel.width, ktxLevel.height, source->decodedLevels[level]);
+				source->levels.push_back(source->decodedLevels[level]);
+			}
+			source->format = uploadFormat;
+			source->decoded = true;
+			source->file.close();
+		}
+
+		source->decodeMs = std::chrono::duration<double, std::milli>(Clock::now() - decodeStart).count();
+		return source;
+	}
+
+	void TextureManager::createTexture(Texture& texture, std::unique_ptr<TextureSource> source) {
+		texture.format = source->format;
+		texture.width = source->width;
+		texture.height = source->height;
+		texture.mipCount = static_cast<uint32>(source->levels.size());
+
+		VkImageCreateInfo imageCreateInfo{};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.extent = {texture.width, texture.height, 1};
+		imageCreateInfo.mipLevels = texture.mipCount;
+		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.format = texture.format;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		AllocationCreateInfo allocationInfo{};
+		allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		mAllocator->createImage(imageCreateInfo, allocationInfo, texture.image, texture.allocation);
+
+		mStats.memoryBytes += texture.allocation.size;
+		for (uint32 mip = 0; mip < texture.mipCount; mip++) {
+			mStats.rgba8Bytes += imageSize(VK_FORMAT_R8G8B8A8_UNORM, std::max(texture.width >> mip, 1u), std::max(texture.height >> mip, 1u));
+		}
+		mStats.fallbackCount += source->decoded ? 1 : 0;
+		mStats.decodeMs += source->decodeMs;
+
+		texture.source = std::move(source);
+		texture.residentMip = texture.mipCount;
+		texture.uploadedMip = texture.mipCount;
+
+		// The whole tail goes in one go regardless of the stream budget, it is tiny
+		uint32 tailMip = texture.mipCount - 1;
+		while (tailMip > 0 && std::max(texture.width >> (tailMip - 1), texture.height >> (tailMip - 1)) <= MipTailSize) {
+			tailMip--;
+		}
+		while (texture.uploadedMip > tailMip) {
+			uploadMip(texture, texture.uploadedMip - 1);
+		}
+
+		texture.state = SP_TEXTURE_STREAMING;
+	}
+
+	VkDeviceSize TextureManager::uploadMip(Texture& texture, uint32 mip) {
+		std::span<const uint8> data = texture.source->levels[mip];
+
+		VkImageSubresourceLayers subresource{};
+		subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresource.mipLevel = mip;
+		subresource.baseArrayLayer = 0;
+		subresource.layerCount = 1;
+
+		VkExtent3D extent = {std::max(texture.width >> mip, 1u), std::max(texture.height >> mip, 1u), 1};
+
+		// Tickets complete in order, so the last one covers every mip uploaded before it
+		texture.ticket = mUploadManager->uploadImage(texture.image, subresource, extent, data.data(), data.size(),
+		                                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		                                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		texture.uploadedMip = mip;
+		mStats.uploadedBytes += data.size();
+
+		return data.size();
+	}
+
+	void TextureManager::updateView(Texture& texture, uint64 frameNumber) {
+		// Only the resident mips, the finer ones are still undefined or being written
+		VkImageViewCreateInfo viewCreateInfo{};
+		viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewCreateInfo.image = texture.image;
+		viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewCreateInfo.format = texture.format;
+		viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewCreateInfo.subresourceRange.baseMipLevel = texture.residentMip;
+		viewCreateInfo.subresourceRange.levelCount = texture.mipCount - texture.residentMip;
+		viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+		viewCreateInfo.subresourceRange.layerCount = 1;
+
+		VkImageView view = VK_NULL_HANDLE;
+		VkResult result = vkCreateImageView(mDevice, &viewCreateInfo, nullptr, &view);
+		SpConsole::VulkanExitCheck(result, "Failed to create texture view!", SP_FAILURE);
+
+		// Frames in flight keep sampling the old view through the old index, the table holds on to the slot for them
+		BindlessIndex index = mBindlessTable->registerImage(view);
+		if (texture.view != VK_NULL_HANDLE) {
+			mBindlessTable->releaseImage(texture.index);
+			mRetiredViews.push_back({texture.view, frameNumber});
+		}
+
+		texture.view = view;
+		texture.index = index;
+	}
+
+	void TextureManager::releaseRetiredViews(uint64 frameNumber, bool force) {
+		// One frame past the bindless table recycling the slot, so no descriptor points at the view any more
+		std::erase_if(mRetiredViews, [&](const RetiredView& retired) {
+			if (!force && retired.retireFrame + mFramesInFlight >= frameNumber) {
+				return false;
+			}
+			vkDestroyImageView(mDevice, retired.view, nullptr);
+			return true;
+		});
+	}
+} // SpRenderer
@@ -0,0 +1,273 @@
+//
+// Created by robsc on 11/29/25.
+//
+
+#include "Logger.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace SpConsole {
+	static_assert(sizeof(LogRecordHeader) == LogRecordAlignment);
+	static_assert((LogRingSize & (LogRingSize - 1)) == 0);
+
+	static const char* severityPrefix(uint8 severity) {
+		switch (severity) {
+			case SP_MESSAGE_VERBOSE: return "[Verbose] ";
+			case SP_MESSAGE_INFO: return "[Info] ";
+			case SP_MESSAGE_WARNING: return "[Warning] ";
+			case SP_MESSAGE_ERROR: return "[Error] ";
+			case SP_MESSAGE_FATAL: return "[Fatal] ";
+		}
+		return "";
+	}
+
+#pragma region LogRing
+	LogRing::LogRing(uint32 threadId) : mThreadId(threadId), mData(new char[LogRingSize]) {}
+
+	bool LogRing::push(uint64 timestampNs, uint8 severity, uint8 flags, std::string_view prefix, std::string_view message) {
+		size_t length = prefix.size() + message.size();
+		if (length > LogMaxMessageLength) {
+			length = LogMaxMessageLength;
+			flags |= SP_LOG_RECORD_TRUNCATED;
+		}
+
+		uint64 size = logRecordSize(length);
+		uint64 head = mHead.load(std::memory_order_relaxed);
+		uint64 tail = mTail.load(std::memory_order_acquire);
+
+		// Records never wrap, the end of the ring gets skipped with a padding record when one does not fit
+		uint64 offset = head & (LogRingSize - 1);
+		uint64 untilEnd = LogRingSize - offset;
+		uint64 needed = size <= untilEnd ? size : untilEnd + size;
+
+		if (LogRingSize - (head - tail) < needed) {
+			return false;
+		}
+
+		if (size > untilEnd) {
+			LogRecordHeader padding{};
+			padding.flags = SP_LOG_RECORD_PADDING;
+			std::memcpy(mData.get() + offset, &padding, sizeof(padding));
+			head += untilEnd;
+			offset = 0;
+		}
+
+		LogRecordHeader header{};
+		header.timestampNs = timestampNs;
+		header.threadId = mThreadId;
+		header.length = static_cast<uint16>(length);
+		header.severity = severity;
+		header.flags = flags;
+
+		char* record = mData.get() + offset;
+		std::memcpy(record, &header, sizeof(header));
+
+		// Empty views may have a null data pointer, which memcpy must not see even for zero bytes
+		size_t prefixLength = std::min(prefix.size(), length);
+		if (prefixLength != 0) {
+			std::memcpy(record + sizeof(header), prefix.data(), prefixLength);
+		}
+		if (length != prefixLength) {
+			std::memcpy(record + sizeof(header) + prefixLength, message.data(), length - prefixLength);
+		}
+
+		mHead.store(head + size, std::memory_order_release);
+		return true;
+	}
+
+	bool LogRing::empty() const {
+		return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+	}
+#pragma endregion
+
+#pragma region Logger
+	// Marks the thread's ring retired when the thread exits, the drain thread frees it once it is empty
+	struct ThreadRingHandle {
+		std::shared_ptr<LogRing> ring;
+
+		~ThreadRingHandle() {
+			if (ring) {
+				ring->retired.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	static thread_local ThreadRingHandle threadRingHandle;
+
+	Logger& Logger::get() {
+		static Logger logger;
+		return logger;
+	}
+
+	Logger::Logger() : mStartTime(std::chrono::steady_clock::now()) {
+		openLogFile();
+		mDrainThread = std::thread(&Logger::drainLoop, this);
+	}
+
+	Logger::~Logger() {
+		{
+			std::lock_guard lock(mWakeMutex);
+			mStopping = true;
+		}
+		mWake.notify_one();
+		if (mDrainThread.joinable()) {
+			mDrainThread.join();
+		}
+
+		flush();
+
+		if (mLogFile != nullptr) {
+			std::fclose(mLogFile);
+			mLogFile = nullptr;
+		}
+	}
+
+	void Logger::write(MessageSeverity severity, uint8 flags, std::string_view prefix, std::string_view message) {
+		uint64 timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - mStartTime).count();
+
+		LogRing& ring = threadRing();
+		if (!ring.push(timestampNs, static_cast<uint8>(severity), flags, prefix, message)) {
+			// Only happens in bursts faster than the drain thread keeps up with, drain here rather than lose the message
+			mStallCount.fetch_add(1, std::memory_order_relaxed);
+			flush();
+			ring.push(timestampNs, static_cast<uint8>(severity), flags, prefix, message);
+		}
+
+		// Whatever comes next may be exit(), fatal messages must not wait for the drain thread
+		if (severity == SP_MESSAGE_FATAL) {
+			flush();
+		}
+	}
+
+	void Logger::flush() {
+		std::lock_guard lock(mDrainMutex);
+		drainAll();
+	}
+
+	LogStats Logger::getStats() {
+		LogStats stats{};
+		{
+			std::lock_guard lock(mDrainMutex);
+			stats.writtenCount = mWrittenCount;
+		}
+		stats.stallCount = mStallCount.load(std::memory_order_relaxed);
+
+		std::lock_guard lock(mRingMutex);
+		stats.threadCount = mNextThreadId;
+		return stats;
+	}
+
+	LogRing& Logger::threadRing() {
+		if (!threadRingHandle.ring) {
+			std::lock_guard lock(mRingMutex);
+			threadRingHandle.ring = std::make_shared<LogRing>(mNextThreadId++);
+			mRings.push_back(threadRingHandle.ring);
+		}
+		return *threadRingHandle.ring;
+	}
+
+	void Logger::openLogFile() {
+		fs::path logDirectory = fs::path(RENDERER_DATA_DIR) / "logs";
+		std::error_code error;
+		fs::create_directories(logDirectory, error);
+
+		fs::path logPath = logDirectory / "sparker_log.bin";
+		if (fs::exists(logPath, error)) {
+			// Keep the previous run around, it is usually the one worth reading
+			fs::rename(logPath, logDirectory / "sparker_log.prev.bin", error);
+		}
+
+		mLogFile = std::fopen(logPath.string().c_str(), "wb");
+		if (mLogFile == nullptr) {
+			// The logger is still being constructed here, so this one goes straight out
+			std::fprintf(stderr, "[Warning] Failed to open binary log %s\n", logPath.string().c_str());
+			return;
+		}
+
+		LogFileHeader header{};
+		header.magic = LogFileMagic;
+		header.version = LogFileVersion;
+		header.startTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		std::fwrite(&header, sizeof(header), 1, mLogFile);
+	}
+
+	void Logger::drainLoop() {
+		std::unique_lock wakeLock(mWakeMutex);
+		while (!mStopping) {
+			mWake.wait_for(wakeLock, LogDrainInterval);
+
+			wakeLock.unlock();
+			{
+				std::lock_guard lock(mDrainMutex);
+				drainAll();
+			}
+			wakeLock.lock();
+		}
+	}
+
+	void Logger::drainAll() {
+		mDrained.clear();
+		mDrainedText.clear();
+
+		{
+			std::lock_guard lock(mRingMutex);
+
+			for (const std::shared_ptr<LogRing>& ring : mRings) {
+				ring->drain([this](const LogRecordHeader& header, std::string_view text) {
+					mDrained.push_back({header, mDrainedText.size()});
+					mDrainedText.insert(mDrainedText.end(), text.begin(), text.end());
+				});
+			}
+
+			std::erase_if(mRings, [](const std::shared_ptr<LogRing>& ring) {
+				return ring->retired.load(std::memory_order_acquire) && ring->empty();
+			});
+		}
+
+		if (mDrained.empty()) {
+			return;
+		}
+
+		// Each ring is already in order, sorting merges the threads
+		std::stable_sort(mDrained.begin(), mDrained.end(), [](const DrainedRecord& a, const DrainedRecord& b) {
+			return a.header.timestampNs < b.header.timestampNs;
+		});
+
+		mConsoleText.clear();
+		mFileData.clear();
+
+		for (const DrainedRecord& record : mDrained) {
+			std::string_view text(mDrainedText.data() + record.textOffset, record.header.length);
+
+			if (!(record.header.flags & SP_LOG_RECORD_PLAIN)) {
+				mConsoleText += severityPrefix(record.header.severity);
+			}
+			mConsoleText += text;
+			if (record.header.flags & SP_LOG_RECORD_TRUNCATED) {
+				mConsoleText += " [...]";
+			}
+			mConsoleText += '\n';
+
+			const char* headerBytes = reinterpret_cast<const char*>(&record.header);
+			mFileData.insert(mFileData.end(), headerBytes, headerBytes + sizeof(record.header));
+			mFileData.insert(mFileData.end(), text.begin(), text.end());
+			mFileData.resize(mFileData.size() + logRecordSize(text.size()) - sizeof(record.header) - text.size(), 0);
+		}
+
+		std::fwrite(mConsoleText.data(), 1, mConsoleText.size(), stdout);
+		std::fflush(stdout);
+
+		if (mLogFile != nullptr && !mFileData.empty()) {
+			std::fwrite(mFileData.data(), 1, mFileData.size(), mLogFile);
+			std::fflush(mLogFile);
+		}
+
+		mWrittenCount += mDrained.size();
+	}
+#pragma endregion
+}
@@ -2,41 +2,37 @@
 // Created by robsc on 10/19/25.
 //
 #include "Utils.h"
+#include "Logger.h"
+
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 namespace SpConsole {
-    void PlainWrite(const char* message) {
-        std::cout << message << std::endl;
+    void WriteRecord(MessageSeverity severity, uint8 flags, std::string_view prefix, std::string_view message) {
+        Logger::get().write(severity, flags, prefix, message);
     }
 
-    void Write(MessageSeverity severity, std::string message) {
-        std::string suffix;
-        switch ( severity ) {
-            case SP_MESSAGE_VERBOSE:
-                suffix = "[Verbose] " + std::string(message);
-                std::cout << suffix << std::endl;
-                break;
-            case SP_MESSAGE_INFO:
-                suffix = "[Info] " + std::string(message);
-                std::cout << suffix << std::endl;
-                break;
-            case SP_MESSAGE_ERROR:
-                suffix = "[Error] " + std::string(message);
-                std::cout << suffix << std::endl;
-                break;
-            case SP_MESSAGE_WARNING:
-                suffix = "[Warning] " + std::string(message);
-                std::cout << suffix << std::endl;
-                break;
-            case SP_MESSAGE_FATAL:
-                suffix = "[Fatal] " + std::string(message);
-                std::cout << suffix << std::endl;
-                break;
-        }
+    void Flush() {
+        Logger::get().flush();
+    }
+
+    void PlainWrite(std::string_view message) {
+        WriteRecord(SP_MESSAGE_INFO, SP_LOG_RECORD_PLAIN, {}, message);
     }
 
-    void FatalExit(std::string message, ExitCode code) {
-        Write(SP_MESSAGE_FATAL, message);
+    void FatalExit(std::string_view message, ExitCode code) {
+        // Fatal records flush before returning
+        WriteRecord(SP_MESSAGE_FATAL, 0, {}, message);
         exit(code);
     }
 
@@ -48,7 +44,7 @@ namespace SpConsole {
         if ( result == VK_SUCCESS ) { Write(successSeverity, successMessage); }
         else {
             Write(failSeverity, failMessage);
-            Write(failSeverity, ("Result Code: " + std::to_string(result)).c_str());
+            Write(failSeverity, "Result Code: " + std::to_string(result));
         }
     }
 
@@ -59,14 +55,14 @@ namespace SpConsole {
         if ( result == VK_SUCCESS ) { Write(SP_MESSAGE_INFO, successMessage); }
         else {
             Write(failSeverity, failMessage);
-            Write(failSeverity, ("Result Code: " + std::to_string(result)).c_str());
+            Write(failSeverity, "Result Code: " + std::to_string(result));
         }
     }
 
     void VulkanResult(VkResult result, MessageSeverity failSeverity, const char* failMessage) {
         if ( result != VK_SUCCESS ) {
             Write(failSeverity, failMessage);
-            Write(failSeverity, ("Result Code: " + std::to_string(result)).c_str());
+            Write(failSeverity, "Result Code: " + std::to_string(result));
         }
     }
 
@@ -79,7 +75,7 @@ namespace SpConsole {
         if ( result == VK_SUCCESS ) { Write(successSeverity, successMessage); }
         else {
             Write(SP_MESSAGE_FATAL, failMessage);
-            Write(SP_MESSAGE_FATAL, ("Result Code: " + std::to_string(result)).c_str());
+            Write(SP_MESSAGE_FATAL, "Result Code: " + std::to_string(result));
             exit(code);
         }
     }
@@ -88,7 +84,7 @@ namespace SpConsole {
         if ( result == VK_SUCCESS ) { Write(SP_MESSAGE_INFO, successMessage); }
         else {
             Write(SP_MESSAGE_FATAL, failMessage);
-            Write(SP_MESSAGE_FATAL, ("Result Code: " + std::to_string(result)).c_str());
+            Write(SP_MESSAGE_FATAL, "Result Code: " + std::to_string(result));
             exit(code);
         }
     }
@@ -96,7 +92,7 @@ namespace SpConsole {
     void VulkanExitCheck(VkResult result, const char* failMessage, ExitCode code) {
         if ( result != VK_SUCCESS ) {
             Write(SP_MESSAGE_FATAL, failMessage);
-            Write(SP_MESSAGE_FATAL, ("Result Code: " + std::to_string(result)).c_str());
+            Write(SP_MESSAGE_FATAL, "Result Code: " + std::to_string(result));
             exit(code);
         }
     }
@@ -105,34 +101,31 @@ namespace SpConsole {
                              VkDebugUtilsMessageTypeFlagsEXT messageType,
                              const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
                              void* pUserData) {
-        std::string message;
+        std::string_view message = pCallbackData->pMessage;
         switch (messageSeverity) {
-
-
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-                message =  std::string("[Verbose] [Vulkan] ") + pCallbackData->pMessage;
-                PlainWrite(message.c_str());
+                if (SP_MESSAGE_VERBOSE >= SP_LOG_MIN_SEVERITY) {
+                    WriteRecord(SP_MESSAGE_VERBOSE, 0, "[Vulkan] ", message);
+                }
                 break;
 
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-                message =  std::string("[Info] [Vulkan] ") + pCallbackData->pMessage;
-                PlainWrite(message.c_str());
+                if (SP_MESSAGE_INFO >= SP_LOG_MIN_SEVERITY) {
+                    WriteRecord(SP_MESSAGE_INFO, 0, "[Vulkan] ", message);
+                }
                 break;
 
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-                message =  std::string("[Warning] [Vulkan] ") + pCallbackData->pMessage;
-                PlainWrite(message.c_str());
+                WriteRecord(SP_MESSAGE_WARNING, 0, "[Vulkan] ", message);
                 break;
 
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-                message =  std::string("[Error] [Vulkan] ") + pCallbackData->pMessage;
-                PlainWrite(message.c_str());
+                WriteRecord(SP_MESSAGE_ERROR, 0, "[Vulkan] ", message);
                 break;
 
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_FLAG_BITS_MAX_ENUM_EXT:
-                message =  std::string("[Fatal] [Vulkan] ") + pCallbackData->pMessage;
-                FatalExit(message.c_str(), SP_FAILURE);
-                break;
+                WriteRecord(SP_MESSAGE_FATAL, 0, "[Vulkan] ", message);
+                exit(SP_FAILURE);
 
         }
 
@@ -142,12 +135,55 @@ namespace SpConsole {
     void sdlErrorCheck(bool result) {
         if (!result) {
             const char* sdlError = SDL_GetError();
-            std::string message = std::string("[SDL ERROR] ") + sdlError;
-            PlainWrite(message.c_str());
+            WriteRecord(SP_MESSAGE_ERROR, SP_LOG_RECORD_PLAIN, "[SDL ERROR] ", sdlError);
         }
     }
 }
 
+uint64 Utils::hash64(const void* data, size_t size, uint64 seed) {
+    const uint64 m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+
+    uint64 h = seed ^ (size * m);
+
+    const uint8* bytes = static_cast<const uint8*>(data);
+    const uint8* end = bytes + (size / 8) * 8;
+
+    while (bytes != end) {
+        uint64 k;
+        std::memcpy(&k, bytes, sizeof(k));
+        bytes += 8;
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (size & 7) {
+        case 7: h ^= static_cast<uint64>(bytes[6]) << 48; [[fallthrough]];
+        case 6: h ^= static_cast<uint64>(bytes[5]) << 40; [[fallthrough]];
+        case 5: h ^= static_cast<uint64>(bytes[4]) << 32; [[fallthrough]];
+        case 4: h ^= static_cast<uint64>(bytes[3]) << 24; [[fallthrough]];
+        case 3: h ^= static_cast<uint64>(bytes[2]) << 16; [[fallthrough]];
+        case 2: h ^= static_cast<uint64>(bytes[1]) << 8; [[fallthrough]];
+        case 1: h ^= static_cast<uint64>(bytes[0]);
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+uint64 Utils::hash64(std::string_view string, uint64 seed) {
+    return hash64(string.data(), string.size(), seed);
+}
+
 std::vector<char> Utils::FileUtils::readBinaryFile(std::filesystem::path filePath) {
     std::ifstream file(filePath, std::ios::binary | std::ios::ate);
 
@@ -177,7 +213,7 @@ std::vector<char> Utils::FileUtils::readBinaryFile(std::filesystem::path filePat
     return buffer;
 }
 
-void Utils::FileUtils::writeBinaryFile(std::filesystem::path filePath, std::vector<char>& data) {
+void Utils::FileUtils::writeBinaryFile(std::filesystem::path filePath, std::span<const char> data) {
     std::ofstream file(filePath, std::ios::out | std::ios::binary);
 
     if (!file.is_open()) {
@@ -194,7 +230,7 @@ void Utils::FileUtils::writeBinaryFile(std::filesystem::path filePath, std::vect
         SpConsole::Write(SP_MESSAGE_INFO, "Opened File");
     }
 
-    file.write(static_cast<char*>(data.data()), static_cast<std::streamsize>(sizeof(char) * data.size()));
+    file.write(data.data(), static_cast<std::streamsize>(sizeof(char) * data.size()));
     file.close();
 }
 
@@ -225,7 +261,7 @@ std::vector<char> Utils::FileUtils::readTextFile(std::filesystem::path filePath)
     return buffer;
 }
 
-void Utils::FileUtils::writeTextFile(std::filesystem::path filePath, std::vector<char>& data) {
+void Utils::FileUtils::writeTextFile(std::filesystem::path filePath, std::span<const char> data) {
     std::ofstream file(filePath, std::ios::out);
 
     if (!file.is_open()) {
@@ -242,6 +278,174 @@ void Utils::FileUtils::writeTextFile(std::filesystem::path filePath, std::vector
         SpConsole::Write(SP_MESSAGE_INFO, "Opened File");
     }
 
-    file.write(static_cast<char*>(data.data()), static_cast<std::streamsize>(sizeof(char) * data.size()));
+    file.write(data.data(), static_cast<std::streamsize>(sizeof(char) * data.size()));
     file.close();
 }
+
+Utils::MappedFile Utils::FileUtils::mapFile(const std::filesystem::path& filePath, FileAccessHint hint) {
+    MappedFile file = MappedFile::open(filePath, hint);
+    if (!file) {
+        SpConsole::Write(SP_MESSAGE_ERROR, "Failed to map file \"" + filePath.string() + "\"");
+    }
+    return file;
+}
+
+std::future<Utils::MappedFile> Utils::FileUtils::mapFileAsync(std::filesystem::path filePath) {
+    return std::async(std::launch::async, [filePath = std::move(filePath)]() {
+        MappedFile file = mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+
+        // Read hints are only hints, touching every page guarantees it is resident before the future is ready
+        const size_t stride = 4096;
+        const volatile char* data = file.data().data();
+        char sink = 0;
+        for (size_t offset = 0; offset < file.size(); offset += stride) {
+            sink ^= data[offset];
+        }
+        (void)sink;
+
+        file.advise(SP_FILE_ACCESS_NORMAL);
+        return file;
+    });
+}
+
+#pragma region MappedFile
+Utils::MappedFile::~MappedFile() {
+    close();
+}
+
+Utils::MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+Utils::MappedFile& Utils::MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+
+        mData = std::exchange(other.mData, nullptr);
+        mSize = std::exchange(other.mSize, 0);
+        mOpen = std::exchange(other.mOpen, false);
+#ifdef _WIN32
+        mFileHandle = std::exchange(other.mFileHandle, nullptr);
+        mMappingHandle = std::exchange(other.mMappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+Utils::MappedFile Utils::MappedFile::open(const std::filesystem::path& filePath, FileAccessHint hint) {
+    MappedFile file;
+
+#ifdef _WIN32
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hint == SP_FILE_ACCESS_SEQUENTIAL) flags = FILE_FLAG_SEQUENTIAL_SCAN;
+    if (hint == SP_FILE_ACCESS_RANDOM) flags = FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                    OPEN_EXISTING, flags, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return file;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return file;
+    }
+
+    file.mFileHandle = fileHandle;
+    file.mOpen = true;
+    if (fileSize.QuadPart == 0) {
+        // Zero length files cannot be mapped
+        return file;
+    }
+
+    file.mMappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file.mMappingHandle == nullptr) {
+        file.close();
+        return file;
+    }
+
+    file.mData = static_cast<const char*>(MapViewOfFile(file.mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (file.mData == nullptr) {
+        file.close();
+        return file;
+    }
+    file.mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fileDescriptor = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0) {
+        return file;
+    }
+
+    struct stat fileStat{};
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        ::close(fileDescriptor);
+        return file;
+    }
+
+    file.mOpen = true;
+    if (fileStat.st_size == 0) {
+        // Zero length files cannot be mapped
+        ::close(fileDescriptor);
+        return file;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        file.mOpen = false;
+        return file;
+    }
+
+    file.mData = static_cast<const char*>(mapping);
+    file.mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    file.advise(hint);
+    return file;
+}
+
+void Utils::MappedFile::advise(FileAccessHint hint, size_t offset, size_t size) const {
+    if (mData == nullptr || offset >= mSize) {
+        return;
+    }
+    size = std::min(size, mSize - offset);
+
+#ifdef _WIN32
+    if (hint == SP_FILE_ACCESS_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<char*>(mData) + offset, size};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    int advice = MADV_NORMAL;
+    switch (hint) {
+        case SP_FILE_ACCESS_NORMAL: advice = MADV_NORMAL; break;
+        case SP_FILE_ACCESS_SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+        case SP_FILE_ACCESS_RANDOM: advice = MADV_RANDOM; break;
+        case SP_FILE_ACCESS_WILLNEED: advice = MADV_WILLNEED; break;
+    }
+
+    // madvise wants a page aligned start, mmap already aligned the base
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t alignedOffset = offset & ~(pageSize - 1);
+    madvise(const_cast<char*>(mData) + alignedOffset, size + (offset - alignedOffset), advice);
+#endif
+}
+
+void Utils::MappedFile::close() {
+#ifdef _WIN32
+    if (mData != nullptr) UnmapViewOfFile(mData);
+    if (mMappingHandle != nullptr) CloseHandle(mMappingHandle);
+    if (mFileHandle != nullptr) CloseHandle(mFileHandle);
+    mMappingHandle = nullptr;
+    mFileHandle = nullptr;
+#else
+    if (mData != nullptr) munmap(const_cast<char*>(mData), mSize);
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+#pragma endregion
@@ -4,62 +4,42 @@
 
 #include "Vertex.h"
 
-VkVertexInputBindingDescription Vertex2D::getBindingDescription() {
-	VkVertexInputBindingDescription bindingDescription {};
-	bindingDescription.binding = 0;
-	bindingDescription.stride = sizeof(Vertex2D);
-	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-	return bindingDescription;
+namespace {
+	SpRenderer::Unorm8x4 packColor(const vec3& color) {
+		return {SpRenderer::packUnorm8(color.x), SpRenderer::packUnorm8(color.y), SpRenderer::packUnorm8(color.z), 255};
+	}
+
+	SpRenderer::Half2 packTexCoord(const vec2& texCoord) {
+		return {SpRenderer::packHalf(texCoord.x), SpRenderer::packHalf(texCoord.y)};
+	}
 }
 
-std::array<VkVertexInputAttributeDescription, 3> Vertex2D::getBindingDescriptions() {
-	std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions {};
-
-	attributeDescriptions[0].binding = 0;
-	attributeDescriptions[0].location = 0;
-	attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-	attributeDescriptions[0].offset = offsetof(Vertex2D, position);
-
-	attributeDescriptions[1].binding = 0;
-	attributeDescriptions[1].location = 1;
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[1].offset = offsetof(Vertex2D, color);
-
-	attributeDescriptions[2].binding = 0;
-	attributeDescriptions[2].location = 2;
-	attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-	attributeDescriptions[2].offset = offsetof(Vertex2D, texCoord);
+Vertex2DPacked packVertex(const Vertex2D& vertex, float positionScale) {
+	float inverseScale = 1.0f / positionScale;
 
-	return attributeDescriptions;
-}
-
-VkVertexInputBindingDescription Vertex::getBindingDescription() {
-	VkVertexInputBindingDescription bindingDescription {};
-	bindingDescription.binding = 0;
-	bindingDescription.stride = sizeof(Vertex);
-	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	Vertex2DPacked packed{};
+	packed.position = {
+		SpRenderer::packSnorm16(vertex.position.x * inverseScale),
+		SpRenderer::packSnorm16(vertex.position.y * inverseScale)
+	};
+	packed.texCoord = packTexCoord(vertex.texCoord);
+	packed.color = packColor(vertex.color);
 
-	return bindingDescription;
+	return packed;
 }
 
-std::array<VkVertexInputAttributeDescription, 3> Vertex::getBindingDescriptions() {
-	std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions {};
-
-	attributeDescriptions[0].binding = 0;
-	attributeDescriptions[0].location = 0;
-	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[0].offset = offsetof(Vertex, position);
-
-	attributeDescriptions[1].binding = 0;
-	attributeDescriptions[1].location = 1;
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[1].offset = offsetof(Vertex, color);
+VertexPacked packVertex(const Vertex& vertex, float positionScale) {
+	float inverseScale = 1.0f / positionScale;
 
-	attributeDescriptions[2].binding = 0;
-	attributeDescriptions[2].location = 2;
-	attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-	attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+	VertexPacked packed{};
+	packed.position = {
+		SpRenderer::packSnorm16(vertex.position.x * inverseScale),
+		SpRenderer::packSnorm16(vertex.position.y * inverseScale),
+		SpRenderer::packSnorm16(vertex.position.z * inverseScale),
+		SpRenderer::packSnorm16(1.0f)
+	};
+	packed.texCoord = packTexCoord(vertex.texCoord);
+	packed.color = packColor(vertex.color);
 
-	return attributeDescriptions;
+	return packed;
 }
@@ -0,0 +1,275 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "Json.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace SpMeshCook {
+	namespace {
+		const JsonValue NullValue{};
+
+		// Deep enough for any glTF, shallow enough that a hostile file can't run the stack out
+		const uint32 MaxJsonDepth = 128;
+
+		class JsonParser {
+		public:
+			explicit JsonParser(std::string_view text) : mText(text) {}
+
+			bool parse(JsonValue& value, std::string& error) {
+				bool parsed = parseValue(value, 0);
+				skipWhitespace();
+				if (parsed && mPosition != mText.size()) {
+					fail("trailing characters");
+					parsed = false;
+				}
+				if (!parsed) {
+					error = mError + " at byte " + std::to_string(mPosition);
+				}
+				return parsed;
+			}
+
+		private:
+			std::string_view mText;
+			size_t mPosition = 0;
+			std::string mError;
+
+			bool fail(const char* message) {
+				if (mError.empty()) {
+					mError = message;
+				}
+				return false;
+			}
+
+			void skipWhitespace() {
+				while (mPosition < mText.size() &&
+				       (mText[mPosition] == ' ' || mText[mPosition] == '\t' || mText[mPosition] == '\n' || mText[mPosition] == '\r')) {
+					mPosition++;
+				}
+			}
+
+			bool consume(char character) {
+				skipWhitespace();
+				if (mPosition < mText.size() && mText[mPosition] == character) {
+					mPosition++;
+					return true;
+				}
+				return false;
+			}
+
+			bool consumeLiteral(std::string_view literal) {
+				if (mText.substr(mPosition, literal.size()) != literal) {
+					return fail("invalid literal");
+				}
+				mPosition += literal.size();
+				return true;
+			}
+
+			bool parseValue(JsonValue& value, uint32 depth) {
+				if (depth > MaxJsonDepth) {
+					return fail("nested too deeply");
+				}
+
+				skipWhitespace();
+				if (mPosition >= mText.size()) {
+					return fail("unexpected end");
+				}
+
+				switch (mText[mPosition]) {
+					case '{':
+						return parseObject(value, depth);
+					case '[':
+						return parseArray(value, depth);
+					case '"':
+						value.type = SP_JSON_STRING;
+						return parseString(value.string);
+					case 't':
+						value.type = SP_JSON_BOOL;
+						value.boolean = true;
+						return consumeLiteral("true");
+					case 'f':
+						value.type = SP_JSON_BOOL;
+						value.boolean = false;
+						return consumeLiteral("false");
+					case 'n':
+						value.type = SP_JSON_NULL;
+						return consumeLiteral("null");
+					default:
+						return parseNumber(value);
+				}
+			}
+
+			bool parseObject(JsonValue& value, uint32 depth) {
+				value.type = SP_JSON_OBJECT;
+				mPosition++;
+
+				if (consume('}')) {
+					return true;
+				}
+				do {
+					skipWhitespace();
+					std::string& key = value.keys.emplace_back();
+					if (mPosition >= mText.size() || mText[mPosition] != '"' || !parseString(key)) {
+						return fail("expected a key");
+					}
+					if (!consume(':')) {
+						return fail("expected ':'");
+					}
+					if (!parseValue(value.elements.emplace_back(), depth + 1)) {
+						return false;
+					}
+				} while (consume(','));
+
+				return consume('}') || fail("expected '}'");
+			}
+
+			bool parseArray(JsonValue& value, uint32 depth) {
+				value.type = SP_JSON_ARRAY;
+				mPosition++;
+
+				if (consume(']')) {
+					return true;
+				}
+				do {
+					if (!parseValue(value.elements.emplace_back(), depth + 1)) {
+						return false;
+					}
+				} while (consume(','));
+
+				return consume(']') || fail("expected ']'");
+			}
+
+			bool parseNumber(JsonValue& value) {
+				// from_chars takes no leading '+', which JSON doesn't allow either
+				const char* begin = mText.data() + mPosition;
+				const char* end = mText.data() + mText.size();
+				auto [pointer, result] = std::from_chars(begin, end, value.number);
+				if (result != std::errc() || !std::isfinite(value.number)) {
+					return fail("invalid number");
+				}
+
+				value.type = SP_JSON_NUMBER;
+				mPosition += static_cast<size_t>(pointer - begin);
+				return true;
+			}
+
+			bool parseHex(uint32& codePoint) {
+				if (mPosition + 4 > mText.size()) {
+					return fail("truncated escape");
+				}
+				auto [pointer, result] = std::from_chars(mText.data() + mPosition, mText.data() + mPosition + 4, codePoint, 16);
+				if (result != std::errc() || pointer != mText.data() + mPosition + 4) {
+					return fail("invalid escape");
+				}
+				mPosition += 4;
+				return true;
+			}
+
+			static void appendUtf8(std::string& string, uint32 codePoint) {
+				if (codePoint < 0x80) {
+					string += static_cast<char>(codePoint);
+				}else if (codePoint < 0x800) {
+					string += static_cast<char>(0xC0 | (codePoint >> 6));
+					string += static_cast<char>(0x80 | (codePoint & 0x3F));
+				}else if (codePoint < 0x10000) {
+					string += static_cast<char>(0xE0 | (codePoint >> 12));
+					string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+					string += static_cast<char>(0x80 | (codePoint & 0x3F));
+				}else {
+					string += static_cast<char>(0xF0 | (codePoint >> 18));
+					string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+					string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+					string += static_cast<char>(0x80 | (codePoint & 0x3F));
+				}
+			}
+
+			bool parseString(std::string& string) {
+				mPosition++;
+
+				while (mPosition < mText.size()) {
+					char character = mText[mPosition++];
+					if (character == '"') {
+						return true;
+					}
+					if (static_cast<uint8>(character) < 0x20) {
+						return fail("control character in string");
+					}
+					if (character != '\\') {
+						string += character;
+						continue;
+					}
+
+					if (mPosition >= mText.size()) {
+						break;
+					}
+					char escape = mText[mPosition++];
+					switch (escape) {
+						case '"': string += '"'; break;
+						case '\\': string += '\\'; break;
+						case '/': string += '/'; break;
+						case 'b': string += '\b'; break;
+						case 'f': string += '\f'; break;
+						case 'n': string += '\n'; break;
+						case 'r': string += '\r'; break;
+						case 't': string += '\t'; break;
+						case 'u': {
+							uint32 codePoint;
+							if (!parseHex(codePoint)) {
+								return false;
+							}
+							// A high surrogate pairs with the low one escaped right after it
+							if (codePoint >= 0xD800 && codePoint < 0xDC00 && mText.substr(mPosition, 2) == "\\u") {
+								mPosition += 2;
+								uint32 low;
+								if (!parseHex(low) || low < 0xDC00 || low >= 0xE000) {
+									return fail("invalid surrogate pair");
+								}
+								codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+							}
+							appendUtf8(string, codePoint);
+							break;
+						}
+						default:
+							return fail("invalid escape");
+					}
+				}
+
+				return fail("unterminated string");
+			}
+		};
+	}
+
+	const JsonValue& JsonValue::operator[](std::string_view key) const {
+		if (type != SP_JSON_OBJECT) {
+			return NullValue;
+		}
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (keys[i] == key) {
+				return elements[i];
+			}
+		}
+		return NullValue;
+	}
+
+	const JsonValue& JsonValue::operator[](size_t index) const {
+		if (type != SP_JSON_ARRAY || index >= elements.size()) {
+			return NullValue;
+		}
+		return elements[index];
+	}
+
+	uint32 JsonValue::asUint(uint32 fallback) const {
+		if (type != SP_JSON_NUMBER || number < 0.0 || number > std::numeric_limits<uint32>::max() || std::floor(number) != number) {
+			return fallback;
+		}
+		return static_cast<uint32>(number);
+	}
+
+	bool parseJson(std::string_view text, JsonValue& value, std::string& error) {
+		value = {};
+		JsonParser parser(text);
+		return parser.parse(value, error);
+	}
+} // SpMeshCook
@@ -0,0 +1,59 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_JSON_H
+#define SPARKER_ENGINE_JSON_H
+
+#include <SpRenderer/Utils.h>
+
+namespace SpMeshCook {
+	enum JsonType {
+		SP_JSON_NULL,
+		SP_JSON_BOOL,
+		SP_JSON_NUMBER,
+		SP_JSON_STRING,
+		SP_JSON_ARRAY,
+		SP_JSON_OBJECT
+	};
+
+	/*!
+	 * Just enough JSON for glTF. Objects keep their keys in file order, lookups are linear
+	 */
+	struct JsonValue {
+		JsonType type = SP_JSON_NULL;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> elements; // Array elements, or object values
+		std::vector<std::string> keys;   // Objects only, keys[i] names elements[i]
+
+		bool isNull() const { return type == SP_JSON_NULL; }
+		size_t size() const { return elements.size(); }
+
+		/*!
+		 * Null value when this isn't an object or the key is missing
+		 */
+		const JsonValue& operator[](std::string_view key) const;
+		/*!
+		 * Null value when this isn't an array or the index is out of range
+		 */
+		const JsonValue& operator[](size_t index) const;
+
+		double asNumber(double fallback) const { return type == SP_JSON_NUMBER ? number : fallback; }
+		/*!
+		 * fallback for anything that isn't a whole number fitting in a uint32
+		 */
+		uint32 asUint(uint32 fallback) const;
+		const std::string& asString() const { return string; }
+	};
+
+	/**
+	 *
+	 * @param error Why and where the text was rejected
+	 * @return False when the text isn't one valid JSON value
+	 */
+	bool parseJson(std::string_view text, JsonValue& value, std::string& error);
+} // SpMeshCook
+
+#endif //SPARKER_ENGINE_JSON_H
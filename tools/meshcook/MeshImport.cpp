@@ -0,0 +1,621 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "MeshImport.h"
+#include "Json.h"
+
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace SpMeshCook {
+	namespace {
+#pragma region Gltf
+
+		// 'glTF', 'JSON' and 'BIN\0'
+		const uint32 GlbMagic = 0x46546C67;
+		const uint32 GlbJsonChunk = 0x4E4F534A;
+		const uint32 GlbBinaryChunk = 0x004E4942;
+		const size_t GlbHeaderSize = 12;
+		const size_t GlbChunkHeaderSize = 8;
+
+		// Accessor component types, the GL enums glTF reuses
+		const uint32 GltfByte = 5120;
+		const uint32 GltfUnsignedByte = 5121;
+		const uint32 GltfShort = 5122;
+		const uint32 GltfUnsignedShort = 5123;
+		const uint32 GltfUnsignedInt = 5125;
+		const uint32 GltfFloat = 5126;
+
+		const uint32 GltfTriangles = 4;
+
+		struct GltfFile {
+			Utils::MappedFile file;
+			JsonValue json;
+			std::span<const uint8> binaryChunk;       // .glb only
+			std::vector<Utils::MappedFile> external;  // Buffers in their own files, mapped like the main one
+			std::vector<std::vector<uint8>> embedded; // Buffers decoded from data URIs
+			std::vector<std::span<const uint8>> buffers;
+		};
+
+		// Resolved accessor, element i starts at data[i * stride]
+		struct GltfAccessor {
+			const uint8* data = nullptr; // Null without a buffer view, every element is 0 then
+			uint32 count = 0;
+			uint32 stride = 0;
+			uint32 componentType = 0;
+			uint32 componentCount = 0;
+			bool normalized = false;
+		};
+
+		uint32 componentSize(uint32 componentType) {
+			switch (componentType) {
+				case GltfByte:
+				case GltfUnsignedByte:
+					return 1;
+				case GltfShort:
+				case GltfUnsignedShort:
+					return 2;
+				case GltfUnsignedInt:
+				case GltfFloat:
+					return 4;
+				default:
+					return 0;
+			}
+		}
+
+		uint32 typeComponentCount(const std::string& type) {
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			return 0;
+		}
+
+		template<typename T>
+		T readUnaligned(const uint8* data) {
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		bool decodeBase64(std::string_view text, std::vector<uint8>& bytes) {
+			auto sextet = [](char character) -> int32 {
+				if (character >= 'A' && character <= 'Z') return character - 'A';
+				if (character >= 'a' && character <= 'z') return character - 'a' + 26;
+				if (character >= '0' && character <= '9') return character - '0' + 52;
+				if (character == '+') return 62;
+				if (character == '/') return 63;
+				return -1;
+			};
+
+			while (!text.empty() && text.back() == '=') {
+				text.remove_suffix(1);
+			}
+
+			bytes.clear();
+			bytes.reserve(text.size() * 3 / 4);
+
+			uint32 bits = 0;
+			uint32 bitCount = 0;
+			for (char character : text) {
+				int32 value = sextet(character);
+				if (value < 0) {
+					return false;
+				}
+				bits = (bits << 6) | static_cast<uint32>(value);
+				bitCount += 6;
+				if (bitCount >= 8) {
+					bitCount -= 8;
+					bytes.push_back(static_cast<uint8>(bits >> bitCount));
+				}
+			}
+			return true;
+		}
+
+		// URIs may escape spaces and the like, enough of RFC 3986 for file names
+		std::string decodeUri(std::string_view uri) {
+			std::string decoded;
+			for (size_t i = 0; i < uri.size(); i++) {
+				uint32 value;
+				if (uri[i] == '%' && i + 2 < uri.size() &&
+				    std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3) {
+					decoded += static_cast<char>(value);
+					i += 2;
+				}else {
+					decoded += uri[i];
+				}
+			}
+			return decoded;
+		}
+
+		bool readGlb(GltfFile& gltf, std::string_view& jsonText, std::string& error) {
+			std::span<const uint8> bytes = gltf.file.bytes();
+			if (bytes.size() < GlbHeaderSize + GlbChunkHeaderSize || readUnaligned<uint32>(bytes.data()) != GlbMagic) {
+				error = "not a glTF binary";
+				return false;
+			}
+			if (readUnaligned<uint32>(bytes.data() + 4) != 2) {
+				error = "only glTF 2.0 is supported";
+				return false;
+			}
+
+			size_t offset = GlbHeaderSize;
+			while (offset + GlbChunkHeaderSize <= bytes.size()) {
+				uint32 chunkLength = readUnaligned<uint32>(bytes.data() + offset);
+				uint32 chunkType = readUnaligned<uint32>(bytes.data() + offset + 4);
+				offset += GlbChunkHeaderSize;
+				if (chunkLength > bytes.size() - offset) {
+					error = "truncated chunk";
+					return false;
+				}
+
+				std::span<const uint8> chunk = bytes.subspan(offset, chunkLength);
+				if (chunkType == GlbJsonChunk && jsonText.empty()) {
+					jsonText = {reinterpret_cast<const char*>(chunk.data()), chunk.size()};
+				}else if (chunkType == GlbBinaryChunk && gltf.binaryChunk.empty()) {
+					gltf.binaryChunk = chunk;
+				}
+				// Chunks are padded to 4 bytes
+				offset += (chunkLength + 3) & ~3u;
+			}
+
+			if (jsonText.empty()) {
+				error = "no JSON chunk";
+				return false;
+			}
+			return true;
+		}
+
+		bool loadBuffers(GltfFile& gltf, const fs::path& directory, std::string& error) {
+			const JsonValue& buffers = gltf.json["buffers"];
+			for (size_t i = 0; i < buffers.size(); i++) {
+				const JsonValue& buffer = buffers[i];
+				const JsonValue& uri = buffer["uri"];
+				uint32 byteLength = buffer["byteLength"].asUint(0);
+
+				std::span<const uint8> data;
+				if (uri.isNull()) {
+					// The glb's own binary chunk, only ever buffer 0
+					if (i != 0 || gltf.binaryChunk.empty()) {
+						error = "buffer " + std::to_string(i) + " has no data";
+						return false;
+					}
+					data = gltf.binaryChunk;
+				}else if (uri.asString().starts_with("data:")) {
+					size_t comma = uri.asString().find(";base64,");
+					std::vector<uint8>& decoded = gltf.embedded.emplace_back();
+					if (comma == std::string::npos || !decodeBase64(std::string_view(uri.asString()).substr(comma + 8), decoded)) {
+						error = "buffer " + std::to_string(i) + " has an invalid data URI";
+						return false;
+					}
+					data = decoded;
+				}else {
+					fs::path bufferPath = directory / fs::path(decodeUri(uri.asString()));
+					Utils::MappedFile& file = gltf.external.emplace_back(Utils::FileUtils::mapFile(bufferPath, SP_FILE_ACCESS_SEQUENTIAL));
+					if (!file) {
+						error = "could not open buffer " + bufferPath.string();
+						return false;
+					}
+					data = file.bytes();
+				}
+
+				if (data.size() < byteLength) {
+					error = "buffer " + std::to_string(i) + " is shorter than its byteLength";
+					return false;
+				}
+				gltf.buffers.push_back(data.first(byteLength));
+			}
+			return true;
+		}
+
+		bool resolveAccessor(const GltfFile& gltf, uint32 index, GltfAccessor& accessor, std::string& error) {
+			const JsonValue& json = gltf.json["accessors"][index];
+			if (json.isNull()) {
+				error = "missing accessor " + std::to_string(index);
+				return false;
+			}
+			if (!json["sparse"].isNull()) {
+				error = "sparse accessors are not supported";
+				return false;
+			}
+
+			accessor.count = json["count"].asUint(0);
+			accessor.componentType = json["componentType"].asUint(0);
+			accessor.componentCount = typeComponentCount(json["type"].asString());
+			accessor.normalized = json["normalized"].boolean;
+
+			uint32 elementSize = componentSize(accessor.componentType) * accessor.componentCount;
+			if (elementSize == 0) {
+				error = "accessor " + std::to_string(index) + " has an unsupported type";
+				return false;
+			}
+			accessor.stride = elementSize;
+
+			const JsonValue& viewIndex = json["bufferView"];
+			if (viewIndex.isNull()) {
+				return true;
+			}
+
+			const JsonValue& view = gltf.json["bufferViews"][viewIndex.asUint(std::numeric_limits<uint32>::max())];
+			uint32 bufferIndex = view["buffer"].asUint(std::numeric_limits<uint32>::max());
+			if (view.isNull() || bufferIndex >= gltf.buffers.size()) {
+				error = "accessor " + std::to_string(index) + " has an invalid buffer view";
+				return false;
+			}
+
+			uint64 viewOffset = view["byteOffset"].asUint(0);
+			uint64 viewLength = view["byteLength"].asUint(0);
+			uint64 accessorOffset = json["byteOffset"].asUint(0);
+			accessor.stride = view["byteStride"].asUint(elementSize);
+
+			std::span<const uint8> buffer = gltf.buffers[bufferIndex];
+			uint64 accessorEnd = accessor.count == 0 ? 0 : accessorOffset + static_cast<uint64>(accessor.stride) * (accessor.count - 1) + elementSize;
+			if (viewOffset + viewLength > buffer.size() || accessorEnd > viewLength || accessor.stride < elementSize) {
+				error = "accessor " + std::to_string(index) + " is out of bounds";
+				return false;
+			}
+
+			accessor.data = buffer.data() + viewOffset + accessorOffset;
+			return true;
+		}
+
+		float readComponent(const GltfAccessor& accessor, uint32 element, uint32 component) {
+			if (accessor.data == nullptr) {
+				return 0.0f;
+			}
+
+			const uint8* data = accessor.data + static_cast<size_t>(element) * accessor.stride;
+			switch (accessor.componentType) {
+				case GltfFloat:
+					return readUnaligned<float>(data + component * 4);
+				case GltfUnsignedByte: {
+					float value = data[component];
+					return accessor.normalized ? value / 255.0f : value;
+				}
+				case GltfByte: {
+					float value = static_cast<int8>(data[component]);
+					return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+				}
+				case GltfUnsignedShort: {
+					float value = readUnaligned<uint16>(data + component * 2);
+					return accessor.normalized ? value / 65535.0f : value;
+				}
+				case GltfShort: {
+					float value = readUnaligned<int16>(data + component * 2);
+					return accessor.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+				}
+				default:
+					return static_cast<float>(readUnaligned<uint32>(data + component * 4));
+			}
+		}
+
+		uint32 readIndex(const GltfAccessor& accessor, uint32 element) {
+			const uint8* data = accessor.data + static_cast<size_t>(element) * accessor.stride;
+			switch (accessor.componentType) {
+				case GltfUnsignedByte:
+					return data[0];
+				case GltfUnsignedShort:
+					return readUnaligned<uint16>(data);
+				default:
+					return readUnaligned<uint32>(data);
+			}
+		}
+
+		bool importPrimitive(const GltfFile& gltf, const JsonValue& primitive, ImportedMesh& mesh, std::string& error) {
+			const JsonValue& attributes = primitive["attributes"];
+
+			if (attributes["POSITION"].isNull()) {
+				error = "a primitive has no positions";
+				return false;
+			}
+			GltfAccessor positions;
+			if (!resolveAccessor(gltf, attributes["POSITION"].asUint(0), positions, error)) {
+				return false;
+			}
+			if (positions.componentType != GltfFloat || positions.componentCount != 3) {
+				error = "positions have to be float vec3";
+				return false;
+			}
+
+			GltfAccessor texCoords;
+			bool hasTexCoords = !attributes["TEXCOORD_0"].isNull();
+			if (hasTexCoords && !resolveAccessor(gltf, attributes["TEXCOORD_0"].asUint(0), texCoords, error)) {
+				return false;
+			}
+
+			GltfAccessor colors;
+			bool hasColors = !attributes["COLOR_0"].isNull();
+			if (hasColors && !resolveAccessor(gltf, attributes["COLOR_0"].asUint(0), colors, error)) {
+				return false;
+			}
+
+			if ((hasTexCoords && (texCoords.count < positions.count || texCoords.componentCount != 2)) ||
+			    (hasColors && (colors.count < positions.count || colors.componentCount < 3))) {
+				error = "a primitive's attributes don't match its positions";
+				return false;
+			}
+
+			uint32 baseVertex = static_cast<uint32>(mesh.vertices.size());
+			for (uint32 i = 0; i < positions.count; i++) {
+				Vertex vertex{};
+				vertex.position = vec3(readComponent(positions, i, 0), readComponent(positions, i, 1), readComponent(positions, i, 2));
+				if (hasTexCoords) {
+					vertex.texCoord = vec2(readComponent(texCoords, i, 0), readComponent(texCoords, i, 1));
+				}
+				vertex.color = hasColors ? vec3(readComponent(colors, i, 0), readComponent(colors, i, 1), readComponent(colors, i, 2))
+				                         : vec3(1.0f);
+				mesh.vertices.push_back(vertex);
+			}
+
+			if (primitive["indices"].isNull()) {
+				for (uint32 i = 0; i + 2 < positions.count; i += 3) {
+					mesh.indices.insert(mesh.indices.end(), {baseVertex + i, baseVertex + i + 1, baseVertex + i + 2});
+				}
+				return true;
+			}
+
+			GltfAccessor indices;
+			if (!resolveAccessor(gltf, primitive["indices"].asUint(0), indices, error)) {
+				return false;
+			}
+			if (indices.componentCount != 1 || indices.data == nullptr ||
+			    (indices.componentType != GltfUnsignedByte && indices.componentType != GltfUnsignedShort && indices.componentType != GltfUnsignedInt)) {
+				error = "indices have to be unsigned integer scalars";
+				return false;
+			}
+
+			for (uint32 i = 0; i + 2 < indices.count; i += 3) {
+				uint32 triangle[3] = {readIndex(indices, i), readIndex(indices, i + 1), readIndex(indices, i + 2)};
+				for (uint32 index : triangle) {
+					if (index >= positions.count) {
+						error = "index " + std::to_string(index) + " is out of range";
+						return false;
+					}
+				}
+				mesh.indices.insert(mesh.indices.end(), {baseVertex + triangle[0], baseVertex + triangle[1], baseVertex + triangle[2]});
+			}
+			return true;
+		}
+
+#pragma endregion Gltf
+
+#pragma region Obj
+
+		class ObjLine {
+		public:
+			explicit ObjLine(std::string_view line) : mLine(line) {}
+
+			std::string_view token() {
+				skipWhitespace();
+				size_t end = mPosition;
+				while (end < mLine.size() && mLine[end] != ' ' && mLine[end] != '\t') {
+					end++;
+				}
+				std::string_view token = mLine.substr(mPosition, end - mPosition);
+				mPosition = end;
+				return token;
+			}
+
+			bool number(float& value) {
+				skipWhitespace();
+				auto [pointer, result] = std::from_chars(mLine.data() + mPosition, mLine.data() + mLine.size(), value);
+				if (result != std::errc()) {
+					return false;
+				}
+				mPosition = static_cast<size_t>(pointer - mLine.data());
+				return true;
+			}
+
+			std::string_view rest() {
+				skipWhitespace();
+				std::string_view rest = mLine.substr(mPosition);
+				while (!rest.empty() && (rest.back() == ' ' || rest.back() == '\t')) {
+					rest.remove_suffix(1);
+				}
+				return rest;
+			}
+
+		private:
+			std::string_view mLine;
+			size_t mPosition = 0;
+
+			void skipWhitespace() {
+				while (mPosition < mLine.size() && (mLine[mPosition] == ' ' || mLine[mPosition] == '\t')) {
+					mPosition++;
+				}
+			}
+		};
+
+		/*!
+		 * 1 based or negative from the end, -1 for an empty reference
+		 */
+		bool resolveObjIndex(std::string_view text, size_t count, int64& index) {
+			if (text.empty()) {
+				index = -1;
+				return true;
+			}
+
+			int64 value;
+			auto [pointer, result] = std::from_chars(text.data(), text.data() + text.size(), value);
+			if (result != std::errc() || pointer != text.data() + text.size() || value == 0) {
+				return false;
+			}
+
+			index = value > 0 ? value - 1 : static_cast<int64>(count) + value;
+			return index >= 0 && index < static_cast<int64>(count);
+		}
+
+#pragma endregion Obj
+	}
+
+	bool importGltf(const fs::path& filePath, std::vector<ImportedMesh>& meshes, std::string& error) {
+		GltfFile gltf;
+		gltf.file = Utils::FileUtils::mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+		if (!gltf.file) {
+			error = "could not open the file";
+			return false;
+		}
+
+		std::string_view jsonText = gltf.file.text();
+		if (filePath.extension() == ".glb") {
+			jsonText = {};
+			if (!readGlb(gltf, jsonText, error)) {
+				return false;
+			}
+		}
+
+		if (!parseJson(jsonText, gltf.json, error)) {
+			error = "invalid JSON, " + error;
+			return false;
+		}
+		if (!gltf.json["asset"]["version"].asString().starts_with("2.")) {
+			error = "only glTF 2.0 is supported";
+			return false;
+		}
+		if (!loadBuffers(gltf, filePath.parent_path(), error)) {
+			return false;
+		}
+
+		const JsonValue& gltfMeshes = gltf.json["meshes"];
+		for (size_t i = 0; i < gltfMeshes.size(); i++) {
+			const JsonValue& gltfMesh = gltfMeshes[i];
+
+			ImportedMesh mesh;
+			mesh.name = gltfMesh["name"].isNull() ? "mesh " + std::to_string(i) : gltfMesh["name"].asString();
+
+			const JsonValue& primitives = gltfMesh["primitives"];
+			for (size_t j = 0; j < primitives.size(); j++) {
+				uint32 mode = primitives[j]["mode"].asUint(GltfTriangles);
+				if (mode != GltfTriangles) {
+					SpConsole::Write(SP_MESSAGE_WARNING, mesh.name + ": skipped primitive " + std::to_string(j) +
+					                                     ", mode " + std::to_string(mode) + " is not a triangle list");
+					continue;
+				}
+				if (!importPrimitive(gltf, primitives[j], mesh, error)) {
+					error = mesh.name + ": " + error;
+					return false;
+				}
+			}
+
+			if (!mesh.indices.empty()) {
+				meshes.push_back(std::move(mesh));
+			}
+		}
+		return true;
+	}
+
+	bool importObj(const fs::path& filePath, std::vector<ImportedMesh>& meshes, std::string& error) {
+		Utils::MappedFile file = Utils::FileUtils::mapFile(filePath, SP_FILE_ACCESS_SEQUENTIAL);
+		if (!file) {
+			error = "could not open the file";
+			return false;
+		}
+
+		std::vector<vec3> positions;
+		std::vector<vec3> colors;
+		std::vector<vec2> texCoords;
+
+		ImportedMesh mesh;
+		mesh.name = filePath.stem().string();
+		// Position and texture coordinate index pairs already turned into a vertex of the current mesh
+		std::unordered_map<uint64, uint32> vertexIndices;
+		std::vector<uint32> polygon;
+
+		auto finishMesh = [&](std::string_view nextName) {
+			if (!mesh.indices.empty()) {
+				meshes.push_back(std::move(mesh));
+				mesh = {};
+				vertexIndices.clear();
+			}
+			if (!nextName.empty()) {
+				mesh.name = nextName;
+			}
+		};
+
+		std::string_view text = file.text();
+		uint32 lineNumber = 0;
+		while (!text.empty()) {
+			size_t lineEnd = text.find('\n');
+			std::string_view lineText = text.substr(0, lineEnd);
+			text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+			lineNumber++;
+
+			if (!lineText.empty() && lineText.back() == '\r') {
+				lineText.remove_suffix(1);
+			}
+
+			ObjLine line(lineText);
+			std::string_view keyword = line.token();
+
+			if (keyword == "v") {
+				vec3 position;
+				if (!line.number(position.x) || !line.number(position.y) || !line.number(position.z)) {
+					error = "line " + std::to_string(lineNumber) + ": invalid position";
+					return false;
+				}
+				vec3 color(1.0f);
+				if (line.number(color.x) && (!line.number(color.y) || !line.number(color.z))) {
+					// A w coordinate, not a color
+					color = vec3(1.0f);
+				}
+				positions.push_back(position);
+				colors.push_back(color);
+			}else if (keyword == "vt") {
+				vec2 texCoord;
+				if (!line.number(texCoord.x)) {
+					error = "line " + std::to_string(lineNumber) + ": invalid texture coordinate";
+					return false;
+				}
+				if (!line.number(texCoord.y)) {
+					texCoord.y = 0.0f;
+				}
+				// OBJ puts the origin at the bottom left, Vulkan samples from the top left
+				texCoord.y = 1.0f - texCoord.y;
+				texCoords.push_back(texCoord);
+			}else if (keyword == "f") {
+				polygon.clear();
+				for (std::string_view corner = line.token(); !corner.empty(); corner = line.token()) {
+					size_t firstSlash = corner.find('/');
+					std::string_view positionText = corner.substr(0, firstSlash);
+					std::string_view texCoordText;
+					if (firstSlash != std::string_view::npos) {
+						texCoordText = corner.substr(firstSlash + 1);
+						texCoordText = texCoordText.substr(0, texCoordText.find('/'));
+					}
+
+					int64 position;
+					int64 texCoord;
+					if (positionText.empty() || !resolveObjIndex(positionText, positions.size(), position) ||
+					    !resolveObjIndex(texCoordText, texCoords.size(), texCoord)) {
+						error = "line " + std::to_string(lineNumber) + ": invalid face";
+						return false;
+					}
+
+					uint64 key = (static_cast<uint64>(position) << 32) | static_cast<uint64>(texCoord + 1);
+					auto [it, inserted] = vertexIndices.try_emplace(key, static_cast<uint32>(mesh.vertices.size()));
+					if (inserted) {
+						Vertex vertex{};
+						vertex.position = positions[position];
+						vertex.texCoord = texCoord >= 0 ? texCoords[texCoord] : vec2(0.0f);
+						vertex.color = colors[position];
+						mesh.vertices.push_back(vertex);
+					}
+					polygon.push_back(it->second);
+				}
+
+				for (size_t i = 2; i < polygon.size(); i++) {
+					mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+				}
+			}else if (keyword == "o" || keyword == "g") {
+				finishMesh(line.rest());
+			}
+		}
+
+		finishMesh({});
+		return true;
+	}
+} // SpMeshCook
@@ -0,0 +1,37 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_MESHIMPORT_H
+#define SPARKER_ENGINE_MESHIMPORT_H
+
+#include <SpRenderer/Vertex.h>
+
+namespace SpMeshCook {
+	/*!
+	 * Triangle list in mesh space, vertices shared between triangles where the source shares them
+	 */
+	struct ImportedMesh {
+		std::string name;
+		std::vector<Vertex> vertices;
+		std::vector<uint32> indices;
+	};
+
+	/**
+	 * Every glTF mesh becomes one mesh with its triangle primitives merged. Node transforms are not applied, placing
+	 * meshes is up to the scene. Reads .gltf with external or embedded buffers and .glb.
+	 *
+	 * @param error Why the file was rejected
+	 */
+	bool importGltf(const std::filesystem::path& filePath, std::vector<ImportedMesh>& meshes, std::string& error);
+
+	/**
+	 * Positions, texture coordinates and the common "v x y z r g b" vertex color extension. Objects and groups start
+	 * a new mesh, faces with more than three corners are fanned.
+	 *
+	 * @param error Why the file was rejected
+	 */
+	bool importObj(const std::filesystem::path& filePath, std::vector<ImportedMesh>& meshes, std::string& error);
+} // SpMeshCook
+
+#endif //SPARKER_ENGINE_MESHIMPORT_H
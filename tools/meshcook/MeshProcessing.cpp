@@ -0,0 +1,488 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "MeshProcessing.h"
+
+#include <SpRenderer/GpuScene.h>
+
+#include <cmath>
+#include <numeric>
+
+namespace SpMeshCook {
+	namespace {
+		// Forsyth's published tuning, the simulated cache is bigger than real ones so scores fall off smoothly
+		const uint32 ForsythCacheSize = 32;
+		const float CacheDecayPower = 1.5f;
+		const float LastTriangleScore = 0.75f;
+		const float ValenceBoostScale = 2.0f;
+		const float ValenceBoostPower = 0.5f;
+
+		// Cones wider than this are useless for culling, about 84 degrees from the axis
+		const float MinConeDot = 0.1f;
+
+		const uint32 NoTriangle = std::numeric_limits<uint32>::max();
+
+		float vertexScore(int32 cachePosition, uint32 remainingTriangles) {
+			if (remainingTriangles == 0) {
+				return -1.0f;
+			}
+
+			float score = 0.0f;
+			if (cachePosition >= 0) {
+				// The last triangle's vertices score a little lower, so strips don't keep walking in one direction
+				if (cachePosition < 3) {
+					score = LastTriangleScore;
+				}else {
+					float scale = 1.0f / static_cast<float>(ForsythCacheSize - 3);
+					score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, CacheDecayPower);
+				}
+			}
+
+			// Vertices with few triangles left are finished off first, so they don't linger as single triangles
+			return score + ValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -ValenceBoostPower);
+		}
+
+		vec3 triangleNormal(std::span<const Vertex> vertices, const uint32* triangle) {
+			const vec3& a = vertices[triangle[0]].position;
+			const vec3& b = vertices[triangle[1]].position;
+			const vec3& c = vertices[triangle[2]].position;
+			// Length is twice the area, which weights sums of these by area
+			return glm::cross(b - a, c - a);
+		}
+
+		vec3 triangleCentroid(std::span<const Vertex> vertices, const uint32* triangle) {
+			return (vertices[triangle[0]].position + vertices[triangle[1]].position + vertices[triangle[2]].position) / 3.0f;
+		}
+
+		/*!
+		 * Misses of a FIFO cache, a vertex is in it while fewer than cacheSize misses happened since it was loaded
+		 */
+		class CacheSimulation {
+		public:
+			CacheSimulation(uint32 vertexCount, uint32 cacheSize) : mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+			uint32 triangleMisses(const uint32* triangle) {
+				uint32 misses = 0;
+				for (uint32 i = 0; i < 3; i++) {
+					if (mTime - mTimestamps[triangle[i]] > mCacheSize) {
+						mTimestamps[triangle[i]] = mTime++;
+						misses++;
+					}
+				}
+				return misses;
+			}
+
+			void reset() {
+				mTime += mCacheSize + 1;
+			}
+
+		private:
+			std::vector<uint32> mTimestamps;
+			uint32 mCacheSize;
+			uint32 mTime;
+		};
+
+		SpRenderer::MeshFileMeshlet finishMeshlet(std::span<const uint32> indices,
+		                                          std::span<const Vertex> vertices,
+		                                          uint32 firstIndex,
+		                                          uint32 triangleCount,
+		                                          std::span<const uint32> meshletVertices) {
+			SpRenderer::MeshFileMeshlet meshlet{};
+			meshlet.firstIndex = firstIndex;
+			meshlet.triangleCount = triangleCount;
+			meshlet.vertexCount = static_cast<uint32>(meshletVertices.size());
+
+			vec3 minimum(std::numeric_limits<float>::max());
+			vec3 maximum(std::numeric_limits<float>::lowest());
+			for (uint32 vertex : meshletVertices) {
+				minimum = glm::min(minimum, vertices[vertex].position);
+				maximum = glm::max(maximum, vertices[vertex].position);
+			}
+			vec3 center = (minimum + maximum) * 0.5f;
+			float radius = 0.0f;
+			for (uint32 vertex : meshletVertices) {
+				radius = std::max(radius, glm::length(vertices[vertex].position - center));
+			}
+			meshlet.boundingSphere = vec4(center, radius);
+
+			// Average facing, then how far the widest triangle strays from it
+			vec3 axis(0.0f);
+			for (uint32 triangle = 0; triangle < triangleCount; triangle++) {
+				vec3 normal = triangleNormal(vertices, &indices[firstIndex + triangle * 3]);
+				float length = glm::length(normal);
+				if (length > 0.0f) {
+					axis = axis + normal / length;
+				}
+			}
+
+			// w of 1 never passes the culling test
+			meshlet.cone = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			float axisLength = glm::length(axis);
+			if (axisLength == 0.0f) {
+				return meshlet;
+			}
+			axis = axis / axisLength;
+
+			float minDot = 1.0f;
+			for (uint32 triangle = 0; triangle < triangleCount; triangle++) {
+				vec3 normal = triangleNormal(vertices, &indices[firstIndex + triangle * 3]);
+				float length = glm::length(normal);
+				if (length > 0.0f) {
+					minDot = std::min(minDot, glm::dot(normal / length, axis));
+				}
+			}
+
+			// Every normal is within acos(minDot) of the axis, so views within 90 degrees minus that of the axis see
+			// only back faces, cos(90 - angle) = sin(angle)
+			if (minDot > MinConeDot) {
+				meshlet.cone = vec4(axis, std::sqrt(1.0f - minDot * minDot));
+			}
+			return meshlet;
+		}
+	}
+
+	CookedMesh cookMesh(const ImportedMesh& mesh, const CookSettings& settings, CookStats& stats) {
+		stats = {};
+
+		std::vector<Vertex> vertices = mesh.vertices;
+		std::vector<uint32> indices;
+		indices.reserve(mesh.indices.size());
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			uint32 a = mesh.indices[i];
+			uint32 b = mesh.indices[i + 1];
+			uint32 c = mesh.indices[i + 2];
+			if (a == b || b == c || a == c) {
+				stats.droppedTriangles++;
+				continue;
+			}
+			indices.insert(indices.end(), {a, b, c});
+		}
+
+		CookedMesh cooked;
+		cooked.name = mesh.name;
+		if (indices.empty()) {
+			return cooked;
+		}
+
+		stats.acmrBefore = averageCacheMissRatio(indices, static_cast<uint32>(vertices.size()));
+
+		optimizeVertexCache(indices, static_cast<uint32>(vertices.size()));
+		if (settings.optimizeOverdraw) {
+			optimizeOverdraw(indices, vertices);
+		}
+		// Last, it follows the final triangle order
+		uint32 vertexCount = optimizeVertexFetch(indices, vertices);
+		stats.droppedVertices = static_cast<uint32>(mesh.vertices.size()) - vertexCount;
+
+		stats.acmrAfter = averageCacheMissRatio(indices, vertexCount);
+
+		if (settings.buildMeshlets) {
+			cooked.meshlets = buildMeshlets(indices, vertices);
+		}
+
+		// Same scale GpuScene::addMesh picks, the largest absolute coordinate maps to 1
+		cooked.positionScale = 0.0f;
+		for (const Vertex& vertex : vertices) {
+			cooked.positionScale = std::max({cooked.positionScale, std::abs(vertex.position.x), std::abs(vertex.position.y), std::abs(vertex.position.z)});
+		}
+		if (cooked.positionScale == 0.0f) {
+			cooked.positionScale = 1.0f;
+		}
+		cooked.boundingSphere = SpRenderer::GpuScene::boundingSphere(vertices);
+
+		cooked.vertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			cooked.vertices[i] = packVertex(vertices[i], cooked.positionScale);
+		}
+		cooked.indices = std::move(indices);
+
+		return cooked;
+	}
+
+	void optimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount) {
+		const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+		if (triangleCount == 0) {
+			return;
+		}
+
+		// Triangles of each vertex, the live ones are the first remaining[v] of its range
+		std::vector<uint32> remaining(vertexCount, 0);
+		for (uint32 index : indices) {
+			remaining[index]++;
+		}
+		std::vector<uint32> adjacencyOffsets(vertexCount + 1, 0);
+		std::inclusive_scan(remaining.begin(), remaining.end(), adjacencyOffsets.begin() + 1);
+		std::vector<uint32> adjacency(indices.size());
+		{
+			std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32 triangle = 0; triangle < triangleCount; triangle++) {
+				for (uint32 i = 0; i < 3; i++) {
+					adjacency[fill[indices[triangle * 3 + i]]++] = triangle;
+				}
+			}
+		}
+
+		std::vector<int32> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32 vertex = 0; vertex < vertexCount; vertex++) {
+			vertexScores[vertex] = vertexScore(-1, remaining[vertex]);
+		}
+
+		auto triangleScore = [&](uint32 triangle) {
+			const uint32* corners = &indices[triangle * 3];
+			return vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+		};
+
+		// Scores only change around the cache, so the whole mesh is searched just this once
+		std::vector<bool> emitted(triangleCount, false);
+		uint32 bestTriangle = 0;
+		for (uint32 triangle = 1; triangle < triangleCount; triangle++) {
+			if (triangleScore(triangle) > triangleScore(bestTriangle)) {
+				bestTriangle = triangle;
+			}
+		}
+
+		std::vector<uint32> output;
+		output.reserve(indices.size());
+
+		std::vector<uint32> cache;
+		std::vector<uint32> nextCache;
+		cache.reserve(ForsythCacheSize + 3);
+		nextCache.reserve(ForsythCacheSize + 3);
+
+		uint32 inputCursor = 0;
+		for (uint32 emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+			// Nothing in the cache has triangles left, carry on with the next one in input order
+			if (bestTriangle == NoTriangle) {
+				while (emitted[inputCursor]) {
+					inputCursor++;
+				}
+				bestTriangle = inputCursor;
+			}
+
+			const uint32* corners = &indices[bestTriangle * 3];
+			output.insert(output.end(), corners, corners + 3);
+			emitted[bestTriangle] = true;
+
+			for (uint32 i = 0; i < 3; i++) {
+				uint32 vertex = corners[i];
+				uint32* begin = &adjacency[adjacencyOffsets[vertex]];
+				uint32* end = begin + remaining[vertex];
+				*std::find(begin, end, bestTriangle) = *(end - 1);
+				remaining[vertex]--;
+			}
+
+			// The triangle's vertices move to the front, everything else shifts back
+			nextCache.assign(corners, corners + 3);
+			for (uint32 vertex : cache) {
+				if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) {
+					nextCache.push_back(vertex);
+				}
+			}
+			for (size_t i = 0; i < nextCache.size(); i++) {
+				cachePositions[nextCache[i]] = i < ForsythCacheSize ? static_cast<int32>(i) : -1;
+			}
+			for (uint32 vertex : nextCache) {
+				vertexScores[vertex] = vertexScore(cachePositions[vertex], remaining[vertex]);
+			}
+
+			// Only triangles of vertices that were or are cached changed score
+			bestTriangle = NoTriangle;
+			float bestScore = -1.0f;
+			for (uint32 vertex : nextCache) {
+				for (uint32 j = 0; j < remaining[vertex]; j++) {
+					uint32 triangle = adjacency[adjacencyOffsets[vertex] + j];
+					float score = triangleScore(triangle);
+					if (score > bestScore) {
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+
+			if (nextCache.size() > ForsythCacheSize) {
+				nextCache.resize(ForsythCacheSize);
+			}
+			std::swap(cache, nextCache);
+		}
+
+		indices = std::move(output);
+	}
+
+	void optimizeOverdraw(std::vector<uint32>& indices, std::span<const Vertex> vertices, float threshold) {
+		const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+		const uint32 vertexCount = static_cast<uint32>(vertices.size());
+		if (triangleCount < 2) {
+			return;
+		}
+
+		// Hard boundaries, where every vertex of a triangle missed and the cache effectively started over
+		std::vector<uint32> hardClusters;
+		{
+			CacheSimulation cache(vertexCount, StatsCacheSize);
+			for (uint32 triangle = 0; triangle < triangleCount; triangle++) {
+				if (cache.triangleMisses(&indices[triangle * 3]) == 3) {
+					hardClusters.push_back(triangle);
+				}
+			}
+		}
+		hardClusters.push_back(triangleCount);
+
+		// Soft boundaries split a hard cluster wherever its miss ratio so far is close enough to the whole cluster's.
+		// Every cut resets the cache, which is what drawing the pieces in another order costs
+		std::vector<uint32> clusters;
+		CacheSimulation cache(vertexCount, StatsCacheSize);
+		for (size_t i = 0; i + 1 < hardClusters.size(); i++) {
+			uint32 begin = hardClusters[i];
+			uint32 end = hardClusters[i + 1];
+
+			cache.reset();
+			uint32 clusterMisses = 0;
+			for (uint32 triangle = begin; triangle < end; triangle++) {
+				clusterMisses += cache.triangleMisses(&indices[triangle * 3]);
+			}
+			float clusterRatio = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+			cache.reset();
+			clusters.push_back(begin);
+			uint32 softBegin = begin;
+			uint32 misses = 0;
+			for (uint32 triangle = begin; triangle < end; triangle++) {
+				misses += cache.triangleMisses(&indices[triangle * 3]);
+				float ratio = static_cast<float>(misses) / static_cast<float>(triangle + 1 - softBegin);
+				if (triangle + 1 < end && ratio <= clusterRatio * threshold) {
+					softBegin = triangle + 1;
+					clusters.push_back(softBegin);
+					misses = 0;
+					cache.reset();
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+
+		// Area weighted, so slivers don't pull the center around
+		vec3 meshCenter(0.0f);
+		float meshArea = 0.0f;
+		for (uint32 triangle = 0; triangle < triangleCount; triangle++) {
+			float area = glm::length(triangleNormal(vertices, &indices[triangle * 3]));
+			meshCenter = meshCenter + triangleCentroid(vertices, &indices[triangle * 3]) * area;
+			meshArea += area;
+		}
+		if (meshArea > 0.0f) {
+			meshCenter = meshCenter / meshArea;
+		}
+
+		// How far out the cluster sits along its own facing, the outermost clusters are drawn first
+		const uint32 clusterCount = static_cast<uint32>(clusters.size() - 1);
+		std::vector<float> sortKeys(clusterCount);
+		for (uint32 cluster = 0; cluster < clusterCount; cluster++) {
+			vec3 center(0.0f);
+			vec3 normal(0.0f);
+			float area = 0.0f;
+			for (uint32 triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++) {
+				vec3 triangleFacing = triangleNormal(vertices, &indices[triangle * 3]);
+				float triangleArea = glm::length(triangleFacing);
+				center = center + triangleCentroid(vertices, &indices[triangle * 3]) * triangleArea;
+				normal = normal + triangleFacing;
+				area += triangleArea;
+			}
+
+			float normalLength = glm::length(normal);
+			if (area == 0.0f || normalLength == 0.0f) {
+				sortKeys[cluster] = 0.0f;
+				continue;
+			}
+			sortKeys[cluster] = glm::dot(center / area - meshCenter, normal / normalLength);
+		}
+
+		std::vector<uint32> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32 a, uint32 b) {
+			return sortKeys[a] > sortKeys[b];
+		});
+
+		std::vector<uint32> output;
+		output.reserve(indices.size());
+		for (uint32 cluster : order) {
+			output.insert(output.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+		}
+		indices = std::move(output);
+	}
+
+	uint32 optimizeVertexFetch(std::vector<uint32>& indices, std::vector<Vertex>& vertices) {
+		const uint32 Unused = std::numeric_limits<uint32>::max();
+		std::vector<uint32> remap(vertices.size(), Unused);
+		std::vector<Vertex> reordered;
+		reordered.reserve(vertices.size());
+
+		for (uint32& index : indices) {
+			if (remap[index] == Unused) {
+				remap[index] = static_cast<uint32>(reordered.size());
+				reordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices = std::move(reordered);
+		return static_cast<uint32>(vertices.size());
+	}
+
+	std::vector<SpRenderer::MeshFileMeshlet> buildMeshlets(std::span<const uint32> indices, std::span<const Vertex> vertices) {
+		std::vector<SpRenderer::MeshFileMeshlet> meshlets;
+
+		// Meshlet each vertex was last added to, so membership is a compare instead of a search
+		const uint32 NoMeshlet = std::numeric_limits<uint32>::max();
+		std::vector<uint32> vertexMeshlet(vertices.size(), NoMeshlet);
+		std::vector<uint32> meshletVertices;
+		meshletVertices.reserve(SpRenderer::MaxMeshletVertices);
+
+		uint32 firstIndex = 0;
+		uint32 triangleCount = 0;
+		const uint32 totalTriangles = static_cast<uint32>(indices.size() / 3);
+		for (uint32 triangle = 0; triangle < totalTriangles; triangle++) {
+			const uint32* corners = &indices[triangle * 3];
+			const uint32 current = static_cast<uint32>(meshlets.size());
+
+			uint32 newVertices = 0;
+			for (uint32 i = 0; i < 3; i++) {
+				if (vertexMeshlet[corners[i]] != current) newVertices++;
+			}
+
+			if (triangleCount == SpRenderer::MaxMeshletTriangles || meshletVertices.size() + newVertices > SpRenderer::MaxMeshletVertices) {
+				meshlets.push_back(finishMeshlet(indices, vertices, firstIndex, triangleCount, meshletVertices));
+				firstIndex = triangle * 3;
+				triangleCount = 0;
+				meshletVertices.clear();
+			}
+
+			const uint32 meshlet = static_cast<uint32>(meshlets.size());
+			for (uint32 i = 0; i < 3; i++) {
+				if (vertexMeshlet[corners[i]] != meshlet) {
+					vertexMeshlet[corners[i]] = meshlet;
+					meshletVertices.push_back(corners[i]);
+				}
+			}
+			triangleCount++;
+		}
+
+		if (triangleCount != 0) {
+			meshlets.push_back(finishMeshlet(indices, vertices, firstIndex, triangleCount, meshletVertices));
+		}
+		return meshlets;
+	}
+
+	float averageCacheMissRatio(std::span<const uint32> indices, uint32 vertexCount, uint32 cacheSize) {
+		const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+		if (triangleCount == 0) {
+			return 0.0f;
+		}
+
+		CacheSimulation cache(vertexCount, cacheSize);
+		uint32 misses = 0;
+		for (uint32 triangle = 0; triangle < triangleCount; triangle++) {
+			misses += cache.triangleMisses(&indices[triangle * 3]);
+		}
+		return static_cast<float>(misses) / static_cast<float>(triangleCount);
+	}
+} // SpMeshCook
@@ -0,0 +1,82 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_MESHPROCESSING_H
+#define SPARKER_ENGINE_MESHPROCESSING_H
+
+#include "MeshImport.h"
+
+#include <SpRenderer/MeshFile.h>
+
+namespace SpMeshCook {
+	// Simulated post transform cache for the statistics, a small FIFO like most hardware
+	const uint32 StatsCacheSize = 16;
+	// Overdraw ordering may cost this much of the vertex cache, as a factor of the optimized miss ratio
+	const float OverdrawCacheThreshold = 1.05f;
+
+	struct CookSettings {
+		bool optimizeOverdraw = true;
+		bool buildMeshlets = true;
+	};
+
+	/*!
+	 * A mesh in file layout, indices relative to its own vertices
+	 */
+	struct CookedMesh {
+		std::string name;
+		vec4 boundingSphere;
+		float positionScale;
+		std::vector<VertexPacked> vertices;
+		std::vector<uint32> indices;
+		std::vector<SpRenderer::MeshFileMeshlet> meshlets;
+	};
+
+	struct CookStats {
+		float acmrBefore = 0.0f; // Average cache misses per triangle with StatsCacheSize, 0.5 is the practical floor
+		float acmrAfter = 0.0f;
+		uint32 droppedTriangles = 0;
+		uint32 droppedVertices = 0;
+	};
+
+	/*!
+	 * Vertex cache, overdraw and vertex fetch order, meshlets, then quantization. Degenerate triangles and vertices
+	 * no triangle uses are dropped
+	 */
+	CookedMesh cookMesh(const ImportedMesh& mesh, const CookSettings& settings, CookStats& stats);
+
+	/**
+	 * Reorders triangles so vertices are reused while they are still in the post transform cache, Tom Forsyth's
+	 * linear speed vertex cache optimization
+	 */
+	void optimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount);
+
+	/**
+	 * Splits the cache optimized order into clusters where the cache starts over anyway, and sorts the clusters so
+	 * the ones facing away from the mesh's center, which are likely to occlude the rest, draw first. Sander et al.,
+	 * Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+	 *
+	 * @param threshold Clusters are only cut where the miss ratio so far stays under threshold times the overall one
+	 */
+	void optimizeOverdraw(std::vector<uint32>& indices, std::span<const Vertex> vertices, float threshold = OverdrawCacheThreshold);
+
+	/**
+	 * Renumbers the vertices in the order the indices first use them, so vertex fetch reads memory front to back
+	 *
+	 * @return Vertex count after dropping unused ones
+	 */
+	uint32 optimizeVertexFetch(std::vector<uint32>& indices, std::vector<Vertex>& vertices);
+
+	/*!
+	 * Cuts the index order into runs of at most MaxMeshletTriangles triangles touching at most MaxMeshletVertices
+	 * vertices, without reordering anything
+	 */
+	std::vector<SpRenderer::MeshFileMeshlet> buildMeshlets(std::span<const uint32> indices, std::span<const Vertex> vertices);
+
+	/*!
+	 * Average cache misses per triangle of a FIFO cache
+	 */
+	float averageCacheMissRatio(std::span<const uint32> indices, uint32 vertexCount, uint32 cacheSize = StatsCacheSize);
+} // SpMeshCook
+
+#endif //SPARKER_ENGINE_MESHPROCESSING_H
@@ -0,0 +1,100 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "MeshWriter.h"
+
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace SpMeshCook {
+	namespace {
+		uint64 alignSection(uint64 offset) {
+			return (offset + SpRenderer::MeshFileAlignment - 1) & ~static_cast<uint64>(SpRenderer::MeshFileAlignment - 1);
+		}
+
+		template<typename T>
+		void writeSection(std::vector<char>& data, uint64 offset, std::span<const T> values) {
+			std::memcpy(data.data() + offset, values.data(), values.size_bytes());
+		}
+	}
+
+	uint64 writeMeshFile(const fs::path& filePath, std::span<const CookedMesh> meshes, std::string& error) {
+		uint64 vertexCount = 0;
+		uint64 indexCount = 0;
+		uint64 meshletCount = 0;
+		for (const CookedMesh& mesh : meshes) {
+			vertexCount += mesh.vertices.size();
+			indexCount += mesh.indices.size();
+			meshletCount += mesh.meshlets.size();
+		}
+
+		// The scene's geometry buffers are the real limit, but the header counts have to fit first
+		if (vertexCount > std::numeric_limits<uint32>::max() || indexCount > std::numeric_limits<uint32>::max() ||
+		    meshletCount > std::numeric_limits<uint32>::max()) {
+			error = "too much geometry for one file";
+			return 0;
+		}
+
+		SpRenderer::MeshFileHeader header{};
+		header.magic = SpRenderer::MeshFileMagic;
+		header.version = SpRenderer::MeshFileVersion;
+		header.meshCount = static_cast<uint32>(meshes.size());
+		header.meshletCount = static_cast<uint32>(meshletCount);
+		header.vertexCount = static_cast<uint32>(vertexCount);
+		header.indexCount = static_cast<uint32>(indexCount);
+		header.meshOffset = alignSection(sizeof(header));
+		header.meshletOffset = alignSection(header.meshOffset + meshes.size() * sizeof(SpRenderer::MeshFileMesh));
+		header.vertexOffset = alignSection(header.meshletOffset + meshletCount * sizeof(SpRenderer::MeshFileMeshlet));
+		header.indexOffset = alignSection(header.vertexOffset + vertexCount * sizeof(VertexPacked));
+		header.fileSize = header.indexOffset + indexCount * sizeof(uint32);
+
+		std::vector<char> data(header.fileSize, 0);
+		std::memcpy(data.data(), &header, sizeof(header));
+
+		uint32 firstVertex = 0;
+		uint32 firstIndex = 0;
+		uint32 firstMeshlet = 0;
+		for (size_t i = 0; i < meshes.size(); i++) {
+			const CookedMesh& mesh = meshes[i];
+
+			SpRenderer::MeshFileMesh fileMesh{};
+			fileMesh.boundingSphere = mesh.boundingSphere;
+			fileMesh.positionScale = mesh.positionScale;
+			fileMesh.firstVertex = firstVertex;
+			fileMesh.vertexCount = static_cast<uint32>(mesh.vertices.size());
+			fileMesh.firstIndex = firstIndex;
+			fileMesh.indexCount = static_cast<uint32>(mesh.indices.size());
+			fileMesh.firstMeshlet = firstMeshlet;
+			fileMesh.meshletCount = static_cast<uint32>(mesh.meshlets.size());
+			// Cut to fit, the terminator is already there
+			std::memcpy(fileMesh.name, mesh.name.data(), std::min<size_t>(mesh.name.size(), SpRenderer::MeshNameSize - 1));
+
+			std::memcpy(data.data() + header.meshOffset + i * sizeof(fileMesh), &fileMesh, sizeof(fileMesh));
+			writeSection<SpRenderer::MeshFileMeshlet>(data, header.meshletOffset + firstMeshlet * sizeof(SpRenderer::MeshFileMeshlet), mesh.meshlets);
+			writeSection<VertexPacked>(data, header.vertexOffset + firstVertex * sizeof(VertexPacked), mesh.vertices);
+			writeSection<uint32>(data, header.indexOffset + firstIndex * sizeof(uint32), mesh.indices);
+
+			firstVertex += fileMesh.vertexCount;
+			firstIndex += fileMesh.indexCount;
+			firstMeshlet += fileMesh.meshletCount;
+		}
+
+		if (filePath.has_parent_path() && !fs::exists(filePath.parent_path())) {
+			fs::create_directories(filePath.parent_path());
+		}
+
+		fs::path tempPath = filePath;
+		tempPath += ".tmp";
+		Utils::FileUtils::writeBinaryFile(tempPath, data);
+
+		std::error_code renameError;
+		fs::rename(tempPath, filePath, renameError);
+		if (renameError) {
+			error = "could not replace " + filePath.string() + ": " + renameError.message();
+			return 0;
+		}
+		return header.fileSize;
+	}
+} // SpMeshCook
@@ -0,0 +1,21 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#ifndef SPARKER_ENGINE_MESHWRITER_H
+#define SPARKER_ENGINE_MESHWRITER_H
+
+#include "MeshProcessing.h"
+
+namespace SpMeshCook {
+	/**
+	 * Lays the meshes out back to back in the MeshFile.h format and replaces the file in one rename, so a mapped
+	 * copy of the old file stays intact
+	 *
+	 * @param error Why nothing was written
+	 * @return Bytes written, 0 on failure
+	 */
+	uint64 writeMeshFile(const std::filesystem::path& filePath, std::span<const CookedMesh> meshes, std::string& error);
+} // SpMeshCook
+
+#endif //SPARKER_ENGINE_MESHWRITER_H
@@ -0,0 +1,98 @@
+//
+// Created by robsc on 12/01/25.
+//
+
+#include "MeshWriter.h"
+
+#include <cstring>
+
+int main(int argc, char* args[]) {
+    SpMeshCook::CookSettings settings{};
+    std::filesystem::path inputPath;
+    std::filesystem::path outputPath;
+    bool validArgs = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(args[i], "--no-overdraw") == 0) {
+            settings.optimizeOverdraw = false;
+        }else if (std::strcmp(args[i], "--no-meshlets") == 0) {
+            settings.buildMeshlets = false;
+        }else if (args[i][0] != '-' && inputPath.empty()) {
+            inputPath = args[i];
+        }else if (args[i][0] != '-' && outputPath.empty()) {
+            outputPath = args[i];
+        }else {
+            validArgs = false;
+        }
+    }
+
+    if (!validArgs || inputPath.empty() || outputPath.empty()) {
+        SpConsole::PlainWrite("Usage: SparkerMeshCook <input .gltf/.glb/.obj> <output" MESH_FILE_EXTENSION "> [--no-overdraw] [--no-meshlets]");
+        SpConsole::Flush();
+        return SP_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<SpMeshCook::ImportedMesh> importedMeshes;
+    std::string error;
+    std::string extension = inputPath.extension().string();
+    bool imported = false;
+    if (extension == ".gltf" || extension == ".glb") {
+        imported = SpMeshCook::importGltf(inputPath, importedMeshes, error);
+    }else if (extension == ".obj") {
+        imported = SpMeshCook::importObj(inputPath, importedMeshes, error);
+    }else {
+        error = "unknown extension \"" + extension + "\"";
+    }
+
+    if (!imported) {
+        SpConsole::Write(SP_MESSAGE_ERROR, "Failed to import " + inputPath.string() + ": " + error);
+        SpConsole::Flush();
+        return SP_FAILURE;
+    }
+
+    std::vector<SpMeshCook::CookedMesh> cookedMeshes;
+    cookedMeshes.reserve(importedMeshes.size());
+    for (const SpMeshCook::ImportedMesh& mesh : importedMeshes) {
+        if (mesh.indices.empty()) {
+            SpConsole::Write(SP_MESSAGE_WARNING, "Skipping mesh \"" + mesh.name + "\", it has no triangles");
+            continue;
+        }
+
+        SpMeshCook::CookStats stats{};
+        cookedMeshes.push_back(SpMeshCook::cookMesh(mesh, settings, stats));
+        const SpMeshCook::CookedMesh& cooked = cookedMeshes.back();
+        if (cooked.indices.empty()) {
+            SpConsole::Write(SP_MESSAGE_WARNING, "Skipping mesh \"" + mesh.name + "\", all of its triangles are degenerate");
+            cookedMeshes.pop_back();
+            continue;
+        }
+
+        SpConsole::Write(SP_MESSAGE_INFO, "\"" + cooked.name + "\": ACMR " + std::to_string(stats.acmrBefore) + " -> " +
+                                          std::to_string(stats.acmrAfter) + ", " + std::to_string(cooked.vertices.size()) +
+                                          " vertices, " + std::to_string(cooked.indices.size() / 3) + " triangles, " +
+                                          std::to_string(cooked.meshlets.size()) + " meshlets, dropped " +
+                                          std::to_string(stats.droppedTriangles) + " degenerate triangles and " +
+                                          std::to_string(stats.droppedVertices) + " unused vertices");
+    }
+
+    if (cookedMeshes.empty()) {
+        SpConsole::Write(SP_MESSAGE_ERROR, inputPath.string() + " has no meshes with triangles");
+        SpConsole::Flush();
+        return SP_FAILURE;
+    }
+
+    uint64 fileSize = SpMeshCook::writeMeshFile(outputPath, cookedMeshes, error);
+    if (fileSize == 0) {
+        SpConsole::Write(SP_MESSAGE_ERROR, "Failed to write " + outputPath.string() + ": " + error);
+        SpConsole::Flush();
+        return SP_FAILURE;
+    }
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    SpConsole::Write(SP_MESSAGE_INFO, "Wrote " + std::to_string(cookedMeshes.size()) + " meshes, " +
+                                      std::to_string(fileSize / 1024) + " KiB to " + outputPath.string() + " in " +
+                                      std::to_string(elapsedMs) + " ms");
+    SpConsole::Flush();
+    return SP_SUCCESS;
+}